@@ -420,7 +420,8 @@ jlong SVNRepos::recover(File &path, ReposNotifyCallback *notifyCallback)
       return -1;
     }
 
-  SVN_JNI_ERR(svn_repos_recover4(path.getInternalStyle(requestPool), FALSE,
+  SVN_JNI_ERR(svn_repos_recover5(path.getInternalStyle(requestPool), FALSE,
+                                 NULL,
                                  notifyCallback != NULL
                                     ? ReposNotifyCallback::notify
                                     : NULL,
@@ -641,9 +642,9 @@ SVNRepos::verify(File &path, Revision &revisionStart, Revision &revisionEnd,
       (SVN_ERR_INCORRECT_PARAMS, NULL,
        _("Start revision cannot be higher than end revision")), );
 
-  SVN_JNI_ERR(svn_repos_verify_fs3(repos, lower, upper,
+  SVN_JNI_ERR(svn_repos_verify_fs4(repos, lower, upper,
                                    checkNormalization,
-                                   metadataOnly,
+                                   metadataOnly, 1,
                                    (!notifyCallback ? NULL
                                     : ReposNotifyCallback::notify),
                                    notifyCallback,
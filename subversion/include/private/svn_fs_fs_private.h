@@ -313,6 +313,8 @@ typedef struct svn_fs_fs__ioctl_get_stats_input_t
 {
   svn_fs_progress_notify_func_t progress_func;
   void *progress_baton;
+  /* Number of worker threads; 0 is the same as 1. */
+  int jobs;
 } svn_fs_fs__ioctl_get_stats_input_t;
 
 typedef struct svn_fs_fs__ioctl_get_stats_output_t
@@ -359,11 +361,22 @@ typedef struct svn_fs_fs__ioctl_build_rep_cache_input_t
   svn_revnum_t end_rev;
   svn_fs_progress_notify_func_t progress_func;
   void *progress_baton;
+  /* Number of worker threads; 0 is the same as 1. */
+  int jobs;
 } svn_fs_fs__ioctl_build_rep_cache_input_t;
 
 /* See svn_fs_fs__build_rep_cache(). */
 SVN_FS_DECLARE_IOCTL_CODE(SVN_FS_FS__IOCTL_BUILD_REP_CACHE, SVN_FS_TYPE_FSFS, 1004);
 
+typedef struct svn_fs_fs__ioctl_build_mergeinfo_index_input_t
+{
+  svn_fs_progress_notify_func_t progress_func;
+  void *progress_baton;
+} svn_fs_fs__ioctl_build_mergeinfo_index_input_t;
+
+/* See svn_fs_fs__build_mergeinfo_index(). */
+SVN_FS_DECLARE_IOCTL_CODE(SVN_FS_FS__IOCTL_BUILD_MERGEINFO_INDEX, SVN_FS_TYPE_FSFS, 1005);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
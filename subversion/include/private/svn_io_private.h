@@ -135,6 +135,92 @@ svn_stream__from_aprfile(apr_file_t *file,
                          svn_boolean_t truncate_on_seek,
                          apr_pool_t *pool);
 
+/* Infrastructure for efficiently calling fsync on files and directories.
+ *
+ * The idea is to have a container of open file handles (including
+ * directory handles on POSIX), at most one per file.  During the course
+ * of an operation that needs to be fsync'ed, all touched files and
+ * folders accumulate in the container.
+ *
+ * At the end of the operation, all file changes will be written the
+ * physical disk, once per file and folder.  Afterwards, all handles will
+ * be closed and the container is ready for reuse.
+ *
+ * To minimize the delay caused by the batch flush, run all fsync calls
+ * concurrently - if the OS supports multi-threading.
+ */
+
+/** Opaque container type.
+ */
+typedef struct svn_io__batch_fsync_t svn_io__batch_fsync_t;
+
+/** Initialize the concurrent fsync infrastructure.  Clean it up when
+ * @a owning_pool gets cleared.
+ *
+ * This function must be called before using any of the other
+ * svn_io__batch_fsync_* functions.  Repeated calls are no-ops as long as
+ * the infrastructure has not been cleaned up.
+ */
+svn_error_t *
+svn_io__batch_fsync_init(apr_pool_t *owning_pool);
+
+/** Set @a *result_p to a new batch fsync structure, allocated in
+ * @a result_pool.  If @a flush_to_disk is not set, the resulting struct
+ * will not actually use fsync.
+ */
+svn_error_t *
+svn_io__batch_fsync_create(svn_io__batch_fsync_t **result_p,
+                           svn_boolean_t flush_to_disk,
+                           apr_pool_t *result_pool);
+
+/** Open the file at @a filename for read and write access.  Return it in
+ * @a *file and schedule it for fsync in @a batch.  If @a batch already
+ * contains an open file for @a filename, return that instead creating a
+ * new instance.
+ *
+ * Use @a scratch_pool for temporaries.
+ */
+svn_error_t *
+svn_io__batch_fsync_open_file(apr_file_t **file,
+                              svn_io__batch_fsync_t *batch,
+                              const char *filename,
+                              apr_pool_t *scratch_pool);
+
+/** Inform the @a batch that a file or directory has been created at
+ * @a path.  "Created" means either newly created to renamed to @a path -
+ * even if another item with the same name existed before.  Depending on
+ * the OS, the correct path will scheduled for fsync.
+ *
+ * Use @a scratch_pool for temporaries.
+ */
+svn_error_t *
+svn_io__batch_fsync_new_path(svn_io__batch_fsync_t *batch,
+                             const char *path,
+                             apr_pool_t *scratch_pool);
+
+/** Schedule the existing file at @a path for fsync in @a batch, together
+ * with its directory entry as svn_io__batch_fsync_new_path() would do.
+ * Unlike svn_io__batch_fsync_open_file(), don't require write access
+ * to the file on platforms that can sync read-only handles.  This is
+ * useful for files that have already been made read-only.
+ *
+ * If @a batch has been created without flush_to_disk, this is a no-op
+ * that does not even open the file.
+ *
+ * Use @a scratch_pool for temporaries.
+ */
+svn_error_t *
+svn_io__batch_fsync_add_file(svn_io__batch_fsync_t *batch,
+                             const char *path,
+                             apr_pool_t *scratch_pool);
+
+/** For all files and directories in @a batch, flush all changes to disk
+ * and close the file handles.  Use @a scratch_pool for temporaries.
+ */
+svn_error_t *
+svn_io__batch_fsync_run(svn_io__batch_fsync_t *batch,
+                        apr_pool_t *scratch_pool);
+
 #if defined(WIN32)
 
 /* ### Move to something like io.h or subr.h, to avoid making it
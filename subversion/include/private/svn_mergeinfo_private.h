@@ -287,6 +287,79 @@ svn_rangelist__merge_many(svn_rangelist_t *merged_rangelist,
                           apr_pool_t *result_pool,
                           apr_pool_t *scratch_pool);
 
+/* A rangelist in compact form.  Instead of an array of pointers to
+ * individually allocated svn_merge_range_t, the ranges are stored in
+ * parallel arrays, each allocated in a single block.  The ranges are
+ * non-empty forward ranges in ascending order that do not overlap.
+ *
+ * Operations on compact rangelists are simple linear scans over these
+ * arrays.  Use them where many rangelist operations are being applied,
+ * e.g. when combining the mergeinfo of many subtrees, and convert from
+ * and to svn_rangelist_t only at the boundaries.
+ */
+typedef struct svn_rangelist__compact_t
+{
+  /* Number of ranges. */
+  int nelts;
+
+  /* The i-th range is START[i] to END[i] and is inheritable if
+   * INHERITABLE[i] is set. */
+  svn_revnum_t *start;
+  svn_revnum_t *end;
+  svn_boolean_t *inheritable;
+} svn_rangelist__compact_t;
+
+/* Return RANGELIST in compact form, allocated in RESULT_POOL.  Return NULL
+ * if RANGELIST contains empty or reverse ranges or if its ranges are not
+ * in ascending order or overlap.  Adjacent ranges will be combined if they
+ * have the same inheritability.
+ */
+svn_rangelist__compact_t *
+svn_rangelist__compact(const svn_rangelist_t *rangelist,
+                       apr_pool_t *result_pool);
+
+/* Return COMPACT as a rangelist allocated in RESULT_POOL.  All ranges of
+ * the result are allocated in a single block.
+ */
+svn_rangelist_t *
+svn_rangelist__from_compact(const svn_rangelist__compact_t *compact,
+                            apr_pool_t *result_pool);
+
+/* Return the union of RANGELIST1 and RANGELIST2, allocated in RESULT_POOL.
+ * A revision is inheritable in the result if it is inheritable in either
+ * input.  This gives the same result as svn_rangelist_merge2().
+ */
+svn_rangelist__compact_t *
+svn_rangelist__compact_merge(const svn_rangelist__compact_t *rangelist1,
+                             const svn_rangelist__compact_t *rangelist2,
+                             apr_pool_t *result_pool);
+
+/* Return the intersection of RANGELIST1 and RANGELIST2, allocated in
+ * RESULT_POOL.  A revision is inheritable in the result if it is
+ * inheritable in either input.
+ *
+ * For inputs that are inheritable throughout, this gives the same result
+ * as svn_rangelist_intersect().  Otherwise, ranges of different
+ * inheritability will not be combined like svn_rangelist_intersect()
+ * does when CONSIDER_INHERITANCE is FALSE.
+ */
+svn_rangelist__compact_t *
+svn_rangelist__compact_intersect(const svn_rangelist__compact_t *rangelist1,
+                                 const svn_rangelist__compact_t *rangelist2,
+                                 apr_pool_t *result_pool);
+
+/* Return the revisions in WHITEBOARD that are not in ERASER, allocated in
+ * RESULT_POOL.  The inheritability of ERASER is ignored, i.e. remaining
+ * revisions keep their inheritability from WHITEBOARD.
+ *
+ * For inputs that are inheritable throughout, this gives the same result
+ * as svn_rangelist_remove().
+ */
+svn_rangelist__compact_t *
+svn_rangelist__compact_remove(const svn_rangelist__compact_t *eraser,
+                              const svn_rangelist__compact_t *whiteboard,
+                              apr_pool_t *result_pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -118,7 +118,8 @@ const char *
 svn_spillbuf__get_filename(const svn_spillbuf_t *buf);
 
 /* Retrieve the handle of the spill file. The returned value will be
-   NULL if the file has not been created yet. */
+   NULL if the file has not been created yet.  The spill buffer remembers
+   where it left the file pointer, so callers must not move it. */
 apr_file_t *
 svn_spillbuf__get_file(const svn_spillbuf_t *buf);
 
@@ -382,6 +383,99 @@ svn_hash__make(apr_pool_t *pool);
 
 /** @} */
 
+/**
+ * @defgroup svn_hash_table Open-addressing string hash tables
+ * @{
+ */
+
+/** A hash table mapping byte-string keys to non-NULL values.
+ *
+ * In contrast to #apr_hash_t, the entries are kept in one contiguous
+ * array and are found through an open-addressing (linear probing) index.
+ * That makes lookups in large tables cheaper and keeps the per-entry
+ * overhead low.  Iteration returns the entries in the order in which
+ * they were added.
+ *
+ * As with #apr_hash_t, keys are not copied and must remain valid for as
+ * long as they are in the table.  Growing the table allocates new arrays
+ * from the table's pool.  Removed entries are dropped when that happens,
+ * so a table that shrank will also get smaller again.
+ *
+ * @since New in 1.15.
+ */
+typedef struct svn_hash__table_t svn_hash__table_t;
+
+/** Return a new, empty table allocated in @a result_pool, with space
+ * for @a initial_size entries before it needs to grow.
+ *
+ * @since New in 1.15.
+ */
+svn_hash__table_t *
+svn_hash__table_make(apr_size_t initial_size,
+                     apr_pool_t *result_pool);
+
+/** Return the pool that @a table has been allocated in.
+ *
+ * @since New in 1.15.
+ */
+apr_pool_t *
+svn_hash__table_pool_get(const svn_hash__table_t *table);
+
+/** Return the number of entries in @a table.
+ *
+ * @since New in 1.15.
+ */
+apr_size_t
+svn_hash__table_count(const svn_hash__table_t *table);
+
+/** Return the value stored for the @a klen bytes long @a key in @a table,
+ * or @c NULL if there is no such entry.
+ *
+ * @since New in 1.15.
+ */
+void *
+svn_hash__table_get(svn_hash__table_t *table,
+                    const char *key,
+                    apr_size_t klen);
+
+/** Store @a val for the @a klen bytes long @a key in @a table, replacing
+ * any previous value.  If @a val is @c NULL, remove the entry instead.
+ *
+ * @since New in 1.15.
+ */
+void
+svn_hash__table_set(svn_hash__table_t *table,
+                    const char *key,
+                    apr_size_t klen,
+                    void *val);
+
+/** Iterate over the entries in @a table.  Starting at the position
+ * given in @a *iter, return the value of the next entry and update
+ * @a *iter to point behind it.  If @a key and / or @a klen are not
+ * @c NULL, set them to the entry's key and its length.  Return @c NULL
+ * if there are no more entries.
+ *
+ * Set @a *iter to 0 to start a new iteration.  @a table must not be
+ * modified during the iteration, except for removing the current entry.
+ *
+ * @since New in 1.15.
+ */
+void *
+svn_hash__table_next(const char **key,
+                     apr_size_t *klen,
+                     const svn_hash__table_t *table,
+                     apr_size_t *iter);
+
+/** Like svn_hash__table_get() but for NUL-terminated @a key. */
+#define svn_hash__table_gets(table, key) \
+  svn_hash__table_get(table, key, strlen(key))
+
+/** Like svn_hash__table_set() but for NUL-terminated @a key. */
+#define svn_hash__table_sets(table, key, val) \
+  svn_hash__table_set(table, key, strlen(key), val)
+
+/** @} */
+
 /**
  * @defgroup svn_hash_read Reading serialized hash tables
  * @{
@@ -626,6 +720,82 @@ svn_root_pools__release_pool(apr_pool_t *pool,
 
 /** @} */
 
+/**
+ * @defgroup svn_jobs Worker threads with in-order results
+ * @{
+ */
+
+/* Callback type used by svn__jobs_run() to create the next job.  Set *JOB
+ * to a new job object, allocated in JOB_POOL, or to NULL if there is no
+ * more work to do.  BATON is the baton passed to svn__jobs_run().
+ *
+ * JOB_POOL is a pool of its own that will be used by the worker thread
+ * without synchronization.  It gets destroyed after the job has finished.
+ * This is being called in the thread that called svn__jobs_run().
+ */
+typedef svn_error_t *
+(*svn__job_start_func_t)(void **job,
+                         void *baton,
+                         apr_pool_t *job_pool,
+                         apr_pool_t *scratch_pool);
+
+/* Callback type used by svn__jobs_run() to do the actual work of JOB,
+ * possibly in a worker thread.  Allocate results that the finish callback
+ * shall see in RESULT_POOL, which is the JOB_POOL that JOB was created in.
+ * Use SCRATCH_POOL for temporary allocations.
+ *
+ * Call CANCEL_FUNC with CANCEL_BATON periodically.  It will return
+ * SVN_ERR_CANCELLED when the job is no longer needed.  In a worker thread,
+ * this is never the cancellation callback passed to svn__jobs_run().
+ */
+typedef svn_error_t *
+(*svn__job_work_func_t)(void *job,
+                        svn_cancel_func_t cancel_func,
+                        void *cancel_baton,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool);
+
+/* Callback type used by svn__jobs_run() to process the outcome of JOB.
+ * ERR is the error returned by the work callback for JOB and must be
+ * handled, e.g. returned or cleared, by this function.  BATON is the baton
+ * passed to svn__jobs_run().  Use SCRATCH_POOL for temporary allocations.
+ *
+ * This is being called in the thread that called svn__jobs_run().
+ */
+typedef svn_error_t *
+(*svn__job_finish_func_t)(void *job,
+                          svn_error_t *err,
+                          void *baton,
+                          apr_pool_t *scratch_pool);
+
+/* Create jobs with START_FUNC until it returns no more jobs and execute
+ * them with WORK_FUNC, up to MAX_JOBS of them concurrently in worker
+ * threads.  Call FINISH_FUNC for each job in the order in which the jobs
+ * have been created.  BATON is being passed to START_FUNC and FINISH_FUNC.
+ *
+ * If MAX_JOBS is smaller than 2 or if APR has no thread support, execute
+ * all jobs one after the other in the calling thread.
+ *
+ * If CANCEL_FUNC is not NULL, call it with CANCEL_BATON periodically, but
+ * only from the calling thread, while waiting for the workers.  If it or
+ * any of the callbacks returns an error, tell all remaining workers to
+ * stop, dispose of their jobs without finishing them and return that
+ * error.
+ *
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn__jobs_run(int max_jobs,
+              svn__job_start_func_t start_func,
+              svn__job_work_func_t work_func,
+              svn__job_finish_func_t finish_func,
+              void *baton,
+              svn_cancel_func_t cancel_func,
+              void *cancel_baton,
+              apr_pool_t *scratch_pool);
+
+/** @} */
+
 /**
  * @defgroup svn_config_private Private configuration handling API
  * @{
@@ -166,6 +166,18 @@ typedef struct svn_fs_t svn_fs_t;
  */
 #define SVN_FS_CONFIG_FSFS_LOG_ADDRESSING       "fsfs-log-addressing"
 
+/** String with a decimal representation of the maximum number of threads
+ * that FSFS recovery may use to scan revisions for node and copy IDs.
+ * Only repositories with global ID counters, i.e. formats older than 3,
+ * need that scan.  Defaults to "1".
+ *
+ * This option will only be used by svn_fs_recover2() and is otherwise
+ * ignored.
+ *
+ * @since New in 1.15.
+ */
+#define SVN_FS_CONFIG_FSFS_RECOVERY_JOBS        "fsfs-recovery-jobs"
+
 /* Note to maintainers: if you add further SVN_FS_CONFIG_FSFS_CACHE_* knobs,
    update fs_fs.c:verify_as_revision_before_current_plus_plus(). */
 
@@ -602,6 +614,9 @@ svn_fs_hotcopy(const char *src_path,
 /** Perform any necessary non-catastrophic recovery on the Subversion
  * filesystem located at @a path.
  *
+ * @a fs_config is passed to the filesystem and may be @c NULL.  See
+ * #SVN_FS_CONFIG_FSFS_RECOVERY_JOBS.
+ *
  * If @a cancel_func is not @c NULL, it is called periodically with
  * @a cancel_baton as argument to see if the client wishes to cancel
  * recovery.  BDB filesystems do not currently support cancellation.
@@ -631,9 +646,22 @@ svn_fs_hotcopy(const char *src_path,
  * there is no harm in it, either, and it take very little time.  So
  * it's a fine idea to run recovery when the server process starts,
  * before it begins handling any requests.
+ *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_fs_recover2(const char *path,
+                apr_hash_t *fs_config,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                apr_pool_t *pool);
+
+/** Like svn_fs_recover2(), but without @a fs_config.
  *
  * @since New in 1.5.
+ * @deprecated Provided for backward compatibility with the 1.14 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_fs_recover(const char *path,
                svn_cancel_func_t cancel_func,
@@ -768,6 +768,8 @@ svn_repos_fs_pack(svn_repos_t *repos,
  * If @a nonblocking is TRUE, an error of type EWOULDBLOCK is
  * returned if the lock is not immediately available.
  *
+ * @a fs_config is passed to svn_fs_recover2() and may be @c NULL.
+ *
  * If @a notify_func is not NULL, it will be called with @a
  * notify_baton as argument before the recovery starts, but
  * after the exclusive lock has been acquired.
@@ -781,8 +783,25 @@ svn_repos_fs_pack(svn_repos_t *repos,
  * by a single threaded process, or by a multi-threaded process when
  * no other threads are accessing the repository.
  *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_repos_recover5(const char *path,
+                   svn_boolean_t nonblocking,
+                   apr_hash_t *fs_config,
+                   svn_repos_notify_func_t notify_func,
+                   void *notify_baton,
+                   svn_cancel_func_t cancel_func,
+                   void * cancel_baton,
+                   apr_pool_t *pool);
+
+/**
+ * Similar to svn_repos_recover5(), but without @a fs_config.
+ *
  * @since New in 1.7.
+ * @deprecated Provided for backward compatibility with the 1.14 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_repos_recover4(const char *path,
                    svn_boolean_t nonblocking,
@@ -3134,10 +3153,10 @@ enum svn_repos_load_uuid
   svn_repos_load_uuid_force
 };
 
-/** Callback type for use with svn_repos_verify_fs3().  @a revision
+/** Callback type for use with svn_repos_verify_fs4().  @a revision
  * and @a verify_err are the details of a single verification failure
- * that occurred during the svn_repos_verify_fs3() call.  @a baton is
- * the same baton given to svn_repos_verify_fs3().  @a scratch_pool is
+ * that occurred during the svn_repos_verify_fs4() call.  @a baton is
+ * the same baton given to svn_repos_verify_fs4().  @a scratch_pool is
  * provided for the convenience of the implementor, who should not
  * expect it to live longer than a single callback call.
  *
@@ -3147,7 +3166,7 @@ enum svn_repos_load_uuid
  * should also call svn_error_dup() for @a verify_err.  Implementors of this
  * callback are forbidden to call svn_error_clear() for @a verify_err.
  *
- * @see svn_repos_verify_fs3
+ * @see svn_repos_verify_fs4
  *
  * @since New in 1.9.
  */
@@ -3216,16 +3235,48 @@ typedef svn_error_t *(*svn_repos_verify_callback_t)(void *baton,
  *            called has reached its end and is about to return?
  *        ### Not sent, currently, if a FS structure error is found.
  *
+ * If @a jobs is larger than 1 and the backend supports it, split the
+ * revision range into chunks (one shard each, where applicable) and
+ * verify up to @a jobs of them concurrently, each in its own thread with
+ * its own filesystem handle and pools.  Notifications and failures are
+ * still delivered to @a notify_func and @a verify_callback in the calling
+ * thread and in revision order, but FS-specific structure notifications
+ * are interleaved with the per-revision ones of the respective chunk.
+ * If APR has no thread support, @a jobs is ignored.
+ *
  * If @a cancel_func is not @c NULL, call it periodically with @a
  * cancel_baton as argument to see if the caller wishes to cancel the
- * verification.
+ * verification.  @a cancel_func is only ever called from the calling
+ * thread, even if @a jobs is larger than 1.
  *
  * Use @a scratch_pool for temporary allocation.
  *
  * @see svn_repos_verify_callback_t
  *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_repos_verify_fs4(svn_repos_t *repos,
+                     svn_revnum_t start_rev,
+                     svn_revnum_t end_rev,
+                     svn_boolean_t check_normalization,
+                     svn_boolean_t metadata_only,
+                     int jobs,
+                     svn_repos_notify_func_t notify_func,
+                     void *notify_baton,
+                     svn_repos_verify_callback_t verify_callback,
+                     void *verify_baton,
+                     svn_cancel_func_t cancel,
+                     void *cancel_baton,
+                     apr_pool_t *scratch_pool);
+
+/**
+ * Like svn_repos_verify_fs4(), but with @a jobs set to 1.
+ *
  * @since New in 1.9.
+ * @deprecated Provided for backward compatibility with the 1.14 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_repos_verify_fs3(svn_repos_t *repos,
                      svn_revnum_t start_rev,
@@ -3283,7 +3334,7 @@ svn_repos_verify_fs(svn_repos_t *repos,
  * Dump the contents of the filesystem within already-open @a repos into
  * writable @a dumpstream.  If @a dumpstream is
  * @c NULL, this is effectively a primitive verify.  It is not complete,
- * however; see instead svn_repos_verify_fs3().
+ * however; see instead svn_repos_verify_fs4().
  *
  * Begin at revision @a start_rev, and dump every revision up through
  * @a end_rev.  If @a start_rev is #SVN_INVALID_REVNUM, start at revision
@@ -730,15 +730,16 @@ svn_fs_pack(const char *path,
 }
 
 svn_error_t *
-svn_fs_recover(const char *path,
-               svn_cancel_func_t cancel_func, void *cancel_baton,
-               apr_pool_t *pool)
+svn_fs_recover2(const char *path,
+                apr_hash_t *fs_config,
+                svn_cancel_func_t cancel_func, void *cancel_baton,
+                apr_pool_t *pool)
 {
   fs_library_vtable_t *vtable;
   svn_fs_t *fs;
 
   SVN_ERR(fs_library_vtable(&vtable, path, pool));
-  fs = fs_new(NULL, pool);
+  fs = fs_new(fs_config, pool);
 
   SVN_ERR(vtable->open_fs_for_recovery(fs, path, common_pool_lock,
                                        pool, common_pool));
@@ -824,7 +825,7 @@ svn_fs_hotcopy_berkeley(const char *src_path, const char *dest_path,
 svn_error_t *
 svn_fs_berkeley_recover(const char *path, apr_pool_t *pool)
 {
-  return svn_error_trace(svn_fs_recover(path, NULL, NULL, pool));
+  return svn_error_trace(svn_fs_recover2(path, NULL, NULL, NULL, pool));
 }
 
 svn_error_t *
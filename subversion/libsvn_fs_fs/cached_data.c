@@ -33,6 +33,7 @@
 #include "private/svn_subr_private.h"
 #include "private/svn_temp_serializer.h"
 
+#include "changes_index.h"
 #include "fs_fs.h"
 #include "id.h"
 #include "index.h"
@@ -2578,6 +2579,57 @@ compare_dirent_name(const void *a, const void *b)
   return strcmp(lhs->name, rhs);
 }
 
+/* Construct a new directory entry in *DIRENT_P from the key-value pair
+ * ENTRY read from a directory representation.  ID is provided for nicer
+ * error messages.  Allocate the result in RESULT_POOL and use SCRATCH_POOL
+ * for temporaries.  Note that this modifies the value in ENTRY.
+ */
+static svn_error_t *
+parse_dir_entry(svn_fs_dirent_t **dirent_p,
+                svn_hash__entry_t *entry,
+                const svn_fs_id_t *id,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  svn_fs_dirent_t *dirent;
+  char *str;
+
+  dirent = apr_pcalloc(result_pool, sizeof(*dirent));
+  dirent->name = apr_pstrmemdup(result_pool, entry->key, entry->keylen);
+
+  str = svn_cstring_tokenize(" ", &entry->val);
+  if (str == NULL)
+    return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                       _("Directory entry corrupt in '%s'"),
+                       svn_fs_fs__id_unparse(id, scratch_pool)->data);
+
+  if (strcmp(str, SVN_FS_FS__KIND_FILE) == 0)
+    {
+      dirent->kind = svn_node_file;
+    }
+  else if (strcmp(str, SVN_FS_FS__KIND_DIR) == 0)
+    {
+      dirent->kind = svn_node_dir;
+    }
+  else
+    {
+      return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                       _("Directory entry corrupt in '%s'"),
+                       svn_fs_fs__id_unparse(id, scratch_pool)->data);
+    }
+
+  str = svn_cstring_tokenize(" ", &entry->val);
+  if (str == NULL)
+    return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                       _("Directory entry corrupt in '%s'"),
+                       svn_fs_fs__id_unparse(id, scratch_pool)->data);
+
+  SVN_ERR(svn_fs_fs__id_parse(&dirent->id, str, result_pool));
+
+  *dirent_p = dirent;
+  return SVN_NO_ERROR;
+}
+
 /* Into *ENTRIES_P, read all directories entries from the key-value text in
  * STREAM.  If INCREMENTAL is TRUE, read until the end of the STREAM and
  * update the data.  ID is provided for nicer error messages.
@@ -2591,12 +2643,12 @@ read_dir_entries(apr_array_header_t **entries_p,
                  apr_pool_t *scratch_pool)
 {
   apr_pool_t *iterpool = svn_pool_create(scratch_pool);
-  apr_hash_t *hash = NULL;
+  svn_hash__table_t *hash = NULL;
   const char *terminator = SVN_HASH_TERMINATOR;
   apr_array_header_t *entries = NULL;
 
   if (incremental)
-    hash = svn_hash__make(scratch_pool);
+    hash = svn_hash__table_make(16, scratch_pool);
   else
     entries = apr_array_make(result_pool, 16, sizeof(svn_fs_dirent_t *));
 
@@ -2607,7 +2659,6 @@ read_dir_entries(apr_array_header_t **entries_p,
     {
       svn_hash__entry_t entry;
       svn_fs_dirent_t *dirent;
-      char *str;
 
       svn_pool_clear(iterpool);
       SVN_ERR_W(svn_hash__read_entry(&entry, stream, terminator,
@@ -2632,48 +2683,19 @@ read_dir_entries(apr_array_header_t **entries_p,
         {
           /* We must be in incremental mode */
           assert(hash);
-          apr_hash_set(hash, entry.key, entry.keylen, NULL);
+          svn_hash__table_set(hash, entry.key, entry.keylen, NULL);
           continue;
         }
 
       /* Add a new directory entry. */
-      dirent = apr_pcalloc(result_pool, sizeof(*dirent));
-      dirent->name = apr_pstrmemdup(result_pool, entry.key, entry.keylen);
-
-      str = svn_cstring_tokenize(" ", &entry.val);
-      if (str == NULL)
-        return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
-                           _("Directory entry corrupt in '%s'"),
-                           svn_fs_fs__id_unparse(id, scratch_pool)->data);
-
-      if (strcmp(str, SVN_FS_FS__KIND_FILE) == 0)
-        {
-          dirent->kind = svn_node_file;
-        }
-      else if (strcmp(str, SVN_FS_FS__KIND_DIR) == 0)
-        {
-          dirent->kind = svn_node_dir;
-        }
-      else
-        {
-          return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
-                           _("Directory entry corrupt in '%s'"),
-                           svn_fs_fs__id_unparse(id, scratch_pool)->data);
-        }
-
-      str = svn_cstring_tokenize(" ", &entry.val);
-      if (str == NULL)
-        return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
-                           _("Directory entry corrupt in '%s'"),
-                           svn_fs_fs__id_unparse(id, scratch_pool)->data);
-
-      SVN_ERR(svn_fs_fs__id_parse(&dirent->id, str, result_pool));
+      SVN_ERR(parse_dir_entry(&dirent, &entry, id, result_pool,
+                              scratch_pool));
 
       /* In incremental mode, update the hash; otherwise, write to the
        * final array.  Be sure to use hash keys that survive this iteration.
        */
       if (incremental)
-        apr_hash_set(hash, dirent->name, entry.keylen, dirent);
+        svn_hash__table_set(hash, dirent->name, entry.keylen, dirent);
       else
         APR_ARRAY_PUSH(entries, svn_fs_dirent_t *) = dirent;
     }
@@ -2681,12 +2703,13 @@ read_dir_entries(apr_array_header_t **entries_p,
   /* Convert container to a sorted array. */
   if (incremental)
     {
-      apr_hash_index_t *hi;
+      apr_size_t iter = 0;
+      svn_fs_dirent_t *dirent;
 
-      entries = apr_array_make(result_pool, apr_hash_count(hash),
+      entries = apr_array_make(result_pool, svn_hash__table_count(hash),
                                sizeof(svn_fs_dirent_t *));
-      for (hi = apr_hash_first(iterpool, hash); hi; hi = apr_hash_next(hi))
-        APR_ARRAY_PUSH(entries, svn_fs_dirent_t *) = apr_hash_this_val(hi);
+      while ((dirent = svn_hash__table_next(NULL, NULL, hash, &iter)))
+        APR_ARRAY_PUSH(entries, svn_fs_dirent_t *) = dirent;
     }
 
   if (!sorted(entries))
@@ -2834,6 +2857,241 @@ locate_dir_cache(svn_fs_t *fs,
     }
 }
 
+/* Directories in transactions that are too large to be serialized into
+ * FFD->TXN_DIR_CACHE are kept in FFD->TXN_DIRS instead.  Since every
+ * change to them is applied to this in-memory copy as well, adding or
+ * looking up an entry does not require reading the whole children file.
+ */
+typedef struct txn_dir_t
+{
+  /* Maps entry name to svn_fs_dirent_t *. */
+  svn_hash__table_t *entries;
+
+  /* All ENTRIES, sorted by name.  NULL after entries have been added or
+   * removed; we rebuild it upon the next full listing. */
+  apr_array_header_t *sorted;
+
+  /* Size of the children file that ENTRIES correspond to. */
+  svn_filesize_t txn_filesize;
+
+  /* Everything above is allocated in this pool. */
+  apr_pool_t *pool;
+} txn_dir_t;
+
+/* Return the TXN_DIRS container of FS or NULL, if that is not available.
+ */
+static svn_hash__table_t *
+get_txn_dirs(svn_fs_t *fs)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  /* TXN_DIRS lives and dies with TXN_DIR_CACHE. */
+  return ffd->txn_dir_cache ? ffd->txn_dirs : NULL;
+}
+
+/* Return a copy of ENTRY allocated in RESULT_POOL. */
+static svn_fs_dirent_t *
+copy_dir_entry(const svn_fs_dirent_t *entry,
+               apr_pool_t *result_pool)
+{
+  svn_fs_dirent_t *copy = apr_palloc(result_pool, sizeof(*copy));
+  copy->name = apr_pstrdup(result_pool, entry->name);
+  copy->id = svn_fs_fs__id_copy(entry->id, result_pool);
+  copy->kind = entry->kind;
+
+  return copy;
+}
+
+/* Remove the directory stored under KEY from TXN_DIRS, if any. */
+static void
+drop_txn_dir(svn_hash__table_t *txn_dirs,
+             const char *key)
+{
+  txn_dir_t *dir = svn_hash__table_gets(txn_dirs, key);
+  if (dir)
+    {
+      svn_hash__table_sets(txn_dirs, key, NULL);
+      svn_pool_destroy(dir->pool);
+    }
+}
+
+/* Store a copy of the sorted ENTRIES of the directory with the unparsed
+ * noderev id KEY in the TXN_DIRS container of FS, along with the
+ * TXN_FILESIZE of the children file.  Do nothing if the TXN_DIR_CACHE
+ * can hold that directory or if there is no TXN_DIRS container.
+ */
+static void
+store_txn_dir(svn_fs_t *fs,
+              const char *key,
+              apr_array_header_t *entries,
+              svn_filesize_t txn_filesize)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_hash__table_t *txn_dirs = get_txn_dirs(fs);
+  apr_pool_t *pool;
+  txn_dir_t *dir;
+  int i;
+
+  /* Use the same size estimate as the cache users. */
+  if (   txn_dirs == NULL
+      || svn_cache__is_cachable(ffd->txn_dir_cache, 150 * entries->nelts))
+    return;
+
+  drop_txn_dir(txn_dirs, key);
+
+  pool = svn_pool_create(svn_hash__table_pool_get(txn_dirs));
+  dir = apr_pcalloc(pool, sizeof(*dir));
+  dir->entries = svn_hash__table_make(entries->nelts, pool);
+  dir->sorted = apr_array_make(pool, entries->nelts,
+                               sizeof(svn_fs_dirent_t *));
+  dir->txn_filesize = txn_filesize;
+  dir->pool = pool;
+
+  for (i = 0; i < entries->nelts; ++i)
+    {
+      svn_fs_dirent_t *entry
+        = copy_dir_entry(APR_ARRAY_IDX(entries, i, svn_fs_dirent_t *), pool);
+
+      svn_hash__table_sets(dir->entries, entry->name, entry);
+      APR_ARRAY_PUSH(dir->sorted, svn_fs_dirent_t *) = entry;
+    }
+
+  svn_hash__table_sets(txn_dirs, apr_pstrdup(pool, key), dir);
+}
+
+/* Set *DIR to the in-memory copy of the in-txn directory NODEREV in FS
+ * with the unparsed noderev id KEY.  Set it to NULL, if there is no such
+ * copy or if it is out of date.  Use SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+get_txn_dir(txn_dir_t **dir,
+            svn_fs_t *fs,
+            node_revision_t *noderev,
+            const char *key,
+            apr_pool_t *scratch_pool)
+{
+  svn_hash__table_t *txn_dirs = get_txn_dirs(fs);
+
+  *dir = txn_dirs ? svn_hash__table_gets(txn_dirs, key) : NULL;
+  if (*dir)
+    {
+      /* The children file is append-only.  Same size means same data. */
+      svn_filesize_t filesize;
+      SVN_ERR(get_txn_dir_info(&filesize, fs, noderev, scratch_pool));
+
+      if (filesize != (*dir)->txn_filesize)
+        {
+          drop_txn_dir(txn_dirs, key);
+          *dir = NULL;
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Return a sorted copy of all entries in DIR, allocated in RESULT_POOL.
+ */
+static apr_array_header_t *
+txn_dir_entries(txn_dir_t *dir,
+                apr_pool_t *result_pool)
+{
+  apr_array_header_t *result;
+  int i;
+
+  /* Sort at most once between modifications of DIR. */
+  if (dir->sorted == NULL)
+    {
+      apr_size_t iter = 0;
+      svn_fs_dirent_t *entry;
+
+      dir->sorted = apr_array_make(dir->pool,
+                                   (int)svn_hash__table_count(dir->entries),
+                                   sizeof(svn_fs_dirent_t *));
+      while ((entry = svn_hash__table_next(NULL, NULL, dir->entries, &iter)))
+        APR_ARRAY_PUSH(dir->sorted, svn_fs_dirent_t *) = entry;
+
+      svn_sort__array(dir->sorted, compare_dirents);
+    }
+
+  /* Callers may modify the result. */
+  result = apr_array_make(result_pool, dir->sorted->nelts,
+                          sizeof(svn_fs_dirent_t *));
+  for (i = 0; i < dir->sorted->nelts; ++i)
+    APR_ARRAY_PUSH(result, svn_fs_dirent_t *)
+      = copy_dir_entry(APR_ARRAY_IDX(dir->sorted, i, svn_fs_dirent_t *),
+                       result_pool);
+
+  return result;
+}
+
+void
+svn_fs_fs__set_txn_dir(svn_fs_t *fs,
+                       const svn_fs_id_t *id,
+                       apr_array_header_t *entries,
+                       svn_filesize_t txn_filesize,
+                       apr_pool_t *scratch_pool)
+{
+  if (get_txn_dirs(fs))
+    store_txn_dir(fs, svn_fs_fs__id_unparse(id, scratch_pool)->data,
+                  entries, txn_filesize);
+}
+
+void
+svn_fs_fs__update_txn_dir(svn_fs_t *fs,
+                          const svn_fs_id_t *id,
+                          const char *name,
+                          const svn_fs_id_t *child_id,
+                          svn_node_kind_t kind,
+                          svn_filesize_t old_filesize,
+                          svn_filesize_t new_filesize,
+                          apr_pool_t *scratch_pool)
+{
+  svn_hash__table_t *txn_dirs = get_txn_dirs(fs);
+  const char *key;
+  txn_dir_t *dir;
+  svn_fs_dirent_t *entry;
+
+  if (txn_dirs == NULL)
+    return;
+
+  key = svn_fs_fs__id_unparse(id, scratch_pool)->data;
+  dir = svn_hash__table_gets(txn_dirs, key);
+  if (dir == NULL)
+    return;
+
+  /* Somebody else changed the directory since we last looked? */
+  if (dir->txn_filesize != old_filesize)
+    {
+      drop_txn_dir(txn_dirs, key);
+      return;
+    }
+
+  entry = svn_hash__table_gets(dir->entries, name);
+  if (child_id && entry)
+    {
+      /* Replacing an entry keeps the sort order intact. */
+      entry->id = svn_fs_fs__id_copy(child_id, dir->pool);
+      entry->kind = kind;
+    }
+  else if (child_id)
+    {
+      entry = apr_palloc(dir->pool, sizeof(*entry));
+      entry->name = apr_pstrdup(dir->pool, name);
+      entry->id = svn_fs_fs__id_copy(child_id, dir->pool);
+      entry->kind = kind;
+
+      svn_hash__table_sets(dir->entries, entry->name, entry);
+      dir->sorted = NULL;
+    }
+  else if (entry)
+    {
+      svn_hash__table_sets(dir->entries, name, NULL);
+      dir->sorted = NULL;
+    }
+
+  dir->txn_filesize = new_filesize;
+}
+
 svn_error_t *
 svn_fs_fs__rep_contents_dir(apr_array_header_t **entries_p,
                             svn_fs_t *fs,
@@ -2848,6 +3106,21 @@ svn_fs_fs__rep_contents_dir(apr_array_header_t **entries_p,
   /* find the cache we may use */
   svn_cache__t *cache = locate_dir_cache(fs, &key, &pair_key, noderev,
                                          scratch_pool);
+  svn_boolean_t in_txn = noderev->data_rep
+                      && svn_fs_fs__id_txn_used(&noderev->data_rep->txn_id);
+
+  /* Large in-txn directories may be kept in memory. */
+  if (in_txn)
+    {
+      txn_dir_t *txn_dir;
+      SVN_ERR(get_txn_dir(&txn_dir, fs, noderev, key, scratch_pool));
+      if (txn_dir)
+        {
+          *entries_p = txn_dir_entries(txn_dir, result_pool);
+          return SVN_NO_ERROR;
+        }
+    }
+
   if (cache)
     {
       svn_boolean_t found;
@@ -2882,6 +3155,8 @@ svn_fs_fs__rep_contents_dir(apr_array_header_t **entries_p,
    */
   if (cache && svn_cache__is_cachable(cache, 150 * dir->entries->nelts))
     SVN_ERR(svn_cache__set(cache, key, dir, scratch_pool));
+  else if (in_txn)
+    store_txn_dir(fs, key, dir->entries, dir->txn_filesize);
 
   return SVN_NO_ERROR;
 }
@@ -2896,6 +3171,205 @@ svn_fs_fs__find_dir_entry(apr_array_header_t *entries,
   return result ? *result : NULL;
 }
 
+/* Read LEN bytes from OFFSET in REV_FILE of FS into BUFFER.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+read_at_offset(char *buffer,
+               svn_fs_t *fs,
+               svn_fs_fs__revision_file_t *rev_file,
+               apr_off_t offset,
+               apr_size_t len,
+               apr_pool_t *scratch_pool)
+{
+  SVN_ERR(aligned_seek(fs, rev_file->file, NULL, offset, scratch_pool));
+  SVN_ERR(svn_io_file_read_full2(rev_file->file, buffer, len, NULL, NULL,
+                                 scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the error for a corrupt index in directory ID.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+dir_index_corrupt(const svn_fs_id_t *id,
+                  apr_pool_t *scratch_pool)
+{
+  return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                           _("Directory index corrupt in '%s'"),
+                           svn_fs_fs__id_unparse(id, scratch_pool)->data);
+}
+
+/* Set *OFFSET to the entry offset given in line NUMBER of the directory
+ * index starting at INDEX_START in REV_FILE of FS.  The directory data
+ * starts at DATA_START.  ID is provided for nicer error messages.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+read_dir_index_line(apr_off_t *offset,
+                    svn_fs_t *fs,
+                    svn_fs_fs__revision_file_t *rev_file,
+                    apr_off_t data_start,
+                    apr_off_t index_start,
+                    apr_int64_t number,
+                    const svn_fs_id_t *id,
+                    apr_pool_t *scratch_pool)
+{
+  char line[SVN_FS_FS__DIR_INDEX_LINE_LEN];
+  apr_int64_t value;
+
+  SVN_ERR(read_at_offset(line, fs, rev_file,
+                         index_start + number * SVN_FS_FS__DIR_INDEX_LINE_LEN,
+                         sizeof(line), scratch_pool));
+  if (line[SVN_FS_FS__DIR_INDEX_LINE_LEN - 1] != '\n')
+    return svn_error_trace(dir_index_corrupt(id, scratch_pool));
+
+  line[SVN_FS_FS__DIR_INDEX_LINE_LEN - 1] = '\0';
+  SVN_ERR(svn_cstring_strtoi64(&value, line, 0,
+                               index_start - data_start, 16));
+
+  *offset = data_start + (apr_off_t)value;
+  return SVN_NO_ERROR;
+}
+
+/* Read the next directory entry from REV_FILE into *ENTRY, allocated in
+ * POOL.  ENTRY->KEY will be NULL at the end of the directory.  ID is
+ * provided for nicer error messages. */
+static svn_error_t *
+read_next_dir_entry(svn_hash__entry_t *entry,
+                    svn_fs_fs__revision_file_t *rev_file,
+                    const svn_fs_id_t *id,
+                    apr_pool_t *pool)
+{
+  SVN_ERR_W(svn_hash__read_entry(entry, rev_file->stream,
+                                 SVN_HASH_TERMINATOR, FALSE, pool),
+            apr_psprintf(pool,
+                         _("Directory representation corrupt in '%s'"),
+                         svn_fs_fs__id_unparse(id, pool)->data));
+
+  return SVN_NO_ERROR;
+}
+
+/* If the committed directory NODEREV in FS has been stored with an on-disk
+ * index, use that index to find the entry NAME, return it in *DIRENT and
+ * set *INDEXED to TRUE.  *DIRENT will be NULL if there is no such entry.
+ * Otherwise, set *INDEXED to FALSE and leave *DIRENT untouched.
+ *
+ * This reads only O(log n) blocks instead of the whole directory.
+ * Allocate the result in RESULT_POOL and use SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+lookup_indexed_dir_entry(svn_fs_dirent_t **dirent,
+                         svn_boolean_t *indexed,
+                         svn_fs_t *fs,
+                         node_revision_t *noderev,
+                         const char *name,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool)
+{
+  const apr_size_t prefix_len
+    = sizeof(SVN_FS_FS__DIR_INDEX_FOOTER_PREFIX) - 1;
+  representation_t *rep = noderev->data_rep;
+  svn_fs_fs__revision_file_t *rev_file;
+  svn_fs_fs__rep_header_t *header;
+  char footer[SVN_FS_FS__DIR_INDEX_FOOTER_LEN];
+  apr_off_t offset, data_start, index_start;
+  apr_int64_t count, stride, lower, upper, i;
+  svn_hash__entry_t entry;
+  apr_pool_t *iterpool;
+
+  *indexed = FALSE;
+  if (rep->size < SVN_FS_FS__DIR_INDEX_FOOTER_LEN)
+    return SVN_NO_ERROR;
+
+  /* Only PLAIN reps can be accessed randomly. */
+  SVN_ERR(open_and_seek_revision(&rev_file, fs, rep->revision,
+                                 rep->item_index, scratch_pool));
+  SVN_ERR(svn_io_file_get_offset(&offset, rev_file->file, scratch_pool));
+  SVN_ERR(svn_fs_fs__read_rep_header(&header, rev_file->stream,
+                                     scratch_pool, scratch_pool));
+  if (header->type != svn_fs_fs__rep_plain)
+    return svn_error_trace(svn_fs_fs__close_revision_file(rev_file));
+
+  /* Does the directory data end with an index footer? */
+  data_start = offset + header->header_size;
+  SVN_ERR(read_at_offset(footer, fs, rev_file,
+                         data_start + rep->size - (apr_off_t)sizeof(footer),
+                         sizeof(footer), scratch_pool));
+  if (   strncmp(footer, SVN_FS_FS__DIR_INDEX_FOOTER_PREFIX, prefix_len)
+      || footer[sizeof(footer) - 1] != '\n')
+    return svn_error_trace(svn_fs_fs__close_revision_file(rev_file));
+
+  footer[prefix_len + 8] = '\0';
+  footer[sizeof(footer) - 1] = '\0';
+  SVN_ERR(svn_cstring_strtoi64(&count, footer + prefix_len, 1,
+                               APR_INT32_MAX, 16));
+  SVN_ERR(svn_cstring_strtoi64(&stride, footer + prefix_len + 9, 1,
+                               APR_INT32_MAX, 16));
+
+  index_start = data_start + rep->size - (apr_off_t)sizeof(footer)
+              - count * SVN_FS_FS__DIR_INDEX_LINE_LEN;
+  if (index_start < data_start)
+    return svn_error_trace(dir_index_corrupt(noderev->id, scratch_pool));
+
+  /* Binary search for the last index line whose first entry does not
+   * sort after NAME.  All lines before LOWER qualify, UPPER and all lines
+   * after it don't. */
+  iterpool = svn_pool_create(scratch_pool);
+  lower = 0;
+  upper = count;
+  while (lower < upper)
+    {
+      apr_int64_t middle = lower + (upper - lower) / 2;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(read_dir_index_line(&offset, fs, rev_file, data_start,
+                                  index_start, middle, noderev->id,
+                                  iterpool));
+      SVN_ERR(aligned_seek(fs, rev_file->file, NULL, offset, iterpool));
+      SVN_ERR(read_next_dir_entry(&entry, rev_file, noderev->id, iterpool));
+      if (entry.key == NULL)
+        return svn_error_trace(dir_index_corrupt(noderev->id, scratch_pool));
+
+      if (strcmp(entry.key, name) <= 0)
+        lower = middle + 1;
+      else
+        upper = middle;
+    }
+
+  /* Scan the group of entries that may contain NAME. */
+  *dirent = NULL;
+  if (lower > 0)
+    {
+      SVN_ERR(read_dir_index_line(&offset, fs, rev_file, data_start,
+                                  index_start, lower - 1, noderev->id,
+                                  scratch_pool));
+      SVN_ERR(aligned_seek(fs, rev_file->file, NULL, offset, scratch_pool));
+
+      for (i = 0; i < stride; ++i)
+        {
+          int diff;
+
+          svn_pool_clear(iterpool);
+          SVN_ERR(read_next_dir_entry(&entry, rev_file, noderev->id,
+                                      iterpool));
+          if (entry.key == NULL)
+            break;
+
+          diff = strcmp(entry.key, name);
+          if (diff == 0)
+            SVN_ERR(parse_dir_entry(dirent, &entry, noderev->id,
+                                    result_pool, iterpool));
+          if (diff >= 0)
+            break;
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+
+  *indexed = TRUE;
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__rep_contents_dir_entry(svn_fs_dirent_t **dirent,
                                   svn_fs_t *fs,
@@ -2906,12 +3380,29 @@ svn_fs_fs__rep_contents_dir_entry(svn_fs_dirent_t **dirent,
 {
   extract_dir_entry_baton_t baton;
   svn_boolean_t found = FALSE;
+  svn_boolean_t in_txn = noderev->data_rep
+                      && svn_fs_fs__id_txn_used(&noderev->data_rep->txn_id);
 
   /* find the cache we may use */
   pair_cache_key_t pair_key = { 0 };
   const void *key;
   svn_cache__t *cache = locate_dir_cache(fs, &key, &pair_key, noderev,
                                          scratch_pool);
+
+  /* Large in-txn directories may be kept in memory. */
+  if (in_txn)
+    {
+      txn_dir_t *txn_dir;
+      SVN_ERR(get_txn_dir(&txn_dir, fs, noderev, key, scratch_pool));
+      if (txn_dir)
+        {
+          svn_fs_dirent_t *entry = svn_hash__table_gets(txn_dir->entries,
+                                                        name);
+          *dirent = entry ? copy_dir_entry(entry, result_pool) : NULL;
+          return SVN_NO_ERROR;
+        }
+    }
+
   if (cache)
     {
       svn_filesize_t filesize;
@@ -2929,6 +3420,22 @@ svn_fs_fs__rep_contents_dir_entry(svn_fs_dirent_t **dirent,
                                      result_pool));
     }
 
+  /* Huge directories won't fit into the cache anyway.  If they have an
+   * on-disk index, look up just the entry that we need. */
+  if (   ! found
+      && noderev->data_rep
+      && ! svn_fs_fs__id_txn_used(&noderev->data_rep->txn_id)
+      && (   cache == NULL
+          || ! svn_cache__is_cachable(cache,
+                                      noderev->data_rep->expanded_size)))
+    {
+      svn_boolean_t indexed;
+      SVN_ERR(lookup_indexed_dir_entry(dirent, &indexed, fs, noderev, name,
+                                       result_pool, scratch_pool));
+      if (indexed)
+        return SVN_NO_ERROR;
+    }
+
   /* fetch data from disk if we did not find it in the cache */
   if (! found || baton.out_of_date)
     {
@@ -2947,16 +3454,13 @@ svn_fs_fs__rep_contents_dir_entry(svn_fs_dirent_t **dirent,
        * about right. */
       if (cache && svn_cache__is_cachable(cache, 150 * dir.entries->nelts))
         SVN_ERR(svn_cache__set(cache, key, &dir, scratch_pool));
+      else if (in_txn)
+        store_txn_dir(fs, key, dir.entries, dir.txn_filesize);
 
       /* find desired entry and return a copy in POOL, if found */
       entry = svn_fs_fs__find_dir_entry(dir.entries, name, NULL);
       if (entry)
-        {
-          entry_copy = apr_palloc(result_pool, sizeof(*entry_copy));
-          entry_copy->name = apr_pstrdup(result_pool, entry->name);
-          entry_copy->id = svn_fs_fs__id_copy(entry->id, result_pool);
-          entry_copy->kind = entry->kind;
-        }
+        entry_copy = copy_dir_entry(entry, result_pool);
 
       *dirent = entry_copy;
     }
@@ -3064,6 +3568,7 @@ svn_fs_fs__get_changes(apr_array_header_t **changes,
 {
   apr_off_t item_index = SVN_FS_FS__ITEM_INDEX_CHANGES;
   svn_boolean_t found;
+  svn_boolean_t indexed = FALSE;
   fs_fs_data_t *ffd = context->fs->fsap_data;
   svn_fs_fs__changes_list_t *changes_list;
 
@@ -3083,7 +3588,27 @@ svn_fs_fs__get_changes(apr_array_header_t **changes,
       found = FALSE;
     }
 
+  /* Packed shards may provide the changes in a binary index.  Reading
+   * that is cheap enough to not duplicate its contents in the cache. */
   if (!found)
+    {
+      svn_boolean_t eol;
+      SVN_ERR(svn_fs_fs__read_changes_index(changes, &eol, &indexed,
+                                            context->fs, context->revision,
+                                            context->next,
+                                            SVN_FS_FS__CHANGES_BLOCK_SIZE,
+                                            result_pool, scratch_pool));
+      if (indexed)
+        {
+          changes_list = apr_pcalloc(scratch_pool, sizeof(*changes_list));
+          changes_list->start_offset = context->next_offset;
+          changes_list->end_offset = context->next_offset;
+          changes_list->count = (*changes)->nelts;
+          changes_list->eol = eol;
+        }
+    }
+
+  if (!found && !indexed)
     {
       /* read changes from revision file */
 
@@ -3510,17 +4035,33 @@ read_item(svn_stream_t **stream,
   apr_uint32_t digest;
   svn_checksum_t *expected, *actual;
   apr_uint32_t plain_digest;
+  const char *mapped_data;
 
-  /* Read item into string buffer. */
-  svn_stringbuf_t *text = svn_stringbuf_create_ensure(entry->size, pool);
-  text->len = entry->size;
-  text->data[text->len] = 0;
-  SVN_ERR(svn_io_file_read_full2(rev_file->file, text->data, text->len,
-                                 NULL, NULL, pool));
-
-  /* Return (construct, calculate) stream and checksum. */
-  *stream = svn_stream_from_stringbuf(text, pool);
-  digest = svn__fnv1a_32x4(text->data, text->len);
+  if (svn_fs_fs__rev_file_mapped_data(&mapped_data, rev_file, entry->offset,
+                                      entry->size))
+    {
+      /* The pack file is mapped into memory.  Parse the item in-place
+       * instead of copying it into a buffer first. */
+      svn_string_t *text = apr_palloc(pool, sizeof(*text));
+      text->data = mapped_data;
+      text->len = (apr_size_t)entry->size;
+
+      *stream = svn_stream_from_string(text, pool);
+      digest = svn__fnv1a_32x4(text->data, text->len);
+    }
+  else
+    {
+      /* Read item into string buffer. */
+      svn_stringbuf_t *text = svn_stringbuf_create_ensure(entry->size, pool);
+      text->len = entry->size;
+      text->data[text->len] = 0;
+      SVN_ERR(svn_io_file_read_full2(rev_file->file, text->data, text->len,
+                                     NULL, NULL, pool));
+
+      /* Return (construct, calculate) stream and checksum. */
+      *stream = svn_stream_from_stringbuf(text, pool);
+      digest = svn__fnv1a_32x4(text->data, text->len);
+    }
 
   /* Checksums will match most of the time. */
   if (entry->fnv1_checksum == digest)
@@ -3658,11 +4199,157 @@ block_read_noderev(node_revision_t **noderev_p,
   return SVN_NO_ERROR;
 }
 
+/* Read and cache the item described by ENTRY from REVISION_FILE in FS.
+ * Representation windows starting at or beyond MAX_OFFSET will be
+ * skipped unless MAX_OFFSET is -1.  If IS_RESULT is set, return the item
+ * allocated in RESULT_POOL in *ITEM.  Otherwise, the item will only be
+ * cached and *ITEM remains unchanged.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+block_read_item(void **item,
+                svn_fs_t *fs,
+                svn_fs_fs__revision_file_t *revision_file,
+                svn_fs_fs__p2l_entry_t *entry,
+                apr_off_t max_offset,
+                svn_boolean_t is_result,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_pool_t *pool = is_result ? result_pool : scratch_pool;
+
+  SVN_ERR(svn_io_file_seek(revision_file->file, APR_SET, &entry->offset,
+                           scratch_pool));
+  switch (entry->type)
+    {
+      case SVN_FS_FS__ITEM_TYPE_FILE_REP:
+      case SVN_FS_FS__ITEM_TYPE_DIR_REP:
+      case SVN_FS_FS__ITEM_TYPE_FILE_PROPS:
+      case SVN_FS_FS__ITEM_TYPE_DIR_PROPS:
+        SVN_ERR(block_read_contents(fs, revision_file, entry, max_offset,
+                                    scratch_pool));
+        break;
+
+      case SVN_FS_FS__ITEM_TYPE_NODEREV:
+        if (ffd->node_revision_cache || is_result)
+          SVN_ERR(block_read_noderev((node_revision_t **)item, fs,
+                                     revision_file, entry, is_result, pool,
+                                     scratch_pool));
+        break;
+
+      case SVN_FS_FS__ITEM_TYPE_CHANGES:
+        SVN_ERR(block_read_changes(fs, revision_file, entry, scratch_pool));
+        break;
+
+      default:
+        break;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Number of consecutive block_read() calls that must hit the same or the
+ * directly following block before we consider the access pattern to be
+ * sequential and start reading ahead. */
+#define SEQUENTIAL_READ_THRESHOLD 2
+
+/* Update the access pattern statistics in FS for a block_read() covering
+ * BLOCK_START up to END_OFFSET in REVISION_FILE.  Return the number of
+ * blocks that we should read ahead, i.e. 0 unless the access pattern looks
+ * sequential. */
+static int
+block_read_ahead_count(svn_fs_t *fs,
+                       svn_fs_fs__revision_file_t *revision_file,
+                       apr_off_t block_start,
+                       apr_off_t end_offset)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  /* Reading the same or the next block(s) in the same file again? */
+  if (   ffd->block_read_file == revision_file->start_revision
+      && block_start >= ffd->block_read_start
+      && block_start <= ffd->block_read_end)
+    ++ffd->sequential_block_reads;
+  else
+    ffd->sequential_block_reads = 0;
+
+  ffd->block_read_file = revision_file->start_revision;
+  ffd->block_read_start = block_start;
+  ffd->block_read_end = end_offset;
+
+  return ffd->sequential_block_reads >= SEQUENTIAL_READ_THRESHOLD
+       ? ffd->block_read_ahead
+       : 0;
+}
+
+/* Read up to COUNT blocks following the block that ends at BLOCK_END from
+ * REVISION_FILE in FS and put all data that fully fits into those blocks
+ * into the cache.  REVISION is any revision in REVISION_FILE.  Set
+ * *READ_END to the end of the data range read.  Stop early at the end
+ * of the file.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+block_read_ahead(apr_off_t *read_end,
+                 svn_fs_t *fs,
+                 svn_revnum_t revision,
+                 svn_fs_fs__revision_file_t *revision_file,
+                 apr_off_t block_end,
+                 int count,
+                 apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_off_t max_offset;
+  apr_off_t block_start;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int k, i;
+
+  SVN_ERR(svn_fs_fs__p2l_get_max_offset(&max_offset, fs, revision_file,
+                                        revision, scratch_pool));
+
+  for (k = 0, block_start = block_end;
+       k < count && block_start < max_offset;
+       ++k, block_start += ffd->block_size)
+    {
+      apr_array_header_t *entries;
+      apr_off_t offset = block_start;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_fs__p2l_index_lookup(&entries, fs, revision_file,
+                                          revision, block_start,
+                                          ffd->block_size, iterpool,
+                                          iterpool));
+      SVN_ERR(aligned_seek(fs, revision_file->file, &offset, offset,
+                           iterpool));
+
+      /* Only read what starts in this block and is reasonably small. */
+      for (i = 0; i < entries->nelts; ++i)
+        {
+          svn_fs_fs__p2l_entry_t *entry
+            = &APR_ARRAY_IDX(entries, i, svn_fs_fs__p2l_entry_t);
+
+          if (   entry->type != SVN_FS_FS__ITEM_TYPE_UNUSED
+              && entry->offset >= block_start
+              && entry->size < ffd->block_size)
+            SVN_ERR(block_read_item(NULL, fs, revision_file, entry,
+                                    block_start + ffd->block_size, FALSE,
+                                    iterpool, iterpool));
+        }
+    }
+
+  ffd->blocks_read_ahead += k;
+  *read_end = block_start;
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* Read the whole (e.g. 64kB) block containing ITEM_INDEX of REVISION in FS
  * and put all data into cache.  If necessary and depending on heuristics,
- * neighboring blocks may also get read.  The data is being read from
- * already open REVISION_FILE, which must be the correct rev / pack file
- * w.r.t. REVISION.
+ * neighboring blocks may also get read.  Once the access pattern looks
+ * sequential, the next few blocks will be read and cached as well.  The
+ * data is being read from already open REVISION_FILE, which must be the
+ * correct rev / pack file w.r.t. REVISION.
  *
  * For noderevs and changed path lists, the item fetched can be allocated
  * RESULT_POOL and returned in *RESULT.  Otherwise, RESULT must be NULL.
@@ -3679,8 +4366,10 @@ block_read(void **result,
   fs_fs_data_t *ffd = fs->fsap_data;
   apr_off_t offset, wanted_offset = 0;
   apr_off_t block_start = 0;
+  apr_off_t first_block_start;
   apr_array_header_t *entries;
   int run_count = 0;
+  int read_ahead;
   int i;
   apr_pool_t *iterpool;
 
@@ -3700,6 +4389,7 @@ block_read(void **result,
                                  revision, NULL, item_index, iterpool));
 
   offset = wanted_offset;
+  first_block_start = offset - (offset % ffd->block_size);
 
   /* Heuristics:
    *
@@ -3725,7 +4415,6 @@ block_read(void **result,
       for (i = 0; i < entries->nelts; ++i)
         {
           svn_boolean_t is_result, is_wanted;
-          apr_pool_t *pool;
           svn_fs_fs__p2l_entry_t* entry;
 
           svn_pool_clear(iterpool);
@@ -3741,9 +4430,6 @@ block_read(void **result,
                       && entry->item.number == item_index;
           is_result = result && is_wanted;
 
-          /* select the pool that we want the item to be allocated in */
-          pool = is_result ? result_pool : iterpool;
-
           /* handle all items that start within this block and are relatively
            * small (i.e. < block size).  Always read the item we need to return.
            */
@@ -3751,37 +4437,11 @@ block_read(void **result,
                             && entry->size < ffd->block_size))
             {
               void *item = NULL;
-              SVN_ERR(svn_io_file_seek(revision_file->file, APR_SET,
-                                       &entry->offset, iterpool));
-              switch (entry->type)
-                {
-                  case SVN_FS_FS__ITEM_TYPE_FILE_REP:
-                  case SVN_FS_FS__ITEM_TYPE_DIR_REP:
-                  case SVN_FS_FS__ITEM_TYPE_FILE_PROPS:
-                  case SVN_FS_FS__ITEM_TYPE_DIR_PROPS:
-                    SVN_ERR(block_read_contents(fs, revision_file, entry,
-                                                is_wanted
-                                                  ? -1
-                                                  : block_start + ffd->block_size,
-                                                iterpool));
-                    break;
-
-                  case SVN_FS_FS__ITEM_TYPE_NODEREV:
-                    if (ffd->node_revision_cache || is_result)
-                      SVN_ERR(block_read_noderev((node_revision_t **)&item,
-                                                 fs, revision_file,
-                                                 entry, is_result, pool,
-                                                 iterpool));
-                    break;
-
-                  case SVN_FS_FS__ITEM_TYPE_CHANGES:
-                    SVN_ERR(block_read_changes(fs, revision_file,
-                                               entry, iterpool));
-                    break;
-
-                  default:
-                    break;
-                }
+              SVN_ERR(block_read_item(&item, fs, revision_file, entry,
+                                      is_wanted
+                                        ? -1
+                                        : block_start + ffd->block_size,
+                                      is_result, result_pool, iterpool));
 
               if (is_result)
                 *result = item;
@@ -3800,6 +4460,21 @@ block_read(void **result,
 
   /* if the caller requested a result, we must have provided one by now */
   assert(!result || *result);
+
+  /* Sequential access, e.g. during export or verify?  Then there will
+   * soon be requests for the following blocks as well.  Fetch them now
+   * in one go instead of seeking back and forth between the rev / pack
+   * file and its index for every single block. */
+  offset = block_start + ffd->block_size;
+  read_ahead = block_read_ahead_count(fs, revision_file, first_block_start,
+                                      offset);
+  if (read_ahead)
+    {
+      SVN_ERR(block_read_ahead(&offset, fs, revision, revision_file, offset,
+                               read_ahead, iterpool));
+      ffd->block_read_end = offset;
+    }
+
   svn_pool_destroy(iterpool);
 
   return SVN_NO_ERROR;
@@ -161,6 +161,33 @@ svn_fs_fs__rep_contents_dir_entry(svn_fs_dirent_t **dirent,
                                   apr_pool_t *result_pool,
                                   apr_pool_t *scratch_pool);
 
+/* If the directory with noderev ID in the current transaction of FS is
+   too large for the txn directory cache, keep a copy of its sorted ENTRIES
+   in memory.  TXN_FILESIZE is the current size of the directory's children
+   file.  Use SCRATCH_POOL for temporary allocations. */
+void
+svn_fs_fs__set_txn_dir(svn_fs_t *fs,
+                       const svn_fs_id_t *id,
+                       apr_array_header_t *entries,
+                       svn_filesize_t txn_filesize,
+                       apr_pool_t *scratch_pool);
+
+/* Apply the change of entry NAME to the in-memory copy of the directory
+   with noderev ID in the current transaction of FS, if there is such a
+   copy.  CHILD_ID and KIND describe the new entry; a NULL CHILD_ID removes
+   NAME.  OLD_FILESIZE and NEW_FILESIZE are the sizes of the directory's
+   children file before and after the change.  Use SCRATCH_POOL for
+   temporary allocations. */
+void
+svn_fs_fs__update_txn_dir(svn_fs_t *fs,
+                          const svn_fs_id_t *id,
+                          const char *name,
+                          const svn_fs_id_t *child_id,
+                          svn_node_kind_t kind,
+                          svn_filesize_t old_filesize,
+                          svn_filesize_t new_filesize,
+                          apr_pool_t *scratch_pool);
+
 /* Set *PROPLIST to be an apr_hash_t containing the property list of
    node-revision NODEREV as seen in filesystem FS.  Use POOL for
    temporary allocations. */
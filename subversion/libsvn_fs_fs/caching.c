@@ -26,6 +26,7 @@
 #include "dag.h"
 #include "tree.h"
 #include "index.h"
+#include "changes_index.h"
 #include "temp_serializer.h"
 #include "../libsvn_fs/fs-loader.h"
 
@@ -351,8 +352,14 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                              apr_pool_t *pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
+
+  /* Copies of a repository share its UUID and may even get put in place of
+   * the original.  Include the instance ID such that a repository replaced
+   * by e.g. a hotcopy does not see the cache entries of the old one.  This
+   * matters for packed revprops, whose keys survive sync barriers. */
   const char *prefix = apr_pstrcat(pool,
                                    "fsfs:", fs->uuid,
+                                   "/", ffd->instance_id,
                                    "/", normalize_key_part(fs->path, pool),
                                    ":",
                                    SVN_VA_NULL);
@@ -375,7 +382,9 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
   prefix = apr_pstrcat(pool, "ns:", cache_namespace, ":", prefix, SVN_VA_NULL);
   has_namespace = strlen(cache_namespace) > 0;
 
-  membuffer = svn_cache__get_global_membuffer_cache();
+  membuffer = ffd->no_membuffer
+            ? NULL
+            : svn_cache__get_global_membuffer_cache();
 
   /* General rules for assigning cache priorities:
    *
@@ -515,6 +524,22 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                        no_handler,
                        fs->pool, pool));
 
+  /* initialize the changes index cache, if caching has been enabled */
+  SVN_ERR(create_cache(&(ffd->changes_index_cache),
+                       NULL,
+                       membuffer,
+                       4, 1, /* Large entries. Rarely used. */
+                       svn_fs_fs__serialize_changes_index,
+                       svn_fs_fs__deserialize_changes_index,
+                       sizeof(svn_revnum_t),
+                       apr_pstrcat(pool, prefix, "CHANGES_INDEX",
+                                   SVN_VA_NULL),
+                       0,
+                       has_namespace,
+                       fs,
+                       no_handler,
+                       fs->pool, pool));
+
   /* if enabled, cache revprops */
   SVN_ERR(create_cache(&(ffd->revprop_cache),
                        NULL,
@@ -839,6 +864,7 @@ svn_fs_fs__initialize_txn_caches(svn_fs_t *fs,
   if (ffd->txn_dir_cache != NULL || ffd->concurrent_transactions)
     {
       ffd->txn_dir_cache = NULL;
+      ffd->txn_dirs = NULL;
       ffd->concurrent_transactions = TRUE;
 
       return SVN_NO_ERROR;
@@ -882,6 +908,10 @@ svn_fs_fs__initialize_txn_caches(svn_fs_t *fs,
                        TRUE,
                        pool, pool));
 
+  /* Directories too large for the cache above.  This gets dropped
+   * together with TXN_DIR_CACHE. */
+  ffd->txn_dirs = svn_hash__table_make(16, pool);
+
   /* reset the transaction-specific cache if the pool gets cleaned up. */
   init_txn_callbacks(fs, &(ffd->txn_dir_cache), pool);
 
@@ -896,4 +926,5 @@ svn_fs_fs__reset_txn_caches(svn_fs_t *fs)
 
   fs_fs_data_t *ffd = fs->fsap_data;
   ffd->txn_dir_cache = NULL;
+  ffd->txn_dirs = NULL;
 }
@@ -0,0 +1,910 @@
+/* changes_index.c --- binary index of the changed paths lists in a pack
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include "svn_pools.h"
+#include "svn_hash.h"
+#include "svn_dirent_uri.h"
+#include "svn_sorts.h"
+#include "private/svn_sorts_private.h"
+#include "private/svn_subr_private.h"
+#include "private/svn_temp_serializer.h"
+
+#include "changes_index.h"
+#include "cached_data.h"
+#include "id.h"
+#include "util.h"
+
+#include "svn_private_config.h"
+
+/* The index file is a single svn__compress_zlib() block.  All numbers in
+ * the uncompressed data are 7b/8b encoded, see svn__encode_uint():
+ *
+ *   <first rev> <rev count> <block size> <path count>
+ *   <path count> x <prefix len> <suffix len> <suffix>
+ *   <rev count> x <change count> <block offset>*
+ *   <records len> <records>
+ *
+ * Paths are sorted and front-coded, i.e. each path only stores the part
+ * that differs from its predecessor.  For every revision, we store the
+ * offset of every BLOCK SIZE'th change record within RECORDS such that
+ * readers can fetch changes lists in blocks without decoding the entries
+ * before them.  There is at least one block offset per revision.
+ *
+ * Each change record is
+ *
+ *   <path idx> <flags> [<copyfrom rev> <copyfrom path idx>] <id len> <id>
+ *
+ * The copyfrom info is only present if FLAG_HAS_COPYFROM has been set.
+ * ID is the unparsed noderev ID and empty if the change has none.  Bits
+ * 0..2 of FLAGS contain the change kind, bits 3..5 the node kind and bits
+ * 8..9 the mergeinfo mod value relative to svn_tristate_false.
+ */
+
+#define FLAG_NODE_KIND_SHIFT    3
+#define FLAG_TEXT_MOD           0x040
+#define FLAG_PROP_MOD           0x080
+#define FLAG_MERGEINFO_SHIFT    8
+#define FLAG_COPYFROM_KNOWN     0x400
+#define FLAG_HAS_COPYFROM       0x800
+
+/* The contents of the changes index of a single shard.  All arrays are
+ * flat, so we can easily put the whole struct into a cache. */
+typedef struct changes_index_t
+{
+  /* First revision of the shard. */
+  svn_revnum_t start_rev;
+
+  /* Whether the shard has a changes index at all.  If FALSE, all further
+   * members are 0 or NULL. */
+  svn_boolean_t found;
+
+  /* Number of revisions in the shard. */
+  apr_size_t rev_count;
+
+  /* Number of changes per block. */
+  apr_size_t block_size;
+
+  /* All paths referenced by the records, concatenated in PATH_DATA.
+   * Path I spans PATH_OFFSETS[I] up to PATH_OFFSETS[I+1]. */
+  apr_size_t path_count;
+  apr_size_t *path_offsets;
+  const char *path_data;
+
+  /* Number of entries in the changed paths list of each revision,
+   * REV_COUNT entries. */
+  apr_size_t *change_counts;
+
+  /* Offsets of each block of entries within RECORDS.  The blocks of
+   * revision I start at index FIRST_BLOCK[I] in BLOCKS.  FIRST_BLOCK
+   * has REV_COUNT + 1 entries. */
+  apr_size_t *first_block;
+  apr_size_t *blocks;
+
+  /* The change records section of the uncompressed index data. */
+  const unsigned char *records;
+  apr_size_t records_len;
+} changes_index_t;
+
+/* Append the 7b/8b encoded VALUE to BUFFER. */
+static void
+append_uint(svn_stringbuf_t *buffer,
+            apr_uint64_t value)
+{
+  unsigned char bytes[SVN__MAX_ENCODED_UINT_LEN];
+  unsigned char *end = svn__encode_uint(bytes, value);
+
+  svn_stringbuf_appendbytes(buffer, (const char *)bytes, end - bytes);
+}
+
+/* Return a "corrupt index" error for the changes index containing
+ * REVISION. */
+static svn_error_t *
+corrupt_index(svn_revnum_t revision)
+{
+  return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                           _("Corrupt changes index for revision %ld"),
+                           revision);
+}
+
+/* Decode the next number from *P into *VALUE and advance *P.  END is
+ * the end of the data buffer and REVISION is used for error reporting.
+ */
+static svn_error_t *
+read_uint(apr_uint64_t *value,
+          const unsigned char **p,
+          const unsigned char *end,
+          svn_revnum_t revision)
+{
+  *p = svn__decode_uint(value, *p, end);
+  if (*p == NULL)
+    return svn_error_trace(corrupt_index(revision));
+
+  return SVN_NO_ERROR;
+}
+
+/* Like read_uint but also verify that *VALUE is less than LIMIT. */
+static svn_error_t *
+read_limited(apr_size_t *value,
+             const unsigned char **p,
+             const unsigned char *end,
+             apr_uint64_t limit,
+             svn_revnum_t revision)
+{
+  apr_uint64_t temp;
+
+  SVN_ERR(read_uint(&temp, p, end, revision));
+  if (temp >= limit)
+    return svn_error_trace(corrupt_index(revision));
+
+  *value = (apr_size_t)temp;
+  return SVN_NO_ERROR;
+}
+
+/* Container used while building the index. */
+typedef struct index_builder_t
+{
+  /* Maps const char * paths to apr_size_t * path indexes. */
+  apr_hash_t *path_ids;
+
+  /* svn_string_t *, in order of their path indexes. */
+  apr_array_header_t *paths;
+
+  /* Change records using the preliminary path indexes of PATH_IDS. */
+  svn_stringbuf_t *records;
+
+  /* Number of changes in each revision (apr_size_t). */
+  apr_array_header_t *counts;
+
+  /* Allocate PATHS, PATH_IDS and their contents here. */
+  apr_pool_t *pool;
+} index_builder_t;
+
+/* Return the preliminary index of PATH of length LEN in BUILDER,
+ * adding it if necessary. */
+static apr_size_t
+intern_path(index_builder_t *builder,
+            const char *path,
+            apr_size_t len)
+{
+  apr_size_t *id = apr_hash_get(builder->path_ids, path, len);
+  if (id == NULL)
+    {
+      svn_string_t *copy = svn_string_ncreate(path, len, builder->pool);
+
+      id = apr_palloc(builder->pool, sizeof(*id));
+      *id = builder->paths->nelts;
+      APR_ARRAY_PUSH(builder->paths, svn_string_t *) = copy;
+      apr_hash_set(builder->path_ids, copy->data, copy->len, id);
+    }
+
+  return *id;
+}
+
+/* Append the record for CHANGE to BUILDER.
+ * Use SCRATCH_POOL for temporary allocations. */
+static void
+add_change(index_builder_t *builder,
+           const change_t *change,
+           apr_pool_t *scratch_pool)
+{
+  const svn_fs_path_change2_t *info = &change->info;
+  apr_uint64_t flags
+    = (apr_uint64_t)info->change_kind
+    | ((apr_uint64_t)info->node_kind << FLAG_NODE_KIND_SHIFT)
+    | ((apr_uint64_t)(info->mergeinfo_mod - svn_tristate_false)
+         << FLAG_MERGEINFO_SHIFT);
+
+  if (info->text_mod)
+    flags |= FLAG_TEXT_MOD;
+  if (info->prop_mod)
+    flags |= FLAG_PROP_MOD;
+  if (info->copyfrom_known)
+    flags |= FLAG_COPYFROM_KNOWN;
+  if (info->copyfrom_path)
+    flags |= FLAG_HAS_COPYFROM;
+
+  append_uint(builder->records,
+              intern_path(builder, change->path.data, change->path.len));
+  append_uint(builder->records, flags);
+
+  if (info->copyfrom_path)
+    {
+      append_uint(builder->records, info->copyfrom_rev);
+      append_uint(builder->records,
+                  intern_path(builder, info->copyfrom_path,
+                              strlen(info->copyfrom_path)));
+    }
+
+  if (info->node_rev_id)
+    {
+      svn_string_t *id = svn_fs_fs__id_unparse(info->node_rev_id,
+                                               scratch_pool);
+      append_uint(builder->records, id->len);
+      svn_stringbuf_appendbytes(builder->records, id->data, id->len);
+    }
+  else
+    {
+      append_uint(builder->records, 0);
+    }
+}
+
+/* Sort function ordering svn_string_t * elements by their contents. */
+static int
+compare_paths(const void *lhs,
+              const void *rhs)
+{
+  const svn_string_t *lhs_path = *(const svn_string_t * const *)lhs;
+  const svn_string_t *rhs_path = *(const svn_string_t * const *)rhs;
+  apr_size_t len = MIN(lhs_path->len, rhs_path->len);
+  int diff = memcmp(lhs_path->data, rhs_path->data, len);
+
+  if (diff)
+    return diff;
+
+  return lhs_path->len < rhs_path->len ? -1
+       : lhs_path->len > rhs_path->len ? 1 : 0;
+}
+
+/* Copy the change record at *P to OUTPUT, replacing its preliminary path
+ * indexes with their final values in REMAP.  Advance *P to the next
+ * record.  END is the end of the records section.  Since we produced the
+ * data ourselves, REVISION will only be used for error reporting.
+ */
+static svn_error_t *
+remap_record(svn_stringbuf_t *output,
+             const unsigned char **p,
+             const unsigned char *end,
+             const apr_size_t *remap,
+             svn_revnum_t revision)
+{
+  apr_uint64_t value, flags;
+
+  SVN_ERR(read_uint(&value, p, end, revision));
+  append_uint(output, remap[value]);
+  SVN_ERR(read_uint(&flags, p, end, revision));
+  append_uint(output, flags);
+
+  if (flags & FLAG_HAS_COPYFROM)
+    {
+      SVN_ERR(read_uint(&value, p, end, revision));
+      append_uint(output, value);
+      SVN_ERR(read_uint(&value, p, end, revision));
+      append_uint(output, remap[value]);
+    }
+
+  SVN_ERR(read_uint(&value, p, end, revision));
+  append_uint(output, value);
+  svn_stringbuf_appendbytes(output, (const char *)*p, (apr_size_t)value);
+  *p += value;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__write_changes_index(svn_fs_t *fs,
+                               const char *pack_file_dir,
+                               svn_revnum_t shard_rev,
+                               int shard_size,
+                               svn_io__batch_fsync_t *batch,
+                               svn_cancel_func_t cancel_func,
+                               void *cancel_baton,
+                               apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_pool_t *block_pool = svn_pool_create(scratch_pool);
+  index_builder_t builder;
+  apr_array_header_t *sorted;
+  apr_size_t *remap;
+  svn_stringbuf_t *content, *compressed;
+  svn_string_t *previous = NULL;
+  const unsigned char *p, *end;
+  apr_file_t *file;
+  const char *path;
+  int i;
+
+  builder.path_ids = svn_hash__make(scratch_pool);
+  builder.paths = apr_array_make(scratch_pool, 256, sizeof(svn_string_t *));
+  builder.records = svn_stringbuf_create_ensure(0x10000, scratch_pool);
+  builder.counts = apr_array_make(scratch_pool, shard_size,
+                                  sizeof(apr_size_t));
+  builder.pool = scratch_pool;
+
+  /* Collect all changes of the shard.  Paths get numbered in order of
+   * appearance for now. */
+  for (i = 0; i < shard_size; ++i)
+    {
+      svn_fs_fs__changes_context_t *context;
+      apr_size_t count = 0;
+
+      svn_pool_clear(iterpool);
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_ERR(svn_fs_fs__create_changes_context(&context, fs,
+                                                shard_rev + i, iterpool));
+      while (!context->eol)
+        {
+          apr_array_header_t *changes;
+          int k;
+
+          svn_pool_clear(block_pool);
+          SVN_ERR(svn_fs_fs__get_changes(&changes, context, block_pool,
+                                         block_pool));
+          for (k = 0; k < changes->nelts; ++k)
+            add_change(&builder, APR_ARRAY_IDX(changes, k, change_t *),
+                       block_pool);
+
+          count += changes->nelts;
+        }
+
+      APR_ARRAY_PUSH(builder.counts, apr_size_t) = count;
+    }
+
+  svn_pool_destroy(block_pool);
+
+  /* Sort the paths to maximize the prefix sharing between neighbours. */
+  sorted = apr_array_copy(scratch_pool, builder.paths);
+  svn_sort__array(sorted, compare_paths);
+
+  remap = apr_palloc(scratch_pool, sorted->nelts * sizeof(*remap));
+  for (i = 0; i < sorted->nelts; ++i)
+    {
+      svn_string_t *path_str = APR_ARRAY_IDX(sorted, i, svn_string_t *);
+      apr_size_t *id = apr_hash_get(builder.path_ids, path_str->data,
+                                    path_str->len);
+      remap[*id] = i;
+    }
+
+  /* Header and front-coded path list. */
+  content = svn_stringbuf_create_ensure(builder.records->len + 0x1000,
+                                        scratch_pool);
+  append_uint(content, shard_rev);
+  append_uint(content, shard_size);
+  append_uint(content, SVN_FS_FS__CHANGES_BLOCK_SIZE);
+  append_uint(content, sorted->nelts);
+
+  for (i = 0; i < sorted->nelts; ++i)
+    {
+      svn_string_t *path_str = APR_ARRAY_IDX(sorted, i, svn_string_t *);
+      apr_size_t prefix = 0;
+
+      if (previous)
+        while (   prefix < previous->len
+               && prefix < path_str->len
+               && previous->data[prefix] == path_str->data[prefix])
+          ++prefix;
+
+      append_uint(content, prefix);
+      append_uint(content, path_str->len - prefix);
+      svn_stringbuf_appendbytes(content, path_str->data + prefix,
+                                path_str->len - prefix);
+      previous = path_str;
+    }
+
+  /* Rewrite the records with the final path indexes.  The record sizes
+   * may change, so determine the block offsets along the way. */
+  {
+    svn_stringbuf_t *records = svn_stringbuf_create_ensure(
+                                 builder.records->len, scratch_pool);
+    svn_stringbuf_t *revs = svn_stringbuf_create_empty(scratch_pool);
+
+    p = (const unsigned char *)builder.records->data;
+    end = p + builder.records->len;
+
+    for (i = 0; i < builder.counts->nelts; ++i)
+      {
+        apr_size_t count = APR_ARRAY_IDX(builder.counts, i, apr_size_t);
+        apr_size_t k;
+
+        append_uint(revs, count);
+        if (count == 0)
+          append_uint(revs, records->len);
+
+        for (k = 0; k < count; ++k)
+          {
+            if (k % SVN_FS_FS__CHANGES_BLOCK_SIZE == 0)
+              append_uint(revs, records->len);
+
+            SVN_ERR(remap_record(records, &p, end, remap, shard_rev + i));
+          }
+      }
+
+    svn_stringbuf_appendstr(content, revs);
+    append_uint(content, records->len);
+    svn_stringbuf_appendstr(content, records);
+  }
+
+  /* Write the index file. */
+  compressed = svn_stringbuf_create_empty(scratch_pool);
+  SVN_ERR(svn__compress_zlib(content->data, content->len, compressed,
+                             SVN__COMPRESSION_ZLIB_DEFAULT));
+
+  path = svn_dirent_join(pack_file_dir, PATH_CHANGES_INDEX, scratch_pool);
+  SVN_ERR(svn_io__batch_fsync_open_file(&file, batch, path,
+                                        scratch_pool));
+  SVN_ERR(svn_io_file_write_full(file, compressed->data, compressed->len,
+                                 NULL, scratch_pool));
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Parse the uncompressed index DATA of the shard starting at START_REV
+ * into INDEX.  Allocate the results in RESULT_POOL. */
+static svn_error_t *
+parse_index(changes_index_t *index,
+            svn_stringbuf_t *data,
+            svn_revnum_t start_rev,
+            apr_pool_t *result_pool)
+{
+  const unsigned char *p = (const unsigned char *)data->data;
+  const unsigned char *end = p + data->len;
+  svn_stringbuf_t *path_data;
+  apr_array_header_t *blocks;
+  apr_uint64_t value;
+  apr_size_t i;
+
+  SVN_ERR(read_uint(&value, &p, end, start_rev));
+  if (value != (apr_uint64_t)start_rev)
+    return svn_error_trace(corrupt_index(start_rev));
+
+  /* There is at most one change record per byte. */
+  SVN_ERR(read_limited(&index->rev_count, &p, end, data->len, start_rev));
+  SVN_ERR(read_limited(&index->block_size, &p, end, data->len, start_rev));
+  SVN_ERR(read_limited(&index->path_count, &p, end, data->len, start_rev));
+  if (index->block_size == 0)
+    return svn_error_trace(corrupt_index(start_rev));
+
+  /* Expand the front-coded paths. */
+  path_data = svn_stringbuf_create_ensure(data->len, result_pool);
+  index->path_offsets = apr_palloc(result_pool,
+                                   (index->path_count + 1)
+                                   * sizeof(*index->path_offsets));
+  index->path_offsets[0] = 0;
+  for (i = 0; i < index->path_count; ++i)
+    {
+      apr_size_t prefix, suffix;
+      apr_size_t previous = i ? index->path_offsets[i-1] : 0;
+
+      SVN_ERR(read_limited(&prefix, &p, end,
+                           index->path_offsets[i] - previous + 1,
+                           start_rev));
+      SVN_ERR(read_limited(&suffix, &p, end, end - p + 1, start_rev));
+
+      /* Make sure that appending won't move the previous path. */
+      svn_stringbuf_ensure(path_data, path_data->len + prefix + suffix + 1);
+      svn_stringbuf_appendbytes(path_data, path_data->data + previous,
+                                prefix);
+      svn_stringbuf_appendbytes(path_data, (const char *)p, suffix);
+      p += suffix;
+
+      index->path_offsets[i+1] = path_data->len;
+    }
+
+  index->path_data = path_data->data;
+
+  /* Block tables. */
+  index->change_counts = apr_palloc(result_pool,
+                                    index->rev_count
+                                    * sizeof(*index->change_counts));
+  index->first_block = apr_palloc(result_pool,
+                                  (index->rev_count + 1)
+                                  * sizeof(*index->first_block));
+  blocks = apr_array_make(result_pool, (int)index->rev_count,
+                          sizeof(apr_size_t));
+  for (i = 0; i < index->rev_count; ++i)
+    {
+      apr_size_t k, count, block_count;
+
+      SVN_ERR(read_limited(&count, &p, end, data->len, start_rev));
+      block_count = MAX(1, (count + index->block_size - 1)
+                           / index->block_size);
+
+      index->change_counts[i] = count;
+      index->first_block[i] = blocks->nelts;
+      for (k = 0; k < block_count; ++k)
+        SVN_ERR(read_limited(&APR_ARRAY_PUSH(blocks, apr_size_t), &p, end,
+                             data->len, start_rev));
+    }
+
+  index->first_block[index->rev_count] = blocks->nelts;
+  index->blocks = (apr_size_t *)blocks->elts;
+
+  /* Change records. */
+  SVN_ERR(read_limited(&index->records_len, &p, end, end - p + 1,
+                       start_rev));
+  if (p + index->records_len != end)
+    return svn_error_trace(corrupt_index(start_rev));
+
+  for (i = 0; i < (apr_size_t)blocks->nelts; ++i)
+    if (index->blocks[i] > index->records_len)
+      return svn_error_trace(corrupt_index(start_rev));
+
+  index->records = p;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *INDEX to the changes index for the shard containing the packed
+ * REVISION in FS.  Allocate it in RESULT_POOL and use SCRATCH_POOL for
+ * temporary allocations.
+ */
+static svn_error_t *
+read_index(changes_index_t **index,
+           svn_fs_t *fs,
+           svn_revnum_t revision,
+           apr_pool_t *result_pool,
+           apr_pool_t *scratch_pool)
+{
+  changes_index_t *result = apr_pcalloc(result_pool, sizeof(*result));
+  svn_stringbuf_t *compressed;
+  svn_stringbuf_t *data;
+  const char *path;
+  svn_error_t *err;
+
+  result->start_rev = svn_fs_fs__packed_base_rev(fs, revision);
+  result->found = FALSE;
+  *index = result;
+
+  path = svn_fs_fs__path_rev_packed(fs, revision, PATH_CHANGES_INDEX,
+                                    scratch_pool);
+  err = svn_stringbuf_from_file2(&compressed, path, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      /* Shards packed without the index. */
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  data = svn_stringbuf_create_empty(result_pool);
+  SVN_ERR(svn__decompress_zlib(compressed->data, compressed->len, data,
+                               APR_SIZE_MAX));
+  SVN_ERR(parse_index(result, data, result->start_rev, result_pool));
+  result->found = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__serialize_changes_index(void **data,
+                                   apr_size_t *data_len,
+                                   void *in,
+                                   apr_pool_t *pool)
+{
+  changes_index_t *index = in;
+  svn_temp_serializer__context_t *context;
+  svn_stringbuf_t *serialized;
+  apr_size_t path_offsets_size = 0;
+  apr_size_t path_data_size = 0;
+  apr_size_t first_block_size = 0;
+  apr_size_t blocks_size = 0;
+  apr_size_t change_counts_size
+    = index->rev_count * sizeof(*index->change_counts);
+
+  if (index->found)
+    {
+      path_offsets_size
+        = (index->path_count + 1) * sizeof(*index->path_offsets);
+      path_data_size = index->path_offsets[index->path_count];
+      first_block_size
+        = (index->rev_count + 1) * sizeof(*index->first_block);
+      blocks_size
+        = index->first_block[index->rev_count] * sizeof(*index->blocks);
+    }
+
+  /* serialize struct and all its elements */
+  context = svn_temp_serializer__init(index, sizeof(*index),
+                                      sizeof(*index) + path_offsets_size
+                                      + path_data_size + change_counts_size
+                                      + first_block_size + blocks_size
+                                      + index->records_len + 64,
+                                      pool);
+
+  svn_temp_serializer__add_leaf(context,
+                                (const void * const *)&index->path_offsets,
+                                path_offsets_size);
+  svn_temp_serializer__add_leaf(context,
+                                (const void * const *)&index->path_data,
+                                path_data_size);
+  svn_temp_serializer__add_leaf(context,
+                                (const void * const *)&index->change_counts,
+                                change_counts_size);
+  svn_temp_serializer__add_leaf(context,
+                                (const void * const *)&index->first_block,
+                                first_block_size);
+  svn_temp_serializer__add_leaf(context,
+                                (const void * const *)&index->blocks,
+                                blocks_size);
+  svn_temp_serializer__add_leaf(context,
+                                (const void * const *)&index->records,
+                                index->records_len);
+
+  /* return the serialized result */
+  serialized = svn_temp_serializer__get(context);
+
+  *data = serialized->data;
+  *data_len = serialized->len;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__deserialize_changes_index(void **out,
+                                     void *data,
+                                     apr_size_t data_len,
+                                     apr_pool_t *pool)
+{
+  changes_index_t *index = data;
+
+  /* resolve the pointers in the struct */
+  svn_temp_deserializer__resolve(index, (void**)&index->path_offsets);
+  svn_temp_deserializer__resolve(index, (void**)&index->path_data);
+  svn_temp_deserializer__resolve(index, (void**)&index->change_counts);
+  svn_temp_deserializer__resolve(index, (void**)&index->first_block);
+  svn_temp_deserializer__resolve(index, (void**)&index->blocks);
+  svn_temp_deserializer__resolve(index, (void**)&index->records);
+
+  /* done */
+  *out = index;
+
+  return SVN_NO_ERROR;
+}
+
+/* Return path number I from INDEX, allocated in RESULT_POOL.  If LEN is
+ * not NULL, set *LEN to the length of the path. */
+static const char *
+get_path(apr_size_t *len,
+         const changes_index_t *index,
+         apr_size_t i,
+         apr_pool_t *result_pool)
+{
+  apr_size_t path_len = index->path_offsets[i+1] - index->path_offsets[i];
+
+  if (len)
+    *len = path_len;
+
+  return apr_pstrmemdup(result_pool,
+                        index->path_data + index->path_offsets[i],
+                        path_len);
+}
+
+/* Decode the change record at *P in INDEX into *CHANGE and advance *P.
+ * Allocate *CHANGE in RESULT_POOL.  REVISION is used for error reporting.
+ */
+static svn_error_t *
+read_record(change_t **change,
+            const unsigned char **p,
+            const changes_index_t *index,
+            svn_revnum_t revision,
+            apr_pool_t *result_pool)
+{
+  change_t *result = apr_pcalloc(result_pool, sizeof(*result));
+  svn_fs_path_change2_t *info = &result->info;
+  const unsigned char *end = index->records + index->records_len;
+  apr_size_t value, flags;
+
+  SVN_ERR(read_limited(&value, p, end, index->path_count, revision));
+  result->path.data = get_path(&result->path.len, index, value,
+                               result_pool);
+
+  SVN_ERR(read_limited(&flags, p, end, 0x1000, revision));
+  info->change_kind = (svn_fs_path_change_kind_t)(flags & 7);
+  info->node_kind = (svn_node_kind_t)((flags >> FLAG_NODE_KIND_SHIFT) & 7);
+  info->text_mod = (flags & FLAG_TEXT_MOD) != 0;
+  info->prop_mod = (flags & FLAG_PROP_MOD) != 0;
+  info->mergeinfo_mod = (svn_tristate_t)(svn_tristate_false
+                                         + ((flags >> FLAG_MERGEINFO_SHIFT)
+                                            & 3));
+  info->copyfrom_known = (flags & FLAG_COPYFROM_KNOWN) != 0;
+
+  if (   info->change_kind > svn_fs_path_change_reset
+      || info->node_kind > svn_node_symlink
+      || info->mergeinfo_mod > svn_tristate_unknown)
+    return svn_error_trace(corrupt_index(revision));
+
+  if (flags & FLAG_HAS_COPYFROM)
+    {
+      apr_uint64_t copyfrom_rev;
+
+      SVN_ERR(read_uint(&copyfrom_rev, p, end, revision));
+      SVN_ERR(read_limited(&value, p, end, index->path_count, revision));
+
+      info->copyfrom_rev = (svn_revnum_t)copyfrom_rev;
+      info->copyfrom_path = get_path(NULL, index, value, result_pool);
+    }
+  else
+    {
+      info->copyfrom_rev = SVN_INVALID_REVNUM;
+      info->copyfrom_path = NULL;
+    }
+
+  SVN_ERR(read_limited(&value, p, end, end - *p + 1, revision));
+  if (value)
+    {
+      char *id = apr_pstrmemdup(result_pool, (const char *)*p, value);
+      SVN_ERR(svn_fs_fs__id_parse(&info->node_rev_id, id, result_pool));
+    }
+
+  *p += value;
+  *change = result;
+
+  return SVN_NO_ERROR;
+}
+
+/* Data request structure and result of svn_fs_fs__read_changes_index(),
+ * see there for the meaning of the members.
+ */
+typedef struct changes_index_baton_t
+{
+  /* Input. */
+  svn_revnum_t revision;
+  apr_size_t first;
+  apr_size_t limit;
+
+  /* Output. */
+  apr_array_header_t *changes;
+  svn_boolean_t eol;
+  svn_boolean_t found;
+} changes_index_baton_t;
+
+/* Decode the changes requested in BATON from INDEX and set the output
+ * fields in BATON.  Allocate them in RESULT_POOL.
+ */
+static svn_error_t *
+extract_changes(changes_index_baton_t *baton,
+                const changes_index_t *index,
+                apr_pool_t *result_pool)
+{
+  svn_revnum_t revision = baton->revision;
+  const unsigned char *p = NULL;
+  apr_size_t i, first, last, count;
+
+  baton->found = index->found;
+  if (!index->found)
+    return SVN_NO_ERROR;
+
+  if (revision - index->start_rev >= index->rev_count)
+    return svn_error_trace(corrupt_index(revision));
+
+  /* Position on the first requested entry. */
+  count = index->change_counts[revision - index->start_rev];
+  first = MIN(baton->first, count);
+  last = count - first > baton->limit ? first + baton->limit : count;
+  baton->changes = apr_array_make(result_pool, (int)(last - first),
+                                  sizeof(change_t *));
+
+  i = first - first % index->block_size;
+  if (i < last)
+    p = index->records
+      + index->blocks[index->first_block[revision - index->start_rev]
+                      + first / index->block_size];
+
+  for (; i < last; ++i)
+    {
+      change_t *change;
+      SVN_ERR(read_record(&change, &p, index, revision, result_pool));
+
+      if (i >= first)
+        APR_ARRAY_PUSH(baton->changes, change_t *) = change;
+    }
+
+  baton->eol = last == count;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn_cache__partial_getter_func_t: decode the changes requested
+ * in changes_index_baton_t *BATON from changes_index_t *DATA and set the
+ * output fields in *BATON.
+ */
+static svn_error_t *
+changes_index_access_func(void **out,
+                          const void *data,
+                          apr_size_t data_len,
+                          void *baton,
+                          apr_pool_t *result_pool)
+{
+  /* resolve all pointer values of in-cache data */
+  const changes_index_t *cached = data;
+  changes_index_t index = *cached;
+
+  index.path_offsets
+    = (apr_size_t *)svn_temp_deserializer__ptr(cached,
+                          (const void *const *)&cached->path_offsets);
+  index.path_data
+    = svn_temp_deserializer__ptr(cached,
+                          (const void *const *)&cached->path_data);
+  index.change_counts
+    = (apr_size_t *)svn_temp_deserializer__ptr(cached,
+                          (const void *const *)&cached->change_counts);
+  index.first_block
+    = (apr_size_t *)svn_temp_deserializer__ptr(cached,
+                          (const void *const *)&cached->first_block);
+  index.blocks
+    = (apr_size_t *)svn_temp_deserializer__ptr(cached,
+                          (const void *const *)&cached->blocks);
+  index.records
+    = svn_temp_deserializer__ptr(cached,
+                          (const void *const *)&cached->records);
+
+  return svn_error_trace(extract_changes(baton, &index, result_pool));
+}
+
+svn_error_t *
+svn_fs_fs__read_changes_index(apr_array_header_t **changes,
+                              svn_boolean_t *eol,
+                              svn_boolean_t *found,
+                              svn_fs_t *fs,
+                              svn_revnum_t revision,
+                              apr_size_t first,
+                              apr_size_t limit,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  changes_index_baton_t baton;
+  svn_boolean_t is_cached = FALSE;
+  svn_revnum_t start_rev;
+  void *dummy = NULL;
+
+  *found = FALSE;
+  if (!svn_fs_fs__is_packed_rev(fs, revision))
+    return SVN_NO_ERROR;
+
+  baton.revision = revision;
+  baton.first = first;
+  baton.limit = limit;
+  baton.changes = NULL;
+  baton.eol = FALSE;
+  baton.found = FALSE;
+
+  /* try to find the info in the cache */
+  start_rev = svn_fs_fs__packed_base_rev(fs, revision);
+  SVN_ERR(svn_cache__get_partial(&dummy, &is_cached,
+                                 ffd->changes_index_cache, &start_rev,
+                                 changes_index_access_func, &baton,
+                                 result_pool));
+
+  /* read from disk, cache and copy the result */
+  if (!is_cached)
+    {
+      changes_index_t *index;
+
+      SVN_ERR(read_index(&index, fs, revision, scratch_pool, scratch_pool));
+      SVN_ERR(svn_cache__set(ffd->changes_index_cache, &start_rev, index,
+                             scratch_pool));
+      SVN_ERR(extract_changes(&baton, index, result_pool));
+    }
+
+  if (baton.found)
+    {
+      *changes = baton.changes;
+      *eol = baton.eol;
+      *found = TRUE;
+    }
+
+  return SVN_NO_ERROR;
+}
@@ -0,0 +1,94 @@
+/* changes_index.h --- binary index of the changed paths lists in a pack
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef SVN_LIBSVN_FS_FS_CHANGES_INDEX_H
+#define SVN_LIBSVN_FS_FS_CHANGES_INDEX_H
+
+#include "fs.h"
+#include "private/svn_io_private.h"
+
+/* Packed shards may contain a PATH_CHANGES_INDEX file that holds the
+ * changed paths lists of all revisions in that shard in a compact binary
+ * form.  All paths are being stored only once per shard and reading a
+ * changes list from the index requires neither opening the pack file nor
+ * parsing the textual representation.
+ *
+ * The index is optional.  Readers fall back to the changed paths lists
+ * in the pack file if a shard has no index.
+ */
+
+/* Read the changed paths lists of the SHARD_SIZE revisions starting at
+ * SHARD_REV in FS and write them as changes index into PACK_FILE_DIR.
+ * The revisions must not have been packed yet.  Schedule the new index
+ * file for fsync in BATCH.
+ *
+ * CANCEL_FUNC and CANCEL_BATON are used in the usual way.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_fs_fs__write_changes_index(svn_fs_t *fs,
+                               const char *pack_file_dir,
+                               svn_revnum_t shard_rev,
+                               int shard_size,
+                               svn_io__batch_fsync_t *batch,
+                               svn_cancel_func_t cancel_func,
+                               void *cancel_baton,
+                               apr_pool_t *scratch_pool);
+
+/* If REVISION in FS has been packed into a shard with a changes index,
+ * set *FOUND to TRUE and return up to LIMIT entries of its changed paths
+ * list in *CHANGES, starting with entry number FIRST.  Set *EOL if there
+ * are no further entries after those.  Otherwise, set *FOUND to FALSE
+ * and leave the other outputs untouched.
+ *
+ * Allocate *CHANGES in RESULT_POOL and use SCRATCH_POOL for temporaries.
+ */
+svn_error_t *
+svn_fs_fs__read_changes_index(apr_array_header_t **changes,
+                              svn_boolean_t *eol,
+                              svn_boolean_t *found,
+                              svn_fs_t *fs,
+                              svn_revnum_t revision,
+                              apr_size_t first,
+                              apr_size_t limit,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool);
+
+/*
+ * Implements svn_cache__serialize_func_t for parsed changes indexes.
+ */
+svn_error_t *
+svn_fs_fs__serialize_changes_index(void **data,
+                                   apr_size_t *data_len,
+                                   void *in,
+                                   apr_pool_t *pool);
+
+/*
+ * Implements svn_cache__deserialize_func_t for parsed changes indexes.
+ */
+svn_error_t *
+svn_fs_fs__deserialize_changes_index(void **out,
+                                     void *data,
+                                     apr_size_t data_len,
+                                     apr_pool_t *pool);
+
+#endif
@@ -31,11 +31,13 @@
 #include "svn_fs.h"
 #include "svn_delta.h"
 #include "svn_version.h"
+#include "svn_cache_config.h"
 #include "svn_pools.h"
 #include "fs.h"
 #include "fs_fs.h"
 #include "tree.h"
 #include "lock.h"
+#include "mergeinfo_index.h"
 #include "hotcopy.h"
 #include "id.h"
 #include "pack.h"
@@ -48,6 +50,7 @@
 #include "svn_private_config.h"
 #include "private/svn_fs_util.h"
 #include "private/svn_fs_fs_private.h"
+#include "private/svn_io_private.h"
 
 #include "../libsvn_fs/fs-loader.h"
 
@@ -271,7 +274,7 @@ fs_ioctl(svn_fs_t *fs, svn_fs_ioctl_code_t ctlcode,
           svn_fs_fs__ioctl_get_stats_output_t *output;
 
           output = apr_pcalloc(result_pool, sizeof(*output));
-          SVN_ERR(svn_fs_fs__get_stats(&output->stats, fs,
+          SVN_ERR(svn_fs_fs__get_stats(&output->stats, fs, input->jobs,
                                        input->progress_func,
                                        input->progress_baton,
                                        cancel_func, cancel_baton,
@@ -319,12 +322,27 @@ fs_ioctl(svn_fs_t *fs, svn_fs_ioctl_code_t ctlcode,
           SVN_ERR(svn_fs_fs__build_rep_cache(fs,
                                              input->start_rev,
                                              input->end_rev,
+                                             input->jobs,
                                              input->progress_func,
                                              input->progress_baton,
                                              cancel_func,
                                              cancel_baton,
                                              scratch_pool));
 
+          *output_p = NULL;
+          return SVN_NO_ERROR;
+        }
+      else if (ctlcode.code == SVN_FS_FS__IOCTL_BUILD_MERGEINFO_INDEX.code)
+        {
+          svn_fs_fs__ioctl_build_mergeinfo_index_input_t *input = input_void;
+
+          SVN_ERR(svn_fs_fs__build_mergeinfo_index(fs,
+                                                   input->progress_func,
+                                                   input->progress_baton,
+                                                   cancel_func,
+                                                   cancel_baton,
+                                                   scratch_pool));
+
           *output_p = NULL;
           return SVN_NO_ERROR;
         }
@@ -372,6 +390,8 @@ initialize_fs_struct(svn_fs_t *fs)
   ffd->use_log_addressing = FALSE;
   ffd->revprop_prefix = 0;
   ffd->flush_to_disk = TRUE;
+  ffd->block_read_file = SVN_INVALID_REVNUM;
+  ffd->recovery_chunk_size = SVN_FS_FS__RECOVERY_CHUNK_SIZE;
 
   fs->vtable = &fs_vtable;
   fs->fsap_data = ffd;
@@ -445,6 +465,40 @@ fs_open(svn_fs_t *fs,
 }
 
 
+svn_error_t *
+svn_fs_fs__open_clone(svn_fs_t **clone_p,
+                      svn_fs_t *fs,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  fs_fs_data_t *clone_ffd;
+  svn_fs_t *clone = apr_pmemdup(result_pool, fs, sizeof(*clone));
+
+  clone->pool = result_pool;
+  clone->path = NULL;
+  clone->config = fs->config ? apr_hash_copy(result_pool, fs->config) : NULL;
+  clone->access_ctx = NULL;
+  clone->uuid = NULL;
+
+  SVN_ERR(initialize_fs_struct(clone));
+  clone_ffd = clone->fsap_data;
+  clone_ffd->no_membuffer = svn_cache_config_get()->single_threaded;
+
+  SVN_ERR(svn_fs_fs__open(clone, fs->path, scratch_pool));
+  SVN_ERR(svn_fs_fs__initialize_caches(clone, scratch_pool));
+
+  /* Process-wide data, e.g. the lock mutexes, must be the same for all
+     instances of the repository. */
+  clone_ffd->shared = ffd->shared;
+  clone_ffd->svn_fs_open_ = ffd->svn_fs_open_;
+
+  *clone_p = clone;
+
+  return SVN_NO_ERROR;
+}
+
+
 
 /* This implements the fs_library_vtable_t.open_for_recovery() API. */
 static svn_error_t *
@@ -705,6 +759,8 @@ svn_fs_fs__init(const svn_version_t *loader_version,
                              loader_version->major);
   SVN_ERR(svn_ver_check_list2(fs_version(), checklist, svn_ver_equal));
 
+  SVN_ERR(svn_io__batch_fsync_init(common_pool));
+
   *vtable = &library_vtable;
   return SVN_NO_ERROR;
 }
@@ -64,11 +64,17 @@ extern "C" {
 #define PATH_TXN_CURRENT      "txn-current"      /* File with next txn key */
 #define PATH_TXN_CURRENT_LOCK "txn-current-lock" /* Lock for txn-current */
 #define PATH_LOCKS_DIR        "locks"            /* Directory of locks */
+#define PATH_LOCK_DB          "locks.db"         /* Optional lock database */
+#define PATH_NODE_HISTORY_DB  "node-history.db"  /* Optional history index */
+#define PATH_MERGEINFO_DB     "mergeinfo.db"     /* Optional mergeinfo index */
+#define PATH_RECOVERY_CHECKPOINT "recovery-checkpoint"
+                                                 /* Progress of ID recovery */
 #define PATH_MIN_UNPACKED_REV "min-unpacked-rev" /* Oldest revision which
                                                     has not been packed. */
 #define PATH_REVPROP_GENERATION "revprop-generation"
                                                  /* Current revprop generation*/
 #define PATH_MANIFEST         "manifest"         /* Manifest file name */
+#define PATH_CHANGES_INDEX    "changes.idx"      /* Binary changes lists */
 #define PATH_PACKED           "pack"             /* Packed revision data file */
 #define PATH_EXT_PACKED_SHARD ".pack"            /* Extension for packed
                                                     shards */
@@ -104,6 +110,7 @@ extern "C" {
 #define CONFIG_OPTION_ENABLE_REP_SHARING "enable-rep-sharing"
 #define CONFIG_SECTION_DELTIFICATION     "deltification"
 #define CONFIG_OPTION_ENABLE_DIR_DELTIFICATION   "enable-dir-deltification"
+#define CONFIG_OPTION_DIR_INDEX_THRESHOLD        "directory-index-threshold"
 #define CONFIG_OPTION_ENABLE_PROPS_DELTIFICATION "enable-props-deltification"
 #define CONFIG_OPTION_MAX_DELTIFICATION_WALK     "max-deltification-walk"
 #define CONFIG_OPTION_MAX_LINEAR_DELTIFICATION   "max-linear-deltification"
@@ -115,6 +122,17 @@ extern "C" {
 #define CONFIG_OPTION_BLOCK_SIZE         "block-size"
 #define CONFIG_OPTION_L2P_PAGE_SIZE      "l2p-page-size"
 #define CONFIG_OPTION_P2L_PAGE_SIZE      "p2l-page-size"
+#define CONFIG_OPTION_BLOCK_READ_AHEAD   "block-read-ahead"
+#define CONFIG_OPTION_MMAP_PACK_FILES    "mmap-pack-files"
+#define CONFIG_OPTION_FILE_HANDLE_CACHE_SIZE "file-handle-cache-size"
+#define CONFIG_OPTION_CHANGES_INDEX      "changes-index"
+#define CONFIG_OPTION_NODE_HISTORY_INDEX "node-history-index"
+#define CONFIG_OPTION_MERGEINFO_INDEX    "mergeinfo-index"
+#define CONFIG_SECTION_LOCKS             "locks"
+#define CONFIG_OPTION_ENABLE_LOCK_DB     "enable-lock-db"
+#define CONFIG_SECTION_CONCURRENCY       "concurrency"
+#define CONFIG_OPTION_PACK_THREADS       "pack-threads"
+#define CONFIG_OPTION_HOTCOPY_THREADS    "hotcopy-threads"
 #define CONFIG_SECTION_DEBUG             "debug"
 #define CONFIG_OPTION_PACK_AFTER_COMMIT  "pack-after-commit"
 #define CONFIG_OPTION_VERIFY_BEFORE_COMMIT "verify-before-commit"
@@ -127,7 +145,7 @@ extern "C" {
    Note: If you bump this, please update the switch statement in
          svn_fs_fs__create() as well.
  */
-#define SVN_FS_FS__FORMAT_NUMBER   8
+#define SVN_FS_FS__FORMAT_NUMBER   9
 
 /* The minimum format number that supports svndiff version 1.  */
 #define SVN_FS_FS__MIN_SVNDIFF1_FORMAT 2
@@ -200,6 +218,10 @@ extern "C" {
     database. */
 #define SVN_FS_FS__MIN_REP_CACHE_SCHEMA_V2_FORMAT 8
 
+/* The minimum format number that writes L2P and P2L index pages in the
+   block-packed format.  Older index data remains readable. */
+#define SVN_FS_FS__MIN_BLOCK_PACKED_INDEX_FORMAT 9
+
 /* On most operating systems apr implements file locks per process, not
    per file.  On Windows apr implements the locking as per file handle
    locks, so we don't have to add our own mutex for just in-process
@@ -210,6 +232,20 @@ extern "C" {
 #define SVN_FS_FS__USE_LOCK_MUTEX 0
 #endif
 
+/* Upper limit to the number of shards that we pack in parallel. */
+#define SVN_FS_FS__MAX_PACK_THREADS 64
+
+/* Upper limit to the number of shards that we hotcopy in parallel. */
+#define SVN_FS_FS__MAX_HOTCOPY_THREADS 64
+
+/* Upper limit to the number of revision ranges that we scan in parallel
+   during recovery. */
+#define SVN_FS_FS__MAX_RECOVERY_THREADS 64
+
+/* Number of revisions that recovery scans as one range.  After each
+   range, we update the recovery checkpoint. */
+#define SVN_FS_FS__RECOVERY_CHUNK_SIZE 1000
+
 /* Maximum number of changes we deliver per request when listing the
    changed paths for a given revision.   Anything > 0 will do.
    At 100..300 bytes per entry, this limits the allocation to ~30kB. */
@@ -283,6 +319,17 @@ typedef struct fs_fs_shared_data_t
 /* Data structure for the 1st level DAG node cache. */
 typedef struct fs_fs_dag_cache_t fs_fs_dag_cache_t;
 
+/* The packed revprop manifest that we read last, see revprops.c. */
+typedef struct fs_fs_revprop_manifest_t fs_fs_revprop_manifest_t;
+
+/* The section of a line of node history that we read last from the
+   node history index, see node_history.c. */
+typedef struct fs_fs_node_history_t fs_fs_node_history_t;
+
+/* The range of revisions covered by the mergeinfo index as far as we
+   know, see mergeinfo_index.c. */
+typedef struct fs_fs_mergeinfo_index_t fs_fs_mergeinfo_index_t;
+
 /* Key type for all caches that use revision + offset / counter as key.
 
    Note: Cache keys should be 16 bytes for best performance and there
@@ -347,6 +394,34 @@ typedef struct fs_fs_data_t
    * (not just the one bit that we need, atm). */
   svn_boolean_t use_block_read;
 
+  /* Number of blocks to read and cache in addition to the current one
+   * once block-read detected a sequential access pattern.  0 disables
+   * the read-ahead. */
+  int block_read_ahead;
+
+  /* Access pattern tracking for block-read:  The first revision in the
+   * rev / pack file that we read from last, the range of data that we
+   * read from it and how many consecutive block reads fell into or right
+   * behind the previously read range. */
+  svn_revnum_t block_read_file;
+  apr_off_t block_read_start;
+  apr_off_t block_read_end;
+  int sequential_block_reads;
+
+  /* Total number of blocks that block-read fetched ahead of time. */
+  apr_uint64_t blocks_read_ahead;
+
+  /* If set, map pack files into memory when opening them for reading and
+   * read index and meta data directly from there. */
+  svn_boolean_t mmap_pack_files;
+
+  /* Maximum number of rev / pack files that we keep open for re-use.
+   * 0 disables the file handle cache. */
+  int file_handle_cache_size;
+
+  /* Cache of open rev / pack files, lazily created.  See rev_file.c. */
+  struct svn_fs_fs__rev_file_cache_t *rev_file_cache;
+
   /* The revision that was youngest, last time we checked. */
   svn_revnum_t youngest_rev_cache;
 
@@ -360,6 +435,11 @@ typedef struct fs_fs_data_t
      e.g. memcached may be ignored as caching is an optional feature. */
   svn_boolean_t fail_stop;
 
+  /* If TRUE, don't use the process-global membuffer cache.  Set for
+     instances that run in parallel to others while that cache has been
+     configured for single-threaded use. */
+  svn_boolean_t no_membuffer;
+
   /* A cache of revision root IDs, mapping from (svn_revnum_t *) to
      (svn_fs_id_t *).  (Not threadsafe.) */
   svn_cache__t *rev_root_id_cache;
@@ -385,10 +465,24 @@ typedef struct fs_fs_data_t
   apr_uint64_t revprop_prefix;
 
   /* Revision property cache.  Maps from (rev,prefix) to apr_hash_t.
+     Packed revprops use the tag of their pack file instead of the
+     prefix, see revprops.c.
      Unparsed svn_string_t representations of the serialized hash
      will be written to the cache but the getter returns apr_hash_t. */
   svn_cache__t *revprop_cache;
 
+  /* Manifest of the revprop pack shard that we accessed last.  NULL if
+     we did not read any, yet.  Only valid for the same REVPROP_PREFIX. */
+  fs_fs_revprop_manifest_t *revprop_manifest;
+
+  /* Section of the node history index that we accessed last.  NULL if
+     we did not read any, yet. */
+  fs_fs_node_history_t *node_history;
+
+  /* What we know about the mergeinfo index.  NULL if we did not access
+     it, yet. */
+  fs_fs_mergeinfo_index_t *mergeinfo_index;
+
   /* Node properties cache.  Maps from rep key to apr_hash_t. */
   svn_cache__t *properties_cache;
 
@@ -416,6 +510,10 @@ typedef struct fs_fs_data_t
      the key is the (revision, first-element-in-block) pair. */
   svn_cache__t *changes_cache;
 
+  /* Cache for the parsed changes indexes of pack shards; the key is the
+     first revision of the shard.  See changes_index.c. */
+  svn_cache__t *changes_index_cache;
+
   /* Cache for svn_fs_fs__rep_header_t objects; the key is a
      (revision, item index) pair */
   svn_cache__t *rep_header_cache;
@@ -456,6 +554,11 @@ typedef struct fs_fs_data_t
      unparsed FS ID to ###x.  NULL outside transactions. */
   svn_cache__t *txn_dir_cache;
 
+  /* Changed directories of the current transaction that are too large for
+     TXN_DIR_CACHE; maps from unparsed FS ID to txn_dir_t (see
+     cached_data.c).  Only valid while TXN_DIR_CACHE is not NULL. */
+  struct svn_hash__table_t *txn_dirs;
+
   /* Data shared between all svn_fs_t objects for a given filesystem. */
   fs_fs_shared_data_t *shared;
 
@@ -465,6 +568,35 @@ typedef struct fs_fs_data_t
   /* Thread-safe boolean */
   svn_atomic_t rep_cache_db_opened;
 
+  /* Whether the next write access to the locks should move them into
+     PATH_LOCK_DB. */
+  svn_boolean_t enable_lock_db;
+
+  /* Whether PATH_LOCK_DB exists.  Checked when opening the filesystem
+     and again when taking out the write lock.  Until then, readers may
+     miss a migration to PATH_LOCK_DB by another process. */
+  svn_boolean_t has_lock_db;
+
+  /* The sqlite database holding the locks.  NULL, if PATH_LOCK_DB has
+     not been opened (yet). */
+  svn_sqlite__db_t *lock_db;
+
+  /* Whether commits shall record their new node revisions in
+     PATH_NODE_HISTORY_DB. */
+  svn_boolean_t node_history_enabled;
+
+  /* The sqlite database holding the node history index.  NULL, if
+     PATH_NODE_HISTORY_DB has not been opened (yet). */
+  svn_sqlite__db_t *node_history_db;
+
+  /* Whether commits shall update the mergeinfo index in
+     PATH_MERGEINFO_DB. */
+  svn_boolean_t mergeinfo_index_enabled;
+
+  /* The sqlite database holding the mergeinfo index.  NULL, if
+     PATH_MERGEINFO_DB has not been opened (yet). */
+  svn_sqlite__db_t *mergeinfo_db;
+
   /* The oldest revision not in a pack file.  It also applies to revprops
    * if revprop packing has been enabled by the FSFS format version. */
   svn_revnum_t min_unpacked_rev;
@@ -483,6 +615,10 @@ typedef struct fs_fs_data_t
   /* Whether directory nodes shall be deltified just like file nodes. */
   svn_boolean_t deltify_directories;
 
+  /* Directories with at least this many entries will be stored as PLAIN
+   * representations with an on-disk index.  0 disables the index. */
+  apr_int64_t dir_index_threshold;
+
   /* Whether nodes properties shall be deltified. */
   svn_boolean_t deltify_properties;
 
@@ -502,6 +638,25 @@ typedef struct fs_fs_data_t
   /* Pack after every commit. */
   svn_boolean_t pack_after_commit;
 
+  /* Whether packing shall write a PATH_CHANGES_INDEX file per shard. */
+  svn_boolean_t changes_index_enabled;
+
+  /* Maximum number of threads to use for packing shards in parallel. */
+  int pack_threads;
+
+  /* Maximum number of threads to use for copying shards in parallel
+     when this repository is the source of a hotcopy. */
+  int hotcopy_threads;
+
+  /* Maximum number of threads to use for scanning revisions in parallel
+     when recovering repositories with global ID counters.  Taken from
+     SVN_FS_CONFIG_FSFS_RECOVERY_JOBS. */
+  int recovery_threads;
+
+  /* Number of revisions per recovery scan range.  Defaults to
+     SVN_FS_FS__RECOVERY_CHUNK_SIZE; tests may use smaller ranges. */
+  svn_revnum_t recovery_chunk_size;
+
   /* Verify each new revision before commit. */
   svn_boolean_t verify_before_commit;
 
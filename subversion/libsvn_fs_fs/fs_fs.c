@@ -120,6 +120,24 @@ get_lock_on_filesystem(const char *lock_filename,
   return svn_error_trace(svn_io__file_lock_autocreate(lock_filename, pool));
 }
 
+/* Set the HAS_LOCK_DB member of FS->FSAP_DATA according to whether
+   PATH_LOCK_DB exists in FS.  Use SCRATCH_POOL for temporary
+   allocations. */
+static svn_error_t *
+check_lock_db(svn_fs_t *fs,
+              apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_node_kind_t kind;
+
+  SVN_ERR(svn_io_check_path(svn_dirent_join(fs->path, PATH_LOCK_DB,
+                                            scratch_pool),
+                            &kind, scratch_pool));
+  ffd->has_lock_db = kind != svn_node_none;
+
+  return SVN_NO_ERROR;
+}
+
 /* Reset the HAS_WRITE_LOCK member in the FFD given as BATON_VOID.
    When registered with the pool holding the lock on the lock file,
    this makes sure the flag gets reset just before we release the lock. */
@@ -216,6 +234,12 @@ with_some_lock_file(with_lock_baton_t *baton)
             err = svn_fs_fs__update_min_unpacked_rev(fs, pool);
           if (!err)
             err = get_youngest(&ffd->youngest_rev_cache, fs, pool);
+
+          /* Another process may have moved the locks into PATH_LOCK_DB
+             since we last checked.  Lock lookups while we hold the write
+             lock, e.g. during commits, must not miss that. */
+          if (!err && ffd->has_write_lock && !ffd->has_lock_db)
+            err = check_lock_db(fs, pool);
         }
 
       if (!err)
@@ -761,6 +785,30 @@ read_config(fs_fs_data_t *ffd,
   else
     ffd->rep_sharing_allowed = FALSE;
 
+  /* The lock database requires SQLite just like the rep-cache. */
+  if (ffd->format >= SVN_FS_FS__MIN_REP_SHARING_FORMAT)
+    SVN_ERR(svn_config_get_bool(config, &ffd->enable_lock_db,
+                                CONFIG_SECTION_LOCKS,
+                                CONFIG_OPTION_ENABLE_LOCK_DB, FALSE));
+  else
+    ffd->enable_lock_db = FALSE;
+
+  /* So does the node history index. */
+  if (ffd->format >= SVN_FS_FS__MIN_REP_SHARING_FORMAT)
+    SVN_ERR(svn_config_get_bool(config, &ffd->node_history_enabled,
+                                CONFIG_SECTION_IO,
+                                CONFIG_OPTION_NODE_HISTORY_INDEX, FALSE));
+  else
+    ffd->node_history_enabled = FALSE;
+
+  /* Same for the mergeinfo index. */
+  if (ffd->format >= SVN_FS_FS__MIN_REP_SHARING_FORMAT)
+    SVN_ERR(svn_config_get_bool(config, &ffd->mergeinfo_index_enabled,
+                                CONFIG_SECTION_IO,
+                                CONFIG_OPTION_MERGEINFO_INDEX, FALSE));
+  else
+    ffd->mergeinfo_index_enabled = FALSE;
+
   /* Initialize deltification settings in ffd. */
   if (ffd->format >= SVN_FS_FS__MIN_DELTIFICATION_FORMAT)
     {
@@ -768,6 +816,10 @@ read_config(fs_fs_data_t *ffd,
                                   CONFIG_SECTION_DELTIFICATION,
                                   CONFIG_OPTION_ENABLE_DIR_DELTIFICATION,
                                   TRUE));
+      SVN_ERR(svn_config_get_int64(config, &ffd->dir_index_threshold,
+                                   CONFIG_SECTION_DELTIFICATION,
+                                   CONFIG_OPTION_DIR_INDEX_THRESHOLD,
+                                   0));
       SVN_ERR(svn_config_get_bool(config, &ffd->deltify_properties,
                                   CONFIG_SECTION_DELTIFICATION,
                                   CONFIG_OPTION_ENABLE_PROPS_DELTIFICATION,
@@ -784,6 +836,7 @@ read_config(fs_fs_data_t *ffd,
   else
     {
       ffd->deltify_directories = FALSE;
+      ffd->dir_index_threshold = 0;
       ffd->deltify_properties = FALSE;
       ffd->max_deltification_walk = SVN_FS_FS_MAX_DELTIFICATION_WALK;
       ffd->max_linear_deltification = SVN_FS_FS_MAX_LINEAR_DELTIFICATION;
@@ -813,6 +866,8 @@ read_config(fs_fs_data_t *ffd,
 
   if (ffd->format >= SVN_FS_FS__MIN_LOG_ADDRESSING_FORMAT)
     {
+      apr_int64_t block_read_ahead;
+
       SVN_ERR(svn_config_get_int64(config, &ffd->block_size,
                                    CONFIG_SECTION_IO,
                                    CONFIG_OPTION_BLOCK_SIZE,
@@ -825,6 +880,14 @@ read_config(fs_fs_data_t *ffd,
                                    CONFIG_SECTION_IO,
                                    CONFIG_OPTION_P2L_PAGE_SIZE,
                                    0x400));
+      SVN_ERR(svn_config_get_int64(config, &block_read_ahead,
+                                   CONFIG_SECTION_IO,
+                                   CONFIG_OPTION_BLOCK_READ_AHEAD,
+                                   4));
+      SVN_ERR(svn_config_get_bool(config, &ffd->mmap_pack_files,
+                                  CONFIG_SECTION_IO,
+                                  CONFIG_OPTION_MMAP_PACK_FILES,
+                                  FALSE));
 
       /* Don't accept unreasonable or illegal values.
        * Block size and P2L page size are in kbytes;
@@ -840,6 +903,9 @@ read_config(fs_fs_data_t *ffd,
       ffd->block_size *= 0x400;
       ffd->p2l_page_size *= 0x400;
       /* L2P pages are in entries - not in (k)Bytes */
+
+      /* Reading too far ahead would only thrash the cache. */
+      ffd->block_read_ahead = (int)MAX(0, MIN(block_read_ahead, 64));
     }
   else
     {
@@ -847,20 +913,64 @@ read_config(fs_fs_data_t *ffd,
       ffd->block_size = 0x1000; /* Matches default APR file buffer size. */
       ffd->l2p_page_size = 0x2000;    /* Matches above default. */
       ffd->p2l_page_size = 0x100000;  /* Matches above default in bytes. */
+      ffd->block_read_ahead = 0;
+      ffd->mmap_pack_files = FALSE;
     }
 
+  /* The file handle cache works for all formats. */
+  {
+    apr_int64_t file_handle_cache_size;
+    SVN_ERR(svn_config_get_int64(config, &file_handle_cache_size,
+                                 CONFIG_SECTION_IO,
+                                 CONFIG_OPTION_FILE_HANDLE_CACHE_SIZE,
+                                 16));
+
+    /* Don't let a single svn_fs_t hog the process' file handles. */
+    ffd->file_handle_cache_size = (int)MAX(0, MIN(file_handle_cache_size,
+                                                  256));
+  }
+
   if (ffd->format >= SVN_FS_FS__MIN_PACKED_FORMAT)
     {
+      apr_int64_t pack_threads;
+
       SVN_ERR(svn_config_get_bool(config, &ffd->pack_after_commit,
                                   CONFIG_SECTION_DEBUG,
                                   CONFIG_OPTION_PACK_AFTER_COMMIT,
                                   FALSE));
+      SVN_ERR(svn_config_get_bool(config, &ffd->changes_index_enabled,
+                                  CONFIG_SECTION_IO,
+                                  CONFIG_OPTION_CHANGES_INDEX,
+                                  FALSE));
+      SVN_ERR(svn_config_get_int64(config, &pack_threads,
+                                   CONFIG_SECTION_CONCURRENCY,
+                                   CONFIG_OPTION_PACK_THREADS,
+                                   1));
+
+      /* Don't accept unreasonable values. */
+      ffd->pack_threads = (int)MAX(1, MIN(pack_threads,
+                                          SVN_FS_FS__MAX_PACK_THREADS));
     }
   else
     {
       ffd->pack_after_commit = FALSE;
+      ffd->changes_index_enabled = FALSE;
+      ffd->pack_threads = 1;
     }
 
+  {
+    apr_int64_t hotcopy_threads;
+
+    SVN_ERR(svn_config_get_int64(config, &hotcopy_threads,
+                                 CONFIG_SECTION_CONCURRENCY,
+                                 CONFIG_OPTION_HOTCOPY_THREADS,
+                                 1));
+
+    /* Don't accept unreasonable values. */
+    ffd->hotcopy_threads = (int)MAX(1, MIN(hotcopy_threads,
+                                           SVN_FS_FS__MAX_HOTCOPY_THREADS));
+  }
+
   /* Initialize compression settings in ffd. */
   if (ffd->format >= SVN_FS_FS__MIN_DELTIFICATION_FORMAT)
     {
@@ -1017,6 +1127,16 @@ write_config(svn_fs_t *fs,
 "### directory deltification is enabled by default."                         NL
 "# " CONFIG_OPTION_ENABLE_DIR_DELTIFICATION " = true"                        NL
 "###"                                                                        NL
+"### Looking up a single entry in a directory normally requires reading"     NL
+"### and parsing the whole directory.  Directories with at least"            NL
+"### directory-index-threshold entries will instead be stored as"            NL
+"### fulltext with an index appended, allowing single-entry lookups to"      NL
+"### read only a few blocks.  These directories will not be deltified,"      NL
+"### so use this only for directories with many thousand entries."           NL
+"### Older Subversion versions can still read such directories."             NL
+"### directory-index-threshold is 0 (disabled) by default."                  NL
+"# " CONFIG_OPTION_DIR_INDEX_THRESHOLD " = 0"                                NL
+"###"                                                                        NL
 "### The following parameter enables deltification for properties on files"  NL
 "### and directories.  Overall, this is a minor tuning option but can save"  NL
 "### some disk space if you merge frequently or frequently change node"      NL
@@ -1148,6 +1268,100 @@ write_config(svn_fs_t *fs,
 "### Must be a power of 2."                                                  NL
 "### p2l-page-size is given in kBytes and with a default of 1024 kBytes."    NL
 "# " CONFIG_OPTION_P2L_PAGE_SIZE " = 1024"                                   NL
+"###"                                                                        NL
+"### When block-read has been enabled and data is being read sequentially,"  NL
+"### e.g. during export, dump or verify, FSFS will read and cache that many" NL
+"### blocks beyond the one currently requested.  This replaces many small"   NL
+"### reads and index lookups by a few larger ones.  Set it to 0 to disable"  NL
+"### the read-ahead.  Values larger than 64 will be capped."                 NL
+"### block-read-ahead is given in blocks and with a default of 4 blocks."    NL
+"# " CONFIG_OPTION_BLOCK_READ_AHEAD " = 4"                                   NL
+"###"                                                                        NL
+"### If mmap-pack-files is enabled, FSFS will map pack files into memory"    NL
+"### instead of reading them through the file API.  Index lookups and meta"  NL
+"### data parsing then work directly on the mapped data, saving system"      NL
+"### calls and copies.  This is most useful for large, frequently read"      NL
+"### repositories on 64 bit systems.  Should mapping a file fail, FSFS will" NL
+"### fall back to normal file I/O.  Non-packed revisions are never mapped."  NL
+"### mmap-pack-files is disabled by default."                                NL
+"# " CONFIG_OPTION_MMAP_PACK_FILES " = false"                                NL
+"###"                                                                        NL
+"### FSFS keeps up to file-handle-cache-size rev / pack files open, along"   NL
+"### with their parsed footers, so it does not have to re-open them for"     NL
+"### each access.  Each open svn_fs_t has its own set of cached handles,"    NL
+"### i.e. a server process may keep a multiple of this many files open."     NL
+"### Set it to 0 to disable the cache.  Values larger than 256 will be"      NL
+"### capped."                                                                NL
+"### On Windows, only pack files will be cached."                            NL
+"### file-handle-cache-size defaults to 16."                                 NL
+"# " CONFIG_OPTION_FILE_HANDLE_CACHE_SIZE " = 16"                            NL
+"###"                                                                        NL
+"### If changes-index is enabled, 'svnadmin pack' stores the changed paths"  NL
+"### lists of each packed shard a second time in a compact binary index."    NL
+"### Each path is stored only once per shard and reading the index is much"  NL
+"### cheaper than parsing the lists in the pack file,  which speeds up"      NL
+"### 'svn log -v' and similar operations on packed revisions.  The index"    NL
+"### is only written for shards packed while this option is enabled but"     NL
+"### will be used whenever present.  It typically adds a few percent to"     NL
+"### the size of the packed revision data."                                  NL
+"### changes-index is disabled by default."                                  NL
+"# " CONFIG_OPTION_CHANGES_INDEX " = false"                                  NL
+"###"                                                                        NL
+"### If node-history-index is enabled, each commit records its new node"     NL
+"### revisions and their predecessors in a SQLite database.  'svn log' on"   NL
+"### a path and other history walks can then follow long stretches of a"     NL
+"### node's history with a single database query instead of reading one"     NL
+"### node revision from the revision files per change.  Revisions that"      NL
+"### were committed while this option was disabled are not indexed; their"   NL
+"### history is still being found the usual way.  The index is used"         NL
+"### whenever present."                                                      NL
+"### node-history-index is disabled by default."                             NL
+"# " CONFIG_OPTION_NODE_HISTORY_INDEX " = false"                             NL
+"###"                                                                        NL
+"### If mergeinfo-index is enabled, each commit also updates a catalog of"   NL
+"### all explicit mergeinfo in the repository, stored in parsed form in a"   NL
+"### SQLite database.  Mergeinfo queries on indexed revisions, e.g. during"  NL
+"### 'svn merge', then look up the mergeinfo of a whole sub-tree with a"     NL
+"### single query instead of crawling the tree and parsing the mergeinfo"    NL
+"### of every node.  After enabling this option, build the catalog for"      NL
+"### the youngest revision once with 'svnfsfs build-mergeinfo-index'."       NL
+"### Older revisions are not indexed.  Commits do not create the catalog"    NL
+"### but keep an existing one up to date, catching up on revisions that"     NL
+"### were committed while this option was disabled."                         NL
+"### mergeinfo-index is disabled by default."                                NL
+"# " CONFIG_OPTION_MERGEINFO_INDEX " = false"                                NL
+""                                                                           NL
+"[" CONFIG_SECTION_LOCKS "]"                                                 NL
+"### By default, every lock is stored in a file of its own and each parent"  NL
+"### directory keeps a list of all locks below it.  Listing or checking"     NL
+"### locks recursively thus reads one file per lock and taking a lock"       NL
+"### rewrites the lists of all its parents.  Enable the following option"    NL
+"### to keep all locks in a single SQLite database instead, which is much"   NL
+"### faster for repositories with many locks.  The existing locks are moved" NL
+"### into that database the next time a lock is taken or released.  From"    NL
+"### then on, the database is used regardless of this setting.  Subversion"  NL
+"### versions before 1.15 do not know about the database and will not see"   NL
+"### those locks, so don't enable this while such versions still access"     NL
+"### the repository."                                                        NL
+"### enable-lock-db is false by default."                                    NL
+"# " CONFIG_OPTION_ENABLE_LOCK_DB " = false"                                 NL
+""                                                                           NL
+"[" CONFIG_SECTION_CONCURRENCY "]"                                           NL
+"### Parameters in this section control how many threads FSFS may use to"    NL
+"### speed up maintenance operations.  They have no effect if Subversion"    NL
+"### has been built without thread support."                                 NL
+"###"                                                                        NL
+"### 'svnadmin pack' may pack up to this many shards concurrently.  Each"    NL
+"### shard still becomes visible in packed form strictly in order.  Memory"  NL
+"### usage and I/O load grow with the number of threads."                    NL
+"### pack-threads is 1 by default, i.e. shards get packed one at a time."    NL
+"# " CONFIG_OPTION_PACK_THREADS " = 1"                                       NL
+"###"                                                                        NL
+"### 'svnadmin hotcopy' may copy up to this many shards concurrently when"   NL
+"### this repository is the hotcopy source.  The destination still only"     NL
+"### sees revisions once all revisions before them have been copied."        NL
+"### hotcopy-threads is 1 by default, i.e. shards get copied one at a time." NL
+"# " CONFIG_OPTION_HOTCOPY_THREADS " = 1"                                    NL
 ""                                                                           NL
 "[" CONFIG_SECTION_DEBUG "]"                                                 NL
 "###"                                                                        NL
@@ -1167,6 +1381,7 @@ static svn_error_t *
 read_global_config(svn_fs_t *fs)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
+  apr_int64_t recovery_threads;
 
   ffd->use_block_read = svn_hash__get_bool(fs->config,
                                            SVN_FS_CONFIG_FSFS_BLOCK_READ,
@@ -1181,6 +1396,16 @@ read_global_config(svn_fs_t *fs)
   if (!ffd->use_block_read)
     ffd->block_size = MIN(0x1000, ffd->block_size);
 
+  /* Only used by svn_fs_fs__recover().  Don't accept unreasonable values. */
+  SVN_ERR(svn_cstring_strtoi64(&recovery_threads,
+                               svn_hash__get_cstring(
+                                   fs->config,
+                                   SVN_FS_CONFIG_FSFS_RECOVERY_JOBS,
+                                   "1"),
+                               1, APR_INT32_MAX, 10));
+  ffd->recovery_threads = (int)MIN(recovery_threads,
+                                   SVN_FS_FS__MAX_RECOVERY_THREADS);
+
   return SVN_NO_ERROR;
 }
 
@@ -1262,6 +1487,10 @@ svn_fs_fs__open(svn_fs_t *fs, const char *path, apr_pool_t *pool)
   /* Global configuration options. */
   SVN_ERR(read_global_config(fs));
 
+  /* Find out once where the locks are stored, so that lock lookups don't
+     have to. */
+  SVN_ERR(check_lock_db(fs, pool));
+
   ffd->youngest_rev_cache = 0;
 
   return SVN_NO_ERROR;
@@ -1952,6 +2181,13 @@ svn_fs_fs__create(svn_fs_t *fs,
           case 9: format = 7;
                   break;
 
+          case 10:
+          case 11:
+          case 12:
+          case 13:
+          case 14: format = 8;
+                  break;
+
           default:format = SVN_FS_FS__FORMAT_NUMBER;
         }
 
@@ -2323,8 +2559,11 @@ svn_fs_fs__info_format(int *fs_format,
     case 8:
       (*supports_version)->minor = 10;
       break;
+    case 9:
+      (*supports_version)->minor = 15;
+      break;
 #ifdef SVN_DEBUG
-# if SVN_FS_FS__FORMAT_NUMBER != 8
+# if SVN_FS_FS__FORMAT_NUMBER != 9
 #  error "Need to add a 'case' statement here"
 # endif
 #endif
@@ -2368,15 +2607,17 @@ ensure_representation_sha1(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
-/* Recursively index (in the rep-cache) the filesystem node with the
- * given ID, located in revision REV and its matching REV_FILE (if the
- * node ID cannot be found in this revision, do nothing).
- * Compute the SHA1 checksum of the node's representation and add
- * a corresponding entry to the repository's rep-cache.
+/* Recursively index the filesystem node with the given ID, located in
+ * revision REV and its matching REV_FILE (if the node ID cannot be found
+ * in this revision, do nothing).
+ * Compute the SHA1 checksum of the node's representation and append a
+ * copy of it, allocated in REPS->POOL, to REPS.  The caller will add
+ * those to the repository's rep-cache.
  * If the node represents a directory this function will recurse and
  * index all children of this directory as well. */
 static svn_error_t *
-reindex_node(svn_fs_t *fs,
+reindex_node(apr_array_header_t *reps,
+             svn_fs_t *fs,
              const svn_fs_id_t *id,
              svn_revnum_t rev,
              svn_fs_fs__revision_file_t *rev_file,
@@ -2427,7 +2668,7 @@ reindex_node(svn_fs_t *fs,
 
               dirent = APR_ARRAY_IDX(entries, i, svn_fs_dirent_t *);
 
-              SVN_ERR(reindex_node(fs, dirent->id, rev, rev_file,
+              SVN_ERR(reindex_node(reps, fs, dirent->id, rev, rev_file,
                                    cancel_func, cancel_baton, iterpool));
             }
           svn_pool_destroy(iterpool);
@@ -2438,22 +2679,216 @@ reindex_node(svn_fs_t *fs,
       noderev->kind == svn_node_file)
     {
       SVN_ERR(ensure_representation_sha1(fs, noderev->data_rep, pool));
-      SVN_ERR(svn_fs_fs__set_rep_reference(fs, noderev->data_rep, pool));
+      APR_ARRAY_PUSH(reps, representation_t *)
+        = svn_fs_fs__rep_copy(noderev->data_rep, reps->pool);
     }
 
   if (noderev->prop_rep && noderev->prop_rep->revision == rev)
     {
       SVN_ERR(ensure_representation_sha1(fs, noderev->prop_rep, pool));
-      SVN_ERR(svn_fs_fs__set_rep_reference(fs, noderev->prop_rep, pool));
+      APR_ARRAY_PUSH(reps, representation_t *)
+        = svn_fs_fs__rep_copy(noderev->prop_rep, reps->pool);
     }
 
   return SVN_NO_ERROR;
 }
 
+/* Set *REPS_P to the array of all representation_t * that revision REV
+ * in FS adds to the rep-cache, allocated in RESULT_POOL.  Use
+ * SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+collect_rev_reps(apr_array_header_t **reps_p,
+                 svn_fs_t *fs,
+                 svn_revnum_t rev,
+                 svn_cancel_func_t cancel_func,
+                 void *cancel_baton,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  svn_fs_id_t *root_id;
+  svn_fs_fs__revision_file_t *file;
+  apr_array_header_t *reps = apr_array_make(result_pool, 16,
+                                            sizeof(representation_t *));
+
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&file, fs, rev,
+                                           scratch_pool, scratch_pool));
+  SVN_ERR(svn_fs_fs__rev_get_root(&root_id, fs, rev, scratch_pool,
+                                  scratch_pool));
+  SVN_ERR(reindex_node(reps, fs, root_id, rev, file, cancel_func,
+                       cancel_baton, scratch_pool));
+  SVN_ERR(svn_fs_fs__close_revision_file(file));
+
+  *reps_p = reps;
+  return SVN_NO_ERROR;
+}
+
+/* Parameters shared by all parallel rep-cache building jobs. */
+typedef struct build_rep_cache_jobs_baton_t
+{
+  /* The repository whose rep-cache gets updated. */
+  svn_fs_t *fs;
+
+  /* The next revision to hand out, the last one to scan and the number
+     of revisions per job. */
+  svn_revnum_t next_rev;
+  svn_revnum_t end_rev;
+  svn_revnum_t chunk_size;
+
+  /* The caller's callbacks, as passed to svn_fs_fs__build_rep_cache. */
+  svn_fs_progress_notify_func_t progress_func;
+  void *progress_baton;
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+} build_rep_cache_jobs_baton_t;
+
+/* A range of revisions being scanned by a worker thread. */
+typedef struct build_rep_cache_job_t
+{
+  /* Private instance of the repository, used only by the worker. */
+  svn_fs_t *fs;
+
+  /* Revisions to scan. */
+  svn_revnum_t start_rev;
+  svn_revnum_t end_rev;
+
+  /* Outcome: one array of representation_t * per revision. */
+  apr_array_header_t **reps;
+} build_rep_cache_job_t;
+
+/* Implement svn__job_start_func_t for build_rep_cache_parallel().
+   BATON is a build_rep_cache_jobs_baton_t. */
+static svn_error_t *
+build_rep_cache_job_start(void **job_p,
+                          void *baton,
+                          apr_pool_t *job_pool,
+                          apr_pool_t *scratch_pool)
+{
+  build_rep_cache_jobs_baton_t *jobs = baton;
+  build_rep_cache_job_t *job;
+  svn_revnum_t chunk_size = jobs->chunk_size;
+
+  *job_p = NULL;
+  if (jobs->next_rev > jobs->end_rev)
+    return SVN_NO_ERROR;
+
+  job = apr_pcalloc(job_pool, sizeof(*job));
+  job->start_rev = jobs->next_rev;
+  job->end_rev = MIN(jobs->end_rev,
+                     (job->start_rev / chunk_size + 1) * chunk_size - 1);
+  job->reps = apr_pcalloc(job_pool, (job->end_rev - job->start_rev + 1)
+                                    * sizeof(*job->reps));
+  SVN_ERR(svn_fs_fs__open_clone(&job->fs, jobs->fs, job_pool,
+                                scratch_pool));
+
+  jobs->next_rev = job->end_rev + 1;
+  *job_p = job;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn__job_work_func_t for build_rep_cache_parallel(),
+   collecting the reps of all revisions of the build_rep_cache_job_t
+   JOB_BATON. */
+static svn_error_t *
+build_rep_cache_job_work(void *job_baton,
+                         svn_cancel_func_t cancel_func,
+                         void *cancel_baton,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool)
+{
+  build_rep_cache_job_t *job = job_baton;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_revnum_t rev;
+
+  for (rev = job->start_rev; rev <= job->end_rev; ++rev)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(collect_rev_reps(&job->reps[rev - job->start_rev],
+                               job->fs, rev, cancel_func, cancel_baton,
+                               result_pool, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn__job_finish_func_t for build_rep_cache_parallel(),
+   adding the reps found by the build_rep_cache_job_t JOB_BATON to the
+   rep-cache.  BATON is a build_rep_cache_jobs_baton_t. */
+static svn_error_t *
+build_rep_cache_job_finish(void *job_baton,
+                           svn_error_t *err,
+                           void *baton,
+                           apr_pool_t *scratch_pool)
+{
+  build_rep_cache_job_t *job = job_baton;
+  build_rep_cache_jobs_baton_t *jobs = baton;
+  apr_pool_t *iterpool;
+  svn_revnum_t rev;
+
+  SVN_ERR(err);
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (rev = job->start_rev; rev <= job->end_rev; ++rev)
+    {
+      svn_pool_clear(iterpool);
+
+      if (jobs->progress_func)
+        jobs->progress_func(rev, jobs->progress_baton, iterpool);
+
+      SVN_ERR(svn_fs_fs__set_rep_references(jobs->fs,
+                                            job->reps[rev - job->start_rev],
+                                            iterpool));
+      if (jobs->cancel_func)
+        SVN_ERR(jobs->cancel_func(jobs->cancel_baton));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn_fs_fs__build_rep_cache for START_REV through END_REV
+ * using up to JOBS worker threads that scan the revisions in
+ * shard-sized chunks.  The rep-cache gets updated by the calling thread
+ * strictly in revision order, one SQLite transaction per revision. */
+static svn_error_t *
+build_rep_cache_parallel(svn_fs_t *fs,
+                         svn_revnum_t start_rev,
+                         svn_revnum_t end_rev,
+                         int jobs,
+                         svn_fs_progress_notify_func_t progress_func,
+                         void *progress_baton,
+                         svn_cancel_func_t cancel_func,
+                         void *cancel_baton,
+                         apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  build_rep_cache_jobs_baton_t baton;
+
+  baton.fs = fs;
+  baton.next_rev = start_rev;
+  baton.end_rev = end_rev;
+  baton.chunk_size = ffd->max_files_per_dir
+                   ? ffd->max_files_per_dir
+                   : SVN_FS_FS_DEFAULT_MAX_FILES_PER_DIR;
+  baton.progress_func = progress_func;
+  baton.progress_baton = progress_baton;
+  baton.cancel_func = cancel_func;
+  baton.cancel_baton = cancel_baton;
+
+  return svn_error_trace(svn__jobs_run(jobs, build_rep_cache_job_start,
+                                       build_rep_cache_job_work,
+                                       build_rep_cache_job_finish, &baton,
+                                       cancel_func, cancel_baton, pool));
+}
+
 svn_error_t *
 svn_fs_fs__build_rep_cache(svn_fs_t *fs,
                            svn_revnum_t start_rev,
                            svn_revnum_t end_rev,
+                           int jobs,
                            svn_fs_progress_notify_func_t progress_func,
                            void *progress_baton,
                            svn_cancel_func_t cancel_func,
@@ -2495,27 +2930,27 @@ svn_fs_fs__build_rep_cache(svn_fs_t *fs,
   if (!ffd->rep_cache_db)
     SVN_ERR(svn_fs_fs__open_rep_cache(fs, pool));
 
+  /* Scan multiple revisions concurrently? */
+  if (jobs > 1 && start_rev < end_rev)
+    return svn_error_trace(build_rep_cache_parallel(fs, start_rev, end_rev,
+                                                    jobs, progress_func,
+                                                    progress_baton,
+                                                    cancel_func,
+                                                    cancel_baton, pool));
+
   iterpool = svn_pool_create(pool);
   for (rev = start_rev; rev <= end_rev; rev++)
     {
-      svn_fs_id_t *root_id;
-      svn_fs_fs__revision_file_t *file;
-      svn_error_t *err;
+      apr_array_header_t *reps;
 
       svn_pool_clear(iterpool);
 
       if (progress_func)
         progress_func(rev, progress_baton, iterpool);
 
-      SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&file, fs, rev,
-                                               iterpool, iterpool));
-      SVN_ERR(svn_fs_fs__rev_get_root(&root_id, fs, rev, iterpool, iterpool));
-
-      SVN_ERR(svn_sqlite__begin_transaction(ffd->rep_cache_db));
-      err = reindex_node(fs, root_id, rev, file, cancel_func, cancel_baton, iterpool);
-      SVN_ERR(svn_sqlite__finish_transaction(ffd->rep_cache_db, err));
-
-      SVN_ERR(svn_fs_fs__close_revision_file(file));
+      SVN_ERR(collect_rev_reps(&reps, fs, rev, cancel_func, cancel_baton,
+                               iterpool, iterpool));
+      SVN_ERR(svn_fs_fs__set_rep_references(fs, reps, iterpool));
     }
 
   svn_pool_destroy(iterpool);
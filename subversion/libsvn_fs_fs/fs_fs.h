@@ -39,6 +39,17 @@ svn_error_t *svn_fs_fs__open(svn_fs_t *fs,
                              const char *path,
                              apr_pool_t *pool);
 
+/* Open another instance of the filesystem FS and return it in *CLONE_P,
+   allocated in RESULT_POOL.  The clone shares FS's configuration and
+   process-wide data but has its own caches and file handles, such that
+   it can be used by a different thread than FS.  Unless the global
+   membuffer cache is thread-safe, the clone will not use it.
+   Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *svn_fs_fs__open_clone(svn_fs_t **clone_p,
+                                   svn_fs_t *fs,
+                                   apr_pool_t *result_pool,
+                                   apr_pool_t *scratch_pool);
+
 /* Initialize parts of the FS data that are being shared across multiple
    filesystem objects.  Use COMMON_POOL for process-wide and POOL for
    temporary allocations.  Use COMMON_POOL_LOCK to ensure that the
@@ -307,11 +318,18 @@ svn_fs_fs__reset_txn_caches(svn_fs_t *fs);
 /* Scan all contents of the repository FS and return statistics in *STATS,
  * allocated in RESULT_POOL.  Report progress through PROGRESS_FUNC with
  * PROGRESS_BATON, if PROGRESS_FUNC is not NULL.
+ *
+ * If JOBS is larger than 1 and APR supports threads, read up to JOBS
+ * shards concurrently.  The information on all representations that
+ * have already been processed is kept in a temporary file instead of
+ * in memory.
+ *
  * Use SCRATCH_POOL for temporary allocations.
  */
 svn_error_t *
 svn_fs_fs__get_stats(svn_fs_fs__stats_t **stats,
                      svn_fs_t *fs,
+                     int jobs,
                      svn_fs_progress_notify_func_t progress_func,
                      void *progress_baton,
                      svn_cancel_func_t cancel_func,
@@ -361,6 +379,10 @@ svn_fs_fs__revision_size(apr_off_t *rev_size,
  * SVN_INVALID_REVNUM, start at revision 1; if END_REV is SVN_INVALID_REVNUM,
  * end at the head revision. If the rep-cache does not exist, then create it.
  *
+ * If JOBS is larger than 1 and APR supports threads, scan up to JOBS
+ * chunks of revisions concurrently.  The rep-cache itself is still updated
+ * in revision order and by the calling thread only.
+ *
  * Indicate progress via the optional PROGRESS_FUNC callback using
  * PROGRESS_BATON. The optional CANCEL_FUNC will periodically be called with
  * CANCEL_BATON to allow cancellation. Use POOL for temporary allocations.
@@ -369,6 +391,7 @@ svn_error_t *
 svn_fs_fs__build_rep_cache(svn_fs_t *fs,
                            svn_revnum_t start_rev,
                            svn_revnum_t end_rev,
+                           int jobs,
                            svn_fs_progress_notify_func_t progress_func,
                            void *progress_baton,
                            svn_cancel_func_t cancel_func,
@@ -22,6 +22,8 @@
 #include "svn_pools.h"
 #include "svn_path.h"
 #include "svn_dirent_uri.h"
+#include "private/svn_io_private.h"
+#include "private/svn_subr_private.h"
 
 #include "fs_fs.h"
 #include "hotcopy.h"
@@ -29,6 +31,8 @@
 #include "recovery.h"
 #include "revprops.h"
 #include "rep-cache.h"
+#include "mergeinfo_index.h"
+#include "node_history.h"
 
 #include "../libsvn_fs/fs-loader.h"
 
@@ -38,12 +42,13 @@
  * the destination and do not differ in terms of kind, size, and mtime.
  * Set *SKIPPED_P to FALSE only if the file was copied, do not change
  * the value in *SKIPPED_P otherwise. SKIPPED_P may be NULL if not
- * required. */
+ * required.  If BATCH is not NULL, schedule the copy for fsync in it. */
 static svn_error_t *
 hotcopy_io_dir_file_copy(svn_boolean_t *skipped_p,
                          const char *src_path,
                          const char *dst_path,
                          const char *file,
+                         svn_io__batch_fsync_t *batch,
                          apr_pool_t *scratch_pool)
 {
   const svn_io_dirent2_t *src_dirent;
@@ -72,8 +77,12 @@ hotcopy_io_dir_file_copy(svn_boolean_t *skipped_p,
   if (skipped_p)
     *skipped_p = FALSE;
 
-  return svn_error_trace(svn_io_dir_file_copy(src_path, dst_path, file,
-                                              scratch_pool));
+  SVN_ERR(svn_io_dir_file_copy(src_path, dst_path, file, scratch_pool));
+  if (batch)
+    SVN_ERR(svn_io__batch_fsync_add_file(batch, dst_target,
+                                         scratch_pool));
+
+  return SVN_NO_ERROR;
 }
 
 /* Set *NAME_P to the UTF-8 representation of directory entry NAME.
@@ -115,13 +124,15 @@ entry_name_to_utf8(const char **name_p,
  * exist in the destination and do not differ from the source in terms of
  * kind, size, and mtime. Set *SKIPPED_P to FALSE only if at least one
  * file was copied, do not change the value in *SKIPPED_P otherwise.
- * SKIPPED_P may be NULL if not required. */
+ * SKIPPED_P may be NULL if not required.  If BATCH is not NULL, schedule
+ * all copied files and folders for fsync in it. */
 static svn_error_t *
 hotcopy_io_copy_dir_recursively(svn_boolean_t *skipped_p,
                                 const char *src,
                                 const char *dst_parent,
                                 const char *dst_basename,
                                 svn_boolean_t copy_perms,
+                                svn_io__batch_fsync_t *batch,
                                 svn_cancel_func_t cancel_func,
                                 void *cancel_baton,
                                 apr_pool_t *pool)
@@ -155,9 +166,15 @@ hotcopy_io_copy_dir_recursively(svn_boolean_t *skipped_p,
 
   SVN_ERR(svn_io_check_path(dst_path, &kind, subpool));
 
-  /* Create the new directory. */
+  /* Create the new directory.  Existing ones have been synced before,
+     so don't make incremental hotcopies flush them over and over. */
   /* ### TODO: copy permissions (needs apr_file_attrs_get()) */
-  SVN_ERR(svn_io_make_dir_recursively(dst_path, pool));
+  if (kind == svn_node_none)
+    {
+      SVN_ERR(svn_io_make_dir_recursively(dst_path, pool));
+      if (batch)
+        SVN_ERR(svn_io__batch_fsync_new_path(batch, dst_path, subpool));
+    }
 
   /* Loop over the dirents in SRC.  ('.' and '..' are auto-excluded) */
   SVN_ERR(svn_io_dir_open(&this_dir, src, subpool));
@@ -185,7 +202,8 @@ hotcopy_io_copy_dir_recursively(svn_boolean_t *skipped_p,
           if (this_entry.filetype == APR_REG) /* regular file */
             {
               SVN_ERR(hotcopy_io_dir_file_copy(skipped_p, src, dst_path,
-                                               entryname_utf8, subpool));
+                                               entryname_utf8, batch,
+                                               subpool));
             }
           else if (this_entry.filetype == APR_LNK) /* symlink */
             {
@@ -213,6 +231,7 @@ hotcopy_io_copy_dir_recursively(svn_boolean_t *skipped_p,
                                                       dst_path,
                                                       entryname_utf8,
                                                       copy_perms,
+                                                      batch,
                                                       cancel_func,
                                                       cancel_baton,
                                                       subpool));
@@ -241,6 +260,7 @@ hotcopy_io_copy_dir_recursively(svn_boolean_t *skipped_p,
  * to DST_SUBDIR. Assume a sharding layout based on MAX_FILES_PER_DIR.
  * Set *SKIPPED_P to FALSE only if the file was copied, do not change the
  * value in *SKIPPED_P otherwise. SKIPPED_P may be NULL if not required.
+ * Schedule all new files and folders for fsync in BATCH.
  * Use SCRATCH_POOL for temporary allocations. */
 static svn_error_t *
 hotcopy_copy_shard_file(svn_boolean_t *skipped_p,
@@ -248,6 +268,7 @@ hotcopy_copy_shard_file(svn_boolean_t *skipped_p,
                         const char *dst_subdir,
                         svn_revnum_t rev,
                         int max_files_per_dir,
+                        svn_io__batch_fsync_t *batch,
                         apr_pool_t *scratch_pool)
 {
   const char *src_subdir_shard = src_subdir,
@@ -262,16 +283,25 @@ hotcopy_copy_shard_file(svn_boolean_t *skipped_p,
 
       if (rev % max_files_per_dir == 0)
         {
-          SVN_ERR(svn_io_make_dir_recursively(dst_subdir_shard, scratch_pool));
-          SVN_ERR(svn_io_copy_perms(dst_subdir, dst_subdir_shard,
-                                    scratch_pool));
+          svn_node_kind_t kind;
+
+          SVN_ERR(svn_io_check_path(dst_subdir_shard, &kind, scratch_pool));
+          if (kind == svn_node_none)
+            {
+              SVN_ERR(svn_io_make_dir_recursively(dst_subdir_shard,
+                                                  scratch_pool));
+              SVN_ERR(svn_io_copy_perms(dst_subdir, dst_subdir_shard,
+                                        scratch_pool));
+              SVN_ERR(svn_io__batch_fsync_new_path(batch, dst_subdir_shard,
+                                                   scratch_pool));
+            }
         }
     }
 
   SVN_ERR(hotcopy_io_dir_file_copy(skipped_p,
                                    src_subdir_shard, dst_subdir_shard,
                                    apr_psprintf(scratch_pool, "%ld", rev),
-                                   scratch_pool));
+                                   batch, scratch_pool));
 
   return SVN_NO_ERROR;
 }
@@ -279,19 +309,21 @@ hotcopy_copy_shard_file(svn_boolean_t *skipped_p,
 
 /* Copy a packed shard containing revision REV, and which contains
  * MAX_FILES_PER_DIR revisions, from SRC_FS to DST_FS.
- * Update *DST_MIN_UNPACKED_REV in case the shard is new in DST_FS.
  * Do not re-copy data which already exists in DST_FS.
  * Set *SKIPPED_P to FALSE only if at least one part of the shard
  * was copied, do not change the value in *SKIPPED_P otherwise.
- * SKIPPED_P may be NULL if not required.
- * Use SCRATCH_POOL for temporary allocations. */
+ * SKIPPED_P may be NULL if not required.  Use BATCH to sync the copied
+ * data before returning.
+ *
+ * This does not modify SRC_FS or DST_FS and may be called from multiple
+ * threads concurrently.  Use SCRATCH_POOL for temporary allocations. */
 static svn_error_t *
 hotcopy_copy_packed_shard(svn_boolean_t *skipped_p,
-                          svn_revnum_t *dst_min_unpacked_rev,
                           svn_fs_t *src_fs,
                           svn_fs_t *dst_fs,
                           svn_revnum_t rev,
                           int max_files_per_dir,
+                          svn_io__batch_fsync_t *batch,
                           apr_pool_t *scratch_pool)
 {
   const char *src_subdir;
@@ -311,7 +343,7 @@ hotcopy_copy_packed_shard(svn_boolean_t *skipped_p,
                                             scratch_pool);
   SVN_ERR(hotcopy_io_copy_dir_recursively(skipped_p, src_subdir_packed_shard,
                                           dst_subdir, packed_shard,
-                                          TRUE /* copy_perms */,
+                                          TRUE /* copy_perms */, batch,
                                           NULL /* cancel_func */, NULL,
                                           scratch_pool));
 
@@ -332,7 +364,7 @@ hotcopy_copy_packed_shard(svn_boolean_t *skipped_p,
 
           SVN_ERR(hotcopy_copy_shard_file(skipped_p, src_subdir, dst_subdir,
                                           revprop_rev, max_files_per_dir,
-                                          iterpool));
+                                          batch, iterpool));
         }
       svn_pool_destroy(iterpool);
     }
@@ -341,7 +373,7 @@ hotcopy_copy_packed_shard(svn_boolean_t *skipped_p,
       /* revprop for revision 0 will never be packed */
       if (rev == 0)
         SVN_ERR(hotcopy_copy_shard_file(skipped_p, src_subdir, dst_subdir,
-                                        0, max_files_per_dir,
+                                        0, max_files_per_dir, batch,
                                         scratch_pool));
 
       /* packed revprops folder */
@@ -352,19 +384,13 @@ hotcopy_copy_packed_shard(svn_boolean_t *skipped_p,
       SVN_ERR(hotcopy_io_copy_dir_recursively(skipped_p,
                                               src_subdir_packed_shard,
                                               dst_subdir, packed_shard,
-                                              TRUE /* copy_perms */,
+                                              TRUE /* copy_perms */, batch,
                                               NULL /* cancel_func */, NULL,
                                               scratch_pool));
     }
 
-  /* If necessary, update the min-unpacked rev file in the hotcopy. */
-  if (*dst_min_unpacked_rev < rev + max_files_per_dir)
-    {
-      *dst_min_unpacked_rev = rev + max_files_per_dir;
-      SVN_ERR(svn_fs_fs__write_min_unpacked_rev(dst_fs,
-                                                *dst_min_unpacked_rev,
-                                                scratch_pool));
-    }
+  /* Flush everything we copied concurrently. */
+  SVN_ERR(svn_io__batch_fsync_run(batch, scratch_pool));
 
   return SVN_NO_ERROR;
 }
@@ -532,13 +558,342 @@ remove_folder(const char *path,
   return svn_error_trace(err);
 }
 
+/* Number of revisions that hotcopy_revisions() treats as one chunk in
+ * non-sharded repositories. */
+#define HOTCOPY_LINEAR_CHUNK_SIZE 1000
+
+/* Parameters shared by all steps of hotcopy_revisions(). */
+typedef struct hotcopy_revs_baton_t
+{
+  svn_fs_t *src_fs;
+  svn_fs_t *dst_fs;
+  svn_revnum_t src_min_unpacked_rev;
+  svn_revnum_t src_youngest;
+  svn_revnum_t dst_youngest;
+  svn_boolean_t incremental;
+  int max_files_per_dir;
+  const char *src_revs_dir;
+  const char *dst_revs_dir;
+  const char *src_revprops_dir;
+  const char *dst_revprops_dir;
+  svn_fs_hotcopy_notify_t notify_func;
+  void *notify_baton;
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+
+  /* Current value of the min-unpacked-rev file in DST_FS. */
+  svn_revnum_t dst_min_unpacked_rev;
+} hotcopy_revs_baton_t;
+
+/* Set *END_REV to the first revision after the chunk of revisions that
+ * starts at REV in the hotcopy given by B.  A chunk is either a packed
+ * shard or (up to) a shard of non-packed revisions.  Set *PACKED
+ * accordingly. */
+static void
+hotcopy_chunk_end(svn_revnum_t *end_rev,
+                  svn_boolean_t *packed,
+                  const hotcopy_revs_baton_t *b,
+                  svn_revnum_t rev)
+{
+  int chunk_size = b->max_files_per_dir
+                 ? b->max_files_per_dir
+                 : HOTCOPY_LINEAR_CHUNK_SIZE;
+
+  *packed = rev < b->src_min_unpacked_rev;
+  *end_rev = (rev / chunk_size + 1) * chunk_size;
+  if (*end_rev > b->src_youngest + 1)
+    *end_rev = b->src_youngest + 1;
+}
+
+/* Copy the chunk of revisions from START_REV up to but not including
+ * END_REV as given by PACKED from B->SRC_FS to B->DST_FS.  Do not re-copy
+ * data which already exists in DST_FS.  For each revision, set the
+ * respective element of SKIPPED to FALSE if anything has been copied.
+ * Flush the copied data to disk as configured for DST_FS.
+ *
+ * This does not modify B and may be called from multiple threads
+ * concurrently.  CANCEL_FUNC and CANCEL_BATON do the usual thing.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+hotcopy_copy_chunk(svn_boolean_t *skipped,
+                   const hotcopy_revs_baton_t *b,
+                   svn_revnum_t start_rev,
+                   svn_revnum_t end_rev,
+                   svn_boolean_t packed,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *dst_ffd = b->dst_fs->fsap_data;
+  svn_io__batch_fsync_t *batch;
+  apr_pool_t *iterpool;
+  svn_revnum_t rev;
+
+  /* Collect the files and folders that need to be synced. */
+  SVN_ERR(svn_io__batch_fsync_create(&batch, dst_ffd->flush_to_disk,
+                                     scratch_pool));
+
+  if (packed)
+    return svn_error_trace(hotcopy_copy_packed_shard(&skipped[0],
+                                                     b->src_fs, b->dst_fs,
+                                                     start_rev,
+                                                     b->max_files_per_dir,
+                                                     batch, scratch_pool));
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (rev = start_rev; rev < end_rev; rev++)
+    {
+      svn_boolean_t *rev_skipped = &skipped[rev - start_rev];
+
+      svn_pool_clear(iterpool);
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      /* Copying non-packed revisions is racy in case the source repository is
+       * being packed concurrently with this hotcopy operation. The race can
+       * happen with FS formats prior to SVN_FS_FS__MIN_PACK_LOCK_FORMAT that
+       * support packed revisions. With the pack lock, however, the race is
+       * impossible, because hotcopy and pack operations block each other.
+       *
+       * We assume that all revisions coming after 'min-unpacked-rev' really
+       * are unpacked and that's not necessarily true with concurrent packing.
+       * Don't try to be smart in this edge case, because handling it properly
+       * might require copying *everything* from the start. Just abort the
+       * hotcopy with an ENOENT (revision file moved to a pack, so it is no
+       * longer where we expect it to be). */
+
+      /* Copy the rev file. */
+      SVN_ERR(hotcopy_copy_shard_file(rev_skipped,
+                                      b->src_revs_dir, b->dst_revs_dir, rev,
+                                      b->max_files_per_dir, batch,
+                                      iterpool));
+      /* Copy the revprop file. */
+      SVN_ERR(hotcopy_copy_shard_file(rev_skipped,
+                                      b->src_revprops_dir,
+                                      b->dst_revprops_dir,
+                                      rev, b->max_files_per_dir, batch,
+                                      iterpool));
+
+      /* Flush both files concurrently.  Don't accumulate them across
+       * revisions to keep the number of open file handles low. */
+      SVN_ERR(svn_io__batch_fsync_run(batch, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Make the chunk of revisions from START_REV up to but not including
+ * END_REV as given by PACKED, which hotcopy_copy_chunk() has copied
+ * already, visible in B->DST_FS and notify the user about it.  SKIPPED
+ * is the per-revision result of hotcopy_copy_chunk().  Chunks must be
+ * finished strictly in order.  Use SCRATCH_POOL for temporary
+ * allocations. */
+static svn_error_t *
+hotcopy_finish_chunk(hotcopy_revs_baton_t *b,
+                     svn_revnum_t start_rev,
+                     svn_revnum_t end_rev,
+                     svn_boolean_t packed,
+                     const svn_boolean_t *skipped,
+                     apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *dst_ffd = b->dst_fs->fsap_data;
+  svn_revnum_t rev;
+
+  if (packed)
+    {
+      svn_revnum_t pack_end_rev = end_rev - 1;
+
+      /* If necessary, update the min-unpacked rev file in the hotcopy. */
+      if (b->dst_min_unpacked_rev < end_rev)
+        {
+          b->dst_min_unpacked_rev = end_rev;
+          SVN_ERR(svn_fs_fs__write_min_unpacked_rev(b->dst_fs,
+                                                    b->dst_min_unpacked_rev,
+                                                    scratch_pool));
+        }
+
+      /* Whenever this pack did not previously exist in the destination,
+       * update 'current' to the most recent packed rev (so readers can see
+       * new revisions which arrived in this pack). */
+      if (pack_end_rev > b->dst_youngest)
+        {
+          SVN_ERR(svn_fs_fs__write_current(b->dst_fs, pack_end_rev, 0, 0,
+                                           scratch_pool));
+        }
+
+      /* When notifying about packed shards, make things simpler by either
+       * reporting a full revision range, i.e [pack start, pack end] or
+       * reporting nothing. There is one case when this approach might not
+       * be exact (incremental hotcopy with a pack replacing last unpacked
+       * revisions), but generally this is good enough. */
+      if (b->notify_func && !skipped[0])
+        b->notify_func(b->notify_baton, start_rev, pack_end_rev,
+                       scratch_pool);
+
+      /* Remove revision files which are now packed. */
+      if (b->incremental)
+        {
+          SVN_ERR(hotcopy_remove_rev_files(b->dst_fs, start_rev, end_rev,
+                                           b->max_files_per_dir,
+                                           scratch_pool));
+          if (dst_ffd->format >= SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT)
+            SVN_ERR(hotcopy_remove_revprop_files(b->dst_fs, start_rev,
+                                                 end_rev,
+                                                 b->max_files_per_dir,
+                                                 scratch_pool));
+        }
+
+      /* Now that all revisions have moved into the pack, the original
+       * rev dir can be removed. */
+      SVN_ERR(remove_folder(svn_fs_fs__path_rev_shard(b->dst_fs, start_rev,
+                                                      scratch_pool),
+                            b->cancel_func, b->cancel_baton, scratch_pool));
+      if (   start_rev > 0
+          && dst_ffd->format >= SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT)
+        SVN_ERR(remove_folder(svn_fs_fs__path_revprops_shard(b->dst_fs,
+                                                             start_rev,
+                                                             scratch_pool),
+                              b->cancel_func, b->cancel_baton,
+                              scratch_pool));
+
+      return SVN_NO_ERROR;
+    }
+
+  for (rev = start_rev; rev < end_rev; rev++)
+    {
+      /* Whenever this revision did not previously exist in the destination,
+       * checkpoint the progress via 'current' (do that once per full shard
+       * in order not to slow things down). */
+      if (rev > b->dst_youngest)
+        {
+          if (b->max_files_per_dir && (rev % b->max_files_per_dir == 0))
+            {
+              SVN_ERR(svn_fs_fs__write_current(b->dst_fs, rev, 0, 0,
+                                               scratch_pool));
+            }
+        }
+
+      if (b->notify_func && !skipped[rev - start_rev])
+        b->notify_func(b->notify_baton, rev, rev, scratch_pool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Return a new array of COUNT svn_boolean_t elements, all set to TRUE,
+ * allocated in RESULT_POOL. */
+static svn_boolean_t *
+make_skipped_array(svn_revnum_t count,
+                   apr_pool_t *result_pool)
+{
+  svn_boolean_t *skipped = apr_palloc(result_pool, count * sizeof(*skipped));
+  svn_revnum_t i;
+
+  for (i = 0; i < count; ++i)
+    skipped[i] = TRUE;
+
+  return skipped;
+}
+
+/* Parameters shared by all hotcopy jobs. */
+typedef struct hotcopy_jobs_baton_t
+{
+  /* The hotcopy being executed.  Read-only for the workers. */
+  hotcopy_revs_baton_t *revs;
+
+  /* First revision of the next chunk to copy. */
+  svn_revnum_t next_rev;
+} hotcopy_jobs_baton_t;
+
+/* A chunk of revisions being copied by a worker thread. */
+typedef struct hotcopy_job_t
+{
+  /* Parameters as passed to hotcopy_copy_chunk(). */
+  const hotcopy_revs_baton_t *revs;
+  svn_revnum_t start_rev;
+  svn_revnum_t end_rev;
+  svn_boolean_t packed;
+
+  /* Outcome of hotcopy_copy_chunk(). */
+  svn_boolean_t *skipped;
+} hotcopy_job_t;
+
+/* Implement svn__job_start_func_t for hotcopy_revisions().  BATON is a
+   hotcopy_jobs_baton_t. */
+static svn_error_t *
+hotcopy_job_start(void **job_p,
+                  void *baton,
+                  apr_pool_t *job_pool,
+                  apr_pool_t *scratch_pool)
+{
+  hotcopy_jobs_baton_t *jobs = baton;
+  hotcopy_job_t *job;
+
+  *job_p = NULL;
+  if (jobs->next_rev > jobs->revs->src_youngest)
+    return SVN_NO_ERROR;
+
+  job = apr_pcalloc(job_pool, sizeof(*job));
+  job->revs = jobs->revs;
+  job->start_rev = jobs->next_rev;
+  hotcopy_chunk_end(&job->end_rev, &job->packed, jobs->revs,
+                    job->start_rev);
+  job->skipped = make_skipped_array(job->end_rev - job->start_rev,
+                                    job_pool);
+
+  jobs->next_rev = job->end_rev;
+  *job_p = job;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn__job_work_func_t for hotcopy_revisions(), copying the
+   chunk of the hotcopy_job_t JOB_BATON. */
+static svn_error_t *
+hotcopy_job_work(void *job_baton,
+                 svn_cancel_func_t cancel_func,
+                 void *cancel_baton,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  hotcopy_job_t *job = job_baton;
+
+  return svn_error_trace(hotcopy_copy_chunk(job->skipped, job->revs,
+                                            job->start_rev, job->end_rev,
+                                            job->packed, cancel_func,
+                                            cancel_baton, scratch_pool));
+}
+
+/* Implement svn__job_finish_func_t for hotcopy_revisions(), making the
+   chunk of the hotcopy_job_t JOB_BATON visible in the destination.
+   BATON is a hotcopy_jobs_baton_t.  Whatever failed jobs copied will
+   simply be re-used by the next attempt. */
+static svn_error_t *
+hotcopy_job_finish(void *job_baton,
+                   svn_error_t *err,
+                   void *baton,
+                   apr_pool_t *scratch_pool)
+{
+  hotcopy_job_t *job = job_baton;
+  hotcopy_jobs_baton_t *jobs = baton;
+
+  SVN_ERR(err);
+
+  return svn_error_trace(hotcopy_finish_chunk(jobs->revs, job->start_rev,
+                                              job->end_rev, job->packed,
+                                              job->skipped, scratch_pool));
+}
+
 /* Copy the revision and revprop files (possibly sharded / packed) from
  * SRC_FS to DST_FS.  Do not re-copy data which already exists in DST_FS.
  * When copying packed or unpacked shards, checkpoint the result in DST_FS
  * for every shard by updating the 'current' file if necessary.  Assume
  * the >= SVN_FS_FS__MIN_NO_GLOBAL_IDS_FORMAT filesystem format without
  * global next-ID counters.  Indicate progress via the optional NOTIFY_FUNC
- * callback using NOTIFY_BATON.  Use POOL for temporary allocations.
+ * callback using NOTIFY_BATON.  Copy up to SRC_FS' hotcopy-threads shards
+ * concurrently.  Use POOL for temporary allocations.
  */
 static svn_error_t *
 hotcopy_revisions(svn_fs_t *src_fs,
@@ -557,12 +912,10 @@ hotcopy_revisions(svn_fs_t *src_fs,
                   apr_pool_t *pool)
 {
   fs_fs_data_t *src_ffd = src_fs->fsap_data;
-  fs_fs_data_t *dst_ffd = dst_fs->fsap_data;
-  int max_files_per_dir = src_ffd->max_files_per_dir;
+  hotcopy_revs_baton_t b;
+  hotcopy_jobs_baton_t jobs;
   svn_revnum_t src_min_unpacked_rev;
   svn_revnum_t dst_min_unpacked_rev;
-  svn_revnum_t rev;
-  apr_pool_t *iterpool;
 
   /* Copy the min unpacked rev, and read its value. */
   if (src_ffd->format >= SVN_FS_FS__MIN_PACKED_FORMAT)
@@ -596,131 +949,45 @@ hotcopy_revisions(svn_fs_t *src_fs,
   if (cancel_func)
     SVN_ERR(cancel_func(cancel_baton));
 
+  b.src_fs = src_fs;
+  b.dst_fs = dst_fs;
+  b.src_min_unpacked_rev = src_min_unpacked_rev;
+  b.src_youngest = src_youngest;
+  b.dst_youngest = dst_youngest;
+  b.incremental = incremental;
+  b.max_files_per_dir = src_ffd->max_files_per_dir;
+  b.src_revs_dir = src_revs_dir;
+  b.dst_revs_dir = dst_revs_dir;
+  b.src_revprops_dir = src_revprops_dir;
+  b.dst_revprops_dir = dst_revprops_dir;
+  b.notify_func = notify_func;
+  b.notify_baton = notify_baton;
+  b.cancel_func = cancel_func;
+  b.cancel_baton = cancel_baton;
+  b.dst_min_unpacked_rev = dst_min_unpacked_rev;
+
   /*
-   * Copy the necessary rev files.
+   * Copy the necessary rev files, first the packed shards and then
+   * pairs of non-packed revisions and revprop files.  If necessary,
+   * update 'current' after copying all files from a shard.
    */
 
-  iterpool = svn_pool_create(pool);
-  /* First, copy packed shards. */
-  for (rev = 0; rev < src_min_unpacked_rev; rev += max_files_per_dir)
-    {
-      svn_boolean_t skipped = TRUE;
-      svn_revnum_t pack_end_rev;
-
-      svn_pool_clear(iterpool);
-
-      if (cancel_func)
-        SVN_ERR(cancel_func(cancel_baton));
-
-      /* Copy the packed shard. */
-      SVN_ERR(hotcopy_copy_packed_shard(&skipped, &dst_min_unpacked_rev,
-                                        src_fs, dst_fs,
-                                        rev, max_files_per_dir,
-                                        iterpool));
-
-      pack_end_rev = rev + max_files_per_dir - 1;
-
-      /* Whenever this pack did not previously exist in the destination,
-       * update 'current' to the most recent packed rev (so readers can see
-       * new revisions which arrived in this pack). */
-      if (pack_end_rev > dst_youngest)
-        {
-          SVN_ERR(svn_fs_fs__write_current(dst_fs, pack_end_rev, 0, 0,
-                                           iterpool));
-        }
-
-      /* When notifying about packed shards, make things simpler by either
-       * reporting a full revision range, i.e [pack start, pack end] or
-       * reporting nothing. There is one case when this approach might not
-       * be exact (incremental hotcopy with a pack replacing last unpacked
-       * revisions), but generally this is good enough. */
-      if (notify_func && !skipped)
-        notify_func(notify_baton, rev, pack_end_rev, iterpool);
-
-      /* Remove revision files which are now packed. */
-      if (incremental)
-        {
-          SVN_ERR(hotcopy_remove_rev_files(dst_fs, rev,
-                                           rev + max_files_per_dir,
-                                           max_files_per_dir, iterpool));
-          if (dst_ffd->format >= SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT)
-            SVN_ERR(hotcopy_remove_revprop_files(dst_fs, rev,
-                                                 rev + max_files_per_dir,
-                                                 max_files_per_dir,
-                                                 iterpool));
-        }
-
-      /* Now that all revisions have moved into the pack, the original
-       * rev dir can be removed. */
-      SVN_ERR(remove_folder(svn_fs_fs__path_rev_shard(dst_fs, rev, iterpool),
-                            cancel_func, cancel_baton, iterpool));
-      if (rev > 0 && dst_ffd->format >= SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT)
-        SVN_ERR(remove_folder(svn_fs_fs__path_revprops_shard(dst_fs, rev,
-                                                             iterpool),
-                              cancel_func, cancel_baton, iterpool));
-    }
+  /* Copy up to hotcopy-threads chunks concurrently.  The chunks get
+     finished strictly in order, so the destination only ever shows
+     gapless revision ranges. */
+  jobs.revs = &b;
+  jobs.next_rev = 0;
+  SVN_ERR(svn__jobs_run(src_ffd->hotcopy_threads, hotcopy_job_start,
+                        hotcopy_job_work, hotcopy_job_finish, &jobs,
+                        cancel_func, cancel_baton, pool));
 
   if (cancel_func)
     SVN_ERR(cancel_func(cancel_baton));
 
-  SVN_ERR_ASSERT(rev == src_min_unpacked_rev);
-  SVN_ERR_ASSERT(src_min_unpacked_rev == dst_min_unpacked_rev);
-
-  /* Now, copy pairs of non-packed revisions and revprop files.
-   * If necessary, update 'current' after copying all files from a shard. */
-  for (; rev <= src_youngest; rev++)
-    {
-      svn_boolean_t skipped = TRUE;
-
-      svn_pool_clear(iterpool);
-
-      if (cancel_func)
-        SVN_ERR(cancel_func(cancel_baton));
-
-      /* Copying non-packed revisions is racy in case the source repository is
-       * being packed concurrently with this hotcopy operation. The race can
-       * happen with FS formats prior to SVN_FS_FS__MIN_PACK_LOCK_FORMAT that
-       * support packed revisions. With the pack lock, however, the race is
-       * impossible, because hotcopy and pack operations block each other.
-       *
-       * We assume that all revisions coming after 'min-unpacked-rev' really
-       * are unpacked and that's not necessarily true with concurrent packing.
-       * Don't try to be smart in this edge case, because handling it properly
-       * might require copying *everything* from the start. Just abort the
-       * hotcopy with an ENOENT (revision file moved to a pack, so it is no
-       * longer where we expect it to be). */
-
-      /* Copy the rev file. */
-      SVN_ERR(hotcopy_copy_shard_file(&skipped,
-                                      src_revs_dir, dst_revs_dir, rev,
-                                      max_files_per_dir,
-                                      iterpool));
-      /* Copy the revprop file. */
-      SVN_ERR(hotcopy_copy_shard_file(&skipped,
-                                      src_revprops_dir, dst_revprops_dir,
-                                      rev, max_files_per_dir,
-                                      iterpool));
-
-      /* Whenever this revision did not previously exist in the destination,
-       * checkpoint the progress via 'current' (do that once per full shard
-       * in order not to slow things down). */
-      if (rev > dst_youngest)
-        {
-          if (max_files_per_dir && (rev % max_files_per_dir == 0))
-            {
-              SVN_ERR(svn_fs_fs__write_current(dst_fs, rev, 0, 0,
-                                               iterpool));
-            }
-        }
-
-      if (notify_func && !skipped)
-        notify_func(notify_baton, rev, rev, iterpool);
-    }
-  svn_pool_destroy(iterpool);
-
-  /* We assume that all revisions were copied now, i.e. we didn't exit the
-   * above loop early. 'rev' was last incremented during exit of the loop. */
-  SVN_ERR_ASSERT(rev == src_youngest + 1);
+  /* We assume that all revisions were copied now, i.e. the jobs didn't
+   * stop early. */
+  SVN_ERR_ASSERT(src_min_unpacked_rev == b.dst_min_unpacked_rev);
+  SVN_ERR_ASSERT(jobs.next_rev == src_youngest + 1);
 
   return SVN_NO_ERROR;
 }
@@ -749,6 +1016,11 @@ hotcopy_revisions_old(svn_fs_t *src_fs,
 {
   apr_pool_t *iterpool = svn_pool_create(pool);
   svn_revnum_t rev;
+  fs_fs_data_t *dst_ffd = dst_fs->fsap_data;
+  svn_io__batch_fsync_t *batch;
+
+  SVN_ERR(svn_io__batch_fsync_create(&batch, dst_ffd->flush_to_disk,
+                                     pool));
 
   for (rev = 0; rev <= src_youngest; rev++)
     {
@@ -761,11 +1033,12 @@ hotcopy_revisions_old(svn_fs_t *src_fs,
 
       SVN_ERR(hotcopy_io_dir_file_copy(&skipped, src_revs_dir, dst_revs_dir,
                                        apr_psprintf(iterpool, "%ld", rev),
-                                       iterpool));
+                                       batch, iterpool));
       SVN_ERR(hotcopy_io_dir_file_copy(&skipped, src_revprops_dir,
                                        dst_revprops_dir,
                                        apr_psprintf(iterpool, "%ld", rev),
-                                       iterpool));
+                                       batch, iterpool));
+      SVN_ERR(svn_io__batch_fsync_run(batch, iterpool));
 
       if (notify_func && !skipped)
         notify_func(notify_baton, rev, rev, iterpool);
@@ -959,12 +1232,49 @@ hotcopy_body(void *baton, apr_pool_t *pool)
                                         PATH_LOCKS_DIR, TRUE,
                                         cancel_func, cancel_baton, pool));
 
+  /* Same for the lock database, which replaces the locks tree when
+   * present. */
+  dst_subdir = svn_dirent_join(dst_fs->path, PATH_LOCK_DB, pool);
+  SVN_ERR(svn_io_remove_file2(dst_subdir, TRUE, pool));
+  src_subdir = svn_dirent_join(src_fs->path, PATH_LOCK_DB, pool);
+  SVN_ERR(svn_io_check_path(src_subdir, &kind, pool));
+  if (kind == svn_node_file)
+    {
+      SVN_ERR(svn_sqlite__hotcopy(src_subdir, dst_subdir, pool));
+      SVN_ERR(svn_io_set_file_read_write(dst_subdir, FALSE, pool));
+    }
+
+  /* Replace the node history index as well and remove entries for
+   * revisions that did not make it into the destination. */
+  dst_subdir = svn_dirent_join(dst_fs->path, PATH_NODE_HISTORY_DB, pool);
+  SVN_ERR(svn_io_remove_file2(dst_subdir, TRUE, pool));
+  src_subdir = svn_dirent_join(src_fs->path, PATH_NODE_HISTORY_DB, pool);
+  SVN_ERR(svn_io_check_path(src_subdir, &kind, pool));
+  if (kind == svn_node_file)
+    {
+      SVN_ERR(svn_sqlite__hotcopy(src_subdir, dst_subdir, pool));
+      SVN_ERR(svn_io_set_file_read_write(dst_subdir, FALSE, pool));
+      SVN_ERR(svn_fs_fs__prune_node_history(dst_fs, src_youngest, pool));
+    }
+
+  /* The same goes for the mergeinfo index. */
+  dst_subdir = svn_dirent_join(dst_fs->path, PATH_MERGEINFO_DB, pool);
+  SVN_ERR(svn_io_remove_file2(dst_subdir, TRUE, pool));
+  src_subdir = svn_dirent_join(src_fs->path, PATH_MERGEINFO_DB, pool);
+  SVN_ERR(svn_io_check_path(src_subdir, &kind, pool));
+  if (kind == svn_node_file)
+    {
+      SVN_ERR(svn_sqlite__hotcopy(src_subdir, dst_subdir, pool));
+      SVN_ERR(svn_io_set_file_read_write(dst_subdir, FALSE, pool));
+      SVN_ERR(svn_fs_fs__prune_mergeinfo_index(dst_fs, src_youngest, pool));
+    }
+
   /* Now copy the node-origins cache tree. */
   src_subdir = svn_dirent_join(src_fs->path, PATH_NODE_ORIGINS_DIR, pool);
   SVN_ERR(svn_io_check_path(src_subdir, &kind, pool));
   if (kind == svn_node_dir)
     SVN_ERR(hotcopy_io_copy_dir_recursively(NULL, src_subdir, dst_fs->path,
-                                            PATH_NODE_ORIGINS_DIR, TRUE,
+                                            PATH_NODE_ORIGINS_DIR, TRUE, NULL,
                                             cancel_func, cancel_baton, pool));
 
   /*
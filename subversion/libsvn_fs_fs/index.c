@@ -66,9 +66,25 @@ const apr_uint64_t off_t_max = (sizeof(apr_off_t) == sizeof(apr_int64_t))
 /* We put this string in front of the P2L index header. */
 #define P2L_STREAM_PREFIX "P2L-INDEX\n"
 
+/* Same as above for indexes that store their pages in the block-packed
+ * format (see SVN_FS_FS__MIN_BLOCK_PACKED_INDEX_FORMAT). */
+#define L2P_PACKED_STREAM_PREFIX "L2P-PACKED\n"
+#define P2L_PACKED_STREAM_PREFIX "P2L-PACKED\n"
+
 /* Size of the buffer that will fit the index header prefixes. */
-#define STREAM_PREFIX_LEN MAX(sizeof(L2P_STREAM_PREFIX), \
-                              sizeof(P2L_STREAM_PREFIX))
+#define STREAM_PREFIX_LEN MAX(MAX(sizeof(L2P_STREAM_PREFIX), \
+                                  sizeof(P2L_STREAM_PREFIX)), \
+                              MAX(sizeof(L2P_PACKED_STREAM_PREFIX), \
+                                  sizeof(P2L_PACKED_STREAM_PREFIX)))
+
+/* Block-packed index pages split their value arrays into blocks of up to
+ * this many values.  All values within a block share the same base value
+ * and bit width. */
+enum { PACKED_BLOCK_SIZE = 128 };
+
+/* Number of columns in a block-packed P2L index page: item size, item
+ * compound, revision and FNV checksum. */
+enum { P2L_PACKED_COLUMNS = 4 };
 
 /* Page tables in the log-to-phys index file exclusively contain entries
  * of this type to describe position and size of a given page.
@@ -211,6 +227,16 @@ struct svn_fs_fs__packed_number_stream_t
   /* read the file in chunks of this size */
   apr_size_t block_size;
 
+  /* If not NULL, the stream data from STREAM_START to STREAM_END has been
+   * memory-mapped and is available starting at this address.  We will
+   * then decode directly from memory instead of reading from FILE. */
+  const unsigned char *mapped_data;
+
+  /* If set, the index pages use the block-packed format and must be read
+   * with packed_stream_read_raw().  Only the index headers and page tables
+   * are 7b/8b encoded then. */
+  svn_boolean_t block_packed;
+
   /* pool to be used for file ops etc. */
   apr_pool_t *pool;
 
@@ -250,43 +276,59 @@ SVN__PREVENT_INLINE
 static svn_error_t *
 packed_stream_read(svn_fs_fs__packed_number_stream_t *stream)
 {
-  unsigned char buffer[MAX_NUMBER_PREFETCH];
+  unsigned char file_buffer[MAX_NUMBER_PREFETCH];
+  const unsigned char *buffer;
   apr_size_t bytes_read = 0;
   apr_size_t i;
   value_position_pair_t *target;
   apr_off_t block_start = 0;
   apr_off_t block_left = 0;
-  apr_status_t err;
+  apr_status_t err = APR_SUCCESS;
 
   /* all buffered data will have been read starting here */
   stream->start_offset = stream->next_offset;
 
-  /* packed numbers are usually not aligned to MAX_NUMBER_PREFETCH blocks,
-   * i.e. the last number has been incomplete (and not buffered in stream)
-   * and need to be re-read.  Therefore, always correct the file pointer.
-   */
-  SVN_ERR(svn_io_file_aligned_seek(stream->file, stream->block_size,
-                                   &block_start, stream->next_offset,
-                                   stream->pool));
+  /* prefetch at least one number but don't read beyond the end of the
+   * file section that belongs to this index / stream. */
+  bytes_read = sizeof(file_buffer);
+  if (stream->mapped_data)
+    {
+      /* The index data is already in memory.  Simply decode from there;
+       * there are no block boundaries to take care of. */
+      bytes_read = (apr_size_t)MIN(bytes_read,
+                                   stream->stream_end - stream->next_offset);
+      buffer = stream->mapped_data
+             + (stream->next_offset - stream->stream_start);
+    }
+  else
+    {
+      /* packed numbers are usually not aligned to MAX_NUMBER_PREFETCH
+       * blocks, i.e. the last number has been incomplete (and not buffered
+       * in stream) and need to be re-read.  Therefore, always correct the
+       * file pointer.
+       */
+      SVN_ERR(svn_io_file_aligned_seek(stream->file, stream->block_size,
+                                       &block_start, stream->next_offset,
+                                       stream->pool));
 
-  /* prefetch at least one number but, if feasible, don't cross block
-   * boundaries.  This shall prevent jumping back and forth between two
-   * blocks because the extra data was not actually request _now_.
-   */
-  bytes_read = sizeof(buffer);
-  block_left = stream->block_size - (stream->next_offset - block_start);
-  if (block_left >= 10 && block_left < bytes_read)
-    bytes_read = (apr_size_t)block_left;
-
-  /* Don't read beyond the end of the file section that belongs to this
-   * index / stream. */
-  bytes_read = (apr_size_t)MIN(bytes_read,
-                               stream->stream_end - stream->next_offset);
-
-  err = apr_file_read(stream->file, buffer, &bytes_read);
-  if (err && !APR_STATUS_IS_EOF(err))
-    return stream_error_create(stream, err,
-      _("Can't read index file '%s' at offset 0x%s"));
+      /* If feasible, don't cross block boundaries.  This shall prevent
+       * jumping back and forth between two blocks because the extra data
+       * was not actually request _now_.
+       */
+      block_left = stream->block_size - (stream->next_offset - block_start);
+      if (block_left >= 10 && block_left < bytes_read)
+        bytes_read = (apr_size_t)block_left;
+
+      bytes_read = (apr_size_t)MIN(bytes_read,
+                                   stream->stream_end - stream->next_offset);
+
+      err = apr_file_read(stream->file, file_buffer, &bytes_read);
+      if (err && !APR_STATUS_IS_EOF(err))
+        return stream_error_create(stream, err,
+          _("Can't read index file '%s' at offset 0x%s"));
+
+      buffer = file_buffer;
+    }
 
   /* if the last number is incomplete, trim it from the buffer */
   while (bytes_read > 0 && buffer[bytes_read-1] >= 0x80)
@@ -345,38 +387,71 @@ packed_stream_read(svn_fs_fs__packed_number_stream_t *stream)
 
 /* Create and open a packed number stream reading from offsets START to
  * END in FILE and return it in *STREAM.  Access the file in chunks of
- * BLOCK_SIZE bytes.  Expect the stream to be prefixed by STREAM_PREFIX.
+ * BLOCK_SIZE bytes.  Expect the stream to be prefixed by either
+ * STREAM_PREFIX or PACKED_STREAM_PREFIX.  The latter indicates that the
+ * index pages are block-packed.
+ * If MAPPED_DATA is not NULL, it contains the file contents from START
+ * to END and will be used instead of reading from FILE.
  * Allocate *STREAM in RESULT_POOL and use SCRATCH_POOL for temporaries.
  */
 static svn_error_t *
 packed_stream_open(svn_fs_fs__packed_number_stream_t **stream,
                    apr_file_t *file,
+                   const char *mapped_data,
                    apr_off_t start,
                    apr_off_t end,
                    const char *stream_prefix,
+                   const char *packed_stream_prefix,
                    apr_size_t block_size,
                    apr_pool_t *result_pool,
                    apr_pool_t *scratch_pool)
 {
   char buffer[STREAM_PREFIX_LEN + 1] = { 0 };
   apr_size_t len = strlen(stream_prefix);
+  apr_size_t packed_len = strlen(packed_stream_prefix);
+  apr_size_t read_len = MAX(len, packed_len);
+  svn_boolean_t block_packed;
   svn_fs_fs__packed_number_stream_t *result;
 
   /* If this is violated, we forgot to adjust STREAM_PREFIX_LEN after
    * changing the index header prefixes. */
-  SVN_ERR_ASSERT(len < sizeof(buffer));
+  SVN_ERR_ASSERT(read_len < sizeof(buffer));
 
-  /* Read the header prefix and compare it with the expected prefix */
-  SVN_ERR(svn_io_file_aligned_seek(file, block_size, NULL, start,
-                                   scratch_pool));
-  SVN_ERR(svn_io_file_read_full2(file, buffer, len, NULL, NULL,
-                                 scratch_pool));
+  /* Both prefixes are shorter than any valid index.  But don't read
+   * beyond the end of the index if it has been truncated. */
+  if (end - start < (apr_off_t)read_len)
+    read_len = (apr_size_t)MAX(end - start, 0);
 
-  if (strncmp(buffer, stream_prefix, len))
-    return svn_error_createf(SVN_ERR_FS_INDEX_CORRUPTION, NULL,
-                             _("Index stream header prefix mismatch.\n"
-                               "  expected: %s"
-                               "  found: %s"), stream_prefix, buffer);
+  /* Read the header prefix and compare it with the expected prefixes */
+  if (mapped_data)
+    {
+      memcpy(buffer, mapped_data, read_len);
+    }
+  else
+    {
+      SVN_ERR(svn_io_file_aligned_seek(file, block_size, NULL, start,
+                                       scratch_pool));
+      SVN_ERR(svn_io_file_read_full2(file, buffer, read_len, NULL, NULL,
+                                     scratch_pool));
+    }
+
+  if (read_len >= len && !strncmp(buffer, stream_prefix, len))
+    {
+      block_packed = FALSE;
+    }
+  else if (   read_len >= packed_len
+           && !strncmp(buffer, packed_stream_prefix, packed_len))
+    {
+      block_packed = TRUE;
+      len = packed_len;
+    }
+  else
+    {
+      return svn_error_createf(SVN_ERR_FS_INDEX_CORRUPTION, NULL,
+                               _("Index stream header prefix mismatch.\n"
+                                 "  expected: %s"
+                                 "  found: %s"), stream_prefix, buffer);
+    }
 
   /* Construct the actual stream object. */
   result = apr_palloc(result_pool, sizeof(*result));
@@ -391,6 +466,10 @@ packed_stream_open(svn_fs_fs__packed_number_stream_t **stream,
   result->start_offset = result->stream_start;
   result->next_offset = result->stream_start;
   result->block_size = block_size;
+  result->mapped_data = mapped_data
+                      ? (const unsigned char *)mapped_data + len
+                      : NULL;
+  result->block_packed = block_packed;
 
   *stream = result;
 
@@ -464,6 +543,45 @@ packed_stream_offset(svn_fs_fs__packed_number_stream_t *stream)
   return file_offset - stream->stream_start;
 }
 
+/* Return in *DATA the LEN bytes of raw, i.e. not 7b/8b encoded, data that
+ * start at packed stream offset OFFSET in STREAM.  The buffered numbers in
+ * STREAM are not affected.  If STREAM has been memory-mapped, *DATA will
+ * point into the mapped data.  Otherwise, allocate *DATA in RESULT_POOL.
+ */
+static svn_error_t *
+packed_stream_read_raw(const unsigned char **data,
+                       svn_fs_fs__packed_number_stream_t *stream,
+                       apr_off_t offset,
+                       apr_size_t len,
+                       apr_pool_t *result_pool)
+{
+  apr_off_t file_offset = offset + stream->stream_start;
+  unsigned char *buffer;
+
+  if SVN__PREDICT_FALSE(   offset < 0
+                        || file_offset > stream->stream_end
+                        || stream->stream_end - file_offset
+                             < (apr_off_t)len)
+    return svn_error_create(SVN_ERR_FS_INDEX_CORRUPTION, NULL,
+                            _("Index page extends beyond the end of the "
+                              "index"));
+
+  if (stream->mapped_data)
+    {
+      *data = stream->mapped_data + offset;
+      return SVN_NO_ERROR;
+    }
+
+  buffer = apr_palloc(result_pool, len);
+  SVN_ERR(svn_io_file_aligned_seek(stream->file, stream->block_size, NULL,
+                                   file_offset, result_pool));
+  SVN_ERR(svn_io_file_read_full2(stream->file, buffer, len, NULL, NULL,
+                                 result_pool));
+  *data = buffer;
+
+  return SVN_NO_ERROR;
+}
+
 /* Encode VALUE as 7/8b into P and return the number of bytes written.
  * This will be used when _writing_ packed data.  packed_stream_* is for
  * read operations only.
@@ -483,13 +601,22 @@ encode_uint(unsigned char *p, apr_uint64_t value)
   return (p - start) + 1;
 }
 
+/* Map signed VALUE onto the unsigned value space.
+ * This is the inverse of decode_int().
+ */
+static apr_uint64_t
+map_int(apr_int64_t value)
+{
+  return (apr_uint64_t)(value < 0 ? -1 - 2*value : 2*value);
+}
+
 /* Encode VALUE as 7/8b into P and return the number of bytes written.
  * This maps signed ints onto unsigned ones.
  */
 static apr_size_t
 encode_int(unsigned char *p, apr_int64_t value)
 {
-  return encode_uint(p, (apr_uint64_t)(value < 0 ? -1 - 2*value : 2*value));
+  return encode_uint(p, map_int(value));
 }
 
 /* Append VALUE to STREAM in 7/8b encoding.
@@ -512,6 +639,264 @@ decode_int(apr_uint64_t value)
   return (apr_int64_t)(value % 2 ? -1 - value / 2 : value / 2);
 }
 
+/*
+ * block-packed values
+ *
+ * Index pages in format SVN_FS_FS__MIN_BLOCK_PACKED_INDEX_FORMAT and newer
+ * store arrays of unsigned integers as a sequence of blocks with up to
+ * PACKED_BLOCK_SIZE values each.  All values in a block are stored as
+ * fixed-width differences to the smallest value in that block (frame of
+ * reference).  Decoding these requires no per-byte branching and the
+ * fixed widths make the pages cheaper to decode than 7b/8b numbers.
+ */
+
+/* Return the number of significant bits in VALUE.
+ */
+static int
+bit_width(apr_uint64_t value)
+{
+  int width = 0;
+  while (value)
+    {
+      value >>= 1;
+      ++width;
+    }
+
+  return width;
+}
+
+/* Write the COUNT VALUES minus BASE to P as a little-endian bit stream
+ * using WIDTH bits per value.  The memory at P must have been zeroed.
+ * Return the first byte behind the data written, i.e. pad to full bytes.
+ */
+static unsigned char *
+pack_values(unsigned char *p,
+            const apr_uint64_t *values,
+            apr_size_t count,
+            apr_uint64_t base,
+            int width)
+{
+  apr_size_t i;
+  int used = 0;      /* bits already used in *P */
+
+  for (i = 0; i < count; ++i)
+    {
+      apr_uint64_t value = values[i] - base;
+      int left = width;
+
+      while (left > 0)
+        {
+          int room = 8 - used;
+          *p |= (unsigned char)((value << used) & 0xff);
+          if (left < room)
+            {
+              used += left;
+              break;
+            }
+
+          value >>= room;
+          left -= room;
+          used = 0;
+          ++p;
+        }
+    }
+
+  return used ? p + 1 : p;
+}
+
+/* Expand the COUNT values of WIDTH bits each from the little-endian bit
+ * stream at DATA and add BASE to them.  Write the result to VALUES.
+ * DATA must contain at least (COUNT * WIDTH + 7) / 8 bytes.
+ */
+static void
+unpack_values(apr_uint64_t *values,
+              const unsigned char *data,
+              apr_size_t count,
+              int width,
+              apr_uint64_t base)
+{
+  const unsigned char *end = data + (count * width + 7) / 8;
+  const apr_uint64_t mask = width == 64
+                          ? APR_UINT64_MAX
+                          : ((apr_uint64_t)1 << width) - 1;
+  apr_uint64_t bits = 0;
+  int bits_left = 0;
+  apr_size_t i;
+
+  /* All values are the same.  This is quite common for the item type
+   * and revision columns in P2L pages. */
+  if (width == 0)
+    {
+      for (i = 0; i < count; ++i)
+        values[i] = base;
+
+      return;
+    }
+
+  for (i = 0; i < count; ++i)
+    {
+      apr_uint64_t value;
+
+      /* Fill up the bit buffer with as many whole bytes as will fit. */
+      while (bits_left <= 56 && data < end)
+        {
+          bits |= (apr_uint64_t)*data << bits_left;
+          bits_left += 8;
+          ++data;
+        }
+
+      if SVN__PREDICT_TRUE(bits_left >= width)
+        {
+          value = bits & mask;
+          bits = width == 64 ? 0 : bits >> width;
+          bits_left -= width;
+        }
+      else
+        {
+          /* Only values wider than 56 bits may straddle the end of the
+           * bit buffer.  Take the remainder from the next byte. */
+          apr_uint64_t next = *data;
+          ++data;
+
+          value = (bits | (next << bits_left)) & mask;
+          bits = next >> (width - bits_left);
+          bits_left = 8 - (width - bits_left);
+        }
+
+      values[i] = base + value;
+    }
+}
+
+/* Append the COUNT VALUES to BUFFER in block-packed format.  For each
+ * block, write the base value and the bit width 7b/8b encoded.  These
+ * block headers are followed by the bit-packed data of all blocks.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+encode_packed_values(svn_spillbuf_t *buffer,
+                     const apr_uint64_t *values,
+                     apr_size_t count,
+                     apr_pool_t *scratch_pool)
+{
+  unsigned char encoded[ENCODED_INT_LENGTH];
+  apr_size_t first, i;
+
+  /* The packed data never takes more space than the unpacked values. */
+  unsigned char *packed = apr_pcalloc(scratch_pool,
+                                      count * sizeof(*values) + 1);
+  unsigned char *p = packed;
+
+  for (first = 0; first < count; first += PACKED_BLOCK_SIZE)
+    {
+      apr_size_t last = MIN(first + PACKED_BLOCK_SIZE, count);
+      apr_uint64_t min_value = values[first];
+      apr_uint64_t max_value = values[first];
+      int width;
+
+      for (i = first + 1; i < last; ++i)
+        {
+          min_value = MIN(min_value, values[i]);
+          max_value = MAX(max_value, values[i]);
+        }
+
+      width = bit_width(max_value - min_value);
+      SVN_ERR(svn_spillbuf__write(buffer, (const char *)encoded,
+                                  encode_uint(encoded, min_value),
+                                  scratch_pool));
+      SVN_ERR(svn_spillbuf__write(buffer, (const char *)encoded,
+                                  encode_uint(encoded, width),
+                                  scratch_pool));
+
+      p = pack_values(p, values + first, last - first, min_value, width);
+    }
+
+  return svn_error_trace(svn_spillbuf__write(buffer, (const char *)packed,
+                                             p - packed, scratch_pool));
+}
+
+/* Read the 7b/8b encoded number at *P into *VALUE and move *P behind it.
+ * Never read at or beyond END.
+ */
+static svn_error_t *
+read_encoded_uint(apr_uint64_t *value,
+                  const unsigned char **p,
+                  const unsigned char *end)
+{
+  const unsigned char *q = *p;
+  apr_uint64_t result = 0;
+  int shift = 0;
+
+  for (; q < end && *q >= 0x80; ++q)
+    {
+      if SVN__PREDICT_FALSE(shift > 56)
+        return svn_error_create(SVN_ERR_FS_INDEX_CORRUPTION, NULL,
+                                _("Corrupt index: number too large"));
+
+      result += ((apr_uint64_t)*q & 0x7f) << shift;
+      shift += 7;
+    }
+
+  if SVN__PREDICT_FALSE(q == end)
+    return svn_error_create(SVN_ERR_FS_INDEX_CORRUPTION, NULL,
+                            _("Unexpected end of block-packed index page"));
+
+  *value = result + ((apr_uint64_t)*q << shift);
+  *p = q + 1;
+
+  return SVN_NO_ERROR;
+}
+
+/* Decode COUNT block-packed values from *P into VALUES and move *P behind
+ * them.  Never read at or beyond END.
+ */
+static svn_error_t *
+decode_packed_values(apr_uint64_t *values,
+                     apr_size_t count,
+                     const unsigned char **p,
+                     const unsigned char *end)
+{
+  const unsigned char *header = *p;
+  const unsigned char *data;
+  apr_uint64_t base, width;
+  apr_size_t data_size = 0;
+  apr_size_t first;
+
+  /* Skip and validate the block headers to find the packed data. */
+  for (first = 0; first < count; first += PACKED_BLOCK_SIZE)
+    {
+      apr_size_t block_count = MIN(PACKED_BLOCK_SIZE, count - first);
+
+      SVN_ERR(read_encoded_uint(&base, p, end));
+      SVN_ERR(read_encoded_uint(&width, p, end));
+      if (width > 64)
+        return svn_error_create(SVN_ERR_FS_INDEX_CORRUPTION, NULL,
+                                _("Invalid bit width in index page"));
+
+      data_size += (block_count * (apr_size_t)width + 7) / 8;
+    }
+
+  data = *p;
+  if (data_size > (apr_size_t)(end - data))
+    return svn_error_create(SVN_ERR_FS_INDEX_CORRUPTION, NULL,
+                            _("Unexpected end of block-packed index page"));
+
+  /* Now, expand all blocks.  The headers have already been validated. */
+  for (first = 0; first < count; first += PACKED_BLOCK_SIZE)
+    {
+      apr_size_t block_count = MIN(PACKED_BLOCK_SIZE, count - first);
+
+      SVN_ERR(read_encoded_uint(&base, &header, end));
+      SVN_ERR(read_encoded_uint(&width, &header, end));
+
+      unpack_values(values + first, data, block_count, (int)width, base);
+      data += (block_count * (apr_size_t)width + 7) / 8;
+    }
+
+  *p = data;
+
+  return SVN_NO_ERROR;
+}
+
 /* Write VALUE to the PROTO_INDEX file, using SCRATCH_POOL for temporary
  * allocations.
  *
@@ -718,6 +1103,33 @@ encode_l2p_page(apr_array_header_t *entries,
   return SVN_NO_ERROR;
 }
 
+/* Same as encode_l2p_page but use the block-packed format.
+ */
+static svn_error_t *
+encode_l2p_packed_page(apr_array_header_t *entries,
+                       int start,
+                       int end,
+                       svn_spillbuf_t *buffer,
+                       apr_pool_t *scratch_pool)
+{
+  int i;
+  const apr_uint64_t *values = (const apr_uint64_t *)entries->elts;
+  apr_uint64_t *diffs = apr_palloc(scratch_pool,
+                                   (end - start) * sizeof(*diffs));
+  apr_uint64_t last_value = 0;
+
+  /* Like the 7b/8b format, store the offsets differentially. */
+  for (i = start; i < end; ++i)
+    {
+      apr_int64_t diff = values[i] - last_value;
+      last_value = values[i];
+      diffs[i - start] = map_int(diff);
+    }
+
+  return svn_error_trace(encode_packed_values(buffer, diffs, end - start,
+                                              scratch_pool));
+}
+
 svn_error_t *
 svn_fs_fs__l2p_proto_index_open(apr_file_t **proto_index,
                                 const char *file_name,
@@ -780,6 +1192,8 @@ svn_fs_fs__l2p_index_append(svn_checksum_t **checksum,
   int i;
   apr_uint64_t entry;
   svn_boolean_t eof = FALSE;
+  svn_boolean_t block_packed
+    = ffd->format >= SVN_FS_FS__MIN_BLOCK_PACKED_INDEX_FORMAT;
 
   int last_page_count = 0;          /* total page count at the start of
                                        the current revision */
@@ -845,8 +1259,12 @@ svn_fs_fs__l2p_index_append(svn_checksum_t **checksum,
               entry_count = ffd->l2p_page_size < entries->nelts - i
                           ? (int)ffd->l2p_page_size
                           : entries->nelts - i;
-              SVN_ERR(encode_l2p_page(entries, i, i + entry_count,
-                                      buffer, iterpool));
+              if (block_packed)
+                SVN_ERR(encode_l2p_packed_page(entries, i, i + entry_count,
+                                               buffer, iterpool));
+              else
+                SVN_ERR(encode_l2p_page(entries, i, i + entry_count,
+                                        buffer, iterpool));
 
               APR_ARRAY_PUSH(entry_counts, apr_uint64_t) = entry_count;
               APR_ARRAY_PUSH(page_sizes, apr_uint64_t)
@@ -901,7 +1319,8 @@ svn_fs_fs__l2p_index_append(svn_checksum_t **checksum,
 
 
   /* write header info */
-  SVN_ERR(svn_stream_puts(stream, L2P_STREAM_PREFIX));
+  SVN_ERR(svn_stream_puts(stream, block_packed ? L2P_PACKED_STREAM_PREFIX
+                                              : L2P_STREAM_PREFIX));
   SVN_ERR(stream_write_encoded(stream, revision));
   SVN_ERR(stream_write_encoded(stream, ffd->l2p_page_size));
   SVN_ERR(stream_write_encoded(stream, page_counts->nelts));
@@ -943,13 +1362,20 @@ auto_open_l2p_index(svn_fs_fs__revision_file_t *rev_file,
   if (rev_file->l2p_stream == NULL)
     {
       fs_fs_data_t *ffd = fs->fsap_data;
+      const char *mapped_data = NULL;
 
       SVN_ERR(svn_fs_fs__auto_read_footer(rev_file));
+      svn_fs_fs__rev_file_mapped_data(&mapped_data, rev_file,
+                                      rev_file->l2p_offset,
+                                      rev_file->p2l_offset
+                                        - rev_file->l2p_offset);
       SVN_ERR(packed_stream_open(&rev_file->l2p_stream,
                                  rev_file->file,
+                                 mapped_data,
                                  rev_file->l2p_offset,
                                  rev_file->p2l_offset,
                                  L2P_STREAM_PREFIX,
+                                 L2P_PACKED_STREAM_PREFIX,
                                  (apr_size_t)ffd->block_size,
                                  rev_file->pool,
                                  rev_file->pool));
@@ -1342,21 +1768,49 @@ get_l2p_page(l2p_page_t **page,
   result->offsets = apr_pcalloc(result_pool, result->entry_count
                                            * sizeof(*result->offsets));
 
-  /* read all page entries (offsets in rev file and container sub-items) */
-  for (i = 0; i < result->entry_count; ++i)
+  if (rev_file->l2p_stream->block_packed)
     {
-      apr_uint64_t value = 0;
-      SVN_ERR(packed_stream_get(&value, rev_file->l2p_stream));
-      last_value += decode_int(value);
-      result->offsets[i] = last_value - 1;
+      /* Fetch the whole page at once and expand it in place. */
+      const unsigned char *data;
+      const unsigned char *end;
+
+      SVN_ERR(packed_stream_read_raw(&data, rev_file->l2p_stream,
+                                     (apr_off_t)table_entry->offset,
+                                     table_entry->size, result_pool));
+      end = data + table_entry->size;
+      SVN_ERR(decode_packed_values(result->offsets, result->entry_count,
+                                   &data, end));
+
+      /* The page must have been used completely. */
+      if (data != end)
+        return svn_error_create(SVN_ERR_FS_INDEX_CORRUPTION, NULL,
+                _("L2P actual page size does not match page table value."));
+
+      for (i = 0; i < result->entry_count; ++i)
+        {
+          last_value += decode_int(result->offsets[i]);
+          result->offsets[i] = last_value - 1;
+        }
     }
+  else
+    {
+      /* read all page entries (offsets in rev file and container
+       * sub-items) */
+      for (i = 0; i < result->entry_count; ++i)
+        {
+          apr_uint64_t value = 0;
+          SVN_ERR(packed_stream_get(&value, rev_file->l2p_stream));
+          last_value += decode_int(value);
+          result->offsets[i] = last_value - 1;
+        }
 
-  /* After reading all page entries, the read cursor must have moved by
-   * TABLE_ENTRY->SIZE bytes. */
-  if (   packed_stream_offset(rev_file->l2p_stream)
-      != table_entry->offset + table_entry->size)
-    return svn_error_create(SVN_ERR_FS_INDEX_CORRUPTION, NULL,
+      /* After reading all page entries, the read cursor must have moved
+       * by TABLE_ENTRY->SIZE bytes. */
+      if (   packed_stream_offset(rev_file->l2p_stream)
+          != table_entry->offset + table_entry->size)
+        return svn_error_create(SVN_ERR_FS_INDEX_CORRUPTION, NULL,
                 _("L2P actual page size does not match page table value."));
+    }
 
   *page = result;
 
@@ -1960,6 +2414,48 @@ svn_fs_fs__p2l_proto_index_next_offset(apr_off_t *next_offset,
   return SVN_NO_ERROR;
 }
 
+/* Append the phys-to-log index page description for the entries in
+ * VALUES to BUFFER in block-packed format.  VALUES contains the unsigned
+ * values of the entries' fields, P2L_PACKED_COLUMNS per entry, in the
+ * same order as the 7b/8b format would store them.  The page
+ * starts at rev / pack file offset FIRST_OFFSET.  Store each field as a
+ * separate array such that values of similar magnitude end up in the
+ * same block.  Clear VALUES afterwards.  Use SCRATCH_POOL for temporary
+ * allocations.
+ */
+static svn_error_t *
+encode_p2l_packed_page(svn_spillbuf_t *buffer,
+                       apr_uint64_t first_offset,
+                       apr_array_header_t *values,
+                       apr_pool_t *scratch_pool)
+{
+  unsigned char encoded[ENCODED_INT_LENGTH];
+  apr_size_t count = values->nelts / P2L_PACKED_COLUMNS;
+  apr_uint64_t *column = apr_palloc(scratch_pool, count * sizeof(*column));
+  apr_size_t i;
+  int k;
+
+  SVN_ERR(svn_spillbuf__write(buffer, (const char *)encoded,
+                              encode_uint(encoded, first_offset),
+                              scratch_pool));
+  SVN_ERR(svn_spillbuf__write(buffer, (const char *)encoded,
+                              encode_uint(encoded, count),
+                              scratch_pool));
+
+  for (k = 0; k < P2L_PACKED_COLUMNS; ++k)
+    {
+      for (i = 0; i < count; ++i)
+        column[i] = APR_ARRAY_IDX(values, i * P2L_PACKED_COLUMNS + k,
+                                  apr_uint64_t);
+
+      SVN_ERR(encode_packed_values(buffer, column, count, scratch_pool));
+    }
+
+  apr_array_clear(values);
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__p2l_index_append(svn_checksum_t **checksum,
                             svn_fs_t *fs,
@@ -1978,6 +2474,14 @@ svn_fs_fs__p2l_index_append(svn_checksum_t **checksum,
   unsigned char encoded[ENCODED_INT_LENGTH];
   svn_revnum_t last_revision = revision;
   apr_uint64_t last_compound = 0;
+  svn_boolean_t block_packed
+    = ffd->format >= SVN_FS_FS__MIN_BLOCK_PACKED_INDEX_FORMAT;
+
+  /* Block-packed pages only: start offset of the current page and the
+     values of its entries, P2L_PACKED_COLUMNS per entry, that have not
+     been written to the buffer, yet. */
+  apr_uint64_t page_start_offset = 0;
+  apr_array_header_t *page_values;
 
   apr_uint64_t last_entry_end = 0;
   apr_uint64_t last_page_end = 0;
@@ -1998,6 +2502,9 @@ svn_fs_fs__p2l_index_append(svn_checksum_t **checksum,
   /* for loop temps ... */
   apr_pool_t *iterpool = svn_pool_create(scratch_pool);
 
+  page_values = apr_array_make(local_pool, 16 * P2L_PACKED_COLUMNS,
+                               sizeof(apr_uint64_t));
+
   /* start at the beginning of the source file */
   SVN_ERR(svn_io_file_open(&proto_index, proto_file_name,
                            APR_READ | APR_CREATE | APR_BUFFERED,
@@ -2008,7 +2515,8 @@ svn_fs_fs__p2l_index_append(svn_checksum_t **checksum,
     {
       svn_fs_fs__p2l_entry_t entry;
       apr_uint64_t entry_end;
-      svn_boolean_t new_page = svn_spillbuf__get_size(buffer) == 0;
+      svn_boolean_t new_page =    svn_spillbuf__get_size(buffer) == 0
+                               && page_values->nelts == 0;
       apr_uint64_t compound;
       apr_int64_t rev_diff, compound_diff;
 
@@ -2042,7 +2550,12 @@ svn_fs_fs__p2l_index_append(svn_checksum_t **checksum,
       entry_end = entry.offset + entry.size;
       while (entry_end - last_page_end > page_size)
         {
-          apr_uint64_t buffer_size = svn_spillbuf__get_size(buffer);
+          apr_uint64_t buffer_size;
+          if (page_values->nelts)
+            SVN_ERR(encode_p2l_packed_page(buffer, page_start_offset,
+                                           page_values, iterpool));
+
+          buffer_size = svn_spillbuf__get_size(buffer);
           APR_ARRAY_PUSH(table_sizes, apr_uint64_t)
              = buffer_size - last_buffer_size;
 
@@ -2055,18 +2568,16 @@ svn_fs_fs__p2l_index_append(svn_checksum_t **checksum,
          (all following entries in the same table will store sizes only) */
       if (new_page)
         {
-          SVN_ERR(svn_spillbuf__write(buffer, (const char *)encoded,
-                                      encode_uint(encoded, entry.offset),
-                                      iterpool));
+          if (block_packed)
+            page_start_offset = entry.offset;
+          else
+            SVN_ERR(svn_spillbuf__write(buffer, (const char *)encoded,
+                                        encode_uint(encoded, entry.offset),
+                                        iterpool));
           last_revision = revision;
           last_compound = 0;
         }
 
-      /* write simple item entry */
-      SVN_ERR(svn_spillbuf__write(buffer, (const char *)encoded,
-                                  encode_uint(encoded, entry.size),
-                                  iterpool));
-
       rev_diff = entry.item.revision - last_revision;
       last_revision = entry.item.revision;
 
@@ -2074,15 +2585,32 @@ svn_fs_fs__p2l_index_append(svn_checksum_t **checksum,
       compound_diff = compound - last_compound;
       last_compound = compound;
 
-      SVN_ERR(svn_spillbuf__write(buffer, (const char *)encoded,
-                                  encode_int(encoded, compound_diff),
-                                  iterpool));
-      SVN_ERR(svn_spillbuf__write(buffer, (const char *)encoded,
-                                  encode_int(encoded, rev_diff),
-                                  iterpool));
-      SVN_ERR(svn_spillbuf__write(buffer, (const char *)encoded,
-                                  encode_uint(encoded, entry.fnv1_checksum),
-                                  iterpool));
+      if (block_packed)
+        {
+          /* collect the item entry until the page is complete */
+          APR_ARRAY_PUSH(page_values, apr_uint64_t) = entry.size;
+          APR_ARRAY_PUSH(page_values, apr_uint64_t)
+            = map_int(compound_diff);
+          APR_ARRAY_PUSH(page_values, apr_uint64_t) = map_int(rev_diff);
+          APR_ARRAY_PUSH(page_values, apr_uint64_t) = entry.fnv1_checksum;
+        }
+      else
+        {
+          /* write simple item entry */
+          SVN_ERR(svn_spillbuf__write(buffer, (const char *)encoded,
+                                      encode_uint(encoded, entry.size),
+                                      iterpool));
+          SVN_ERR(svn_spillbuf__write(buffer, (const char *)encoded,
+                                      encode_int(encoded, compound_diff),
+                                      iterpool));
+          SVN_ERR(svn_spillbuf__write(buffer, (const char *)encoded,
+                                      encode_int(encoded, rev_diff),
+                                      iterpool));
+          SVN_ERR(svn_spillbuf__write(buffer, (const char *)encoded,
+                                      encode_uint(encoded,
+                                                  entry.fnv1_checksum),
+                                      iterpool));
+        }
 
       last_entry_end = entry_end;
     }
@@ -2091,6 +2619,10 @@ svn_fs_fs__p2l_index_append(svn_checksum_t **checksum,
   SVN_ERR(svn_io_file_close(proto_index, local_pool));
 
   /* store length of last table */
+  if (page_values->nelts)
+    SVN_ERR(encode_p2l_packed_page(buffer, page_start_offset, page_values,
+                                   iterpool));
+
   APR_ARRAY_PUSH(table_sizes, apr_uint64_t)
       = svn_spillbuf__get_size(buffer) - last_buffer_size;
 
@@ -2101,7 +2633,8 @@ svn_fs_fs__p2l_index_append(svn_checksum_t **checksum,
                                    result_pool);
 
   /* write the start revision, file size and page size */
-  SVN_ERR(svn_stream_puts(stream, P2L_STREAM_PREFIX));
+  SVN_ERR(svn_stream_puts(stream, block_packed ? P2L_PACKED_STREAM_PREFIX
+                                              : P2L_STREAM_PREFIX));
   SVN_ERR(stream_write_encoded(stream, revision));
   SVN_ERR(stream_write_encoded(stream, file_size));
   SVN_ERR(stream_write_encoded(stream, page_size));
@@ -2135,13 +2668,20 @@ auto_open_p2l_index(svn_fs_fs__revision_file_t *rev_file,
   if (rev_file->p2l_stream == NULL)
     {
       fs_fs_data_t *ffd = fs->fsap_data;
+      const char *mapped_data = NULL;
 
       SVN_ERR(svn_fs_fs__auto_read_footer(rev_file));
+      svn_fs_fs__rev_file_mapped_data(&mapped_data, rev_file,
+                                      rev_file->p2l_offset,
+                                      rev_file->footer_offset
+                                        - rev_file->p2l_offset);
       SVN_ERR(packed_stream_open(&rev_file->p2l_stream,
                                  rev_file->file,
+                                 mapped_data,
                                  rev_file->p2l_offset,
                                  rev_file->footer_offset,
                                  P2L_STREAM_PREFIX,
+                                 P2L_PACKED_STREAM_PREFIX,
                                  (apr_size_t)ffd->block_size,
                                  rev_file->pool,
                                  rev_file->pool));
@@ -2265,6 +2805,10 @@ typedef struct p2l_page_info_baton_t
   /* offset within the p2l index file describing the following page */
   apr_off_t next_offset;
 
+  /* end of the first non-empty page description at or after NEXT_OFFSET
+   * within the p2l index file.  Same as NEXT_OFFSET if there is none. */
+  apr_off_t following_offset;
+
   /* PAGE_NO * PAGE_SIZE (if <= OFFSET) */
   apr_off_t page_start;
 
@@ -2288,11 +2832,23 @@ p2l_page_info_copy(p2l_page_info_baton_t *baton,
    */
   if (baton->offset / header->page_size < header->page_count)
     {
+      apr_size_t next_page;
+
       /* This cast is safe because the value is < header->page_count. */
       baton->page_no = (apr_size_t)(baton->offset / header->page_size);
       baton->start_offset = offsets[baton->page_no];
       baton->next_offset = offsets[baton->page_no + 1];
       baton->page_size = header->page_size;
+
+      /* Skip empty page descriptions. */
+      next_page = baton->page_no + 1;
+      while (   next_page < header->page_count
+             && offsets[next_page + 1] == offsets[next_page])
+        ++next_page;
+
+      baton->following_offset = next_page < header->page_count
+                              ? offsets[next_page + 1]
+                              : baton->next_offset;
     }
   else
     {
@@ -2300,6 +2856,7 @@ p2l_page_info_copy(p2l_page_info_baton_t *baton,
       baton->page_no = header->page_count;
       baton->start_offset = offsets[baton->page_no];
       baton->next_offset = offsets[baton->page_no];
+      baton->following_offset = offsets[baton->page_no];
       baton->page_size = 0;
     }
 
@@ -2365,27 +2922,27 @@ get_p2l_page_info(p2l_page_info_baton_t *baton,
   return SVN_NO_ERROR;
 }
 
-/* Read a mapping entry from the phys-to-log index STREAM and append it to
- * RESULT.  *ITEM_INDEX contains the phys offset for the entry and will
+/* Construct a mapping entry from the on-disk values SIZE, COMPOUND,
+ * REVISION and CHECKSUM of a phys-to-log index page and append it to
+ * RESULT.  *ITEM_OFFSET contains the phys offset for the entry and will
  * be moved forward by the size of entry.
  */
 static svn_error_t *
-read_entry(svn_fs_fs__packed_number_stream_t *stream,
-           apr_off_t *item_offset,
-           svn_revnum_t *last_revision,
-           apr_uint64_t *last_compound,
-           apr_array_header_t *result)
+add_p2l_entry(apr_off_t *item_offset,
+              svn_revnum_t *last_revision,
+              apr_uint64_t *last_compound,
+              apr_uint64_t size,
+              apr_uint64_t compound,
+              apr_uint64_t revision,
+              apr_uint64_t checksum,
+              apr_array_header_t *result)
 {
-  apr_uint64_t value;
-
   svn_fs_fs__p2l_entry_t entry;
 
   entry.offset = *item_offset;
-  SVN_ERR(packed_stream_get(&value, stream));
-  entry.size = (apr_off_t)value;
+  entry.size = (apr_off_t)size;
 
-  SVN_ERR(packed_stream_get(&value, stream));
-  *last_compound += decode_int(value);
+  *last_compound += decode_int(compound);
 
   entry.type = *last_compound & 7;
   entry.item.number = *last_compound / 8;
@@ -2399,17 +2956,15 @@ read_entry(svn_fs_fs__packed_number_stream_t *stream,
     return svn_error_create(SVN_ERR_FS_INDEX_CORRUPTION, NULL,
                             _("Changed path list must have item number 1"));
 
-  SVN_ERR(packed_stream_get(&value, stream));
-  *last_revision += (svn_revnum_t)decode_int(value);
+  *last_revision += (svn_revnum_t)decode_int(revision);
   entry.item.revision = *last_revision;
 
-  SVN_ERR(packed_stream_get(&value, stream));
-  entry.fnv1_checksum = (apr_uint32_t)value;
+  entry.fnv1_checksum = (apr_uint32_t)checksum;
 
   /* Truncating the checksum to 32 bits may have hidden random data in the
    * unused extra bits of the on-disk representation (7/8 bit representation
    * uses 5 bytes on disk for the 32 bit value, leaving 3 bits unused). */
-  if (value > APR_UINT32_MAX)
+  if (checksum > APR_UINT32_MAX)
     return svn_error_create(SVN_ERR_FS_INDEX_CORRUPTION, NULL,
                             _("Invalid FNV1 checksum in P2L index"));
 
@@ -2435,10 +2990,91 @@ read_entry(svn_fs_fs__packed_number_stream_t *stream,
   return SVN_NO_ERROR;
 }
 
+/* Read a mapping entry from the phys-to-log index STREAM and append it to
+ * RESULT.  *ITEM_INDEX contains the phys offset for the entry and will
+ * be moved forward by the size of entry.
+ */
+static svn_error_t *
+read_entry(svn_fs_fs__packed_number_stream_t *stream,
+           apr_off_t *item_offset,
+           svn_revnum_t *last_revision,
+           apr_uint64_t *last_compound,
+           apr_array_header_t *result)
+{
+  apr_uint64_t size, compound, revision, checksum;
+
+  SVN_ERR(packed_stream_get(&size, stream));
+  SVN_ERR(packed_stream_get(&compound, stream));
+  SVN_ERR(packed_stream_get(&revision, stream));
+  SVN_ERR(packed_stream_get(&checksum, stream));
+
+  return svn_error_trace(add_p2l_entry(item_offset, last_revision,
+                                       last_compound, size, compound,
+                                       revision, checksum, result));
+}
+
+/* Decode the block-packed phys-to-log index page description of LEN bytes
+ * at DATA and append up to MAX_ENTRIES of its entries to RESULT.  Set
+ * *ITEM_OFFSET to the rev / pack file offset behind the last entry added.
+ * START_REVISION is the first revision covered by the index.  Use
+ * SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+decode_p2l_packed_page(apr_array_header_t *result,
+                       apr_off_t *item_offset,
+                       const unsigned char *data,
+                       apr_size_t len,
+                       svn_revnum_t start_revision,
+                       apr_size_t max_entries,
+                       apr_pool_t *scratch_pool)
+{
+  const unsigned char *end = data + len;
+  apr_uint64_t value;
+  apr_size_t count, i;
+  apr_uint64_t *columns;
+  svn_revnum_t last_revision = start_revision;
+  apr_uint64_t last_compound = 0;
+  int k;
+
+  /* read rev file offset of the first page entry (all page entries will
+   * only store their sizes) and the number of entries. */
+  SVN_ERR(read_encoded_uint(&value, &data, end));
+  *item_offset = (apr_off_t)value;
+  SVN_ERR(read_encoded_uint(&value, &data, end));
+
+  /* Each column has a header of at least 2 bytes per block. */
+  if (   value == 0
+      || value > (apr_uint64_t)len * PACKED_BLOCK_SIZE
+                 / (2 * P2L_PACKED_COLUMNS))
+    return svn_error_create(SVN_ERR_FS_INDEX_CORRUPTION, NULL,
+                            _("Invalid number of entries in P2L page"));
+
+  count = (apr_size_t)value;
+  columns = apr_palloc(scratch_pool,
+                       count * P2L_PACKED_COLUMNS * sizeof(*columns));
+  for (k = 0; k < P2L_PACKED_COLUMNS; ++k)
+    SVN_ERR(decode_packed_values(columns + k * count, count, &data, end));
+
+  /* The numbers must not overlap into the next page description. */
+  if (data != end)
+    return svn_error_create(SVN_ERR_FS_INDEX_CORRUPTION, NULL,
+             _("P2L page description overlaps with next page description"));
+
+  for (i = 0; i < MIN(count, max_entries); ++i)
+    SVN_ERR(add_p2l_entry(item_offset, &last_revision, &last_compound,
+                          columns[i], columns[count + i],
+                          columns[2 * count + i], columns[3 * count + i],
+                          result));
+
+  return SVN_NO_ERROR;
+}
+
 /* Read the phys-to-log mappings for the cluster beginning at rev file
  * offset PAGE_START from the index for START_REVISION in FS.  The data
  * can be found in the index page beginning at START_OFFSET with the next
- * page beginning at NEXT_OFFSET.  PAGE_SIZE is the L2P index page size.
+ * page beginning at NEXT_OFFSET.  The first non-empty page description
+ * from NEXT_OFFSET onwards ends at FOLLOWING_OFFSET.  PAGE_SIZE is the
+ * L2P index page size.
  * Return the relevant index entries in *ENTRIES.  Use REV_FILE to access
  * on-disk data.  Allocate *ENTRIES in RESULT_POOL.
  */
@@ -2449,6 +3085,7 @@ get_p2l_page(apr_array_header_t **entries,
              svn_revnum_t start_revision,
              apr_off_t start_offset,
              apr_off_t next_offset,
+             apr_off_t following_offset,
              apr_off_t page_start,
              apr_uint64_t page_size,
              apr_pool_t *result_pool)
@@ -2463,6 +3100,51 @@ get_p2l_page(apr_array_header_t **entries,
 
   /* open index and navigate to page start */
   SVN_ERR(auto_open_p2l_index(rev_file, fs, start_revision));
+
+  if (rev_file->p2l_stream->block_packed)
+    {
+      const unsigned char *data;
+      apr_size_t len;
+
+      /* Same logic as below but each page description must be read
+       * and decoded as a whole. */
+      if (start_offset == next_offset)
+        {
+          /* Empty page.  Use the first entry of the next page. */
+          len = (apr_size_t)(following_offset - start_offset);
+          SVN_ERR(packed_stream_read_raw(&data, rev_file->p2l_stream,
+                                         start_offset, len, result_pool));
+          SVN_ERR(decode_p2l_packed_page(result, &item_offset, data, len,
+                                         start_revision, 1, result_pool));
+        }
+      else
+        {
+          len = (apr_size_t)(next_offset - start_offset);
+          SVN_ERR(packed_stream_read_raw(&data, rev_file->p2l_stream,
+                                         start_offset, len, result_pool));
+          SVN_ERR(decode_p2l_packed_page(result, &item_offset, data, len,
+                                         start_revision, APR_SIZE_MAX,
+                                         result_pool));
+
+          /* if we haven't covered the cluster end yet, we must read the
+           * first entry of the next page */
+          if (item_offset < page_start + page_size)
+            {
+              len = (apr_size_t)(following_offset - next_offset);
+              SVN_ERR(packed_stream_read_raw(&data, rev_file->p2l_stream,
+                                             next_offset, len,
+                                             result_pool));
+              SVN_ERR(decode_p2l_packed_page(result, &item_offset, data,
+                                             len, start_revision, 1,
+                                             result_pool));
+            }
+        }
+
+      *entries = result;
+
+      return SVN_NO_ERROR;
+    }
+
   packed_stream_seek(rev_file->p2l_stream, start_offset);
 
   /* read rev file offset of the first page entry (all page entries will
@@ -2577,6 +3259,7 @@ prefetch_p2l_page(svn_boolean_t *end,
                        baton->first_revision,
                        baton->start_offset,
                        baton->next_offset,
+                       baton->following_offset,
                        baton->page_start,
                        baton->page_size,
                        scratch_pool));
@@ -2790,6 +3473,7 @@ p2l_index_lookup(apr_array_header_t *entries,
                            page_info.first_revision,
                            page_info.start_offset,
                            page_info.next_offset,
+                           page_info.following_offset,
                            page_info.page_start,
                            page_info.page_size, iterpool));
 
@@ -0,0 +1,63 @@
+/* lock-db.sql -- schema of the optional FSFS lock database
+ *   This is intended for use with SQLite 3
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+-- STMT_CREATE_SCHEMA
+/* One row per lock, keyed by the canonical fspath of the locked file.
+   The dates are apr_time_t values; EXPIRATION_DATE is NULL for locks
+   that don't expire.  Since the keys are sorted bytewise, all locks
+   within a sub-tree form a single range of the primary key. */
+CREATE TABLE locks (
+  path TEXT NOT NULL PRIMARY KEY,
+  token TEXT NOT NULL,
+  owner TEXT NOT NULL,
+  comment TEXT,
+  is_dav_comment INTEGER NOT NULL,
+  creation_date INTEGER NOT NULL,
+  expiration_date INTEGER
+  );
+
+PRAGMA USER_VERSION = 1;
+
+-- STMT_GET_LOCK
+SELECT path, token, owner, comment, is_dav_comment, creation_date,
+       expiration_date
+FROM locks
+WHERE path = ?1
+
+-- STMT_GET_LOCKS_IN_RANGE
+/* Return up to ?3 locks with paths strictly between ?1 and ?2. */
+SELECT path, token, owner, comment, is_dav_comment, creation_date,
+       expiration_date
+FROM locks
+WHERE path > ?1 AND path < ?2
+ORDER BY path
+LIMIT ?3
+
+-- STMT_SET_LOCK
+INSERT OR REPLACE INTO locks (path, token, owner, comment, is_dav_comment,
+                              creation_date, expiration_date)
+VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7)
+
+-- STMT_DELETE_LOCK
+DELETE FROM locks
+WHERE path = ?1
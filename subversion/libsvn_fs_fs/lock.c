@@ -42,8 +42,13 @@
 #include "private/svn_fs_util.h"
 #include "private/svn_fspath.h"
 #include "private/svn_sorts_private.h"
+#include "private/svn_sqlite.h"
 #include "svn_private_config.h"
 
+#include "lock-db.h"
+
+LOCK_DB_SQL_DECLARE_STATEMENTS(statements);
+
 /* Names of hash keys used to store a lock for writing to disk. */
 #define PATH_KEY "path"
 #define TOKEN_KEY "token"
@@ -331,6 +336,205 @@ read_digest_file(apr_hash_t **children_p,
 }
 
 
+
+/*** Lock database functions. ***/
+
+/* Number of locks that walk_db_locks() fetches at once. */
+#define LOCK_DB_PAGE_SIZE 1000
+
+/* Return the lock in the current row of STMT, allocated in RESULT_POOL. */
+static svn_lock_t *
+read_lock_row(svn_sqlite__stmt_t *stmt,
+              apr_pool_t *result_pool)
+{
+  svn_lock_t *lock = svn_lock_create(result_pool);
+
+  lock->path = svn_sqlite__column_text(stmt, 0, result_pool);
+  lock->token = svn_sqlite__column_text(stmt, 1, result_pool);
+  lock->owner = svn_sqlite__column_text(stmt, 2, result_pool);
+  lock->comment = svn_sqlite__column_text(stmt, 3, result_pool);
+  lock->is_dav_comment = svn_sqlite__column_boolean(stmt, 4);
+  lock->creation_date = svn_sqlite__column_int64(stmt, 5);
+  lock->expiration_date = svn_sqlite__column_int64(stmt, 6);
+
+  return lock;
+}
+
+/* Set *LOCK_P to the lock on PATH in the lock database SDB or to NULL,
+   if there is none.  Allocate the result in RESULT_POOL. */
+static svn_error_t *
+db_get_lock(svn_lock_t **lock_p,
+            svn_sqlite__db_t *sdb,
+            const char *path,
+            apr_pool_t *result_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_GET_LOCK));
+  SVN_ERR(svn_sqlite__bindf(stmt, "s", path));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  *lock_p = have_row ? read_lock_row(stmt, result_pool) : NULL;
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+/* Add LOCK to the lock database SDB, replacing any previous lock on the
+   same path.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+db_set_lock(svn_sqlite__db_t *sdb,
+            const svn_lock_t *lock,
+            apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_SET_LOCK));
+  SVN_ERR(svn_sqlite__bindf(stmt, "ssssdL",
+                            lock->path, lock->token, lock->owner,
+                            lock->comment, lock->is_dav_comment ? 1 : 0,
+                            (apr_int64_t)lock->creation_date));
+
+  /* Leave it NULL for locks that don't expire. */
+  if (lock->expiration_date)
+    SVN_ERR(svn_sqlite__bind_int64(stmt, 7, lock->expiration_date));
+
+  return svn_error_trace(svn_sqlite__insert(NULL, stmt));
+}
+
+/* Remove the lock on PATH from the lock database SDB. */
+static svn_error_t *
+db_delete_lock(svn_sqlite__db_t *sdb,
+               const char *path)
+{
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_DELETE_LOCK));
+  SVN_ERR(svn_sqlite__bindf(stmt, "s", path));
+
+  return svn_error_trace(svn_sqlite__step_done(stmt));
+}
+
+/* Return the path of the lock database in the filesystem at FS_PATH. */
+static const char *
+path_lock_db(const char *fs_path,
+             apr_pool_t *result_pool)
+{
+  return svn_dirent_join(fs_path, PATH_LOCK_DB, result_pool);
+}
+
+/* Move all locks of FS from the digest files into a new lock database
+   and remove the digest files afterwards.  The caller must hold the
+   write lock.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+create_lock_db(svn_fs_t *fs,
+               apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  const char *db_path = path_lock_db(fs->path, scratch_pool);
+  const char *tmp_path = apr_pstrcat(scratch_pool, db_path, ".tmp",
+                                     SVN_VA_NULL);
+  const char *digest_path;
+  apr_hash_t *children;
+  apr_hash_index_t *hi;
+  svn_lock_t *lock;
+  svn_sqlite__db_t *sdb;
+  svn_error_t *err;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  /* Start from scratch, should a previous attempt have been interrupted. */
+  SVN_ERR(svn_io_remove_file2(tmp_path, TRUE, scratch_pool));
+  SVN_ERR(svn_io_file_create_empty(tmp_path, scratch_pool));
+  SVN_ERR(svn_io_copy_perms(svn_fs_fs__path_current(fs, scratch_pool),
+                            tmp_path, scratch_pool));
+
+  SVN_ERR(svn_sqlite__open(&sdb, tmp_path, svn_sqlite__mode_rwcreate,
+                           statements, 0, NULL, 0,
+                           scratch_pool, scratch_pool));
+  SVN_SQLITE__ERR_CLOSE(svn_sqlite__exec_statements(sdb, STMT_CREATE_SCHEMA),
+                        sdb);
+
+  /* The digest file of the root lists all locks in the repository. */
+  SVN_SQLITE__ERR_CLOSE(digest_path_from_path(&digest_path, fs->path, "/",
+                                              scratch_pool), sdb);
+  SVN_SQLITE__ERR_CLOSE(read_digest_file(&children, &lock, fs->path,
+                                         digest_path, scratch_pool), sdb);
+
+  SVN_SQLITE__ERR_CLOSE(svn_sqlite__begin_transaction(sdb), sdb);
+  err = lock ? db_set_lock(sdb, lock, scratch_pool) : SVN_NO_ERROR;
+  for (hi = apr_hash_first(scratch_pool, children); hi && !err;
+       hi = apr_hash_next(hi))
+    {
+      const char *digest = apr_hash_this_key(hi);
+      svn_pool_clear(iterpool);
+
+      err = read_digest_file(NULL, &lock, fs->path,
+                             digest_path_from_digest(fs->path, digest,
+                                                     iterpool),
+                             iterpool);
+      if (!err && lock)
+        err = db_set_lock(sdb, lock, iterpool);
+    }
+  svn_pool_destroy(iterpool);
+
+  err = svn_sqlite__finish_transaction(sdb, err);
+  SVN_ERR(svn_error_compose_create(err, svn_sqlite__close(sdb)));
+
+  /* Activate the new database.  Once it exists, the digest files are
+     no longer being read and may be removed. */
+  SVN_ERR(svn_io_file_rename2(tmp_path, db_path, ffd->flush_to_disk,
+                              scratch_pool));
+  SVN_ERR(svn_io_remove_dir2(svn_dirent_join(fs->path, PATH_LOCKS_DIR,
+                                             scratch_pool),
+                             TRUE, NULL, NULL, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *SDB_P to the lock database of FS or to NULL, if FS still uses
+   digest files to store its locks.  If CREATE is set and FS has been
+   configured to use a lock database but doesn't have one, yet, move
+   the existing locks into a new database.  CREATE requires the caller
+   to hold the write lock.  Use SCRATCH_POOL for temporary allocations.
+
+   Whether the database exists is only checked when opening FS and when
+   taking out the write lock, not here. */
+static svn_error_t *
+get_lock_db(svn_sqlite__db_t **sdb_p,
+            svn_fs_t *fs,
+            svn_boolean_t create,
+            apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  const char *db_path;
+
+  /* Once it exists, the database is never removed again. */
+  if (ffd->lock_db)
+    {
+      *sdb_p = ffd->lock_db;
+      return SVN_NO_ERROR;
+    }
+
+  db_path = path_lock_db(fs->path, scratch_pool);
+  if (!ffd->has_lock_db && create && ffd->enable_lock_db)
+    {
+      SVN_ERR_ASSERT(ffd->has_write_lock);
+      SVN_ERR(create_lock_db(fs, scratch_pool));
+      ffd->has_lock_db = TRUE;
+    }
+
+  /* The database will be closed automatically when FS->POOL gets
+     cleaned up. */
+  if (ffd->has_lock_db)
+    SVN_ERR(svn_sqlite__open(&ffd->lock_db, db_path,
+                             svn_sqlite__mode_readwrite, statements,
+                             0, NULL, 0, fs->pool, scratch_pool));
+
+  *sdb_p = ffd->lock_db;
+  return SVN_NO_ERROR;
+}
+
+
+
 
 /*** Lock helper functions (path here are still FS paths, not on-disk
      schema-supporting paths) ***/
@@ -472,15 +676,25 @@ get_lock(svn_lock_t **lock_p,
          apr_pool_t *pool)
 {
   svn_lock_t *lock = NULL;
-  const char *digest_path;
-  svn_node_kind_t kind;
-
-  SVN_ERR(digest_path_from_path(&digest_path, fs->path, path, pool));
-  SVN_ERR(svn_io_check_path(digest_path, &kind, pool));
+  svn_sqlite__db_t *lock_db;
 
   *lock_p = NULL;
-  if (kind != svn_node_none)
-    SVN_ERR(read_digest_file(NULL, &lock, fs->path, digest_path, pool));
+  SVN_ERR(get_lock_db(&lock_db, fs, FALSE, pool));
+  if (lock_db)
+    {
+      SVN_ERR(db_get_lock(&lock, lock_db, path, pool));
+    }
+  else
+    {
+      const char *digest_path;
+      svn_node_kind_t kind;
+
+      SVN_ERR(digest_path_from_path(&digest_path, fs->path, path, pool));
+      SVN_ERR(svn_io_check_path(digest_path, &kind, pool));
+
+      if (kind != svn_node_none)
+        SVN_ERR(read_digest_file(NULL, &lock, fs->path, digest_path, pool));
+    }
 
   if (! lock)
     return must_exist ? SVN_FS__ERR_NO_SUCH_LOCK(fs, path) : SVN_NO_ERROR;
@@ -533,38 +747,54 @@ get_lock_helper(svn_fs_t *fs,
 }
 
 
-/* A function that calls GET_LOCKS_FUNC/GET_LOCKS_BATON for
-   all locks in and under PATH in FS.
-   HAVE_WRITE_LOCK should be true if the caller (directly or indirectly)
-   has the FS write lock. */
+/* Unless LOCK has expired, call GET_LOCKS_FUNC/GET_LOCKS_BATON for it.
+   Expired locks get removed from FS if HAVE_WRITE_LOCK is set. */
 static svn_error_t *
-walk_locks(svn_fs_t *fs,
-           const char *digest_path,
-           svn_fs_get_locks_callback_t get_locks_func,
-           void *get_locks_baton,
-           svn_boolean_t have_write_lock,
-           apr_pool_t *pool)
+report_lock(svn_fs_t *fs,
+            svn_lock_t *lock,
+            svn_fs_get_locks_callback_t get_locks_func,
+            void *get_locks_baton,
+            svn_boolean_t have_write_lock,
+            apr_pool_t *pool)
 {
-  apr_hash_index_t *hi;
-  apr_hash_t *children;
-  apr_pool_t *subpool;
-  svn_lock_t *lock;
-
-  /* First, send up any locks in the current digest file. */
-  SVN_ERR(read_digest_file(&children, &lock, fs->path, digest_path, pool));
-
-  if (lock && lock_expired(lock))
+  if (lock_expired(lock))
     {
       /* Only remove the lock if we have the write lock.
          Read operations shouldn't change the filesystem. */
       if (have_write_lock)
         SVN_ERR(unlock_single(fs, lock, pool));
     }
-  else if (lock)
+  else
     {
       SVN_ERR(get_locks_func(get_locks_baton, lock, pool));
     }
 
+  return SVN_NO_ERROR;
+}
+
+
+/* Implement walk_locks() for filesystems that store their locks in
+   digest files.  DIGEST_PATH is the digest file of the sub-tree root. */
+static svn_error_t *
+walk_digest_locks(svn_fs_t *fs,
+                  const char *digest_path,
+                  svn_fs_get_locks_callback_t get_locks_func,
+                  void *get_locks_baton,
+                  svn_boolean_t have_write_lock,
+                  apr_pool_t *pool)
+{
+  apr_hash_index_t *hi;
+  apr_hash_t *children;
+  apr_pool_t *subpool;
+  svn_lock_t *lock;
+
+  /* First, send up any locks in the current digest file. */
+  SVN_ERR(read_digest_file(&children, &lock, fs->path, digest_path, pool));
+
+  if (lock)
+    SVN_ERR(report_lock(fs, lock, get_locks_func, get_locks_baton,
+                        have_write_lock, pool));
+
   /* Now, report all the child entries (if any; bail otherwise). */
   if (! apr_hash_count(children))
     return SVN_NO_ERROR;
@@ -578,23 +808,119 @@ walk_locks(svn_fs_t *fs,
               (NULL, &lock, fs->path,
                digest_path_from_digest(fs->path, digest, subpool), subpool));
 
-      if (lock && lock_expired(lock))
-        {
-          /* Only remove the lock if we have the write lock.
-             Read operations shouldn't change the filesystem. */
-          if (have_write_lock)
-            SVN_ERR(unlock_single(fs, lock, pool));
-        }
-      else if (lock)
+      if (lock)
+        SVN_ERR(report_lock(fs, lock, get_locks_func, get_locks_baton,
+                            have_write_lock, pool));
+    }
+  svn_pool_destroy(subpool);
+  return SVN_NO_ERROR;
+}
+
+
+/* Implement walk_locks() for filesystems that store their locks in the
+   lock database SDB. */
+static svn_error_t *
+walk_db_locks(svn_fs_t *fs,
+              svn_sqlite__db_t *sdb,
+              const char *path,
+              svn_fs_get_locks_callback_t get_locks_func,
+              void *get_locks_baton,
+              svn_boolean_t have_write_lock,
+              apr_pool_t *pool)
+{
+  apr_array_header_t *locks = apr_array_make(pool, LOCK_DB_PAGE_SIZE,
+                                             sizeof(svn_lock_t *));
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  const char *lower, *upper;
+  svn_lock_t *lock;
+  int i;
+
+  /* First, send up the lock on PATH itself. */
+  SVN_ERR(db_get_lock(&lock, sdb, path, iterpool));
+  if (lock)
+    SVN_ERR(report_lock(fs, lock, get_locks_func, get_locks_baton,
+                        have_write_lock, iterpool));
+
+  /* All paths below PATH start with PATH + '/' and, because '0' follows
+     '/' in ASCII, sort before PATH + '0'. */
+  if (svn_fspath__is_root(path, strlen(path)))
+    {
+      lower = "/";
+      upper = "0";
+    }
+  else
+    {
+      lower = apr_pstrcat(pool, path, "/", SVN_VA_NULL);
+      upper = apr_pstrcat(pool, path, "0", SVN_VA_NULL);
+    }
+
+  /* Fetch the locks page by page.  The callbacks may modify the database
+     (e.g. remove expired locks), so we must not invoke them while the
+     query statement is active. */
+  do
+    {
+      svn_sqlite__stmt_t *stmt;
+      svn_boolean_t have_row;
+
+      svn_pool_clear(iterpool);
+      apr_array_clear(locks);
+
+      SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_GET_LOCKS_IN_RANGE));
+      SVN_ERR(svn_sqlite__bindf(stmt, "ssd", lower, upper,
+                                LOCK_DB_PAGE_SIZE));
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+      while (have_row)
         {
-          SVN_ERR(get_locks_func(get_locks_baton, lock, pool));
+          APR_ARRAY_PUSH(locks, svn_lock_t *) = read_lock_row(stmt, iterpool);
+          SVN_ERR(svn_sqlite__step(&have_row, stmt));
         }
+      SVN_ERR(svn_sqlite__reset(stmt));
+
+      for (i = 0; i < locks->nelts; ++i)
+        SVN_ERR(report_lock(fs, APR_ARRAY_IDX(locks, i, svn_lock_t *),
+                            get_locks_func, get_locks_baton,
+                            have_write_lock, iterpool));
+
+      /* Continue after the last lock that we reported. */
+      if (locks->nelts)
+        lower = apr_pstrdup(pool, APR_ARRAY_IDX(locks, locks->nelts - 1,
+                                                svn_lock_t *)->path);
     }
-  svn_pool_destroy(subpool);
+  while (locks->nelts == LOCK_DB_PAGE_SIZE);
+
+  svn_pool_destroy(iterpool);
   return SVN_NO_ERROR;
 }
 
 
+/* A function that calls GET_LOCKS_FUNC/GET_LOCKS_BATON for
+   all locks in and under PATH in FS.
+   HAVE_WRITE_LOCK should be true if the caller (directly or indirectly)
+   has the FS write lock. */
+static svn_error_t *
+walk_locks(svn_fs_t *fs,
+           const char *path,
+           svn_fs_get_locks_callback_t get_locks_func,
+           void *get_locks_baton,
+           svn_boolean_t have_write_lock,
+           apr_pool_t *pool)
+{
+  svn_sqlite__db_t *lock_db;
+  const char *digest_path;
+
+  SVN_ERR(get_lock_db(&lock_db, fs, FALSE, pool));
+  if (lock_db)
+    return svn_error_trace(walk_db_locks(fs, lock_db, path, get_locks_func,
+                                         get_locks_baton, have_write_lock,
+                                         pool));
+
+  SVN_ERR(digest_path_from_path(&digest_path, fs->path, path, pool));
+  return svn_error_trace(walk_digest_locks(fs, digest_path, get_locks_func,
+                                           get_locks_baton, have_write_lock,
+                                           pool));
+}
+
+
 /* Utility function:  verify that a lock can be used.  Interesting
    errors returned from this function:
 
@@ -652,9 +978,7 @@ svn_fs_fs__allow_locked_operation(const char *path,
   if (recurse)
     {
       /* Discover all locks at or below the path. */
-      const char *digest_path;
-      SVN_ERR(digest_path_from_path(&digest_path, fs->path, path, pool));
-      SVN_ERR(walk_locks(fs, digest_path, get_locks_callback,
+      SVN_ERR(walk_locks(fs, path, get_locks_callback,
                          fs, have_write_lock, pool));
     }
   else
@@ -845,6 +1169,8 @@ lock_body(void *baton, apr_pool_t *pool)
   apr_hash_t *index_updates = apr_hash_make(pool);
   apr_hash_index_t *hi;
   apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_sqlite__db_t *lock_db;
+  svn_error_t *err = SVN_NO_ERROR;
 
   /* Until we implement directory locks someday, we only allow locks
      on files. */
@@ -853,6 +1179,9 @@ lock_body(void *baton, apr_pool_t *pool)
   SVN_ERR(lb->fs->vtable->youngest_rev(&youngest, lb->fs, pool));
   SVN_ERR(lb->fs->vtable->revision_root(&root, lb->fs, youngest, pool));
 
+  /* Move the locks into the database first, if that has been enabled. */
+  SVN_ERR(get_lock_db(&lock_db, lb->fs, TRUE, pool));
+
   for (i = 0; i < lb->targets->nelts; ++i)
     {
       const svn_sort__item_t *item = &APR_ARRAY_IDX(lb->targets, i,
@@ -869,8 +1198,8 @@ lock_body(void *baton, apr_pool_t *pool)
                          youngest, iterpool));
 
       /* If no error occurred while pre-checking, schedule the index updates for
-         this path. */
-      if (!info.fs_err)
+         this path.  The lock database doesn't need them. */
+      if (!info.fs_err && !lock_db)
         schedule_index_update(index_updates, info.path, iterpool);
 
       APR_ARRAY_PUSH(lb->infos, struct lock_info_t) = info;
@@ -897,7 +1226,11 @@ lock_body(void *baton, apr_pool_t *pool)
                             iterpool));
     }
 
-  for (i = 0; i < lb->infos->nelts; ++i)
+  /* Write all locks to the database in a single transaction. */
+  if (lock_db)
+    SVN_ERR(svn_sqlite__begin_transaction(lock_db));
+
+  for (i = 0; i < lb->infos->nelts && !err; ++i)
     {
       struct lock_info_t *info = &APR_ARRAY_IDX(lb->infos, i,
                                                 struct lock_info_t);
@@ -912,8 +1245,15 @@ lock_body(void *baton, apr_pool_t *pool)
           if (target->token)
             info->lock->token = apr_pstrdup(lb->result_pool, target->token);
           else
-            SVN_ERR(svn_fs_fs__generate_lock_token(&(info->lock->token), lb->fs,
-                                                   lb->result_pool));
+            {
+              err = svn_fs_fs__generate_lock_token(&(info->lock->token),
+                                                   lb->fs, lb->result_pool);
+              if (err)
+                {
+                  info->lock = NULL;
+                  break;
+                }
+            }
 
           /* The INFO->PATH is already allocated in LB->RESULT_POOL as a result
              of svn_fspath__canonicalize() (see svn_fs_fs__lock()). */
@@ -925,13 +1265,25 @@ lock_body(void *baton, apr_pool_t *pool)
           info->lock->creation_date = apr_time_now();
           info->lock->expiration_date = lb->expiration_date;
 
-          info->fs_err = set_lock(lb->fs->path, info->lock, rev_0_path,
-                                  iterpool);
+          if (lock_db)
+            info->fs_err = db_set_lock(lock_db, info->lock, iterpool);
+          else
+            info->fs_err = set_lock(lb->fs->path, info->lock, rev_0_path,
+                                    iterpool);
         }
     }
 
+  if (lock_db)
+    {
+      /* No lock has been written if the transaction gets rolled back. */
+      err = svn_sqlite__finish_transaction(lock_db, err);
+      if (err)
+        for (i = 0; i < lb->infos->nelts; ++i)
+          APR_ARRAY_IDX(lb->infos, i, struct lock_info_t).lock = NULL;
+    }
+
   svn_pool_destroy(iterpool);
-  return SVN_NO_ERROR;
+  return svn_error_trace(err);
 }
 
 /* The effective arguments for unlock_body() below. */
@@ -997,10 +1349,15 @@ unlock_body(void *baton, apr_pool_t *pool)
   apr_hash_t *indices_updates = apr_hash_make(pool);
   apr_hash_index_t *hi;
   apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_sqlite__db_t *lock_db;
+  svn_error_t *err = SVN_NO_ERROR;
 
   SVN_ERR(ub->fs->vtable->youngest_rev(&youngest, ub->fs, pool));
   SVN_ERR(ub->fs->vtable->revision_root(&root, ub->fs, youngest, pool));
 
+  /* Move the locks into the database first, if that has been enabled. */
+  SVN_ERR(get_lock_db(&lock_db, ub->fs, TRUE, pool));
+
   for (i = 0; i < ub->targets->nelts; ++i)
     {
       const svn_sort__item_t *item = &APR_ARRAY_IDX(ub->targets, i,
@@ -1019,8 +1376,8 @@ unlock_body(void *baton, apr_pool_t *pool)
                              iterpool));
 
       /* If no error occurred while pre-checking, schedule the index updates for
-         this path. */
-      if (!info.fs_err)
+         this path.  The lock database doesn't need them. */
+      if (!info.fs_err && !lock_db)
         schedule_index_update(indices_updates, info.path, iterpool);
 
       APR_ARRAY_PUSH(ub->infos, struct unlock_info_t) = info;
@@ -1031,7 +1388,10 @@ unlock_body(void *baton, apr_pool_t *pool)
   /* Unlike the lock_body(), we need to delete locks *before* we start to
      update indices. */
 
-  for (i = 0; i < ub->infos->nelts; ++i)
+  if (lock_db)
+    SVN_ERR(svn_sqlite__begin_transaction(lock_db));
+
+  for (i = 0; i < ub->infos->nelts && !err; ++i)
     {
       struct unlock_info_t *info = &APR_ARRAY_IDX(ub->infos, i,
                                                   struct unlock_info_t);
@@ -1040,11 +1400,25 @@ unlock_body(void *baton, apr_pool_t *pool)
 
       if (! info->fs_err)
         {
-          SVN_ERR(delete_lock(ub->fs->path, info->path, iterpool));
-          info->done = TRUE;
+          if (lock_db)
+            err = db_delete_lock(lock_db, info->path);
+          else
+            err = delete_lock(ub->fs->path, info->path, iterpool);
+
+          info->done = !err;
         }
     }
 
+  if (lock_db)
+    {
+      /* Nothing has been removed if the transaction gets rolled back. */
+      err = svn_sqlite__finish_transaction(lock_db, err);
+      if (err)
+        for (i = 0; i < ub->infos->nelts; ++i)
+          APR_ARRAY_IDX(ub->infos, i, struct unlock_info_t).done = FALSE;
+    }
+  SVN_ERR(err);
+
   for (hi = apr_hash_first(pool, indices_updates); hi; hi = apr_hash_next(hi))
     {
       const char *path = apr_hash_this_key(hi);
@@ -1348,7 +1722,6 @@ svn_fs_fs__get_locks(svn_fs_t *fs,
                      void *get_locks_baton,
                      apr_pool_t *pool)
 {
-  const char *digest_path;
   get_locks_filter_baton_t glfb;
 
   SVN_ERR(svn_fs__check_fs(fs, TRUE));
@@ -1359,9 +1732,6 @@ svn_fs_fs__get_locks(svn_fs_t *fs,
   glfb.get_locks_func = get_locks_func;
   glfb.get_locks_baton = get_locks_baton;
 
-  /* Get the top digest path in our tree of interest, and then walk it. */
-  SVN_ERR(digest_path_from_path(&digest_path, fs->path, path, pool));
-  SVN_ERR(walk_locks(fs, digest_path, get_locks_filter_func, &glfb,
-                     FALSE, pool));
+  SVN_ERR(walk_locks(fs, path, get_locks_filter_func, &glfb, FALSE, pool));
   return SVN_NO_ERROR;
 }
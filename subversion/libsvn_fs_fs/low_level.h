@@ -29,6 +29,21 @@
 #define SVN_FS_FS__KIND_FILE          "file"
 #define SVN_FS_FS__KIND_DIR           "dir"
 
+/* Large directories may be written as PLAIN representations with an
+ * index appended after the SVN_HASH_TERMINATOR line.  Readers that parse
+ * the whole directory stop at the terminator and never see the index.
+ *
+ * The index consists of one line per SVN_FS_FS__DIR_INDEX_STRIDE entries,
+ * each giving the offset of the respective entry's "K" line relative to
+ * the start of the representation contents as 16 hex digits plus '\n'.
+ * It is followed by a footer of the form "DIRINDEX <lines> <stride>\n"
+ * with both numbers given as 8 hex digits each.
+ */
+#define SVN_FS_FS__DIR_INDEX_STRIDE        32
+#define SVN_FS_FS__DIR_INDEX_LINE_LEN      17
+#define SVN_FS_FS__DIR_INDEX_FOOTER_PREFIX "DIRINDEX "
+#define SVN_FS_FS__DIR_INDEX_FOOTER_LEN    27
+
 /* The functions are grouped as follows:
  *
  * - revision trailer (up to format 6)
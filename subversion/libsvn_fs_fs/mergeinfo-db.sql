@@ -0,0 +1,101 @@
+/* mergeinfo-db.sql -- schema of the optional FSFS mergeinfo index
+ *   This is intended for use with SQLite 3
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+-- STMT_CREATE_SCHEMA
+/* One row per path and range of revisions in which that path had the
+   same explicit, valid mergeinfo.  The row applies to all revisions from
+   START_REV up to but not including END_REV.  END_REV is NULL while the
+   mergeinfo is still in effect in the youngest indexed revision.
+   MERGEINFO is the parsed mergeinfo in the binary format described in
+   mergeinfo_index.c.
+
+   Several processes may try to create the schema at the same time, so
+   this must not fail if the tables already exist. */
+CREATE TABLE IF NOT EXISTS mergeinfo (
+  path TEXT NOT NULL,
+  start_rev INTEGER NOT NULL,
+  end_rev INTEGER,
+  mergeinfo BLOB NOT NULL,
+  PRIMARY KEY (path, start_rev)
+  );
+
+/* The range of revisions for which the MERGEINFO table is complete.
+   There is at most one row. */
+CREATE TABLE IF NOT EXISTS coverage (
+  id INTEGER NOT NULL PRIMARY KEY,
+  first_rev INTEGER NOT NULL,
+  last_rev INTEGER NOT NULL
+  );
+
+PRAGMA USER_VERSION = 1;
+
+-- STMT_GET_COVERAGE
+SELECT first_rev, last_rev
+FROM coverage
+WHERE id = 0
+
+-- STMT_SET_COVERAGE
+INSERT OR REPLACE INTO coverage (id, first_rev, last_rev)
+VALUES (0, ?1, ?2)
+
+-- STMT_GET_MERGEINFO
+SELECT mergeinfo
+FROM mergeinfo
+WHERE path = ?1 AND start_rev <= ?2 AND (end_rev IS NULL OR end_rev > ?2)
+
+-- STMT_GET_MERGEINFO_IN_RANGE
+/* Return the mergeinfo of all paths strictly between ?1 and ?2 in
+   revision ?3. */
+SELECT path, mergeinfo
+FROM mergeinfo
+WHERE path > ?1 AND path < ?2
+  AND start_rev <= ?3 AND (end_rev IS NULL OR end_rev > ?3)
+ORDER BY path
+
+-- STMT_INSERT_MERGEINFO
+INSERT OR REPLACE INTO mergeinfo (path, start_rev, end_rev, mergeinfo)
+VALUES (?1, ?2, NULL, ?3)
+
+-- STMT_CLOSE_MERGEINFO
+UPDATE mergeinfo SET end_rev = ?2
+WHERE path = ?1 AND end_rev IS NULL
+
+-- STMT_CLOSE_MERGEINFO_IN_RANGE
+UPDATE mergeinfo SET end_rev = ?3
+WHERE path > ?1 AND path < ?2 AND end_rev IS NULL
+
+-- STMT_DEL_MERGEINFO_YOUNGER_THAN_REV
+DELETE FROM mergeinfo
+WHERE start_rev > ?1
+
+-- STMT_REOPEN_MERGEINFO_YOUNGER_THAN_REV
+UPDATE mergeinfo SET end_rev = NULL
+WHERE end_rev > ?1
+
+-- STMT_DEL_COVERAGE_YOUNGER_THAN_REV
+DELETE FROM coverage
+WHERE first_rev > ?1
+
+-- STMT_TRIM_COVERAGE
+UPDATE coverage SET last_rev = ?1
+WHERE last_rev > ?1
@@ -0,0 +1,971 @@
+/* mergeinfo_index.c --- optional catalog of all mergeinfo in a repository
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svn_pools.h"
+#include "svn_hash.h"
+#include "svn_sorts.h"
+#include "svn_dirent_uri.h"
+#include "private/svn_fspath.h"
+#include "private/svn_sorts_private.h"
+#include "private/svn_sqlite.h"
+#include "private/svn_subr_private.h"
+
+#include "fs_fs.h"
+#include "mergeinfo_index.h"
+#include "transaction.h"
+#include "tree.h"
+#include "util.h"
+#include "../libsvn_fs/fs-loader.h"
+
+#include "mergeinfo-db.h"
+
+#include "svn_private_config.h"
+
+MERGEINFO_DB_SQL_DECLARE_STATEMENTS(statements);
+
+/* The MERGEINFO column contains the parsed mergeinfo of a path.  All
+ * numbers are 7b/8b encoded, see svn__encode_uint():
+ *
+ *   <source count> <source count> x <source>
+ *
+ * where each source is
+ *
+ *   <path len> <path> <range count> <range count> x <range>
+ *
+ * and each range is
+ *
+ *   <start> <2 * (end - start) + inheritable>
+ *
+ * Sources and ranges are stored in the order of svn_mergeinfo_parse()'s
+ * output such that decoding yields the same mergeinfo without any further
+ * normalization.
+ */
+
+/* What we know about the mergeinfo index of a filesystem. */
+struct fs_fs_mergeinfo_index_t
+{
+  /* Range of revisions that the index covered when we last checked.
+     Both are SVN_INVALID_REVNUM if it did not cover any. */
+  svn_revnum_t first_rev;
+  svn_revnum_t last_rev;
+
+  /* TRUE, if we found that the filesystem has no mergeinfo index. */
+  svn_boolean_t no_db;
+};
+
+/* Return the fs_fs_mergeinfo_index_t of FS and create it if necessary. */
+static fs_fs_mergeinfo_index_t *
+get_memo(svn_fs_t *fs)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  if (ffd->mergeinfo_index == NULL)
+    {
+      ffd->mergeinfo_index = apr_pcalloc(fs->pool,
+                                         sizeof(*ffd->mergeinfo_index));
+      ffd->mergeinfo_index->first_rev = SVN_INVALID_REVNUM;
+      ffd->mergeinfo_index->last_rev = SVN_INVALID_REVNUM;
+    }
+
+  return ffd->mergeinfo_index;
+}
+
+/* Return the path of the mergeinfo index in the filesystem at FS_PATH. */
+static const char *
+path_mergeinfo_db(const char *fs_path,
+                  apr_pool_t *result_pool)
+{
+  return svn_dirent_join(fs_path, PATH_MERGEINFO_DB, result_pool);
+}
+
+/* Set *SDB_P to the mergeinfo index of FS or to NULL, if FS has none.
+   If CREATE is set, create the database if it does not exist, yet.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+get_mergeinfo_db(svn_sqlite__db_t **sdb_p,
+                 svn_fs_t *fs,
+                 svn_boolean_t create,
+                 apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  const char *db_path;
+  svn_node_kind_t kind;
+  svn_sqlite__db_t *sdb;
+  int version;
+
+  /* Once it exists, the database is never removed again. */
+  *sdb_p = ffd->mergeinfo_db;
+  if (ffd->mergeinfo_db)
+    return SVN_NO_ERROR;
+
+  db_path = path_mergeinfo_db(fs->path, scratch_pool);
+  SVN_ERR(svn_io_check_path(db_path, &kind, scratch_pool));
+  if (kind == svn_node_none)
+    {
+      svn_error_t *err;
+      if (!create)
+        return SVN_NO_ERROR;
+
+      /* Concurrent commits may race to create the index.  Only the
+         winner sets the permissions. */
+      err = svn_io_file_create_empty(db_path, scratch_pool);
+      if (err && !APR_STATUS_IS_EEXIST(err->apr_err))
+        return svn_error_trace(err);
+      else if (err)
+        svn_error_clear(err);
+      else
+        SVN_ERR(svn_io_copy_perms(svn_fs_fs__path_current(fs, scratch_pool),
+                                  db_path, scratch_pool));
+    }
+
+  /* The database will be closed automatically when FS->POOL gets
+     cleaned up. */
+  SVN_ERR(svn_sqlite__open(&sdb, db_path, svn_sqlite__mode_readwrite,
+                           statements, 0, NULL, 0,
+                           fs->pool, scratch_pool));
+
+  /* Creating the schema is idempotent.  Until it exists, the database
+     does not cover any revisions. */
+  SVN_SQLITE__ERR_CLOSE(svn_sqlite__read_schema_version(&version, sdb,
+                                                        scratch_pool),
+                        sdb);
+  if (version <= 0)
+    {
+      if (!create)
+        return svn_error_trace(svn_sqlite__close(sdb));
+
+      SVN_SQLITE__ERR_CLOSE(svn_sqlite__exec_statements(sdb,
+                                                        STMT_CREATE_SCHEMA),
+                            sdb);
+    }
+
+  ffd->mergeinfo_db = sdb;
+  *sdb_p = sdb;
+
+  return SVN_NO_ERROR;
+}
+
+/* Return a corrupt index error for PATH. */
+static svn_error_t *
+corrupt_entry(const char *path)
+{
+  return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                           _("Corrupt mergeinfo index entry for '%s'"),
+                           path);
+}
+
+/* Append the 7b/8b encoded VALUE to BUFFER. */
+static void
+append_uint(svn_stringbuf_t *buffer,
+            apr_uint64_t value)
+{
+  unsigned char bytes[SVN__MAX_ENCODED_UINT_LEN];
+  unsigned char *end = svn__encode_uint(bytes, value);
+
+  svn_stringbuf_appendbytes(buffer, (const char *)bytes, end - bytes);
+}
+
+/* Return MERGEINFO in our binary format, allocated in RESULT_POOL.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_stringbuf_t *
+encode_mergeinfo(svn_mergeinfo_t mergeinfo,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *result = svn_stringbuf_create_empty(result_pool);
+  apr_array_header_t *sources
+    = svn_sort__hash(mergeinfo, svn_sort_compare_items_as_paths,
+                     scratch_pool);
+  int i, k;
+
+  append_uint(result, sources->nelts);
+  for (i = 0; i < sources->nelts; ++i)
+    {
+      svn_sort__item_t *item = &APR_ARRAY_IDX(sources, i, svn_sort__item_t);
+      svn_rangelist_t *rangelist = item->value;
+
+      append_uint(result, item->klen);
+      svn_stringbuf_appendbytes(result, item->key, item->klen);
+      append_uint(result, rangelist->nelts);
+
+      for (k = 0; k < rangelist->nelts; ++k)
+        {
+          const svn_merge_range_t *range
+            = APR_ARRAY_IDX(rangelist, k, const svn_merge_range_t *);
+
+          append_uint(result, range->start);
+          append_uint(result, 2 * (apr_uint64_t)(range->end - range->start)
+                              + (range->inheritable ? 1 : 0));
+        }
+    }
+
+  return result;
+}
+
+/* Set *MERGEINFO to the mergeinfo encoded in the LEN bytes at DATA.  PATH
+   is the path that this mergeinfo belongs to and only used for error
+   messages.  Allocate *MERGEINFO in RESULT_POOL. */
+static svn_error_t *
+decode_mergeinfo(svn_mergeinfo_t *mergeinfo,
+                 const void *data,
+                 apr_size_t len,
+                 const char *path,
+                 apr_pool_t *result_pool)
+{
+  const unsigned char *p = data;
+  const unsigned char *end = p + len;
+  svn_mergeinfo_t result = svn_hash__make(result_pool);
+  apr_uint64_t source_count, range_count, value;
+  apr_uint64_t i, k;
+
+  p = svn__decode_uint(&source_count, p, end);
+  if (p == NULL)
+    return svn_error_trace(corrupt_entry(path));
+
+  for (i = 0; i < source_count; ++i)
+    {
+      const char *source;
+      svn_rangelist_t *rangelist;
+
+      p = svn__decode_uint(&value, p, end);
+      if (p == NULL || value > (apr_uint64_t)(end - p))
+        return svn_error_trace(corrupt_entry(path));
+
+      source = apr_pstrmemdup(result_pool, (const char *)p,
+                              (apr_size_t)value);
+      p += value;
+
+      p = svn__decode_uint(&range_count, p, end);
+      if (p == NULL || range_count > (apr_uint64_t)(end - p))
+        return svn_error_trace(corrupt_entry(path));
+
+      rangelist = apr_array_make(result_pool, (int)range_count,
+                                 sizeof(svn_merge_range_t *));
+      for (k = 0; k < range_count; ++k)
+        {
+          svn_merge_range_t *range = apr_palloc(result_pool,
+                                                sizeof(*range));
+
+          p = svn__decode_uint(&value, p, end);
+          if (p == NULL)
+            return svn_error_trace(corrupt_entry(path));
+          range->start = (svn_revnum_t)value;
+
+          p = svn__decode_uint(&value, p, end);
+          if (p == NULL)
+            return svn_error_trace(corrupt_entry(path));
+          range->end = range->start + (svn_revnum_t)(value / 2);
+          range->inheritable = (value & 1) != 0;
+
+          APR_ARRAY_PUSH(rangelist, svn_merge_range_t *) = range;
+        }
+
+      svn_hash_sets(result, source, rangelist);
+    }
+
+  if (p != end)
+    return svn_error_trace(corrupt_entry(path));
+
+  *mergeinfo = result;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *LOWER and *UPPER to the bounds of the range of paths that contains
+   all descendants of PATH but not PATH itself.  Allocate them in
+   RESULT_POOL. */
+static void
+descendant_range(const char **lower,
+                 const char **upper,
+                 const char *path,
+                 apr_pool_t *result_pool)
+{
+  if (path[0] == '/' && path[1] == '\0')
+    {
+      *lower = "/";
+      *upper = "0";
+    }
+  else
+    {
+      /* '0' is the character that follows '/'. */
+      *lower = apr_pstrcat(result_pool, path, "/", SVN_VA_NULL);
+      *upper = apr_pstrcat(result_pool, path, "0", SVN_VA_NULL);
+    }
+}
+
+/* Set *FIRST_REV and *LAST_REV to the range of revisions covered by the
+   mergeinfo index SDB.  Set both to SVN_INVALID_REVNUM if there is none.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+read_coverage(svn_revnum_t *first_rev,
+              svn_revnum_t *last_rev,
+              svn_sqlite__db_t *sdb,
+              apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_GET_COVERAGE));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  if (have_row)
+    {
+      *first_rev = svn_sqlite__column_revnum(stmt, 0);
+      *last_rev = svn_sqlite__column_revnum(stmt, 1);
+    }
+  else
+    {
+      *first_rev = SVN_INVALID_REVNUM;
+      *last_rev = SVN_INVALID_REVNUM;
+    }
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+/* A path and its encoded mergeinfo as read from the index. */
+typedef struct indexed_mergeinfo_t
+{
+  const char *path;
+  const void *data;
+  apr_size_t len;
+} indexed_mergeinfo_t;
+
+/* Return all entries of SDB for revision REVISION that lie within the
+   descendants of PATH as indexed_mergeinfo_t * in *ENTRIES, ordered by
+   path.  Allocate the result in RESULT_POOL and use SCRATCH_POOL for
+   temporary allocations. */
+static svn_error_t *
+read_descendants(apr_array_header_t **entries,
+                 svn_sqlite__db_t *sdb,
+                 svn_revnum_t revision,
+                 const char *path,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  const char *lower, *upper;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  apr_array_header_t *result
+    = apr_array_make(result_pool, 16, sizeof(indexed_mergeinfo_t *));
+
+  descendant_range(&lower, &upper, path, scratch_pool);
+
+  /* Read all rows before returning them, such that callers may modify
+     the database while processing them. */
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb,
+                                    STMT_GET_MERGEINFO_IN_RANGE));
+  SVN_ERR(svn_sqlite__bindf(stmt, "ssr", lower, upper, revision));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    {
+      indexed_mergeinfo_t *entry = apr_palloc(result_pool, sizeof(*entry));
+      entry->path = svn_sqlite__column_text(stmt, 0, result_pool);
+      entry->data = svn_sqlite__column_blob(stmt, 1, &entry->len,
+                                            result_pool);
+      APR_ARRAY_PUSH(result, indexed_mergeinfo_t *) = entry;
+
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+
+  *entries = result;
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+/* Add the encoded mergeinfo of size LEN at DATA for PATH in SDB as
+   starting with REVISION. */
+static svn_error_t *
+insert_entry(svn_sqlite__db_t *sdb,
+             const char *path,
+             svn_revnum_t revision,
+             const void *data,
+             apr_size_t len)
+{
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_INSERT_MERGEINFO));
+  SVN_ERR(svn_sqlite__bindf(stmt, "srb", path, revision, data, len));
+
+  return svn_error_trace(svn_sqlite__insert(NULL, stmt));
+}
+
+/* Mark the mergeinfo of PATH in SDB as no longer valid in REVISION.  If
+   RECURSIVE is set, do the same for all descendants of PATH.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+close_entries(svn_sqlite__db_t *sdb,
+              const char *path,
+              svn_boolean_t recursive,
+              svn_revnum_t revision,
+              apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_CLOSE_MERGEINFO));
+  SVN_ERR(svn_sqlite__bindf(stmt, "sr", path, revision));
+  SVN_ERR(svn_sqlite__update(NULL, stmt));
+
+  if (recursive)
+    {
+      const char *lower, *upper;
+      descendant_range(&lower, &upper, path, scratch_pool);
+
+      SVN_ERR(svn_sqlite__get_statement(&stmt, sdb,
+                                        STMT_CLOSE_MERGEINFO_IN_RANGE));
+      SVN_ERR(svn_sqlite__bindf(stmt, "ssr", lower, upper, revision));
+      SVN_ERR(svn_sqlite__update(NULL, stmt));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton type for insert_mergeinfo(). */
+typedef struct insert_baton_t
+{
+  /* The database to write to. */
+  svn_sqlite__db_t *sdb;
+
+  /* The revision that the mergeinfo became valid in. */
+  svn_revnum_t revision;
+} insert_baton_t;
+
+/* Implements svn_fs_mergeinfo_receiver_t adding the MERGEINFO of PATH to
+   the index as described by the insert_baton_t BATON. */
+static svn_error_t *
+insert_mergeinfo(const char *path,
+                 svn_mergeinfo_t mergeinfo,
+                 void *baton,
+                 apr_pool_t *scratch_pool)
+{
+  insert_baton_t *ib = baton;
+  svn_stringbuf_t *data = encode_mergeinfo(mergeinfo, scratch_pool,
+                                           scratch_pool);
+
+  return svn_error_trace(insert_entry(ib->sdb, path, ib->revision,
+                                      data->data, data->len));
+}
+
+/* Add the explicit mergeinfo of PATH under the revision ROOT to SDB.  If
+   RECURSIVE is set, do the same for all descendants of PATH.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+index_path(svn_sqlite__db_t *sdb,
+           svn_fs_root_t *root,
+           const char *path,
+           svn_boolean_t recursive,
+           apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *paths = apr_array_make(scratch_pool, 1,
+                                             sizeof(const char *));
+  insert_baton_t baton;
+
+  baton.sdb = sdb;
+  baton.revision = root->rev;
+  APR_ARRAY_PUSH(paths, const char *) = path;
+
+  /* ROOT->REV is not covered by the index, yet.  So, this reads the
+     mergeinfo from the node properties. */
+  return svn_error_trace(root->vtable->get_mergeinfo(root, paths,
+                                                     svn_mergeinfo_explicit,
+                                                     recursive, FALSE,
+                                                     insert_mergeinfo,
+                                                     &baton, scratch_pool));
+}
+
+/* Add the mergeinfo of all descendants of SOURCE_PATH in SOURCE_REV to
+   SDB as mergeinfo of the respective descendants of PATH in REVISION.
+   SOURCE_REV must be covered by SDB.  Use SCRATCH_POOL for temporary
+   allocations. */
+static svn_error_t *
+copy_descendants(svn_sqlite__db_t *sdb,
+                 const char *path,
+                 svn_revnum_t revision,
+                 const char *source_path,
+                 svn_revnum_t source_rev,
+                 apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *entries;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  SVN_ERR(read_descendants(&entries, sdb, source_rev, source_path,
+                           scratch_pool, scratch_pool));
+  for (i = 0; i < entries->nelts; ++i)
+    {
+      const indexed_mergeinfo_t *entry
+        = APR_ARRAY_IDX(entries, i, const indexed_mergeinfo_t *);
+      const char *relpath = svn_fspath__skip_ancestor(source_path,
+                                                      entry->path);
+      svn_pool_clear(iterpool);
+
+      if (relpath == NULL)
+        return svn_error_trace(corrupt_entry(entry->path));
+
+      SVN_ERR(insert_entry(sdb, svn_fspath__join(path, relpath, iterpool),
+                           revision, entry->data, entry->len));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Update SDB with the mergeinfo changes in REVISION of FS.  SDB must cover
+   all revisions from FIRST_REV to the one preceding REVISION.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+index_revision(svn_sqlite__db_t *sdb,
+               svn_fs_t *fs,
+               svn_revnum_t revision,
+               svn_revnum_t first_rev,
+               apr_pool_t *scratch_pool)
+{
+  apr_hash_t *changed_paths;
+  apr_array_header_t *sorted;
+  svn_fs_root_t *root;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  SVN_ERR(svn_fs_fs__revision_root(&root, fs, revision, scratch_pool));
+  SVN_ERR(svn_fs_fs__paths_changed(&changed_paths, fs, revision,
+                                   scratch_pool));
+
+  /* Process parents before their children, such that changes to a copied
+     sub-tree override what it inherited from the copy source. */
+  sorted = svn_sort__hash(changed_paths, svn_sort_compare_items_as_paths,
+                          scratch_pool);
+  for (i = 0; i < sorted->nelts; ++i)
+    {
+      svn_sort__item_t *item = &APR_ARRAY_IDX(sorted, i, svn_sort__item_t);
+      const char *path = item->key;
+      svn_fs_path_change2_t *change = item->value;
+
+      svn_pool_clear(iterpool);
+
+      switch (change->change_kind)
+        {
+          case svn_fs_path_change_modify:
+            if (   change->mergeinfo_mod == svn_tristate_false
+                || (   change->mergeinfo_mod == svn_tristate_unknown
+                    && !change->prop_mod))
+              break;
+
+            SVN_ERR(close_entries(sdb, path, FALSE, revision, iterpool));
+            SVN_ERR(index_path(sdb, root, path, FALSE, iterpool));
+            break;
+
+          case svn_fs_path_change_delete:
+            SVN_ERR(close_entries(sdb, path, TRUE, revision, iterpool));
+            break;
+
+          case svn_fs_path_change_replace:
+          case svn_fs_path_change_add:
+            SVN_ERR(close_entries(sdb, path, TRUE, revision, iterpool));
+
+            /* Copied sub-trees take the mergeinfo of the copy source
+               below their root.  Without copy, all descendants will be
+               listed as added themselves. */
+            if (   change->copyfrom_known
+                && change->copyfrom_path
+                && change->copyfrom_rev >= first_rev)
+              {
+                SVN_ERR(index_path(sdb, root, path, FALSE, iterpool));
+                SVN_ERR(copy_descendants(sdb, path, revision,
+                                         change->copyfrom_path,
+                                         change->copyfrom_rev, iterpool));
+              }
+            else
+              {
+                svn_boolean_t recursive = change->node_kind != svn_node_file
+                                       && (   !change->copyfrom_known
+                                           || change->copyfrom_path);
+                SVN_ERR(index_path(sdb, root, path, recursive, iterpool));
+              }
+            break;
+
+          default:
+            break;
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Index at most this many revisions per SQLite transaction, such that
+   the write lock on the index is never held for long.  Commits wait for
+   that lock. */
+#define MAX_REVS_PER_UPDATE 16
+
+/* Baton type for update_index(). */
+typedef struct update_baton_t
+{
+  /* The filesystem to update the index for. */
+  svn_fs_t *fs;
+
+  /* The revision that the index shall cover after the update. */
+  svn_revnum_t youngest;
+
+  /* If set, start with a full catalog of YOUNGEST if the index does not
+     cover any revisions, yet.  Otherwise, leave such an index alone. */
+  svn_boolean_t create;
+
+  /* The range of revisions covered by the index after the update. */
+  svn_revnum_t first_rev;
+  svn_revnum_t last_rev;
+} update_baton_t;
+
+/* Implements svn_sqlite__transaction_callback_t moving the mergeinfo
+   index SDB towards the state described by the update_baton_t BATON.
+   Index at most MAX_REVS_PER_UPDATE revisions that the index already
+   covers the predecessors of. */
+static svn_error_t *
+update_index(void *baton,
+             svn_sqlite__db_t *sdb,
+             apr_pool_t *scratch_pool)
+{
+  update_baton_t *ub = baton;
+  svn_revnum_t revision;
+  apr_pool_t *iterpool;
+
+  /* Other processes may have updated the index already. */
+  SVN_ERR(read_coverage(&ub->first_rev, &ub->last_rev, sdb, scratch_pool));
+  if (SVN_IS_VALID_REVNUM(ub->last_rev) && ub->last_rev >= ub->youngest)
+    return SVN_NO_ERROR;
+
+  if (!SVN_IS_VALID_REVNUM(ub->first_rev))
+    {
+      /* New index.  Start with a full catalog of the youngest revision. */
+      svn_fs_root_t *root;
+
+      if (!ub->create)
+        return SVN_NO_ERROR;
+
+      SVN_ERR(svn_fs_fs__revision_root(&root, ub->fs, ub->youngest,
+                                       scratch_pool));
+      SVN_ERR(index_path(sdb, root, "/", TRUE, scratch_pool));
+      ub->first_rev = ub->youngest;
+      ub->last_rev = ub->youngest;
+    }
+  else
+    {
+      /* Catch up with revisions that we did not index, yet. */
+      svn_revnum_t last_rev = MIN(ub->youngest,
+                                  ub->last_rev + MAX_REVS_PER_UPDATE);
+
+      iterpool = svn_pool_create(scratch_pool);
+      for (revision = ub->last_rev + 1; revision <= last_rev; ++revision)
+        {
+          svn_pool_clear(iterpool);
+          SVN_ERR(index_revision(sdb, ub->fs, revision, ub->first_rev,
+                                 iterpool));
+        }
+      svn_pool_destroy(iterpool);
+
+      ub->last_rev = last_rev;
+    }
+
+  {
+    svn_sqlite__stmt_t *stmt;
+    SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_SET_COVERAGE));
+    SVN_ERR(svn_sqlite__bindf(stmt, "rr", ub->first_rev, ub->last_rev));
+    SVN_ERR(svn_sqlite__insert(NULL, stmt));
+  }
+
+  return SVN_NO_ERROR;
+}
+
+/* Run one update_index() step on the mergeinfo index SDB of FS as
+   described by BATON and remember the resulting coverage.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+update_mergeinfo_db(svn_fs_t *fs,
+                    svn_sqlite__db_t *sdb,
+                    update_baton_t *baton,
+                    apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  fs_fs_mergeinfo_index_t *memo;
+  svn_error_t *err;
+
+  /* Take the write lock on the database right away.  Concurrent updates
+     would otherwise try to apply the same revisions twice. */
+  err = svn_sqlite__with_immediate_transaction(sdb, update_index, baton,
+                                               scratch_pool);
+  if (svn_error_find_cause(err, SVN_ERR_SQLITE_ROLLBACK_FAILED))
+    {
+      /* Failed rollback means that our db connection is unusable, and
+         the only thing we can do is close it.  The connection will be
+         reopened during the next operation with the index. */
+      ffd->mergeinfo_db = NULL;
+      return svn_error_trace(
+          svn_error_compose_create(err, svn_sqlite__close(sdb)));
+    }
+  else if (err)
+    return svn_error_trace(err);
+
+  memo = get_memo(fs);
+  memo->first_rev = baton->first_rev;
+  memo->last_rev = baton->last_rev;
+  memo->no_db = FALSE;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__update_mergeinfo_index(svn_fs_t *fs,
+                                  svn_revnum_t youngest,
+                                  apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__db_t *sdb;
+  update_baton_t baton;
+
+  if (!ffd->mergeinfo_index_enabled)
+    return SVN_NO_ERROR;
+
+  /* Commits never create the index.  See svn_fs_fs__build_mergeinfo_index
+     for that. */
+  SVN_ERR(get_mergeinfo_db(&sdb, fs, FALSE, scratch_pool));
+  if (sdb == NULL)
+    return SVN_NO_ERROR;
+
+  /* Don't wait for the write lock while the initial catalog is still
+     being built. */
+  SVN_ERR(read_coverage(&baton.first_rev, &baton.last_rev, sdb,
+                        scratch_pool));
+  if (!SVN_IS_VALID_REVNUM(baton.first_rev) || baton.last_rev >= youngest)
+    return SVN_NO_ERROR;
+
+  baton.fs = fs;
+  baton.youngest = youngest;
+  baton.create = FALSE;
+
+  return svn_error_trace(update_mergeinfo_db(fs, sdb, &baton,
+                                             scratch_pool));
+}
+
+svn_error_t *
+svn_fs_fs__build_mergeinfo_index(svn_fs_t *fs,
+                                 svn_fs_progress_notify_func_t progress_func,
+                                 void *progress_baton,
+                                 svn_cancel_func_t cancel_func,
+                                 void *cancel_baton,
+                                 apr_pool_t *scratch_pool)
+{
+  svn_sqlite__db_t *sdb;
+  update_baton_t baton;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  SVN_ERR(get_mergeinfo_db(&sdb, fs, TRUE, scratch_pool));
+
+  baton.fs = fs;
+  baton.create = TRUE;
+  SVN_ERR(svn_fs_fs__youngest_rev(&baton.youngest, fs, scratch_pool));
+
+  /* Commits may add revisions while we catch up.  Release the write lock
+     between steps, such that they can index their own revisions. */
+  do
+    {
+      svn_pool_clear(iterpool);
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_ERR(update_mergeinfo_db(fs, sdb, &baton, iterpool));
+      if (progress_func)
+        progress_func(baton.last_rev, progress_baton, iterpool);
+    }
+  while (baton.last_rev < baton.youngest);
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__mergeinfo_index_covers(svn_boolean_t *covered,
+                                  svn_fs_t *fs,
+                                  svn_revnum_t revision,
+                                  apr_pool_t *scratch_pool)
+{
+  fs_fs_mergeinfo_index_t *memo = get_memo(fs);
+  svn_sqlite__db_t *sdb;
+
+  /* The covered range only ever grows at its upper end. */
+  *covered = FALSE;
+  if (SVN_IS_VALID_REVNUM(memo->first_rev))
+    {
+      if (revision < memo->first_rev)
+        return SVN_NO_ERROR;
+
+      if (revision <= memo->last_rev)
+        {
+          *covered = TRUE;
+          return SVN_NO_ERROR;
+        }
+    }
+
+  /* Don't check for the database file again and again in the common
+     case that there is none. */
+  if (memo->no_db)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(get_mergeinfo_db(&sdb, fs, FALSE, scratch_pool));
+  if (sdb == NULL)
+    {
+      memo->no_db = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(read_coverage(&memo->first_rev, &memo->last_rev, sdb,
+                        scratch_pool));
+  *covered = SVN_IS_VALID_REVNUM(memo->first_rev)
+          && revision >= memo->first_rev
+          && revision <= memo->last_rev;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__get_indexed_mergeinfo(svn_mergeinfo_t *mergeinfo,
+                                 svn_fs_t *fs,
+                                 svn_revnum_t revision,
+                                 const char *path,
+                                 apr_pool_t *result_pool,
+                                 apr_pool_t *scratch_pool)
+{
+  svn_sqlite__db_t *sdb;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  *mergeinfo = NULL;
+
+  SVN_ERR(get_mergeinfo_db(&sdb, fs, FALSE, scratch_pool));
+  SVN_ERR_ASSERT(sdb);
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_GET_MERGEINFO));
+  SVN_ERR(svn_sqlite__bindf(stmt, "sr", path, revision));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  if (have_row)
+    {
+      apr_size_t len;
+      const void *data = svn_sqlite__column_blob(stmt, 0, &len, NULL);
+
+      SVN_SQLITE__ERR_RESET(decode_mergeinfo(mergeinfo, data, len, path,
+                                             result_pool),
+                            stmt);
+    }
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+svn_error_t *
+svn_fs_fs__walk_indexed_mergeinfo(svn_fs_t *fs,
+                                  svn_revnum_t revision,
+                                  const char *path,
+                                  svn_fs_mergeinfo_receiver_t receiver,
+                                  void *baton,
+                                  apr_pool_t *scratch_pool)
+{
+  svn_sqlite__db_t *sdb;
+  apr_array_header_t *entries;
+  apr_pool_t *iterpool;
+  int i;
+
+  SVN_ERR(get_mergeinfo_db(&sdb, fs, FALSE, scratch_pool));
+  SVN_ERR_ASSERT(sdb);
+
+  /* RECEIVER may run other queries, so don't call it while reading. */
+  SVN_ERR(read_descendants(&entries, sdb, revision, path, scratch_pool,
+                           scratch_pool));
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < entries->nelts; ++i)
+    {
+      const indexed_mergeinfo_t *entry
+        = APR_ARRAY_IDX(entries, i, const indexed_mergeinfo_t *);
+      svn_mergeinfo_t mergeinfo;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(decode_mergeinfo(&mergeinfo, entry->data, entry->len,
+                               entry->path, iterpool));
+      SVN_ERR(receiver(entry->path, mergeinfo, baton, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_sqlite__transaction_callback_t removing all information
+   about revisions younger than *(svn_revnum_t *)BATON from SDB. */
+static svn_error_t *
+prune_index(void *baton,
+            svn_sqlite__db_t *sdb,
+            apr_pool_t *scratch_pool)
+{
+  svn_revnum_t youngest = *(svn_revnum_t *)baton;
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb,
+                                    STMT_DEL_MERGEINFO_YOUNGER_THAN_REV));
+  SVN_ERR(svn_sqlite__bindf(stmt, "r", youngest));
+  SVN_ERR(svn_sqlite__step_done(stmt));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb,
+                                    STMT_REOPEN_MERGEINFO_YOUNGER_THAN_REV));
+  SVN_ERR(svn_sqlite__bindf(stmt, "r", youngest));
+  SVN_ERR(svn_sqlite__step_done(stmt));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb,
+                                    STMT_DEL_COVERAGE_YOUNGER_THAN_REV));
+  SVN_ERR(svn_sqlite__bindf(stmt, "r", youngest));
+  SVN_ERR(svn_sqlite__step_done(stmt));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_TRIM_COVERAGE));
+  SVN_ERR(svn_sqlite__bindf(stmt, "r", youngest));
+  SVN_ERR(svn_sqlite__step_done(stmt));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__prune_mergeinfo_index(svn_fs_t *fs,
+                                 svn_revnum_t youngest,
+                                 apr_pool_t *scratch_pool)
+{
+  fs_fs_mergeinfo_index_t *memo;
+  svn_sqlite__db_t *sdb;
+
+  SVN_ERR(get_mergeinfo_db(&sdb, fs, FALSE, scratch_pool));
+  if (sdb == NULL)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_sqlite__with_immediate_transaction(sdb, prune_index,
+                                                 &youngest, scratch_pool));
+
+  /* Forget what we knew about the removed revisions. */
+  memo = get_memo(fs);
+  memo->first_rev = SVN_INVALID_REVNUM;
+  memo->last_rev = SVN_INVALID_REVNUM;
+
+  return SVN_NO_ERROR;
+}
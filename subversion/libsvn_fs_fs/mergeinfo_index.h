@@ -0,0 +1,121 @@
+/* mergeinfo_index.h --- optional catalog of all mergeinfo in a repository
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef SVN_LIBSVN_FS_FS_MERGEINFO_INDEX_H
+#define SVN_LIBSVN_FS_FS_MERGEINFO_INDEX_H
+
+#include "svn_mergeinfo.h"
+#include "fs.h"
+
+/* If enabled, FSFS keeps a catalog of the explicit mergeinfo of all paths
+ * in PATH_MERGEINFO_DB.  Each entry holds the parsed mergeinfo of a path
+ * for a range of revisions, so the mergeinfo of a path or of all paths in
+ * a sub-tree can be looked up directly, without crawling the tree and
+ * parsing mergeinfo properties.
+ *
+ * The catalog covers a contiguous range of revisions starting with the
+ * revision in which it has been created.  Commits extend that range.
+ * Queries for revisions outside the range must use the node properties.
+ *
+ * The index is created explicitly by svn_fs_fs__build_mergeinfo_index,
+ * never by a commit.
+ */
+
+/* Extend the existing mergeinfo index of FS towards covering all
+ * revisions up to and including YOUNGEST.  A single call indexes only a
+ * limited number of revisions; later calls continue where this one
+ * stopped.  Do nothing if the index has not been enabled for FS or has not
+ * been built, yet.  Use SCRATCH_POOL for temporary allocations.
+ *
+ * This is being called after the commit of YOUNGEST, so callers should
+ * treat errors as warnings.
+ */
+svn_error_t *
+svn_fs_fs__update_mergeinfo_index(svn_fs_t *fs,
+                                  svn_revnum_t youngest,
+                                  apr_pool_t *scratch_pool);
+
+/* Create the mergeinfo index of FS with a full catalog of the youngest
+ * revision, if it does not exist, yet, and then extend it to cover all
+ * revisions up to the youngest.  This does not depend on whether the index
+ * has been enabled for FS but only commits in FS instances that have it
+ * enabled will keep it up to date.
+ *
+ * Call PROGRESS_FUNC with PROGRESS_BATON and the last revision covered by
+ * the index after every step, if PROGRESS_FUNC is not NULL.  Use the
+ * optional CANCEL_FUNC with CANCEL_BATON to check for cancellation.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_fs_fs__build_mergeinfo_index(svn_fs_t *fs,
+                                 svn_fs_progress_notify_func_t progress_func,
+                                 void *progress_baton,
+                                 svn_cancel_func_t cancel_func,
+                                 void *cancel_baton,
+                                 apr_pool_t *scratch_pool);
+
+/* Set *COVERED to TRUE, if the mergeinfo index of FS covers REVISION, and
+ * to FALSE otherwise.  Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_fs_fs__mergeinfo_index_covers(svn_boolean_t *covered,
+                                  svn_fs_t *fs,
+                                  svn_revnum_t revision,
+                                  apr_pool_t *scratch_pool);
+
+/* Set *MERGEINFO to the explicit mergeinfo of PATH in REVISION of FS as
+ * recorded in the mergeinfo index or to NULL if PATH has no valid
+ * mergeinfo.  REVISION must be covered by the index.
+ *
+ * Allocate *MERGEINFO in RESULT_POOL and use SCRATCH_POOL for temporaries.
+ */
+svn_error_t *
+svn_fs_fs__get_indexed_mergeinfo(svn_mergeinfo_t *mergeinfo,
+                                 svn_fs_t *fs,
+                                 svn_revnum_t revision,
+                                 const char *path,
+                                 apr_pool_t *result_pool,
+                                 apr_pool_t *scratch_pool);
+
+/* Invoke RECEIVER with BATON for every descendant of PATH in REVISION of
+ * FS that has valid mergeinfo, but not for PATH itself.  REVISION must be
+ * covered by the mergeinfo index.  Use SCRATCH_POOL for temporary
+ * allocations, including the mergeinfo passed to RECEIVER.
+ */
+svn_error_t *
+svn_fs_fs__walk_indexed_mergeinfo(svn_fs_t *fs,
+                                  svn_revnum_t revision,
+                                  const char *path,
+                                  svn_fs_mergeinfo_receiver_t receiver,
+                                  void *baton,
+                                  apr_pool_t *scratch_pool);
+
+/* Remove all information about revisions younger than YOUNGEST from the
+ * mergeinfo index of FS, if that exists.  Use SCRATCH_POOL for temporary
+ * allocations.
+ */
+svn_error_t *
+svn_fs_fs__prune_mergeinfo_index(svn_fs_t *fs,
+                                 svn_revnum_t youngest,
+                                 apr_pool_t *scratch_pool);
+
+#endif
@@ -0,0 +1,64 @@
+/* node-history-db.sql -- schema of the optional FSFS node history index
+ *   This is intended for use with SQLite 3
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+-- STMT_CREATE_SCHEMA
+/* One row per committed node revision, keyed by its unparsed noderev ID.
+   NODE_REVISION and NODE_NUMBER are the two parts of the node ID, i.e.
+   they identify the line of history that the node revision belongs to.
+   REVISION is the revision that created the node revision.  The other
+   columns are copies of the respective noderev fields.
+
+   Several processes may try to create the schema at the same time, so
+   this must not fail if the table already exists. */
+CREATE TABLE IF NOT EXISTS node_history (
+  id TEXT NOT NULL PRIMARY KEY,
+  node_revision INTEGER NOT NULL,
+  node_number INTEGER NOT NULL,
+  revision INTEGER NOT NULL,
+  predecessor_id TEXT,
+  created_path TEXT NOT NULL
+  );
+
+CREATE INDEX IF NOT EXISTS i_node_history_line
+ON node_history (node_revision, node_number, revision);
+
+PRAGMA USER_VERSION = 1;
+
+-- STMT_GET_NODE_HISTORY
+/* Return up to ?4 node revisions of node ID ?1.?2 that have been created
+   in revision ?3 or older, youngest first. */
+SELECT id, revision, predecessor_id, created_path
+FROM node_history
+WHERE node_revision = ?1 AND node_number = ?2 AND revision <= ?3
+ORDER BY revision DESC
+LIMIT ?4
+
+-- STMT_SET_NODE_HISTORY
+INSERT OR REPLACE INTO node_history (id, node_revision, node_number,
+                                     revision, predecessor_id, created_path)
+VALUES (?1, ?2, ?3, ?4, ?5, ?6)
+
+-- STMT_DEL_NODE_HISTORY_YOUNGER_THAN_REV
+DELETE FROM node_history
+WHERE revision > ?1
+
@@ -0,0 +1,370 @@
+/* node_history.c --- optional index of the node revision history
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svn_pools.h"
+#include "svn_hash.h"
+#include "svn_dirent_uri.h"
+#include "private/svn_sqlite.h"
+#include "private/svn_subr_private.h"
+
+#include "node_history.h"
+#include "id.h"
+#include "util.h"
+
+#include "node-history-db.h"
+
+#include "svn_private_config.h"
+
+NODE_HISTORY_DB_SQL_DECLARE_STATEMENTS(statements);
+
+/* Number of node revisions that we read from the index in one go. */
+#define NODE_HISTORY_PAGE_SIZE 1000
+
+/* A section of a line of node history as read from the index. */
+struct fs_fs_node_history_t
+{
+  /* The node ID that all entries share. */
+  svn_fs_fs__id_part_t node_id;
+
+  /* ENTRIES contains all node revisions of NODE_ID that have been
+     created in revisions START_REV to END_REV and that are present in
+     the index.  Empty range if END_REV < START_REV. */
+  svn_revnum_t start_rev;
+  svn_revnum_t end_rev;
+
+  /* Maps unparsed noderev IDs to svn_fs_fs__node_history_t *. */
+  apr_hash_t *entries;
+
+  /* TRUE, if we found that FS has no node history index. */
+  svn_boolean_t no_db;
+
+  /* Pool used for ENTRIES.  Gets cleared whenever we read another
+     section. */
+  apr_pool_t *pool;
+};
+
+/* Return the path of the node history index in the filesystem at
+   FS_PATH. */
+static const char *
+path_node_history_db(const char *fs_path,
+                     apr_pool_t *result_pool)
+{
+  return svn_dirent_join(fs_path, PATH_NODE_HISTORY_DB, result_pool);
+}
+
+/* Set *SDB_P to the node history index of FS or to NULL, if FS has none.
+   If CREATE is set, create the index if it does not exist, yet.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+get_node_history_db(svn_sqlite__db_t **sdb_p,
+                    svn_fs_t *fs,
+                    svn_boolean_t create,
+                    apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  const char *db_path;
+  svn_node_kind_t kind;
+  svn_sqlite__db_t *sdb;
+  int version;
+
+  /* Once it exists, the database is never removed again. */
+  *sdb_p = ffd->node_history_db;
+  if (ffd->node_history_db)
+    return SVN_NO_ERROR;
+
+  db_path = path_node_history_db(fs->path, scratch_pool);
+  SVN_ERR(svn_io_check_path(db_path, &kind, scratch_pool));
+  if (kind == svn_node_none)
+    {
+      svn_error_t *err;
+      if (!create)
+        return SVN_NO_ERROR;
+
+      /* Concurrent commits may race to create the index.  Only the
+         winner sets the permissions. */
+      err = svn_io_file_create_empty(db_path, scratch_pool);
+      if (err && !APR_STATUS_IS_EEXIST(err->apr_err))
+        return svn_error_trace(err);
+      else if (err)
+        svn_error_clear(err);
+      else
+        SVN_ERR(svn_io_copy_perms(svn_fs_fs__path_current(fs, scratch_pool),
+                                  db_path, scratch_pool));
+    }
+
+  /* The database will be closed automatically when FS->POOL gets
+     cleaned up. */
+  SVN_ERR(svn_sqlite__open(&sdb, db_path, svn_sqlite__mode_readwrite,
+                           statements, 0, NULL, 0,
+                           fs->pool, scratch_pool));
+
+  /* The schema may not have been created yet.  Creating it is
+     idempotent, so there is no need to coordinate with other writers. */
+  SVN_SQLITE__ERR_CLOSE(svn_sqlite__read_schema_version(&version, sdb,
+                                                        scratch_pool),
+                        sdb);
+  if (version <= 0)
+    {
+      if (!create)
+        return svn_error_trace(svn_sqlite__close(sdb));
+
+      SVN_SQLITE__ERR_CLOSE(svn_sqlite__exec_statements(sdb,
+                                                        STMT_CREATE_SCHEMA),
+                            sdb);
+    }
+
+  ffd->node_history_db = sdb;
+  *sdb_p = sdb;
+
+  return SVN_NO_ERROR;
+}
+
+/* Write ENTRY to the node history index SDB.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+set_entry(svn_sqlite__db_t *sdb,
+          const svn_fs_fs__node_history_t *entry,
+          apr_pool_t *scratch_pool)
+{
+  const svn_fs_fs__id_part_t *node_id = svn_fs_fs__id_node_id(entry->id);
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_SET_NODE_HISTORY));
+  SVN_ERR(svn_sqlite__bindf(stmt, "siirss",
+                            svn_fs_fs__id_unparse(entry->id,
+                                                  scratch_pool)->data,
+                            (apr_int64_t)node_id->revision,
+                            (apr_int64_t)node_id->number,
+                            svn_fs_fs__id_rev(entry->id),
+                            entry->predecessor_id
+                              ? svn_fs_fs__id_unparse(entry->predecessor_id,
+                                                      scratch_pool)->data
+                              : NULL,
+                            entry->created_path));
+
+  return svn_error_trace(svn_sqlite__insert(NULL, stmt));
+}
+
+svn_error_t *
+svn_fs_fs__add_node_history(svn_fs_t *fs,
+                            const apr_array_header_t *entries,
+                            apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__db_t *sdb;
+  svn_error_t *err = SVN_NO_ERROR;
+  apr_pool_t *iterpool;
+  int i;
+
+  if (!ffd->node_history_enabled || entries->nelts == 0)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(get_node_history_db(&sdb, fs, TRUE, scratch_pool));
+
+  /* We use an sqlite transaction to speed things up;
+   * see <http://www.sqlite.org/faq.html#q19>. */
+  SVN_ERR(svn_sqlite__begin_transaction(sdb));
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < entries->nelts && !err; i++)
+    {
+      svn_pool_clear(iterpool);
+      err = set_entry(sdb,
+                      APR_ARRAY_IDX(entries, i, svn_fs_fs__node_history_t *),
+                      iterpool);
+    }
+  svn_pool_destroy(iterpool);
+
+  err = svn_sqlite__finish_transaction(sdb, err);
+  if (svn_error_find_cause(err, SVN_ERR_SQLITE_ROLLBACK_FAILED))
+    {
+      /* Failed rollback means that our db connection is unusable, and
+         the only thing we can do is close it.  The connection will be
+         reopened during the next operation with the index. */
+      ffd->node_history_db = NULL;
+      err = svn_error_compose_create(err, svn_sqlite__close(sdb));
+    }
+
+  return svn_error_trace(err);
+}
+
+/* Replace the contents of NODE_HISTORY with the youngest section of the
+   history of ID's node that ends with ID's revision, as stored in SDB.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+read_node_history(fs_fs_node_history_t *node_history,
+                  svn_sqlite__db_t *sdb,
+                  const svn_fs_id_t *id,
+                  apr_pool_t *scratch_pool)
+{
+  const svn_fs_fs__id_part_t *node_id = svn_fs_fs__id_node_id(id);
+  svn_revnum_t revision = svn_fs_fs__id_rev(id);
+  svn_revnum_t last_rev = SVN_INVALID_REVNUM;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  int count = 0;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  svn_pool_clear(node_history->pool);
+  node_history->node_id = *node_id;
+  node_history->start_rev = 0;
+  node_history->end_rev = revision;
+  node_history->entries = svn_hash__make(node_history->pool);
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_GET_NODE_HISTORY));
+  SVN_ERR(svn_sqlite__bindf(stmt, "iird",
+                            (apr_int64_t)node_id->revision,
+                            (apr_int64_t)node_id->number,
+                            revision, NODE_HISTORY_PAGE_SIZE));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    {
+      svn_fs_fs__node_history_t *entry;
+      const char *key;
+      const char *pred;
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+
+      entry = apr_pcalloc(node_history->pool, sizeof(*entry));
+      key = svn_sqlite__column_text(stmt, 0, node_history->pool);
+      last_rev = svn_sqlite__column_revnum(stmt, 1);
+      pred = svn_sqlite__column_text(stmt, 2, NULL);
+      entry->created_path = svn_sqlite__column_text(stmt, 3,
+                                                    node_history->pool);
+
+      err = svn_fs_fs__id_parse(&entry->id, apr_pstrdup(iterpool, key),
+                                node_history->pool);
+      if (!err && pred)
+        err = svn_fs_fs__id_parse(&entry->predecessor_id,
+                                  apr_pstrdup(iterpool, pred),
+                                  node_history->pool);
+      if (err)
+        {
+          /* Don't leave an incomplete section behind. */
+          node_history->end_rev = SVN_INVALID_REVNUM;
+          return svn_error_compose_create(err, svn_sqlite__reset(stmt));
+        }
+
+      svn_hash_sets(node_history->entries, key, entry);
+      ++count;
+
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+
+  svn_pool_destroy(iterpool);
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  /* If we hit the page size limit, the oldest revision may only have
+     been read partially and older ones not at all. */
+  if (count == NODE_HISTORY_PAGE_SIZE)
+    node_history->start_rev = last_rev + 1;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__get_node_history(const svn_fs_id_t **predecessor_id,
+                            const char **created_path,
+                            svn_boolean_t *found,
+                            svn_fs_t *fs,
+                            const svn_fs_id_t *id,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  fs_fs_node_history_t *node_history = ffd->node_history;
+  const svn_fs_fs__id_part_t *node_id = svn_fs_fs__id_node_id(id);
+  svn_revnum_t revision = svn_fs_fs__id_rev(id);
+  svn_fs_fs__node_history_t *entry;
+
+  *found = FALSE;
+
+  if (node_history == NULL)
+    {
+      node_history = apr_pcalloc(fs->pool, sizeof(*node_history));
+      node_history->end_rev = SVN_INVALID_REVNUM;
+      node_history->pool = svn_pool_create(fs->pool);
+      ffd->node_history = node_history;
+    }
+
+  /* Fetch the section of the node's history that ends at REVISION
+     unless we already have it. */
+  if (   !svn_fs_fs__id_part_eq(&node_history->node_id, node_id)
+      || revision < node_history->start_rev
+      || revision > node_history->end_rev)
+    {
+      svn_sqlite__db_t *sdb;
+
+      /* Don't check for the database file again and again in the
+         common case that there is none. */
+      if (node_history->no_db)
+        return SVN_NO_ERROR;
+
+      SVN_ERR(get_node_history_db(&sdb, fs, FALSE, scratch_pool));
+      if (sdb == NULL)
+        {
+          node_history->no_db = TRUE;
+          return SVN_NO_ERROR;
+        }
+
+      SVN_ERR(read_node_history(node_history, sdb, id, scratch_pool));
+    }
+
+  entry = svn_hash_gets(node_history->entries,
+                        svn_fs_fs__id_unparse(id, scratch_pool)->data);
+  if (entry)
+    {
+      *predecessor_id = entry->predecessor_id
+                      ? svn_fs_fs__id_copy(entry->predecessor_id, result_pool)
+                      : NULL;
+      *created_path = apr_pstrdup(result_pool, entry->created_path);
+      *found = TRUE;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__prune_node_history(svn_fs_t *fs,
+                              svn_revnum_t youngest,
+                              apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__db_t *sdb;
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(get_node_history_db(&sdb, fs, FALSE, scratch_pool));
+  if (sdb == NULL)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb,
+                                    STMT_DEL_NODE_HISTORY_YOUNGER_THAN_REV));
+  SVN_ERR(svn_sqlite__bindf(stmt, "r", youngest));
+  SVN_ERR(svn_sqlite__step_done(stmt));
+
+  /* Our cached section may refer to the removed revisions. */
+  if (ffd->node_history)
+    ffd->node_history->end_rev = SVN_INVALID_REVNUM;
+
+  return SVN_NO_ERROR;
+}
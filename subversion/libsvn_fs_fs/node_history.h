@@ -0,0 +1,87 @@
+/* node_history.h --- optional index of the node revision history
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef SVN_LIBSVN_FS_FS_NODE_HISTORY_H
+#define SVN_LIBSVN_FS_FS_NODE_HISTORY_H
+
+#include "fs.h"
+
+/* If enabled, commits record all their new node revisions in the
+ * PATH_NODE_HISTORY_DB database together with their predecessors and
+ * created paths.  Following a node's history then only requires one
+ * query per many node revisions instead of reading each of them from
+ * the revision files.
+ *
+ * The index is optional and may be incomplete, e.g. for revisions that
+ * were committed before it got enabled.  Readers must fall back to the
+ * node revisions themselves if the index has no information.
+ */
+
+/* An entry of the node history index. */
+typedef struct svn_fs_fs__node_history_t
+{
+  /* The node revision. */
+  const svn_fs_id_t *id;
+
+  /* Its predecessor.  NULL, if there is none. */
+  const svn_fs_id_t *predecessor_id;
+
+  /* The path at which ID was created. */
+  const char *created_path;
+} svn_fs_fs__node_history_t;
+
+/* Add the svn_fs_fs__node_history_t * ENTRIES to the node history index
+ * of FS and create the index if necessary.  Do nothing if the index has
+ * not been enabled for FS.  Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_fs_fs__add_node_history(svn_fs_t *fs,
+                            const apr_array_header_t *entries,
+                            apr_pool_t *scratch_pool);
+
+/* If the node history index of FS contains the node revision ID, set
+ * *FOUND to TRUE and return its predecessor and created path in
+ * *PREDECESSOR_ID and *CREATED_PATH, respectively.  Otherwise, set *FOUND
+ * to FALSE and leave the other outputs untouched.
+ *
+ * Allocate the results in RESULT_POOL and use SCRATCH_POOL for
+ * temporaries.
+ */
+svn_error_t *
+svn_fs_fs__get_node_history(const svn_fs_id_t **predecessor_id,
+                            const char **created_path,
+                            svn_boolean_t *found,
+                            svn_fs_t *fs,
+                            const svn_fs_id_t *id,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool);
+
+/* Remove all entries for revisions younger than YOUNGEST from the node
+ * history index of FS, if that exists.  Use SCRATCH_POOL for temporary
+ * allocations.
+ */
+svn_error_t *
+svn_fs_fs__prune_node_history(svn_fs_t *fs,
+                              svn_revnum_t youngest,
+                              apr_pool_t *scratch_pool);
+
+#endif
@@ -22,9 +22,12 @@
 #include <assert.h>
 #include <string.h>
 
+#include <apr_thread_proc.h>
+
 #include "svn_pools.h"
 #include "svn_dirent_uri.h"
 #include "svn_sorts.h"
+#include "private/svn_atomic.h"
 #include "private/svn_temp_serializer.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_subr_private.h"
@@ -32,6 +35,7 @@
 #include "private/svn_io_private.h"
 
 #include "fs_fs.h"
+#include "changes_index.h"
 #include "pack.h"
 #include "util.h"
 #include "id.h"
@@ -234,8 +238,8 @@ typedef struct pack_context_t
    * the next range of revisions is being processed */
   apr_pool_t *info_pool;
 
-  /* ensure that all filesystem changes are written to disk. */
-  svn_boolean_t flush_to_disk;
+  /* collects the files and folders that need to be written to disk. */
+  svn_io__batch_fsync_t *batch;
 } pack_context_t;
 
 /* Create and initialize a new pack context for packing shard SHARD_REV in
@@ -243,7 +247,8 @@ typedef struct pack_context_t
  * and return the structure in *CONTEXT.
  *
  * Limit the number of items being copied per iteration to MAX_ITEMS.
- * Set FLUSH_TO_DISK, CANCEL_FUNC and CANCEL_BATON as well.
+ * Schedule the pack file for fsync in BATCH.  Set CANCEL_FUNC and
+ * CANCEL_BATON as well.
  */
 static svn_error_t *
 initialize_pack_context(pack_context_t *context,
@@ -252,7 +257,7 @@ initialize_pack_context(pack_context_t *context,
                         const char *shard_dir,
                         svn_revnum_t shard_rev,
                         int max_items,
-                        svn_boolean_t flush_to_disk,
+                        svn_io__batch_fsync_t *batch,
                         svn_cancel_func_t cancel_func,
                         void *cancel_baton,
                         apr_pool_t *pool)
@@ -281,7 +286,7 @@ initialize_pack_context(pack_context_t *context,
   context->info_pool = svn_pool_create(pool);
   context->paths = svn_prefix_tree__create(context->info_pool);
 
-  context->flush_to_disk = flush_to_disk;
+  context->batch = batch;
 
   /* Create the new directory and pack file. */
   context->shard_dir = shard_dir;
@@ -382,7 +387,8 @@ reset_pack_context(pack_context_t *context,
 }
 
 /* Call this after the last revision range.  It will finalize all index files
- * for CONTEXT and close any open files.  Use POOL for temporary allocations.
+ * for CONTEXT, close any open files and schedule the pack file for fsync
+ * in CONTEXT->BATCH.  Use POOL for temporary allocations.
  */
 static svn_error_t *
 close_pack_context(pack_context_t *context,
@@ -412,10 +418,9 @@ close_pack_context(pack_context_t *context,
   SVN_ERR(svn_io_remove_file2(proto_l2p_index_path, FALSE, pool));
   SVN_ERR(svn_io_remove_file2(proto_p2l_index_path, FALSE, pool));
 
-  /* Ensure that packed file is written to disk.*/
-  if (context->flush_to_disk)
-    SVN_ERR(svn_io_file_flush_to_disk(context->pack_file, pool));
   SVN_ERR(svn_io_file_close(context->pack_file, pool));
+  SVN_ERR(svn_io__batch_fsync_add_file(context->batch,
+                                       context->pack_file_path, pool));
 
   return SVN_NO_ERROR;
 }
@@ -1538,9 +1543,9 @@ append_revision(pack_context_t *context,
  *
  * Pack the revision shard starting at SHARD_REV in filesystem FS from
  * SHARD_DIR into the PACK_FILE_DIR, using POOL for allocations.  Limit
- * the extra memory consumption to MAX_MEM bytes.  If FLUSH_TO_DISK is
- * non-zero, do not return until the data has actually been written on
- * the disk.  CANCEL_FUNC and CANCEL_BATON are what you think they are.
+ * the extra memory consumption to MAX_MEM bytes.  Schedule the new files
+ * for fsync in BATCH.  CANCEL_FUNC and CANCEL_BATON are what you think
+ * they are.
  */
 static svn_error_t *
 pack_log_addressed(svn_fs_t *fs,
@@ -1548,7 +1553,7 @@ pack_log_addressed(svn_fs_t *fs,
                    const char *shard_dir,
                    svn_revnum_t shard_rev,
                    apr_size_t max_mem,
-                   svn_boolean_t flush_to_disk,
+                   svn_io__batch_fsync_t *batch,
                    svn_cancel_func_t cancel_func,
                    void *cancel_baton,
                    apr_pool_t *pool)
@@ -1581,7 +1586,7 @@ pack_log_addressed(svn_fs_t *fs,
 
   /* set up a pack context */
   SVN_ERR(initialize_pack_context(&context, fs, pack_file_dir, shard_dir,
-                                  shard_rev, max_items, flush_to_disk,
+                                  shard_rev, max_items, batch,
                                   cancel_func, cancel_baton, pool));
 
   /* phase 1: determine the size of the revisions to pack */
@@ -1706,8 +1711,7 @@ svn_fs_fs__get_packed_offset(apr_off_t *rev_offset,
  *
  * Pack the revision shard starting at SHARD_REV containing exactly
  * MAX_FILES_PER_DIR revisions from SHARD_PATH into the PACK_FILE_DIR,
- * using POOL for allocations.  If FLUSH_TO_DISK is non-zero, do not
- * return until the data has actually been written on the disk.
+ * using POOL for allocations.  Schedule the new files for fsync in BATCH.
  * CANCEL_FUNC and CANCEL_BATON are what you think they are.
  */
 static svn_error_t *
@@ -1715,7 +1719,7 @@ pack_phys_addressed(const char *pack_file_dir,
                     const char *shard_path,
                     svn_revnum_t start_rev,
                     int max_files_per_dir,
-                    svn_boolean_t flush_to_disk,
+                    svn_io__batch_fsync_t *batch,
                     svn_cancel_func_t cancel_func,
                     void *cancel_baton,
                     apr_pool_t *pool)
@@ -1781,20 +1785,16 @@ pack_phys_addressed(const char *pack_file_dir,
 
   /* Close stream over APR file. */
   SVN_ERR(svn_stream_close(manifest_stream));
-
-  /* Ensure that pack file is written to disk. */
-  if (flush_to_disk)
-    SVN_ERR(svn_io_file_flush_to_disk(manifest_file, pool));
   SVN_ERR(svn_io_file_close(manifest_file, pool));
+  SVN_ERR(svn_io_file_close(pack_file, pool));
+
+  /* Have both files written to disk together with the pack folder. */
+  SVN_ERR(svn_io__batch_fsync_add_file(batch, manifest_file_path, pool));
+  SVN_ERR(svn_io__batch_fsync_add_file(batch, pack_file_path, pool));
 
   /* disallow write access to the manifest file */
   SVN_ERR(svn_io_set_file_read_only(manifest_file_path, FALSE, iterpool));
 
-  /* Ensure that pack file is written to disk. */
-  if (flush_to_disk)
-    SVN_ERR(svn_io_file_flush_to_disk(pack_file, pool));
-  SVN_ERR(svn_io_file_close(pack_file, pool));
-
   svn_pool_destroy(iterpool);
 
   return SVN_NO_ERROR;
@@ -1824,8 +1824,10 @@ pack_rev_shard(svn_fs_t *fs,
                void *cancel_baton,
                apr_pool_t *pool)
 {
+  fs_fs_data_t *ffd = fs->fsap_data;
   const char *pack_file_path;
   svn_revnum_t shard_rev = (svn_revnum_t) (shard * max_files_per_dir);
+  svn_io__batch_fsync_t *batch;
 
   /* Some useful paths. */
   pack_file_path = svn_dirent_join(pack_file_dir, PATH_PACKED, pool);
@@ -1837,16 +1839,30 @@ pack_rev_shard(svn_fs_t *fs,
   /* Create the new directory and pack file. */
   SVN_ERR(svn_io_dir_make(pack_file_dir, APR_OS_DEFAULT, pool));
 
+  /* Collect all files and folders that need to be synced. */
+  SVN_ERR(svn_io__batch_fsync_create(&batch, flush_to_disk, pool));
+  SVN_ERR(svn_io__batch_fsync_new_path(batch, pack_file_dir, pool));
+
   /* Index information files */
   if (svn_fs_fs__use_log_addressing(fs))
     SVN_ERR(pack_log_addressed(fs, pack_file_dir, shard_path,
-                               shard_rev, max_mem, flush_to_disk,
+                               shard_rev, max_mem, batch,
                                cancel_func, cancel_baton, pool));
   else
     SVN_ERR(pack_phys_addressed(pack_file_dir, shard_path, shard_rev,
-                                max_files_per_dir, flush_to_disk,
+                                max_files_per_dir, batch,
                                 cancel_func, cancel_baton, pool));
 
+  /* The revisions have not been marked as packed, yet, so this reads
+   * their changes from the original rev files. */
+  if (ffd->changes_index_enabled)
+    SVN_ERR(svn_fs_fs__write_changes_index(fs, pack_file_dir, shard_rev,
+                                           max_files_per_dir, batch,
+                                           cancel_func, cancel_baton, pool));
+
+  /* Flush all new files and the pack folder concurrently. */
+  SVN_ERR(svn_io__batch_fsync_run(batch, pool));
+
   SVN_ERR(svn_io_copy_perms(shard_path, pack_file_dir, pool));
   SVN_ERR(svn_io_set_file_read_only(pack_file_path, FALSE, pool));
 
@@ -1957,6 +1973,60 @@ synced_pack_shard(void *baton,
   return SVN_NO_ERROR;
 }
 
+/* Return the path of the packed revision SHARD in REVS_DIR.
+ * Allocate the result in RESULT_POOL. */
+static const char *
+get_rev_pack_file_dir(const char *revs_dir,
+                      apr_int64_t shard,
+                      apr_pool_t *result_pool)
+{
+  return svn_dirent_join(revs_dir,
+                         apr_psprintf(result_pool,
+                                      "%" APR_INT64_T_FMT
+                                      PATH_EXT_PACKED_SHARD,
+                                      shard),
+                         result_pool);
+}
+
+/* Return the path of the non-packed revision SHARD in REVS_DIR.
+ * Allocate the result in RESULT_POOL. */
+static const char *
+get_rev_shard_path(const char *revs_dir,
+                   apr_int64_t shard,
+                   apr_pool_t *result_pool)
+{
+  return svn_dirent_join(revs_dir,
+                         apr_psprintf(result_pool, "%" APR_INT64_T_FMT, shard),
+                         result_pool);
+}
+
+/* Switch the shard described by BATON over to its packed revision data,
+ * pack its revprops and tell the caller that we are done with it.  The
+ * packed rev folder has been created prior to calling this function.
+ */
+static svn_error_t *
+commit_packed_shard(struct pack_baton *baton,
+                    apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = baton->fs->fsap_data;
+
+  /* For newer repo formats, we only acquired the pack lock so far.
+     Before modifying the repo state by switching over to the packed
+     data, we need to acquire the global (write) lock. */
+  if (ffd->format >= SVN_FS_FS__MIN_PACK_LOCK_FORMAT)
+    SVN_ERR(svn_fs_fs__with_write_lock(baton->fs, synced_pack_shard, baton,
+                                       pool));
+  else
+    SVN_ERR(synced_pack_shard(baton, pool));
+
+  /* Notify caller we're starting to pack this shard. */
+  if (baton->notify_func)
+    SVN_ERR(baton->notify_func(baton->notify_baton, baton->shard,
+                               svn_fs_pack_notify_end, pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Pack the shard described by BATON.
  *
  * If for some reason we detect a partial packing already performed,
@@ -1975,16 +2045,10 @@ pack_shard(struct pack_baton *baton,
                                svn_fs_pack_notify_start, pool));
 
   /* Some useful paths. */
-  rev_pack_file_dir = svn_dirent_join(baton->revs_dir,
-                  apr_psprintf(pool,
-                               "%" APR_INT64_T_FMT PATH_EXT_PACKED_SHARD,
-                               baton->shard),
-                  pool);
-  baton->rev_shard_path = svn_dirent_join(baton->revs_dir,
-                                          apr_psprintf(pool,
-                                                       "%" APR_INT64_T_FMT,
-                                                       baton->shard),
-                                          pool);
+  rev_pack_file_dir = get_rev_pack_file_dir(baton->revs_dir, baton->shard,
+                                            pool);
+  baton->rev_shard_path = get_rev_shard_path(baton->revs_dir, baton->shard,
+                                             pool);
 
   /* pack the revision content */
   SVN_ERR(pack_rev_shard(baton->fs, rev_pack_file_dir, baton->rev_shard_path,
@@ -1992,23 +2056,137 @@ pack_shard(struct pack_baton *baton,
                          baton->max_mem, ffd->flush_to_disk,
                          baton->cancel_func, baton->cancel_baton, pool));
 
-  /* For newer repo formats, we only acquired the pack lock so far.
-     Before modifying the repo state by switching over to the packed
-     data, we need to acquire the global (write) lock. */
-  if (ffd->format >= SVN_FS_FS__MIN_PACK_LOCK_FORMAT)
-    SVN_ERR(svn_fs_fs__with_write_lock(baton->fs, synced_pack_shard, baton,
-                                       pool));
-  else
-    SVN_ERR(synced_pack_shard(baton, pool));
+  return svn_error_trace(commit_packed_shard(baton, pool));
+}
 
-  /* Notify caller we're starting to pack this shard. */
-  if (baton->notify_func)
-    SVN_ERR(baton->notify_func(baton->notify_baton, baton->shard,
-                               svn_fs_pack_notify_end, pool));
+/* Parameters shared by all parallel shard packing jobs. */
+typedef struct pack_jobs_baton_t
+{
+  /* The repository being packed. */
+  struct pack_baton *pb;
+
+  /* The next shard to start packing and the first one not to pack. */
+  apr_int64_t next_shard;
+  apr_int64_t end_shard;
+} pack_jobs_baton_t;
+
+/* A revision shard being packed by a worker thread. */
+typedef struct pack_job_t
+{
+  /* Private instance of the repository, used only by the worker. */
+  svn_fs_t *fs;
+
+  /* Parameters as passed to pack_rev_shard(). */
+  const char *pack_file_dir;
+  const char *shard_path;
+  apr_int64_t shard;
+  apr_size_t max_mem;
+} pack_job_t;
+
+/* Implement svn__job_start_func_t for pack_shards_parallel().  BATON is
+   a pack_jobs_baton_t. */
+static svn_error_t *
+pack_job_start(void **job_p,
+               void *baton,
+               apr_pool_t *job_pool,
+               apr_pool_t *scratch_pool)
+{
+  pack_jobs_baton_t *jobs = baton;
+  pack_job_t *job;
+
+  *job_p = NULL;
+  if (jobs->next_shard >= jobs->end_shard)
+    return SVN_NO_ERROR;
+
+  job = apr_pcalloc(job_pool, sizeof(*job));
+  job->shard = jobs->next_shard++;
+  job->pack_file_dir = get_rev_pack_file_dir(jobs->pb->revs_dir, job->shard,
+                                             job_pool);
+  job->shard_path = get_rev_shard_path(jobs->pb->revs_dir, job->shard,
+                                       job_pool);
+  job->max_mem = jobs->pb->max_mem;
+  SVN_ERR(svn_fs_fs__open_clone(&job->fs, jobs->pb->fs, job_pool,
+                                scratch_pool));
+
+  *job_p = job;
 
   return SVN_NO_ERROR;
 }
 
+/* Implement svn__job_work_func_t for pack_shards_parallel() packing the
+   revision data of the pack_job_t JOB_BATON into a new pack folder. */
+static svn_error_t *
+pack_job_work(void *job_baton,
+              svn_cancel_func_t cancel_func,
+              void *cancel_baton,
+              apr_pool_t *result_pool,
+              apr_pool_t *scratch_pool)
+{
+  pack_job_t *job = job_baton;
+  fs_fs_data_t *ffd = job->fs->fsap_data;
+
+  return svn_error_trace(pack_rev_shard(job->fs, job->pack_file_dir,
+                                        job->shard_path, job->shard,
+                                        ffd->max_files_per_dir, job->max_mem,
+                                        ffd->flush_to_disk, cancel_func,
+                                        cancel_baton, scratch_pool));
+}
+
+/* Implement svn__job_finish_func_t for pack_shards_parallel() switching
+   the shard of the pack_job_t JOB_BATON over to its packed data.  BATON
+   is a pack_jobs_baton_t. */
+static svn_error_t *
+pack_job_finish(void *job_baton,
+                svn_error_t *err,
+                void *baton,
+                apr_pool_t *scratch_pool)
+{
+  pack_job_t *job = job_baton;
+  pack_jobs_baton_t *jobs = baton;
+  struct pack_baton *pb = jobs->pb;
+
+  pb->shard = job->shard;
+  if (pb->notify_func)
+    err = svn_error_compose_create(pb->notify_func(pb->notify_baton,
+                                                   pb->shard,
+                                                   svn_fs_pack_notify_start,
+                                                   scratch_pool),
+                                   err);
+  SVN_ERR(err);
+
+  pb->rev_shard_path = get_rev_shard_path(pb->revs_dir, pb->shard,
+                                          scratch_pool);
+
+  return svn_error_trace(commit_packed_shard(pb, scratch_pool));
+}
+
+/* Pack the shards FIRST_SHARD up to but not including END_SHARD in the
+ * repository given by BATON, using up to ffd->pack_threads concurrent
+ * workers.  The packed shards replace their non-packed versions strictly
+ * in order, so MIN_UNPACKED_REV only advances over gapless sequences of
+ * completed shards.  On error, the incomplete pack folders of the other
+ * shards will be replaced by the next attempt.  Use POOL for temporary
+ * allocations.
+ */
+static svn_error_t *
+pack_shards_parallel(struct pack_baton *baton,
+                     apr_int64_t first_shard,
+                     apr_int64_t end_shard,
+                     apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = baton->fs->fsap_data;
+  pack_jobs_baton_t jobs;
+
+  jobs.pb = baton;
+  jobs.next_shard = first_shard;
+  jobs.end_shard = end_shard;
+
+  return svn_error_trace(svn__jobs_run(ffd->pack_threads, pack_job_start,
+                                       pack_job_work, pack_job_finish,
+                                       &jobs, baton->cancel_func,
+                                       baton->cancel_baton, pool));
+}
+
 /* Read the youngest rev and the first non-packed rev info for FS from disk.
    Set *FULLY_PACKED when there is no completed unpacked shard.
    Use SCRATCH_POOL for temporary allocations.
@@ -2058,6 +2236,7 @@ pack_body(void *baton,
   struct pack_baton *pb = baton;
   fs_fs_data_t *ffd = pb->fs->fsap_data;
   apr_int64_t completed_shards;
+  apr_int64_t first_shard;
   apr_pool_t *iterpool;
   svn_boolean_t fully_packed;
 
@@ -2080,8 +2259,15 @@ pack_body(void *baton,
     pb->revsprops_dir = svn_dirent_join(pb->fs->path, PATH_REVPROPS_DIR,
                                         pool);
 
+  first_shard = ffd->min_unpacked_rev / ffd->max_files_per_dir;
+
+  /* Pack multiple shards concurrently? */
+  if (ffd->pack_threads > 1 && completed_shards - first_shard > 1)
+    return svn_error_trace(pack_shards_parallel(pb, first_shard,
+                                                completed_shards, pool));
+
   iterpool = svn_pool_create(pool);
-  for (pb->shard = ffd->min_unpacked_rev / ffd->max_files_per_dir;
+  for (pb->shard = first_shard;
        pb->shard < completed_shards;
        pb->shard++)
     {
@@ -24,10 +24,15 @@
 
 #include "svn_hash.h"
 #include "svn_pools.h"
+#include "svn_sorts.h"
+#include "svn_dirent_uri.h"
 #include "private/svn_string_private.h"
+#include "private/svn_subr_private.h"
 
 #include "index.h"
 #include "low_level.h"
+#include "mergeinfo_index.h"
+#include "node_history.h"
 #include "rep-cache.h"
 #include "revprops.h"
 #include "util.h"
@@ -338,6 +343,344 @@ struct recover_baton {
   void *cancel_baton;
 };
 
+/* Part of the recovery procedure.  Scan the revisions START_REV up to but
+   not including END_REV in FS and set *MAX_NODE_ID and *MAX_COPY_ID to the
+   largest node-id and copy-id found in them, if greater than the current
+   value stored in either.  Perform temporary allocations in POOL. */
+static svn_error_t *
+recover_scan_ids(svn_fs_t *fs,
+                 svn_revnum_t start_rev,
+                 svn_revnum_t end_rev,
+                 apr_uint64_t *max_node_id,
+                 apr_uint64_t *max_copy_id,
+                 svn_cancel_func_t cancel_func,
+                 void *cancel_baton,
+                 apr_pool_t *pool)
+{
+  svn_revnum_t rev;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  for (rev = start_rev; rev < end_rev; rev++)
+    {
+      svn_fs_fs__revision_file_t *rev_file;
+      apr_off_t root_offset;
+
+      svn_pool_clear(iterpool);
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, rev, iterpool,
+                                               iterpool));
+      SVN_ERR(recover_get_root_offset(&root_offset, rev, rev_file, iterpool));
+      SVN_ERR(recover_find_max_ids(fs, rev, rev_file, root_offset,
+                                   max_node_id, max_copy_id, iterpool));
+      SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the path of the recovery checkpoint file in FS. */
+static const char *
+path_recovery_checkpoint(svn_fs_t *fs,
+                         apr_pool_t *result_pool)
+{
+  return svn_dirent_join(fs->path, PATH_RECOVERY_CHECKPOINT, result_pool);
+}
+
+/* Set *SIZE to the size of the revision file of REV in FS, which must
+   not be packed.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+get_rev_file_size(apr_off_t *size,
+                  svn_fs_t *fs,
+                  svn_revnum_t rev,
+                  apr_pool_t *scratch_pool)
+{
+  apr_finfo_t finfo;
+
+  SVN_ERR(svn_io_stat(&finfo, svn_fs_fs__path_rev_absolute(fs, rev,
+                                                           scratch_pool),
+                      APR_FINFO_SIZE, scratch_pool));
+  *size = finfo.size;
+
+  return SVN_NO_ERROR;
+}
+
+/* Part of the recovery procedure.  Read the recovery checkpoint of FS and
+   return the revision up to which it is valid in *REV and the maximum
+   node-id and copy-id found in those revisions in *MAX_NODE_ID and
+   *MAX_COPY_ID, respectively.  Set *REV to SVN_INVALID_REVNUM if there is
+   no usable checkpoint, e.g. because it refers to revisions after MAX_REV
+   or because revision *REV has been replaced since.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+read_recovery_checkpoint(svn_revnum_t *rev,
+                         apr_uint64_t *max_node_id,
+                         apr_uint64_t *max_copy_id,
+                         svn_fs_t *fs,
+                         svn_revnum_t max_rev,
+                         apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *content;
+  apr_array_header_t *parts;
+  apr_int64_t checkpoint_rev;
+  apr_int64_t file_size;
+  apr_off_t actual_size;
+  svn_error_t *err;
+
+  *rev = SVN_INVALID_REVNUM;
+
+  err = svn_stringbuf_from_file2(&content,
+                                 path_recovery_checkpoint(fs, scratch_pool),
+                                 scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  /* The checkpoint is merely an optimization.  Simply ignore it if it
+     has been damaged. */
+  parts = svn_cstring_split(content->data, " \n", TRUE, scratch_pool);
+  if (parts->nelts != 4)
+    return SVN_NO_ERROR;
+
+  err = svn_cstring_atoi64(&checkpoint_rev,
+                           APR_ARRAY_IDX(parts, 0, const char *));
+  if (!err)
+    err = svn_cstring_atoi64(&file_size,
+                             APR_ARRAY_IDX(parts, 1, const char *));
+  if (!err)
+    err = svn_cstring_atoui64(max_node_id,
+                              APR_ARRAY_IDX(parts, 2, const char *));
+  if (!err)
+    err = svn_cstring_atoui64(max_copy_id,
+                              APR_ARRAY_IDX(parts, 3, const char *));
+  if (err)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  if (checkpoint_rev < 0 || checkpoint_rev > max_rev)
+    return SVN_NO_ERROR;
+
+  /* Revision files are immutable.  A different size means that the
+     repository has been replaced, e.g. by restoring an older backup. */
+  SVN_ERR(get_rev_file_size(&actual_size, fs, (svn_revnum_t)checkpoint_rev,
+                            scratch_pool));
+  if (actual_size != file_size)
+    return SVN_NO_ERROR;
+
+  *rev = (svn_revnum_t)checkpoint_rev;
+  return SVN_NO_ERROR;
+}
+
+/* Part of the recovery procedure.  Record in FS that the maximum node-id
+   and copy-id found in revisions up to and including REV are MAX_NODE_ID
+   and MAX_COPY_ID, respectively.  Use SCRATCH_POOL for temporary
+   allocations. */
+static svn_error_t *
+write_recovery_checkpoint(svn_fs_t *fs,
+                          svn_revnum_t rev,
+                          apr_uint64_t max_node_id,
+                          apr_uint64_t max_copy_id,
+                          apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  const char *path = path_recovery_checkpoint(fs, scratch_pool);
+  apr_off_t size;
+  const char *buf;
+
+  SVN_ERR(get_rev_file_size(&size, fs, rev, scratch_pool));
+  buf = apr_psprintf(scratch_pool,
+                     "%ld %" APR_OFF_T_FMT " %" APR_UINT64_T_FMT
+                     " %" APR_UINT64_T_FMT "\n",
+                     rev, size, max_node_id, max_copy_id);
+
+  return svn_error_trace(svn_io_write_atomic2(path, buf, strlen(buf),
+                                              svn_fs_fs__path_current(
+                                                  fs, scratch_pool),
+                                              ffd->flush_to_disk,
+                                              scratch_pool));
+}
+
+/* Part of the recovery procedure.  Merge the maxima found in the chunk of
+   revisions ending with END_REV (exclusive) into *MAX_NODE_ID and
+   *MAX_COPY_ID and checkpoint the result in FS.  Chunks must be processed
+   strictly in order.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+recover_finish_chunk(svn_fs_t *fs,
+                     svn_revnum_t end_rev,
+                     apr_uint64_t chunk_node_id,
+                     apr_uint64_t chunk_copy_id,
+                     apr_uint64_t *max_node_id,
+                     apr_uint64_t *max_copy_id,
+                     apr_pool_t *scratch_pool)
+{
+  *max_node_id = MAX(*max_node_id, chunk_node_id);
+  *max_copy_id = MAX(*max_copy_id, chunk_copy_id);
+
+  return svn_error_trace(write_recovery_checkpoint(fs, end_rev - 1,
+                                                   *max_node_id,
+                                                   *max_copy_id,
+                                                   scratch_pool));
+}
+
+/* Parameters shared by all recovery scanning jobs. */
+typedef struct recover_jobs_baton_t
+{
+  /* The repository being recovered. */
+  svn_fs_t *fs;
+
+  /* Number of concurrent workers. */
+  int threads;
+
+  /* Number of revisions per job. */
+  svn_revnum_t chunk_size;
+
+  /* The next revision to hand out and the youngest one to scan. */
+  svn_revnum_t next_rev;
+  svn_revnum_t max_rev;
+
+  /* The maxima found in all chunks finished so far. */
+  apr_uint64_t *max_node_id;
+  apr_uint64_t *max_copy_id;
+} recover_jobs_baton_t;
+
+/* A chunk of revisions being scanned by a worker thread. */
+typedef struct recover_job_t
+{
+  /* The repository to scan.  A private instance if run concurrently. */
+  svn_fs_t *fs;
+
+  /* Revision range as passed to recover_scan_ids(). */
+  svn_revnum_t start_rev;
+  svn_revnum_t end_rev;
+
+  /* Outcome of recover_scan_ids(). */
+  apr_uint64_t max_node_id;
+  apr_uint64_t max_copy_id;
+} recover_job_t;
+
+/* Implement svn__job_start_func_t for recover_max_ids().  BATON is a
+   recover_jobs_baton_t. */
+static svn_error_t *
+recover_job_start(void **job_p,
+                  void *baton,
+                  apr_pool_t *job_pool,
+                  apr_pool_t *scratch_pool)
+{
+  recover_jobs_baton_t *jobs = baton;
+  recover_job_t *job;
+
+  *job_p = NULL;
+  if (jobs->next_rev > jobs->max_rev)
+    return SVN_NO_ERROR;
+
+  job = apr_pcalloc(job_pool, sizeof(*job));
+  job->start_rev = jobs->next_rev;
+  job->end_rev = MIN(jobs->next_rev + jobs->chunk_size,
+                     jobs->max_rev + 1);
+  if (jobs->threads > 1)
+    SVN_ERR(svn_fs_fs__open_clone(&job->fs, jobs->fs, job_pool,
+                                  scratch_pool));
+  else
+    job->fs = jobs->fs;
+
+  jobs->next_rev = job->end_rev;
+  *job_p = job;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn__job_work_func_t for recover_max_ids(), scanning the
+   revisions of the recover_job_t JOB_BATON. */
+static svn_error_t *
+recover_job_work(void *job_baton,
+                 svn_cancel_func_t cancel_func,
+                 void *cancel_baton,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  recover_job_t *job = job_baton;
+
+  return svn_error_trace(recover_scan_ids(job->fs, job->start_rev,
+                                          job->end_rev, &job->max_node_id,
+                                          &job->max_copy_id, cancel_func,
+                                          cancel_baton, scratch_pool));
+}
+
+/* Implement svn__job_finish_func_t for recover_max_ids(), checkpointing
+   the result of the recover_job_t JOB_BATON.  BATON is a
+   recover_jobs_baton_t.  On error, the checkpoint lets the next attempt
+   continue where we stopped. */
+static svn_error_t *
+recover_job_finish(void *job_baton,
+                   svn_error_t *err,
+                   void *baton,
+                   apr_pool_t *scratch_pool)
+{
+  recover_job_t *job = job_baton;
+  recover_jobs_baton_t *jobs = baton;
+
+  SVN_ERR(err);
+
+  return svn_error_trace(recover_finish_chunk(jobs->fs, job->end_rev,
+                                              job->max_node_id,
+                                              job->max_copy_id,
+                                              jobs->max_node_id,
+                                              jobs->max_copy_id,
+                                              scratch_pool));
+}
+
+/* Part of the recovery procedure.  Set *MAX_NODE_ID and *MAX_COPY_ID to
+   the largest node-id and copy-id, respectively, used in revisions 0 to
+   MAX_REV of B->FS.  Continue from the recovery checkpoint, if possible,
+   and update it as we go.  Use POOL for temporary allocations. */
+static svn_error_t *
+recover_max_ids(apr_uint64_t *max_node_id,
+                apr_uint64_t *max_copy_id,
+                struct recover_baton *b,
+                svn_revnum_t max_rev,
+                apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = b->fs->fsap_data;
+  recover_jobs_baton_t jobs;
+  svn_revnum_t checkpoint_rev;
+  svn_revnum_t rev;
+
+  SVN_ERR(read_recovery_checkpoint(&checkpoint_rev, max_node_id,
+                                   max_copy_id, b->fs, max_rev, pool));
+  if (SVN_IS_VALID_REVNUM(checkpoint_rev))
+    {
+      rev = checkpoint_rev + 1;
+    }
+  else
+    {
+      rev = 0;
+      *max_node_id = 0;
+      *max_copy_id = 0;
+    }
+
+  /* Scan up to recovery_threads chunks concurrently. */
+  jobs.fs = b->fs;
+  jobs.threads = ffd->recovery_threads;
+  jobs.chunk_size = MAX(1, ffd->recovery_chunk_size);
+  jobs.next_rev = rev;
+  jobs.max_rev = max_rev;
+  jobs.max_node_id = max_node_id;
+  jobs.max_copy_id = max_copy_id;
+
+  return svn_error_trace(svn__jobs_run(jobs.threads, recover_job_start,
+                                       recover_job_work, recover_job_finish,
+                                       &jobs, b->cancel_func,
+                                       b->cancel_baton, pool));
+}
+
 /* The work-horse for svn_fs_fs__recover, called with the FS
    write lock.  This implements the svn_fs_fs__with_write_lock()
    'body' callback type.  BATON is a 'struct recover_baton *'. */
@@ -408,28 +751,10 @@ recover_body(void *baton, apr_pool_t *pool)
       /* Next we need to find the maximum node id and copy id in use across the
          filesystem.  Unfortunately, the only way we can get this information
          is to scan all the noderevs of all the revisions and keep track as
-         we go along. */
-      svn_revnum_t rev;
-      apr_pool_t *iterpool = svn_pool_create(pool);
-
-      for (rev = 0; rev <= max_rev; rev++)
-        {
-          svn_fs_fs__revision_file_t *rev_file;
-          apr_off_t root_offset;
-
-          svn_pool_clear(iterpool);
-
-          if (b->cancel_func)
-            SVN_ERR(b->cancel_func(b->cancel_baton));
-
-          SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, rev, pool,
-                                                   iterpool));
-          SVN_ERR(recover_get_root_offset(&root_offset, rev, rev_file, pool));
-          SVN_ERR(recover_find_max_ids(fs, rev, rev_file, root_offset,
-                                       &next_node_id, &next_copy_id, pool));
-          SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
-        }
-      svn_pool_destroy(iterpool);
+         we go along.  The recovery checkpoint lets us skip the revisions
+         that a previous run has already scanned. */
+      SVN_ERR(recover_max_ids(&next_node_id, &next_copy_id, b, max_rev,
+                              pool));
 
       /* Now that we finally have the maximum revision, node-id and copy-id, we
          can bump the two ids to get the next of each. */
@@ -488,6 +813,11 @@ recover_body(void *baton, apr_pool_t *pool)
         SVN_ERR(svn_fs_fs__del_rep_reference(fs, max_rev, pool));
     }
 
+  /* The same applies to the node history index, which must not report
+     node revisions that no longer exist. */
+  SVN_ERR(svn_fs_fs__prune_node_history(fs, max_rev, pool));
+  SVN_ERR(svn_fs_fs__prune_mergeinfo_index(fs, max_rev, pool));
+
   /* Now store the discovered youngest revision, and the next IDs if
      relevant, in a new 'current' file. */
   return svn_fs_fs__write_current(fs, max_rev, next_node_id, next_copy_id,
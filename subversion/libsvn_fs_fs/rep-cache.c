@@ -355,6 +355,41 @@ svn_fs_fs__set_rep_reference(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_fs__set_rep_references(svn_fs_t *fs,
+                              const apr_array_header_t *reps,
+                              apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_pool_t *iterpool;
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  if (reps->nelts == 0)
+    return SVN_NO_ERROR;
+
+  SVN_ERR_ASSERT(ffd->rep_sharing_allowed);
+  if (! ffd->rep_cache_db)
+    SVN_ERR(svn_fs_fs__open_rep_cache(fs, scratch_pool));
+
+  /* We use an sqlite transaction to speed things up;
+   * see <http://www.sqlite.org/faq.html#q19>. */
+  SVN_ERR(svn_sqlite__begin_transaction(ffd->rep_cache_db));
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < reps->nelts && !err; i++)
+    {
+      svn_pool_clear(iterpool);
+      err = svn_fs_fs__set_rep_reference(fs,
+                                         APR_ARRAY_IDX(reps, i,
+                                                       representation_t *),
+                                         iterpool);
+    }
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(svn_sqlite__finish_transaction(ffd->rep_cache_db,
+                                                        err));
+}
 
 svn_error_t *
 svn_fs_fs__del_rep_reference(svn_fs_t *fs,
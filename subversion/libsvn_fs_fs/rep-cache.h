@@ -83,6 +83,15 @@ svn_fs_fs__set_rep_reference(svn_fs_t *fs,
                              representation_t *rep,
                              apr_pool_t *pool);
 
+/* Set all representations in REPS (an array of representation_t *) in FS,
+   using a single SQLite transaction.  Use SCRATCH_POOL for temporary
+   allocations.  Errors are the same as for svn_fs_fs__set_rep_reference()
+   plus those from finishing the SQLite transaction. */
+svn_error_t *
+svn_fs_fs__set_rep_references(svn_fs_t *fs,
+                              const apr_array_header_t *reps,
+                              apr_pool_t *scratch_pool);
+
 /* Delete from the cache all reps corresponding to revisions younger
    than YOUNGEST. */
 svn_error_t *
@@ -28,6 +28,8 @@
 
 #include "../libsvn_fs/fs-loader.h"
 
+#include "svn_pools.h"
+
 #include "private/svn_io_private.h"
 #include "svn_private_config.h"
 
@@ -54,9 +56,45 @@ init_revision_file(svn_fs_fs__revision_file_t *file,
   file->p2l_offset = -1;
   file->p2l_checksum = NULL;
   file->footer_offset = -1;
+#if APR_HAS_MMAP
+  file->mmap = NULL;
+#endif
+  file->cache_entry = NULL;
   file->pool = pool;
 }
 
+/* If enabled in FS, map the contents of the open pack FILE into memory.
+ * Mapping failures are not fatal; we then simply continue to use file I/O.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+auto_map_file(svn_fs_fs__revision_file_t *file,
+              svn_fs_t *fs,
+              apr_pool_t *scratch_pool)
+{
+#if APR_HAS_MMAP
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_finfo_t finfo;
+
+  if (!ffd->mmap_pack_files || !file->is_packed)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_io_file_info_get(&finfo, APR_FINFO_SIZE, file->file,
+                               scratch_pool));
+
+  /* Don't try to map files that are larger than our address space. */
+  if (finfo.size > 0 && (apr_uint64_t)finfo.size <= APR_SIZE_MAX)
+    {
+      apr_status_t status = apr_mmap_create(&file->mmap, file->file, 0,
+                                            (apr_size_t)finfo.size,
+                                            APR_MMAP_READ, file->pool);
+      if (status)
+        file->mmap = NULL;
+    }
+#endif
+
+  return SVN_NO_ERROR;
+}
+
 /* Baton type for set_read_only() */
 typedef struct set_read_only_baton_t
 {
@@ -160,6 +198,9 @@ open_pack_or_rev_file(svn_fs_fs__revision_file_t *file,
                                                   result_pool);
           file->is_packed = svn_fs_fs__is_packed_rev(fs, rev);
 
+          if (!writable)
+            SVN_ERR(auto_map_file(file, fs, scratch_pool));
+
           return SVN_NO_ERROR;
         }
 
@@ -199,6 +240,263 @@ open_pack_or_rev_file(svn_fs_fs__revision_file_t *file,
   return svn_error_trace(err);
 }
 
+/* The file handle cache.
+ *
+ * Opening a rev / pack file and reading its footer costs several system
+ * calls, yet many operations (log, blame, ...) touch the same few files
+ * over and over again.  Therefore, we keep a small number of read-only
+ * files open per svn_fs_t, together with their parsed footers and index
+ * streams.
+ *
+ * A cached file is used by at most one caller at a time.  It is "checked
+ * out" by svn_fs_fs__open_pack_or_rev_file() and returned either by
+ * svn_fs_fs__close_revision_file() or when the caller's pool gets cleaned
+ * up.  Idle files are closed in LRU order whenever the cache exceeds its
+ * capacity.  svn_fs_t is not thread-safe, so we don't need to synchronize
+ * access here.
+ */
+typedef struct svn_fs_fs__rev_file_cache_t rev_file_cache_t;
+
+/* An entry in the file handle cache. */
+typedef struct rev_file_cache_entry_t
+{
+  /* The cached file.  Its POOL is private to this entry and also contains
+   * the entry itself. */
+  svn_fs_fs__revision_file_t file;
+
+  /* The cache that this entry belongs to. */
+  rev_file_cache_t *cache;
+
+  /* Pool of the current user of FILE.  NULL while the entry is idle. */
+  apr_pool_t *owner_pool;
+
+  /* If set, close FILE as soon as it gets released. */
+  svn_boolean_t discard;
+
+  /* Neighbours in the cache's list of entries, most recently used first. */
+  struct rev_file_cache_entry_t *previous;
+  struct rev_file_cache_entry_t *next;
+} rev_file_cache_entry_t;
+
+struct svn_fs_fs__rev_file_cache_t
+{
+  /* The filesystem that the cached files belong to. */
+  svn_fs_t *fs;
+
+  /* Maximum number of files that we want to keep open, busy or idle. */
+  int capacity;
+
+  /* Number of entries in the list below. */
+  int count;
+
+  /* List of all entries, most recently used first. */
+  rev_file_cache_entry_t *first;
+  rev_file_cache_entry_t *last;
+
+  /* Parent pool of all entry pools. */
+  apr_pool_t *pool;
+};
+
+/* Remove ENTRY from its cache's list. */
+static void
+unlink_entry(rev_file_cache_entry_t *entry)
+{
+  rev_file_cache_t *cache = entry->cache;
+
+  if (entry->previous)
+    entry->previous->next = entry->next;
+  else
+    cache->first = entry->next;
+
+  if (entry->next)
+    entry->next->previous = entry->previous;
+  else
+    cache->last = entry->previous;
+
+  entry->previous = NULL;
+  entry->next = NULL;
+}
+
+/* Insert ENTRY at the head, i.e. the most recently used end, of its
+ * cache's list. */
+static void
+link_entry_first(rev_file_cache_entry_t *entry)
+{
+  rev_file_cache_t *cache = entry->cache;
+
+  entry->previous = NULL;
+  entry->next = cache->first;
+
+  if (cache->first)
+    cache->first->previous = entry;
+  else
+    cache->last = entry;
+
+  cache->first = entry;
+}
+
+/* Remove the idle ENTRY from its cache and close the file. */
+static void
+drop_entry(rev_file_cache_entry_t *entry)
+{
+  unlink_entry(entry);
+  --entry->cache->count;
+
+  /* This closes the file, releases any memory mapping and frees ENTRY. */
+  svn_pool_destroy(entry->file.pool);
+}
+
+/* Close idle entries in CACHE, least recently used first, until CACHE
+ * no longer exceeds its capacity.  Also close idle non-packed rev files
+ * whose revisions have been packed since; they will not be asked for
+ * again. */
+static void
+evict_entries(rev_file_cache_t *cache)
+{
+  rev_file_cache_entry_t *entry = cache->last;
+  while (entry)
+    {
+      rev_file_cache_entry_t *previous = entry->previous;
+      if (   entry->owner_pool == NULL
+          && (   cache->count > cache->capacity
+              || (   !entry->file.is_packed
+                  && svn_fs_fs__is_packed_rev(cache->fs,
+                                              entry->file.start_revision))))
+        drop_entry(entry);
+
+      entry = previous;
+    }
+}
+
+/* Return the busy ENTRY to its cache. */
+static void
+release_entry(rev_file_cache_entry_t *entry)
+{
+  entry->owner_pool = NULL;
+  if (entry->discard)
+    {
+      drop_entry(entry);
+    }
+  else
+    {
+      unlink_entry(entry);
+      link_entry_first(entry);
+      evict_entries(entry->cache);
+    }
+}
+
+/* APR pool cleanup function returning the rev_file_cache_entry_t BATON to
+ * its cache when the user's pool gets cleaned up. */
+static apr_status_t
+release_entry_on_cleanup(void *baton)
+{
+  release_entry(baton);
+  return APR_SUCCESS;
+}
+
+/* APR pool pre-cleanup function for the rev_file_cache_t BATON.  Detach
+ * all busy entries from their users' pools before the entries get
+ * destroyed together with the cache. */
+static apr_status_t
+rev_file_cache_pre_cleanup(void *baton)
+{
+  rev_file_cache_t *cache = baton;
+  rev_file_cache_entry_t *entry;
+
+  for (entry = cache->first; entry; entry = entry->next)
+    if (entry->owner_pool)
+      {
+        apr_pool_cleanup_kill(entry->owner_pool, entry,
+                              release_entry_on_cleanup);
+        entry->owner_pool = NULL;
+      }
+
+  cache->first = NULL;
+  cache->last = NULL;
+  cache->count = 0;
+
+  return APR_SUCCESS;
+}
+
+/* Return the file handle cache of FS, creating it if necessary. */
+static rev_file_cache_t *
+get_rev_file_cache(svn_fs_t *fs)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  if (ffd->rev_file_cache == NULL)
+    {
+      rev_file_cache_t *cache = apr_pcalloc(fs->pool, sizeof(*cache));
+      cache->fs = fs;
+      cache->capacity = ffd->file_handle_cache_size;
+      cache->pool = svn_pool_create(fs->pool);
+      apr_pool_pre_cleanup_register(cache->pool, cache,
+                                    rev_file_cache_pre_cleanup);
+
+      ffd->rev_file_cache = cache;
+    }
+
+  return ffd->rev_file_cache;
+}
+
+/* Implement svn_fs_fs__open_pack_or_rev_file() using the file handle
+ * cache of FS. */
+static svn_error_t *
+open_cached_rev_file(svn_fs_fs__revision_file_t **file,
+                     svn_fs_t *fs,
+                     svn_revnum_t rev,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  rev_file_cache_t *cache = get_rev_file_cache(fs);
+  svn_boolean_t is_packed = svn_fs_fs__is_packed_rev(fs, rev);
+  svn_revnum_t start_revision = svn_fs_fs__packed_base_rev(fs, rev);
+  rev_file_cache_entry_t *entry;
+
+  for (entry = cache->first; entry; entry = entry->next)
+    if (   entry->owner_pool == NULL
+        && entry->file.start_revision == start_revision
+        && entry->file.is_packed == is_packed)
+      break;
+
+  if (entry)
+    {
+      /* Callers expect a freshly opened file. */
+      apr_off_t offset = 0;
+      SVN_ERR(svn_io_file_seek(entry->file.file, APR_SET, &offset,
+                               scratch_pool));
+      unlink_entry(entry);
+    }
+  else
+    {
+      apr_pool_t *entry_pool = svn_pool_create(cache->pool);
+      svn_error_t *err;
+
+      entry = apr_pcalloc(entry_pool, sizeof(*entry));
+      init_revision_file(&entry->file, fs, rev, entry_pool);
+      err = open_pack_or_rev_file(&entry->file, fs, rev, FALSE, entry_pool,
+                                  scratch_pool);
+      if (err)
+        {
+          svn_pool_destroy(entry_pool);
+          return svn_error_trace(err);
+        }
+
+      entry->cache = cache;
+      entry->file.cache_entry = entry;
+      ++cache->count;
+    }
+
+  entry->owner_pool = result_pool;
+  apr_pool_cleanup_register(result_pool, entry, release_entry_on_cleanup,
+                            apr_pool_cleanup_null);
+  link_entry_first(entry);
+  evict_entries(cache);
+
+  *file = &entry->file;
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__open_pack_or_rev_file(svn_fs_fs__revision_file_t **file,
                                  svn_fs_t *fs,
@@ -206,6 +504,19 @@ svn_fs_fs__open_pack_or_rev_file(svn_fs_fs__revision_file_t **file,
                                  apr_pool_t *result_pool,
                                  apr_pool_t *scratch_pool)
 {
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_boolean_t use_cache = ffd->file_handle_cache_size > 0;
+
+#ifdef WIN32
+  /* Open files can't be removed on Windows but packing a shard will
+   * delete the non-packed rev files.  Pack files are never deleted. */
+  use_cache = use_cache && svn_fs_fs__is_packed_rev(fs, rev);
+#endif
+
+  if (use_cache)
+    return svn_error_trace(open_cached_rev_file(file, fs, rev, result_pool,
+                                                scratch_pool));
+
   *file = apr_palloc(result_pool, sizeof(**file));
   init_revision_file(*file, fs, rev, result_pool);
 
@@ -220,6 +531,25 @@ svn_fs_fs__open_pack_or_rev_file_writable(svn_fs_fs__revision_file_t** file,
                                           apr_pool_t* result_pool,
                                           apr_pool_t *scratch_pool)
 {
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  /* The caller may modify the file, e.g. replace its index data.  Don't
+   * let cached handles serve outdated footers or buffer contents. */
+  if (ffd->rev_file_cache)
+    {
+      rev_file_cache_entry_t *entry = ffd->rev_file_cache->first;
+      while (entry)
+        {
+          rev_file_cache_entry_t *next = entry->next;
+          if (entry->owner_pool)
+            entry->discard = TRUE;
+          else
+            drop_entry(entry);
+
+          entry = next;
+        }
+    }
+
   *file = apr_palloc(result_pool, sizeof(**file));
   init_revision_file(*file, fs, rev, result_pool);
 
@@ -267,6 +597,27 @@ svn_fs_fs__auto_read_footer(svn_fs_fs__revision_file_t *file)
   return SVN_NO_ERROR;
 }
 
+svn_boolean_t
+svn_fs_fs__rev_file_mapped_data(const char **data,
+                                svn_fs_fs__revision_file_t *file,
+                                apr_off_t offset,
+                                apr_off_t len)
+{
+#if APR_HAS_MMAP
+  if (   file->mmap
+      && offset >= 0
+      && len >= 0
+      && offset <= (apr_off_t)file->mmap->size
+      && len <= (apr_off_t)file->mmap->size - offset)
+    {
+      *data = (const char *)file->mmap->mm + offset;
+      return TRUE;
+    }
+#endif
+
+  return FALSE;
+}
+
 svn_error_t *
 svn_fs_fs__open_proto_rev_file(svn_fs_fs__revision_file_t **file,
                                svn_fs_t *fs,
@@ -293,11 +644,35 @@ svn_fs_fs__open_proto_rev_file(svn_fs_fs__revision_file_t **file,
 svn_error_t *
 svn_fs_fs__close_revision_file(svn_fs_fs__revision_file_t *file)
 {
+  if (file->cache_entry)
+    {
+      /* Keep the file open and hand it back to the cache. */
+      rev_file_cache_entry_t *entry = file->cache_entry;
+      if (entry->owner_pool)
+        {
+          apr_pool_cleanup_kill(entry->owner_pool, entry,
+                                release_entry_on_cleanup);
+          release_entry(entry);
+        }
+
+      return SVN_NO_ERROR;
+    }
+
   if (file->stream)
     SVN_ERR(svn_stream_close(file->stream));
   if (file->file)
     SVN_ERR(svn_io_file_close(file->file, file->pool));
 
+#if APR_HAS_MMAP
+  if (file->mmap)
+    {
+      apr_status_t status = apr_mmap_delete(file->mmap);
+      file->mmap = NULL;
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't unmap pack file"));
+    }
+#endif
+
   file->file = NULL;
   file->stream = NULL;
   file->l2p_stream = NULL;
@@ -23,6 +23,8 @@
 #ifndef SVN_LIBSVN_FS__REV_FILE_H
 #define SVN_LIBSVN_FS__REV_FILE_H
 
+#include <apr_mmap.h>
+
 #include "svn_fs.h"
 #include "id.h"
 
@@ -90,6 +92,18 @@ typedef struct svn_fs_fs__revision_file_t
    * been called, yet. */
   apr_off_t footer_offset;
 
+#if APR_HAS_MMAP
+  /* Read-only memory mapping of the whole FILE or NULL.  We only map
+   * pack files as those are immutable and it must be enabled in fsfs.conf.
+   * Use svn_fs_fs__rev_file_mapped_data() to access the contents. */
+  apr_mmap_t *mmap;
+#endif
+
+  /* If not NULL, this file is owned by the filesystem's file handle cache
+   * and svn_fs_fs__close_revision_file() will return it to that cache
+   * instead of closing it. */
+  struct rev_file_cache_entry_t *cache_entry;
+
   /* pool containing this object */
   apr_pool_t *pool;
 } svn_fs_fs__revision_file_t;
@@ -98,7 +112,11 @@ typedef struct svn_fs_fs__revision_file_t
  * been packed, *FILE will be set to the packed file; otherwise, set *FILE
  * to the revision file for REV.  Return SVN_ERR_FS_NO_SUCH_REVISION if the
  * file doesn't exist.  Allocate *FILE in RESULT_POOL and use SCRATCH_POOL
- * for temporaries. */
+ * for temporaries.
+ *
+ * If FS' file handle cache is enabled, *FILE may be a previously opened
+ * file taken from that cache.  It will be returned to the cache when
+ * it gets closed or RESULT_POOL gets cleaned up, whichever comes first. */
 svn_error_t *
 svn_fs_fs__open_pack_or_rev_file(svn_fs_fs__revision_file_t **file,
                                  svn_fs_t *fs,
@@ -111,6 +129,9 @@ svn_fs_fs__open_pack_or_rev_file(svn_fs_fs__revision_file_t **file,
  * filesystem FS has been packed, *FILE will be set to the packed file;
  * otherwise, set *FILE to the revision file for REV.
  *
+ * Files opened for writing are never cached.  Because the caller may
+ * modify the file, all cached handles in FS will be discarded.
+ *
  * Return SVN_ERR_FS_NO_SUCH_REVISION if the file doesn't exist.
  * Allocate *FILE in RESULT_POOL and use SCRATCH_POOLfor temporaries. */
 svn_error_t *
@@ -128,6 +149,18 @@ svn_fs_fs__open_pack_or_rev_file_writable(svn_fs_fs__revision_file_t **file,
 svn_error_t *
 svn_fs_fs__auto_read_footer(svn_fs_fs__revision_file_t *file);
 
+/* If FILE has been memory-mapped and the mapping covers the LEN bytes
+ * starting at OFFSET, set *DATA to the address of the byte at OFFSET and
+ * return TRUE.  Otherwise, leave *DATA untouched and return FALSE.
+ *
+ * The data is valid until FILE gets closed.
+ */
+svn_boolean_t
+svn_fs_fs__rev_file_mapped_data(const char **data,
+                                svn_fs_fs__revision_file_t *file,
+                                apr_off_t offset,
+                                apr_off_t len);
+
 /* Open the proto-rev file of transaction TXN_ID in FS and return it in *FILE.
  * Allocate *FILE in RESULT_POOL use and SCRATCH_POOL for temporaries.. */
 svn_error_t *
@@ -137,7 +170,8 @@ svn_fs_fs__open_proto_rev_file(svn_fs_fs__revision_file_t **file,
                                apr_pool_t* result_pool,
                                apr_pool_t *scratch_pool);
 
-/* Close all files and streams in FILE.
+/* Close all files and streams in FILE.  If FILE came from the file
+ * handle cache, return it to the cache instead.
  */
 svn_error_t *
 svn_fs_fs__close_revision_file(svn_fs_fs__revision_file_t *file);
@@ -182,6 +182,26 @@ typedef struct packed_revprops_t
   apr_array_header_t *manifest;
 } packed_revprops_t;
 
+/* The manifest of a packed revprop shard as remembered by the svn_fs_t
+ * between revprop accesses.  Until the revprop prefix changes, i.e. until
+ * the next sync barrier, it tells us the current pack file names without
+ * re-reading the manifest file.
+ */
+struct fs_fs_revprop_manifest_t
+{
+  /* Value of ffd->REVPROP_PREFIX at the time we read the manifest. */
+  apr_uint64_t prefix;
+
+  /* First revision covered by MANIFEST. */
+  svn_revnum_t manifest_start;
+
+  /* Maps long(rev - MANIFEST_START) to const char* pack file name */
+  apr_array_header_t *manifest;
+
+  /* Pool containing MANIFEST.  Gets cleared when reading a new one. */
+  apr_pool_t *pool;
+};
+
 /* Parse the serialized revprops in CONTENT and return them in *PROPERTIES.
  * Also, put them into the revprop cache, if activated, for future use.
  *
@@ -228,34 +248,64 @@ prepare_revprop_cache(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
-/* Store the unparsed revprop hash CONTENT for REVISION in FS's revprop
+/* Set *KEY to the revprop cache key for the non-packed revprops of
+ * REVISION in FS.
+ */
+static svn_error_t *
+non_packed_revprop_key(pair_cache_key_t *key,
+                       svn_fs_t *fs,
+                       svn_revnum_t revision)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  /* Make sure prepare_revprop_cache() has been called. */
+  SVN_ERR_ASSERT(ffd->revprop_prefix);
+  key->revision = revision;
+  key->second = ffd->revprop_prefix;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *KEY to the revprop cache key for the revprops of REVISION as found
+ * in the pack file with tag TAG.
+ *
+ * Every modification of a revprop pack writes a new pack file with an
+ * increased tag.  Hence, these keys don't need the revprop prefix and stay
+ * valid across sync barriers.  A revprop change, in this or any other
+ * process, only invalidates the entries of the pack that it touched.
+ * Negative values keep these keys apart from the prefix-based ones.
+ */
+static void
+packed_revprop_key(pair_cache_key_t *key,
+                   svn_revnum_t revision,
+                   apr_int64_t tag)
+{
+  key->revision = revision;
+  key->second = -1 - tag;
+}
+
+/* Store the unparsed revprop hash CONTENT under KEY in FS's revprop
  * cache.  If CACHED is not NULL, set *CACHED if there already is such
  * an entry and skip the cache write in that case.  Use SCRATCH_POOL for
  * temporary allocations. */
 static svn_error_t *
 cache_revprops(svn_boolean_t *is_cached,
                svn_fs_t *fs,
-               svn_revnum_t revision,
+               const pair_cache_key_t *key,
                svn_string_t *content,
                apr_pool_t *scratch_pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
-  pair_cache_key_t key;
-
-  /* Make sure prepare_revprop_cache() has been called. */
-  SVN_ERR_ASSERT(ffd->revprop_prefix);
-  key.revision = revision;
-  key.second = ffd->revprop_prefix;
 
   if (is_cached)
     {
-      SVN_ERR(svn_cache__has_key(is_cached, ffd->revprop_cache, &key,
+      SVN_ERR(svn_cache__has_key(is_cached, ffd->revprop_cache, key,
                                  scratch_pool));
       if (*is_cached)
         return SVN_NO_ERROR;
     }
 
-  SVN_ERR(svn_cache__set(ffd->revprop_cache, &key, content, scratch_pool));
+  SVN_ERR(svn_cache__set(ffd->revprop_cache, key, content, scratch_pool));
 
   return SVN_NO_ERROR;
 }
@@ -298,7 +348,12 @@ read_non_packed_revprop(apr_hash_t **properties,
       SVN_ERR(parse_revprop(properties, fs, rev, as_string, pool, iterpool));
 
       if (populate_cache)
-        SVN_ERR(cache_revprops(NULL, fs, rev, as_string, iterpool));
+        {
+          pair_cache_key_t key;
+
+          SVN_ERR(non_packed_revprop_key(&key, fs, rev));
+          SVN_ERR(cache_revprops(NULL, fs, &key, as_string, iterpool));
+        }
     }
 
   svn_pool_clear(iterpool);
@@ -319,6 +374,22 @@ get_min_filename_len(packed_revprops_t *revprops)
   return svn__i64toa(number_buffer, revprops->manifest_start) + 2;
 }
 
+/* Set *TAG to the tag of the revprop pack file FILENAME, i.e. to the
+ * counter following the dot.
+ */
+static svn_error_t *
+get_pack_tag(apr_int64_t *tag,
+             const char *filename)
+{
+  const char *tag_string = strchr(filename, '.');
+  if (tag_string == NULL)
+    return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                             _("Packed file '%s' misses a tag"),
+                             filename);
+
+  return svn_error_trace(svn_cstring_atoi64(tag, tag_string + 1));
+}
+
 /* Given FS and REVPROPS->REVISION, fill the FILENAME, FOLDER and MANIFEST
  * members. Use RESULT_POOL for allocating results and SCRATCH_POOL for
  * temporaries.
@@ -440,6 +511,59 @@ same_shard(svn_fs_t *fs,
   return (r1 / ffd->max_files_per_dir) == (r2 / ffd->max_files_per_dir);
 }
 
+/* Set *TAG to the tag of the pack file that contains the revprops of the
+ * packed revision REV in FS.  Only read the manifest if the one remembered
+ * in FS covers a different shard or predates the last sync barrier.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+get_current_pack_tag(apr_int64_t *tag,
+                     svn_fs_t *fs,
+                     svn_revnum_t rev,
+                     apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  fs_fs_revprop_manifest_t *manifest = ffd->revprop_manifest;
+  const char *filename;
+
+  /* Make sure prepare_revprop_cache() has been called. */
+  SVN_ERR_ASSERT(ffd->revprop_prefix);
+
+  if (   manifest == NULL
+      || manifest->prefix != ffd->revprop_prefix
+      || !same_shard(fs, rev, manifest->manifest_start))
+    {
+      packed_revprops_t revprops = { 0 };
+
+      if (manifest == NULL)
+        {
+          manifest = apr_pcalloc(fs->pool, sizeof(*manifest));
+          manifest->pool = svn_pool_create(fs->pool);
+          ffd->revprop_manifest = manifest;
+        }
+      else
+        {
+          svn_pool_clear(manifest->pool);
+        }
+
+      /* Don't leave an outdated manifest behind if reading fails. */
+      manifest->prefix = 0;
+
+      revprops.revision = rev;
+      SVN_ERR(get_revprop_packname(fs, &revprops, manifest->pool,
+                                   scratch_pool));
+
+      manifest->manifest_start = revprops.manifest_start;
+      manifest->manifest = revprops.manifest;
+      manifest->prefix = ffd->revprop_prefix;
+    }
+
+  filename = APR_ARRAY_IDX(manifest->manifest,
+                           rev - manifest->manifest_start, const char *);
+
+  return svn_error_trace(get_pack_tag(tag, filename));
+}
+
 /* Given FS and the full packed file content in REVPROPS->PACKED_REVPROPS,
  * fill the START_REVISION member, and make PACKED_REVPROPS point to the
  * first serialized revprop.  If READ_ALL is set, initialize the SIZES
@@ -460,6 +584,7 @@ parse_packed_revprops(svn_fs_t *fs,
 {
   svn_stream_t *stream;
   apr_int64_t first_rev, count, i;
+  apr_int64_t tag = 0;
   apr_size_t offset;
   const char *header_end;
   apr_pool_t *iterpool = svn_pool_create(scratch_pool);
@@ -474,6 +599,10 @@ parse_packed_revprops(svn_fs_t *fs,
   SVN_ERR(svn__decompress_zlib(compressed->data, compressed->len,
                                uncompressed, APR_SIZE_MAX));
 
+  /* cache entries are specific to this version of the pack file */
+  if (populate_cache)
+    SVN_ERR(get_pack_tag(&tag, revprops->filename));
+
   /* read first revision number and number of revisions in the pack */
   stream = svn_stream_from_stringbuf(uncompressed, scratch_pool);
   SVN_ERR(svn_fs_fs__read_number_from_stream(&first_rev, NULL, stream,
@@ -568,7 +697,10 @@ parse_packed_revprops(svn_fs_t *fs,
            * We try to detect thosse cases here.
            * Only keep going while most (at least 2/3) aren't cached, yet. */
           svn_boolean_t already_cached;
-          SVN_ERR(cache_revprops(&already_cached, fs, revision, &serialized,
+          pair_cache_key_t key;
+
+          packed_revprop_key(&key, revision, tag);
+          SVN_ERR(cache_revprops(&already_cached, fs, &key, &serialized,
                                  iterpool));
 
           /* Stop populating the cache once we encountered too many entries
@@ -743,11 +875,14 @@ svn_fs_fs__get_revision_proplist(apr_hash_t **proplist_p,
                                  apr_pool_t *scratch_pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
+  pair_cache_key_t key;
 
-  /* Only populate the cache if we did not just cross a sync barrier.
-   * This is to eliminate overhead from code that always sets REFRESH.
-   * For callers that want caching, the caching kicks in on read "later". */
+  /* Only populate the cache with non-packed revprops if we did not just
+   * cross a sync barrier.  This is to eliminate overhead from code that
+   * always sets REFRESH.  For callers that want caching, the caching kicks
+   * in on read "later". */
   svn_boolean_t populate_cache = !refresh;
+  svn_boolean_t use_cache = !refresh;
 
   /* not found, yet */
   *proplist_p = NULL;
@@ -755,21 +890,31 @@ svn_fs_fs__get_revision_proplist(apr_hash_t **proplist_p,
   /* should they be available at all? */
   SVN_ERR(svn_fs_fs__ensure_revision_exists(rev, fs, scratch_pool));
 
+  /* Previous cache contents is invalid now. */
   if (refresh)
+    svn_fs_fs__reset_revprop_cache(fs);
+
+  /* Auto-alloc prefix and construct the key. */
+  SVN_ERR(prepare_revprop_cache(fs, scratch_pool));
+  if (svn_fs_fs__is_packed_revprop(fs, rev))
     {
-      /* Previous cache contents is invalid now. */
-      svn_fs_fs__reset_revprop_cache(fs);
+      /* Cached packed revprops can be validated against the current
+       * manifest, which is cheap compared to reading the pack file.
+       * So, use the cache even after a sync barrier. */
+      apr_int64_t tag;
+      SVN_ERR(get_current_pack_tag(&tag, fs, rev, scratch_pool));
+      packed_revprop_key(&key, rev, tag);
+      use_cache = TRUE;
     }
   else
+    {
+      SVN_ERR(non_packed_revprop_key(&key, fs, rev));
+    }
+
+  if (use_cache)
     {
       /* Try cache lookup first. */
       svn_boolean_t is_cached;
-      pair_cache_key_t key;
-
-      /* Auto-alloc prefix and construct the key. */
-      SVN_ERR(prepare_revprop_cache(fs, scratch_pool));
-      key.revision = rev;
-      key.second = ffd->revprop_prefix;
 
       /* The only way that this might error out is due to parser error. */
       SVN_ERR_W(svn_cache__get((void **) proplist_p, &is_cached,
@@ -805,7 +950,7 @@ svn_fs_fs__get_revision_proplist(apr_hash_t **proplist_p,
   if (ffd->format >= SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT && !*proplist_p)
     {
       packed_revprops_t *revprops;
-      SVN_ERR(read_pack_revprop(&revprops, fs, rev, FALSE, populate_cache,
+      SVN_ERR(read_pack_revprop(&revprops, fs, rev, FALSE, TRUE,
                                 result_pool));
       *proplist_p = revprops->properties;
     }
@@ -1027,7 +1172,6 @@ repack_file_open(apr_file_t **file,
                  apr_pool_t *pool)
 {
   apr_int64_t tag;
-  const char *tag_string;
   const char *new_filename;
   int i;
   int manifest_offset
@@ -1045,13 +1189,7 @@ repack_file_open(apr_file_t **file,
     = svn_dirent_join(revprops->folder, old_filename, pool);
 
   /* increase the tag part, i.e. the counter after the dot */
-  tag_string = strchr(old_filename, '.');
-  if (tag_string == NULL)
-    return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
-                             _("Packed file '%s' misses a tag"),
-                             old_filename);
-
-  SVN_ERR(svn_cstring_atoi64(&tag, tag_string + 1));
+  SVN_ERR(get_pack_tag(&tag, old_filename));
   new_filename = apr_psprintf(pool, "%ld.%" APR_INT64_T_FMT,
                               revprops->start_revision + start,
                               ++tag);
@@ -1065,7 +1203,8 @@ repack_file_open(apr_file_t **file,
   SVN_ERR(svn_io_file_open(file, svn_dirent_join(revprops->folder,
                                                  new_filename,
                                                  pool),
-                           APR_WRITE | APR_CREATE, APR_OS_DEFAULT, pool));
+                           APR_WRITE | APR_CREATE | APR_TRUNCATE,
+                           APR_OS_DEFAULT, pool));
 
   return SVN_NO_ERROR;
 }
@@ -1092,6 +1231,7 @@ write_packed_revprop(const char **final_path,
   svn_stringbuf_t *serialized;
   apr_size_t new_total_size;
   int changed_index;
+  int i;
 
   /* read contents of the current pack file */
   SVN_ERR(read_pack_revprop(&revprops, fs, rev, TRUE, FALSE, pool));
@@ -1114,13 +1254,12 @@ write_packed_revprop(const char **final_path,
   if (   new_total_size < ffd->revprop_pack_size
       || revprops->sizes->nelts == 1)
     {
-      /* simply replace the old pack file with new content as we do it
-       * in the non-packed case */
-
-      *final_path = svn_dirent_join(revprops->folder, revprops->filename,
-                                    pool);
-      SVN_ERR(svn_io_open_unique_file3(&file, tmp_path, revprops->folder,
-                                       svn_io_file_del_none, pool, pool));
+      /* write the new content to a pack file with an increased tag.
+       * That makes cached copies of the old content unreachable in all
+       * processes. */
+      SVN_ERR(repack_file_open(&file, fs, revprops, 0,
+                               revprops->sizes->nelts, files_to_delete,
+                               pool));
       SVN_ERR(repack_revprops(fs, revprops, 0, revprops->sizes->nelts,
                               changed_index, serialized, new_total_size,
                               file, pool));
@@ -1128,7 +1267,7 @@ write_packed_revprop(const char **final_path,
   else
     {
       /* split the pack file into two of roughly equal size */
-      int right_count, left_count, i;
+      int right_count, left_count;
 
       int left = 0;
       int right = revprops->sizes->nelts - 1;
@@ -1199,23 +1338,23 @@ write_packed_revprop(const char **final_path,
                                   serialized, new_total_size, file,
                                   pool));
         }
+    }
 
-      /* write the new manifest */
-      *final_path = svn_dirent_join(revprops->folder, PATH_MANIFEST, pool);
-      SVN_ERR(svn_io_open_unique_file3(&file, tmp_path, revprops->folder,
-                                       svn_io_file_del_none, pool, pool));
-      stream = svn_stream_from_aprfile2(file, TRUE, pool);
-      for (i = 0; i < revprops->manifest->nelts; ++i)
-        {
-          const char *filename = APR_ARRAY_IDX(revprops->manifest, i,
-                                               const char*);
-          SVN_ERR(svn_stream_printf(stream, pool, "%s\n", filename));
-        }
-      SVN_ERR(svn_stream_close(stream));
-      if (ffd->flush_to_disk)
-        SVN_ERR(svn_io_file_flush_to_disk(file, pool));
-      SVN_ERR(svn_io_file_close(file, pool));
+  /* write the new manifest */
+  *final_path = svn_dirent_join(revprops->folder, PATH_MANIFEST, pool);
+  SVN_ERR(svn_io_open_unique_file3(&file, tmp_path, revprops->folder,
+                                   svn_io_file_del_none, pool, pool));
+  stream = svn_stream_from_aprfile2(file, TRUE, pool);
+  for (i = 0; i < revprops->manifest->nelts; ++i)
+    {
+      const char *filename = APR_ARRAY_IDX(revprops->manifest, i,
+                                           const char*);
+      SVN_ERR(svn_stream_printf(stream, pool, "%s\n", filename));
     }
+  SVN_ERR(svn_stream_close(stream));
+  if (ffd->flush_to_disk)
+    SVN_ERR(svn_io_file_flush_to_disk(file, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
 
   return SVN_NO_ERROR;
 }
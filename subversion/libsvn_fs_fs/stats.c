@@ -28,6 +28,7 @@
 #include "private/svn_cache.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_string_private.h"
+#include "private/svn_subr_private.h"
 
 #include "index.h"
 #include "pack.h"
@@ -100,7 +101,8 @@ typedef struct rep_stats_t
 
 /* Represents a link in the rep delta chain.  REVISION + ITEM_INDEX points
  * to BASE_REVISION + BASE_ITEM_INDEX.  We collect this info while scanning
- * a f7 repo in a single pass and resolve it afterwards. */
+ * a shard and resolve it when merging that shard into the query results,
+ * i.e. after all older shards have been resolved. */
 typedef struct rep_ref_t
 {
   /* Revision that contains this representation. */
@@ -164,9 +166,65 @@ typedef struct revision_info_t
   svn_fs_fs__revision_file_t *rev_file;
 } revision_info_t;
 
+/* A noderev's reference to a representation as found while scanning a
+ * shard.  Its effect on the statistics depends on what older shards
+ * contained, so we apply it in scan order when merging the shard.  We
+ * record those only for representations of older shards and for the
+ * first reference to any rep of the current shard.
+ */
+typedef struct rep_use_t
+{
+  /* Revision that contains the representation. */
+  svn_revnum_t revision;
+
+  /* Item index of the rep within REVISION. */
+  apr_uint64_t item_index;
+
+  /* item length in bytes */
+  apr_uint64_t size;
+
+  /* item length after de-deltification */
+  apr_uint64_t expanded_size;
+
+  /* Path of the referencing node. */
+  const char *path;
+
+  /* Classification of the representation as per the referencing node.
+   * Values of rep_kind_t. */
+  char kind;
+
+  /* Whether the referencing node has no deltification predecessor. */
+  svn_boolean_t plain_added;
+
+  /* TRUE, if the rep lives in an older shard, i.e. we could not update
+   * its reference count while scanning. */
+  svn_boolean_t in_older_shard;
+} rep_use_t;
+
+/* Disk-backed container of the rep_stats_t of all revisions that have
+ * been merged into the query results, so far.  Lookups read individual
+ * structs from the file, so only one of them is in memory at any time.
+ */
+typedef struct rep_store_t
+{
+  /* Temporary file containing all rep_stats_t structs in revision order
+   * and, within each revision, ordered by item index. */
+  apr_file_t *file;
+
+  /* Number of structs in FILE. */
+  apr_uint64_t count;
+
+  /* Index of the first struct in FILE per revision (apr_uint64_t). */
+  apr_array_header_t *first_rep;
+
+  /* The struct most recently read from FILE and its index in there. */
+  rep_stats_t current;
+  apr_uint64_t current_index;
+} rep_store_t;
+
 /* Root data structure containing all information about a given repository.
  * We use it as a wrapper around svn_fs_t and pass it around where we would
- * otherwise just use a svn_fs_t.
+ * otherwise just use a svn_fs_t.  Only the main thread may access it.
  */
 typedef struct query_t
 {
@@ -182,8 +240,8 @@ typedef struct query_t
   /* First non-packed revision. */
   svn_revnum_t min_unpacked_rev;
 
-  /* all revisions */
-  apr_array_header_t *revisions;
+  /* representations of all revisions merged so far */
+  rep_store_t *store;
 
   /* empty representation.
    * Used as a dummy base for DELTA reps without base. */
@@ -205,6 +263,57 @@ typedef struct query_t
   void *cancel_baton;
 } query_t;
 
+/* Parameters shared by all stats jobs. */
+typedef struct stats_jobs_baton_t
+{
+  /* The query to collect the results in. */
+  query_t *query;
+
+  /* Number of concurrent workers. */
+  int jobs;
+
+  /* First revision of the next shard to read. */
+  svn_revnum_t next_rev;
+} stats_jobs_baton_t;
+
+/* A pack file or a range of non-packed revisions.  Each shard gets scanned
+ * independently from all others - possibly by a worker thread - and is
+ * then merged into the query results by the main thread in revision order.
+ */
+typedef struct shard_t
+{
+  /* FS API object used to read this shard.  When scanning in a worker
+   * thread, this is a private instance of the repository. */
+  svn_fs_t *fs;
+
+  /* First revision in this shard. */
+  svn_revnum_t start_rev;
+
+  /* Last revision in this shard. */
+  svn_revnum_t end_rev;
+
+  /* TRUE, if this shard is a pack file. */
+  svn_boolean_t packed;
+
+  /* revision_info_t * of START_REV through END_REV */
+  apr_array_header_t *revisions;
+
+  /* rep_ref_t * of all representations found in this shard */
+  apr_array_header_t *rep_refs;
+
+  /* rep_use_t * in scan order */
+  apr_array_header_t *rep_uses;
+
+  /* Cancellation support callback to call once in a while.  May be NULL. */
+  svn_cancel_func_t cancel_func;
+
+  /* Baton for CANCEL_FUNC. */
+  void *cancel_baton;
+
+  /* Pool containing everything above. */
+  apr_pool_t *pool;
+} shard_t;
+
 /* Initialize the LARGEST_CHANGES member in STATS with a capacity of COUNT
  * entries.  Allocate the result in RESULT_POOL.
  */
@@ -370,7 +479,7 @@ compare_representation_item_index(const void *data, const void *key)
   return (lhs > rhs ? 1 : 0);
 }
 
-/* Find the revision_info_t object to the given REVISION in QUERY and
+/* Find the revision_info_t object to the given REVISION in SHARD and
  * return it in *REVISION_INFO. For performance reasons, we skip the
  * lookup if the info is already provided.
  *
@@ -381,7 +490,7 @@ compare_representation_item_index(const void *data, const void *key)
  */
 static rep_stats_t *
 find_representation(int *idx,
-                    query_t *query,
+                    shard_t *shard,
                     revision_info_t **revision_info,
                     svn_revnum_t revision,
                     apr_uint64_t item_index)
@@ -393,7 +502,13 @@ find_representation(int *idx,
   info = revision_info ? *revision_info : NULL;
   if (info == NULL || info->revision != revision)
     {
-      info = APR_ARRAY_IDX(query->revisions, revision, revision_info_t*);
+      if (   revision < shard->start_rev
+          || revision - shard->start_rev >= shard->revisions->nelts)
+        info = NULL;
+      else
+        info = APR_ARRAY_IDX(shard->revisions, revision - shard->start_rev,
+                             revision_info_t*);
+
       if (revision_info)
         *revision_info = info;
     }
@@ -419,15 +534,16 @@ find_representation(int *idx,
   return NULL;
 }
 
-/* Find / auto-construct the representation stats for REP in QUERY and
- * return it in *REPRESENTATION.
+/* Find / auto-construct the representation stats for REP in SHARD and
+ * return it in *REPRESENTATION.  If REP lives in an older shard, set
+ * *REPRESENTATION to NULL.
  *
  * If necessary, allocate the result in RESULT_POOL; use SCRATCH_POOL for
  * temporary allocations.
  */
 static svn_error_t *
 parse_representation(rep_stats_t **representation,
-                     query_t *query,
+                     shard_t *shard,
                      representation_t *rep,
                      revision_info_t *revision_info,
                      apr_pool_t *result_pool,
@@ -436,10 +552,15 @@ parse_representation(rep_stats_t **representation,
   rep_stats_t *result;
   int idx;
 
-  /* read location (revision, offset) and size */
+  /* Reps of older shards get updated when merging this shard. */
+  if (rep->revision < shard->start_rev)
+    {
+      *representation = NULL;
+      return SVN_NO_ERROR;
+    }
 
   /* look it up */
-  result = find_representation(&idx, query, &revision_info, rep->revision,
+  result = find_representation(&idx, shard, &revision_info, rep->revision,
                                rep->item_index);
   if (!result)
     {
@@ -455,9 +576,10 @@ parse_representation(rep_stats_t **representation,
       /* In phys. addressing mode, follow link to the actual representation.
        * In log. addressing mode, we will find it already as part of our
        * linear walk through the whole file. */
-      if (!svn_fs_fs__use_log_addressing(query->fs))
+      if (!svn_fs_fs__use_log_addressing(shard->fs))
         {
           svn_fs_fs__rep_header_t *header;
+          rep_ref_t *ref = apr_pcalloc(result_pool, sizeof(*ref));
           apr_off_t offset = revision_info->offset
                            + (apr_off_t)rep->item_index;
 
@@ -468,24 +590,24 @@ parse_representation(rep_stats_t **representation,
                                              revision_info->rev_file->stream,
                                              scratch_pool, scratch_pool));
 
-          result->header_size = header->header_size;
+          /* The base rep may live in an older shard.  So, determine the
+           * length of the delta chain when merging this shard. */
+          ref->header_size = header->header_size;
+          ref->revision = rep->revision;
+          ref->item_index = rep->item_index;
 
-          /* Determine length of the delta chain. */
           if (header->type == svn_fs_fs__rep_delta)
             {
-              int base_idx;
-              rep_stats_t *base_rep
-                = find_representation(&base_idx, query, NULL,
-                                      header->base_revision,
-                                      header->base_item_index);
-
-              result->chain_length = 1 + MIN(base_rep->chain_length,
-                                             (apr_byte_t)0xfe);
+              ref->base_item_index = header->base_item_index;
+              ref->base_revision = header->base_revision;
             }
           else
             {
-              result->chain_length = 1;
+              ref->base_item_index = SVN_FS_FS__ITEM_INDEX_UNUSED;
+              ref->base_revision = SVN_INVALID_REVNUM;
             }
+
+          APR_ARRAY_PUSH(shard->rep_refs, rep_ref_t *) = ref;
         }
 
       SVN_ERR(svn_sort__array_insert2(revision_info->representations, &result, idx));
@@ -496,17 +618,42 @@ parse_representation(rep_stats_t **representation,
   return SVN_NO_ERROR;
 }
 
+/* Record the use of REP of type KIND by NODEREV in SHARD.  IN_OLDER_SHARD
+ * indicates whether REP is not part of SHARD.  Allocate the record in
+ * RESULT_POOL.
+ */
+static void
+add_rep_use(shard_t *shard,
+            representation_t *rep,
+            rep_kind_t kind,
+            node_revision_t *noderev,
+            svn_boolean_t in_older_shard,
+            apr_pool_t *result_pool)
+{
+  rep_use_t *use = apr_pcalloc(result_pool, sizeof(*use));
+
+  use->revision = rep->revision;
+  use->item_index = rep->item_index;
+  use->size = rep->size;
+  use->expanded_size = rep->expanded_size;
+  use->path = apr_pstrdup(result_pool, noderev->created_path);
+  use->kind = (char)kind;
+  use->plain_added = !noderev->predecessor_id;
+  use->in_older_shard = in_older_shard;
+
+  APR_ARRAY_PUSH(shard->rep_uses, rep_use_t *) = use;
+}
 
 /* forward declaration */
 static svn_error_t *
-read_noderev(query_t *query,
+read_noderev(shard_t *shard,
              svn_stringbuf_t *noderev_str,
              revision_info_t *revision_info,
              apr_pool_t *result_pool,
              apr_pool_t *scratch_pool);
 
 /* Read the noderev item at OFFSET in REVISION_INFO from the filesystem
- * provided by QUERY.  Return it in *NODEREV, allocated in RESULT_POOL.
+ * provided by SHARD.  Return it in *NODEREV, allocated in RESULT_POOL.
  * Use SCRATCH_POOL for temporary allocations.
  *
  * The textual representation of the noderev will be used to determine
@@ -514,7 +661,7 @@ read_noderev(query_t *query,
  */
 static svn_error_t *
 read_phsy_noderev(svn_stringbuf_t **noderev,
-                  query_t *query,
+                  shard_t *shard,
                   apr_off_t offset,
                   revision_info_t *revision_info,
                   apr_pool_t *result_pool,
@@ -555,13 +702,13 @@ read_phsy_noderev(svn_stringbuf_t **noderev,
 
 /* Starting at the directory in NODEREV's text, read all DAG nodes,
  * directories and representations linked in that tree structure.
- * Store them in QUERY and REVISION_INFO.  Also, read them only once.
+ * Store them in SHARD and REVISION_INFO.  Also, read them only once.
  *
  * Use RESULT_POOL for persistent allocations and SCRATCH_POOL for
  * temporaries.
  */
 static svn_error_t *
-parse_dir(query_t *query,
+parse_dir(shard_t *shard,
           node_revision_t *noderev,
           revision_info_t *revision_info,
           apr_pool_t *result_pool,
@@ -571,7 +718,7 @@ parse_dir(query_t *query,
 
   int i;
   apr_array_header_t *entries;
-  SVN_ERR(svn_fs_fs__rep_contents_dir(&entries, query->fs, noderev,
+  SVN_ERR(svn_fs_fs__rep_contents_dir(&entries, shard->fs, noderev,
                                       scratch_pool, scratch_pool));
 
   for (i = 0; i < entries->nelts; ++i)
@@ -583,10 +730,10 @@ parse_dir(query_t *query,
           svn_stringbuf_t *noderev_str;
           svn_pool_clear(iterpool);
 
-          SVN_ERR(read_phsy_noderev(&noderev_str, query,
+          SVN_ERR(read_phsy_noderev(&noderev_str, shard,
                                     svn_fs_fs__id_item(dirent->id),
                                     revision_info, iterpool, iterpool));
-          SVN_ERR(read_noderev(query, noderev_str, revision_info,
+          SVN_ERR(read_noderev(shard, noderev_str, revision_info,
                                result_pool, iterpool));
         }
     }
@@ -596,7 +743,7 @@ parse_dir(query_t *query,
   return SVN_NO_ERROR;
 }
 
-/* Parse the noderev given as NODEREV_STR and store the info in QUERY and
+/* Parse the noderev given as NODEREV_STR and store the info in SHARD and
  * REVISION_INFO.  In phys. addressing mode, continue reading all DAG nodes,
  * directories and representations linked in that tree structure.
  *
@@ -604,7 +751,7 @@ parse_dir(query_t *query,
  * temporaries.
  */
 static svn_error_t *
-read_noderev(query_t *query,
+read_noderev(shard_t *shard,
              svn_stringbuf_t *noderev_str,
              revision_info_t *revision_info,
              apr_pool_t *result_pool,
@@ -617,48 +764,57 @@ read_noderev(query_t *query,
   svn_stream_t *stream = svn_stream_from_stringbuf(noderev_str, scratch_pool);
   SVN_ERR(svn_fs_fs__read_noderev(&noderev, stream, scratch_pool,
                                   scratch_pool));
-  SVN_ERR(svn_fs_fs__fixup_expanded_size(query->fs, noderev->data_rep,
+  SVN_ERR(svn_fs_fs__fixup_expanded_size(shard->fs, noderev->data_rep,
                                          scratch_pool));
-  SVN_ERR(svn_fs_fs__fixup_expanded_size(query->fs, noderev->prop_rep,
+  SVN_ERR(svn_fs_fs__fixup_expanded_size(shard->fs, noderev->prop_rep,
                                          scratch_pool));
 
   if (noderev->data_rep)
     {
-      SVN_ERR(parse_representation(&text, query,
+      rep_kind_t kind = noderev->kind == svn_node_dir ? dir_rep : file_rep;
+      SVN_ERR(parse_representation(&text, shard,
                                    noderev->data_rep, revision_info,
                                    result_pool, scratch_pool));
 
-      /* if we are the first to use this rep, mark it as "text rep" */
-      if (++text->ref_count == 1)
-        text->kind = noderev->kind == svn_node_dir ? dir_rep : file_rep;
+      /* if we are the first to use this rep, mark it as "text rep" and
+       * record it as a change */
+      if (!text)
+        add_rep_use(shard, noderev->data_rep, kind, noderev, TRUE,
+                    result_pool);
+      else if (++text->ref_count == 1)
+        {
+          text->kind = kind;
+          add_rep_use(shard, noderev->data_rep, kind, noderev, FALSE,
+                      result_pool);
+        }
     }
 
   if (noderev->prop_rep)
     {
-      SVN_ERR(parse_representation(&props, query,
+      rep_kind_t kind = noderev->kind == svn_node_dir ? dir_property_rep
+                                                      : file_property_rep;
+      SVN_ERR(parse_representation(&props, shard,
                                    noderev->prop_rep, revision_info,
                                    result_pool, scratch_pool));
 
-      /* if we are the first to use this rep, mark it as "prop rep" */
-      if (++props->ref_count == 1)
-        props->kind = noderev->kind == svn_node_dir ? dir_property_rep
-                                                    : file_property_rep;
+      /* if we are the first to use this rep, mark it as "prop rep" and
+       * record it as a change */
+      if (!props)
+        add_rep_use(shard, noderev->prop_rep, kind, noderev, TRUE,
+                    result_pool);
+      else if (++props->ref_count == 1)
+        {
+          props->kind = kind;
+          add_rep_use(shard, noderev->prop_rep, kind, noderev, FALSE,
+                      result_pool);
+        }
     }
 
-  /* record largest changes */
-  if (text && text->ref_count == 1)
-    add_change(query->stats, text->size, text->expanded_size, text->revision,
-               noderev->created_path, text->kind, !noderev->predecessor_id);
-  if (props && props->ref_count == 1)
-    add_change(query->stats, props->size, props->expanded_size,
-               props->revision, noderev->created_path, props->kind,
-               !noderev->predecessor_id);
-
   /* if this is a directory and has not been processed, yet, read and
    * process it recursively */
   if (   noderev->kind == svn_node_dir && text && text->ref_count == 1
-      && !svn_fs_fs__use_log_addressing(query->fs))
-    SVN_ERR(parse_dir(query, noderev, revision_info, result_pool,
+      && !svn_fs_fs__use_log_addressing(shard->fs))
+    SVN_ERR(parse_dir(shard, noderev, revision_info, result_pool,
                       scratch_pool));
 
   /* update stats */
@@ -676,12 +832,12 @@ read_noderev(query_t *query,
   return SVN_NO_ERROR;
 }
 
-/* For the revision given as REVISION_INFO within QUERY, determine the number
+/* For the revision given as REVISION_INFO within SHARD, determine the number
  * of entries in its changed paths list and store that info in REVISION_INFO.
  * Use SCRATCH_POOL for temporary allocations.
  */
 static svn_error_t *
-get_phys_change_count(query_t *query,
+get_phys_change_count(shard_t *shard,
                       revision_info_t *revision_info,
                       apr_pool_t *scratch_pool)
 {
@@ -689,7 +845,7 @@ get_phys_change_count(query_t *query,
   svn_fs_fs__changes_context_t *context;
 
   /* Fetch the first block of data. */
-  SVN_ERR(svn_fs_fs__create_changes_context(&context, query->fs,
+  SVN_ERR(svn_fs_fs__create_changes_context(&context, shard->fs,
                                             revision_info->revision,
                                             scratch_pool));
 
@@ -713,7 +869,7 @@ get_phys_change_count(query_t *query,
  * *ROOT_NODEREV, the list of *CHANGES and its len in *CHANGES_LEN.
  * Use POOL for temporary allocations. */
 static svn_error_t *
-read_phys_revision(query_t *query,
+read_phys_revision(shard_t *shard,
                    revision_info_t *info,
                    apr_pool_t *result_pool,
                    apr_pool_t *scratch_pool)
@@ -737,7 +893,7 @@ read_phys_revision(query_t *query,
   SVN_ERR(svn_fs_fs__parse_revision_trailer(&root_node_offset,
                                             &changes_offset, trailer,
                                             info->revision));
-  SVN_ERR(get_phys_change_count(query, info, scratch_pool));
+  SVN_ERR(get_phys_change_count(shard, info, scratch_pool));
 
   /* Calculate the length of the changes list. */
   trailer = svn_fs_fs__unparse_revision_trailer(root_node_offset,
@@ -747,42 +903,43 @@ read_phys_revision(query_t *query,
                     - trailer->len;
 
   /* Recursively read nodes added in this rev. */
-  SVN_ERR(read_phsy_noderev(&noderev_str, query, root_node_offset, info,
+  SVN_ERR(read_phsy_noderev(&noderev_str, shard, root_node_offset, info,
                             scratch_pool, scratch_pool));
-  SVN_ERR(read_noderev(query, noderev_str, info, result_pool, scratch_pool));
+  SVN_ERR(read_noderev(shard, noderev_str, info, result_pool, scratch_pool));
 
   return SVN_NO_ERROR;
 }
 
-/* Read the content of the pack file staring at revision BASE physical
- * addressing mode and store it in QUERY.
+/* Read the content of the pack file given as SHARD in physical
+ * addressing mode and store it in SHARD.
  *
  * Use RESULT_POOL for persistent allocations and SCRATCH_POOL for
  * temporaries.
  */
 static svn_error_t *
-read_phys_pack_file(query_t *query,
-                    svn_revnum_t base,
+read_phys_pack_file(shard_t *shard,
                     apr_pool_t *result_pool,
                     apr_pool_t *scratch_pool)
 {
   apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_revnum_t base = shard->start_rev;
+  int count = (int)(shard->end_rev - shard->start_rev + 1);
   int i;
   svn_filesize_t file_size = 0;
   svn_fs_fs__revision_file_t *rev_file;
 
-  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, query->fs, base,
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, shard->fs, base,
                                            scratch_pool, scratch_pool));
   SVN_ERR(svn_io_file_size_get(&file_size, rev_file->file, scratch_pool));
 
   /* process each revision in the pack file */
-  for (i = 0; i < query->shard_size; ++i)
+  for (i = 0; i < count; ++i)
     {
       revision_info_t *info;
 
       /* cancellation support */
-      if (query->cancel_func)
-        SVN_ERR(query->cancel_func(query->cancel_baton));
+      if (shard->cancel_func)
+        SVN_ERR(shard->cancel_func(shard->cancel_baton));
 
       /* create the revision info for the current rev */
       info = apr_pcalloc(result_pool, sizeof(*info));
@@ -791,15 +948,15 @@ read_phys_pack_file(query_t *query,
       info->rev_file = rev_file;
 
       info->revision = base + i;
-      SVN_ERR(svn_fs_fs__get_packed_offset(&info->offset, query->fs, base + i,
+      SVN_ERR(svn_fs_fs__get_packed_offset(&info->offset, shard->fs, base + i,
                                            iterpool));
-      if (i + 1 == query->shard_size)
+      if (i + 1 == count)
         info->end = file_size;
       else
-        SVN_ERR(svn_fs_fs__get_packed_offset(&info->end, query->fs,
+        SVN_ERR(svn_fs_fs__get_packed_offset(&info->end, shard->fs,
                                              base + i + 1, iterpool));
 
-      SVN_ERR(read_phys_revision(query, info, result_pool, iterpool));
+      SVN_ERR(read_phys_revision(shard, info, result_pool, iterpool));
 
       info->representations = apr_array_copy(result_pool,
                                              info->representations);
@@ -808,7 +965,7 @@ read_phys_pack_file(query_t *query,
       info->rev_file = NULL;
 
       /* put it into our container */
-      APR_ARRAY_PUSH(query->revisions, revision_info_t*) = info;
+      APR_ARRAY_PUSH(shard->revisions, revision_info_t*) = info;
 
       /* destroy temps */
       svn_pool_clear(iterpool);
@@ -816,22 +973,19 @@ read_phys_pack_file(query_t *query,
 
   /* Done with this pack file. */
   SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
-
-  /* one more pack file processed */
-  if (query->progress_func)
-    query->progress_func(base, query->progress_baton, scratch_pool);
+  svn_pool_destroy(iterpool);
 
   return SVN_NO_ERROR;
 }
 
 /* Read the content of the file for REVISION in physical addressing mode
- * and store its contents in QUERY.
+ * and store its contents in SHARD.
  *
  * Use RESULT_POOL for persistent allocations and SCRATCH_POOL for
  * temporaries.
  */
 static svn_error_t *
-read_phys_revision_file(query_t *query,
+read_phys_revision_file(shard_t *shard,
                         svn_revnum_t revision,
                         apr_pool_t *result_pool,
                         apr_pool_t *scratch_pool)
@@ -841,11 +995,11 @@ read_phys_revision_file(query_t *query,
   svn_fs_fs__revision_file_t *rev_file;
 
   /* cancellation support */
-  if (query->cancel_func)
-    SVN_ERR(query->cancel_func(query->cancel_baton));
+  if (shard->cancel_func)
+    SVN_ERR(shard->cancel_func(shard->cancel_baton));
 
   /* read the whole pack file into memory */
-  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, query->fs, revision,
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, shard->fs, revision,
                                            scratch_pool, scratch_pool));
   SVN_ERR(svn_io_file_size_get(&file_size, rev_file->file, scratch_pool));
 
@@ -857,23 +1011,14 @@ read_phys_revision_file(query_t *query,
   info->offset = 0;
   info->end = file_size;
 
-  SVN_ERR(read_phys_revision(query, info, result_pool, scratch_pool));
+  SVN_ERR(read_phys_revision(shard, info, result_pool, scratch_pool));
 
   /* Done with this revision. */
   SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
   info->rev_file = NULL;
 
   /* put it into our container */
-  APR_ARRAY_PUSH(query->revisions, revision_info_t*) = info;
-
-  /* show progress every 1000 revs or so */
-  if (query->progress_func)
-    {
-      if (query->shard_size && (revision % query->shard_size == 0))
-        query->progress_func(revision, query->progress_baton, scratch_pool);
-      if (!query->shard_size && (revision % 1000 == 0))
-        query->progress_func(revision, query->progress_baton, scratch_pool);
-    }
+  APR_ARRAY_PUSH(shard->revisions, revision_info_t*) = info;
 
   return SVN_NO_ERROR;
 }
@@ -938,82 +1083,26 @@ compare_representation_refs(const void *lhs, const void *rhs)
   return (lhs_rev > rhs_rev ? 1 : 0);
 }
 
-/* Given all the presentations found in a single rev / pack file as
- * rep_ref_t * in REP_REFS, update the delta chain lengths in QUERY.
- * REP_REFS and its contents can then be discarded.
- */
-static svn_error_t *
-resolve_representation_refs(query_t *query,
-                            apr_array_header_t *rep_refs)
-{
-  int i;
-
-  /* Because delta chains can only point to previous revs, after sorting
-   * REP_REFS, all base refs have already been updated. */
-  svn_sort__array(rep_refs, compare_representation_refs);
-
-  /* Build up the CHAIN_LENGTH values. */
-  for (i = 0; i < rep_refs->nelts; ++i)
-    {
-      int idx;
-      rep_ref_t *ref = APR_ARRAY_IDX(rep_refs, i, rep_ref_t *);
-      rep_stats_t *rep = find_representation(&idx, query, NULL,
-                                             ref->revision, ref->item_index);
-
-      /* No dangling pointers and all base reps have been processed. */
-      SVN_ERR_ASSERT(rep);
-      SVN_ERR_ASSERT(!rep->chain_length);
-
-      /* Set the HEADER_SIZE as we found it during the scan. */
-      rep->header_size = ref->header_size;
-
-      /* The delta chain got 1 element longer. */
-      if (ref->base_revision == SVN_INVALID_REVNUM)
-        {
-          rep->chain_length = 1;
-        }
-      else
-        {
-          rep_stats_t *base;
-
-          base = find_representation(&idx, query, NULL, ref->base_revision,
-                                     ref->base_item_index);
-          SVN_ERR_ASSERT(base);
-          SVN_ERR_ASSERT(base->chain_length);
-
-          rep->chain_length = 1 + MIN(base->chain_length, (apr_byte_t)0xfe);
-        }
-    }
-
-  return SVN_NO_ERROR;
-}
-
 /* Process the logically addressed revision contents of revisions BASE to
- * BASE + COUNT - 1 in QUERY.
+ * BASE + COUNT - 1 in SHARD.  Collect the delta chain links in SHARD, too.
  *
  * Use RESULT_POOL for persistent allocations and SCRATCH_POOL for
  * temporaries.
  */
 static svn_error_t *
-read_log_rev_or_packfile(query_t *query,
+read_log_rev_or_packfile(shard_t *shard,
                          svn_revnum_t base,
                          int count,
                          apr_pool_t *result_pool,
                          apr_pool_t *scratch_pool)
 {
-  fs_fs_data_t *ffd = query->fs->fsap_data;
+  fs_fs_data_t *ffd = shard->fs->fsap_data;
   apr_pool_t *iterpool = svn_pool_create(scratch_pool);
   apr_off_t max_offset;
   apr_off_t offset = 0;
   int i;
   svn_fs_fs__revision_file_t *rev_file;
 
-  /* We collect the delta chain links as we scan the file.  Afterwards,
-   * we determine the lengths of those delta chains and throw this
-   * temporary container away. */
-  apr_array_header_t *rep_refs = apr_array_make(scratch_pool, 64,
-                                                sizeof(rep_ref_t *));
-
   /* we will process every revision in the rev / pack file */
   for (i = 0; i < count; ++i)
     {
@@ -1023,18 +1112,19 @@ read_log_rev_or_packfile(query_t *query,
                                              sizeof(rep_stats_t*));
       info->revision = base + i;
 
-      APR_ARRAY_PUSH(query->revisions, revision_info_t*) = info;
+      APR_ARRAY_PUSH(shard->revisions, revision_info_t*) = info;
     }
 
   /* open the pack / rev file that is covered by the p2l index */
-  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, query->fs, base,
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, shard->fs, base,
                                            scratch_pool, iterpool));
-  SVN_ERR(svn_fs_fs__p2l_get_max_offset(&max_offset, query->fs, rev_file,
+  SVN_ERR(svn_fs_fs__p2l_get_max_offset(&max_offset, shard->fs, rev_file,
                                         base, scratch_pool));
 
   /* record the whole pack size in the first rev so the total sum will
      still be correct */
-  APR_ARRAY_IDX(query->revisions, base, revision_info_t*)->end = max_offset;
+  APR_ARRAY_IDX(shard->revisions, base - shard->start_rev,
+                revision_info_t*)->end = max_offset;
 
   /* for all offsets in the file, get the P2L index entries and process
      the interesting items (change lists, noderevs) */
@@ -1045,11 +1135,11 @@ read_log_rev_or_packfile(query_t *query,
       svn_pool_clear(iterpool);
 
       /* cancellation support */
-      if (query->cancel_func)
-        SVN_ERR(query->cancel_func(query->cancel_baton));
+      if (shard->cancel_func)
+        SVN_ERR(shard->cancel_func(shard->cancel_baton));
 
       /* get all entries for the current block */
-      SVN_ERR(svn_fs_fs__p2l_index_lookup(&entries, query->fs, rev_file, base,
+      SVN_ERR(svn_fs_fs__p2l_index_lookup(&entries, shard->fs, rev_file, base,
                                           offset, ffd->p2l_page_size,
                                           iterpool, iterpool));
 
@@ -1070,13 +1160,14 @@ read_log_rev_or_packfile(query_t *query,
             continue;
 
           /* read and process interesting items */
-          info = APR_ARRAY_IDX(query->revisions, entry->item.revision,
+          info = APR_ARRAY_IDX(shard->revisions,
+                               entry->item.revision - shard->start_rev,
                                revision_info_t*);
 
           if (entry->type == SVN_FS_FS__ITEM_TYPE_NODEREV)
             {
               SVN_ERR(read_item(&item, rev_file, entry, iterpool, iterpool));
-              SVN_ERR(read_noderev(query, item, info, result_pool, iterpool));
+              SVN_ERR(read_noderev(shard, item, info, result_pool, iterpool));
             }
           else if (entry->type == SVN_FS_FS__ITEM_TYPE_CHANGES)
             {
@@ -1092,7 +1183,7 @@ read_log_rev_or_packfile(query_t *query,
             {
               /* Collect the delta chain link. */
               svn_fs_fs__rep_header_t *header;
-              rep_ref_t *ref = apr_pcalloc(scratch_pool, sizeof(*ref));
+              rep_ref_t *ref = apr_pcalloc(result_pool, sizeof(*ref));
 
               SVN_ERR(svn_io_file_aligned_seek(rev_file->file,
                                                rev_file->block_size,
@@ -1117,7 +1208,7 @@ read_log_rev_or_packfile(query_t *query,
                   ref->base_revision = SVN_INVALID_REVNUM;
                 }
 
-              APR_ARRAY_PUSH(rep_refs, rep_ref_t *) = ref;
+              APR_ARRAY_PUSH(shard->rep_refs, rep_ref_t *) = ref;
             }
 
           /* advance offset */
@@ -1125,104 +1216,283 @@ read_log_rev_or_packfile(query_t *query,
         }
     }
 
-  /* Resolve the delta chain links. */
-  SVN_ERR(resolve_representation_refs(query, rep_refs));
-
   /* clean up and close file handles */
   svn_pool_destroy(iterpool);
 
   return SVN_NO_ERROR;
 }
 
-/* Read the content of the pack file staring at revision BASE logical
- * addressing mode and store it in QUERY.
+/* Read all revisions of SHARD and store their contents in SHARD.
  *
  * Use RESULT_POOL for persistent allocations and SCRATCH_POOL for
  * temporaries.
  */
 static svn_error_t *
-read_log_pack_file(query_t *query,
-                   svn_revnum_t base,
-                   apr_pool_t *result_pool,
-                   apr_pool_t *scratch_pool)
+read_shard(shard_t *shard,
+           apr_pool_t *result_pool,
+           apr_pool_t *scratch_pool)
 {
-  SVN_ERR(read_log_rev_or_packfile(query, base, query->shard_size,
-                                   result_pool, scratch_pool));
+  apr_pool_t *iterpool;
+  svn_revnum_t revision;
+  svn_boolean_t log_addressing = svn_fs_fs__use_log_addressing(shard->fs);
 
-  /* one more pack file processed */
-  if (query->progress_func)
-    query->progress_func(base, query->progress_baton, scratch_pool);
+  /* read a pack file */
+  if (shard->packed)
+    {
+      if (log_addressing)
+        return svn_error_trace(read_log_rev_or_packfile(
+                                 shard, shard->start_rev,
+                                 (int)(shard->end_rev - shard->start_rev + 1),
+                                 result_pool, scratch_pool));
+
+      return svn_error_trace(read_phys_pack_file(shard, result_pool,
+                                                 scratch_pool));
+    }
+
+  /* read non-packed revs */
+  iterpool = svn_pool_create(scratch_pool);
+  for (revision = shard->start_rev; revision <= shard->end_rev; ++revision)
+    {
+      svn_pool_clear(iterpool);
+
+      if (log_addressing)
+        SVN_ERR(read_log_rev_or_packfile(shard, revision, 1, result_pool,
+                                         iterpool));
+      else
+        SVN_ERR(read_phys_revision_file(shard, revision, result_pool,
+                                        iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
 
   return SVN_NO_ERROR;
 }
 
-/* Read the content of the file for REVISION in logical addressing mode
- * and store its contents in QUERY.
- *
- * Use RESULT_POOL for persistent allocations and SCRATCH_POOL for
- * temporaries.
+/* Return a new shard object for revisions START_REV through END_REV, to
+ * be read from FS.  PACKED indicates whether these revisions form a pack
+ * file.  Allocate it in RESULT_POOL.
+ */
+static shard_t *
+create_shard(svn_fs_t *fs,
+             svn_revnum_t start_rev,
+             svn_revnum_t end_rev,
+             svn_boolean_t packed,
+             apr_pool_t *result_pool)
+{
+  shard_t *shard = apr_pcalloc(result_pool, sizeof(*shard));
+
+  shard->fs = fs;
+  shard->start_rev = start_rev;
+  shard->end_rev = end_rev;
+  shard->packed = packed;
+  shard->revisions = apr_array_make(result_pool,
+                                    (int)(end_rev - start_rev + 1),
+                                    sizeof(revision_info_t *));
+  shard->rep_refs = apr_array_make(result_pool, 64, sizeof(rep_ref_t *));
+  shard->rep_uses = apr_array_make(result_pool, 64, sizeof(rep_use_t *));
+  shard->pool = result_pool;
+
+  return shard;
+}
+
+/* Return the offset of the rep_stats_t with index INDEX in a rep store
+ * file.
+ */
+static apr_off_t
+rep_store_offset(apr_uint64_t index)
+{
+  return (apr_off_t)(index * sizeof(rep_stats_t));
+}
+
+/* Create an empty rep store for up to REVISION_COUNT revisions and return
+ * it in *STORE.  Allocate it in RESULT_POOL; the temporary file will be
+ * removed when RESULT_POOL gets cleaned up.  Use SCRATCH_POOL for
+ * temporary allocations.
  */
 static svn_error_t *
-read_log_revision_file(query_t *query,
-                       svn_revnum_t revision,
-                       apr_pool_t *result_pool,
-                       apr_pool_t *scratch_pool)
+rep_store_create(rep_store_t **store,
+                 int revision_count,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
 {
-  SVN_ERR(read_log_rev_or_packfile(query, revision, 1,
+  rep_store_t *result = apr_pcalloc(result_pool, sizeof(*result));
+
+  SVN_ERR(svn_io_open_unique_file3(&result->file, NULL, NULL,
+                                   svn_io_file_del_on_close,
                                    result_pool, scratch_pool));
+  result->first_rep = apr_array_make(result_pool, revision_count,
+                                     sizeof(apr_uint64_t));
 
-  /* show progress every 1000 revs or so */
-  if (query->progress_func)
-    {
-      if (query->shard_size && (revision % query->shard_size == 0))
-        query->progress_func(revision, query->progress_baton, scratch_pool);
-      if (!query->shard_size && (revision % 1000 == 0))
-        query->progress_func(revision, query->progress_baton, scratch_pool);
-    }
+  *store = result;
 
   return SVN_NO_ERROR;
 }
 
-/* Read the repository and collect the stats info in QUERY.
+/* Read the struct with index INDEX from STORE's file into STORE->CURRENT.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+rep_store_read(rep_store_t *store,
+               apr_uint64_t index,
+               apr_pool_t *scratch_pool)
+{
+  apr_off_t offset = rep_store_offset(index);
+
+  SVN_ERR(svn_io_file_seek(store->file, APR_SET, &offset, scratch_pool));
+  SVN_ERR(svn_io_file_read_full2(store->file, &store->current,
+                                 sizeof(store->current), NULL, NULL,
+                                 scratch_pool));
+  store->current_index = index;
+
+  return SVN_NO_ERROR;
+}
+
+/* Write STORE->CURRENT back to STORE's file.  Use SCRATCH_POOL for
+ * temporary allocations.
+ */
+static svn_error_t *
+rep_store_write_current(rep_store_t *store,
+                        apr_pool_t *scratch_pool)
+{
+  apr_off_t offset = rep_store_offset(store->current_index);
+
+  SVN_ERR(svn_io_file_seek(store->file, APR_SET, &offset, scratch_pool));
+  SVN_ERR(svn_io_file_write_full(store->file, &store->current,
+                                 sizeof(store->current), NULL,
+                                 scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *REP to the representation with ITEM_INDEX in REVISION as found in
+ * STORE or to NULL, if STORE does not contain it.  The result is valid
+ * until the next call to any other rep store function.  Callers that
+ * modify *REP must call rep_store_write_current() afterwards.
  *
- * Use RESULT_POOL for persistent allocations and SCRATCH_POOL for
- * temporaries.
+ * Use SCRATCH_POOL for temporary allocations.
  */
 static svn_error_t *
-read_revisions(query_t *query,
-               apr_pool_t *result_pool,
+rep_store_find(rep_stats_t **rep,
+               rep_store_t *store,
+               svn_revnum_t revision,
+               apr_uint64_t item_index,
                apr_pool_t *scratch_pool)
 {
-  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
-  svn_revnum_t revision;
+  apr_uint64_t lower, upper;
+  *rep = NULL;
+
+  if (revision < 0 || revision >= store->first_rep->nelts)
+    return SVN_NO_ERROR;
+
+  /* The reps of REVISION are consecutive in STORE and ordered by item
+   * index.  Binary search them without reading the whole range. */
+  lower = APR_ARRAY_IDX(store->first_rep, revision, apr_uint64_t);
+  upper = revision + 1 < store->first_rep->nelts
+        ? APR_ARRAY_IDX(store->first_rep, revision + 1, apr_uint64_t)
+        : store->count;
 
-  /* read all packed revs */
-  for ( revision = 0
-      ; revision < query->min_unpacked_rev
-      ; revision += query->shard_size)
+  while (lower < upper)
     {
-      svn_pool_clear(iterpool);
+      apr_uint64_t middle = lower + (upper - lower) / 2;
 
-      if (svn_fs_fs__use_log_addressing(query->fs))
-        SVN_ERR(read_log_pack_file(query, revision, result_pool, iterpool));
+      SVN_ERR(rep_store_read(store, middle, scratch_pool));
+      if (store->current.item_index < item_index)
+        lower = middle + 1;
+      else if (store->current.item_index > item_index)
+        upper = middle;
       else
-        SVN_ERR(read_phys_pack_file(query, revision, result_pool, iterpool));
+        {
+          *rep = &store->current;
+          break;
+        }
     }
 
-  /* read non-packed revs */
-  for ( ; revision <= query->head; ++revision)
+  return SVN_NO_ERROR;
+}
+
+/* Append all representations of REVISION_INFO to STORE.  All previous
+ * revisions must already have been added.  Use SCRATCH_POOL for temporary
+ * allocations.
+ */
+static svn_error_t *
+rep_store_append(rep_store_t *store,
+                 revision_info_t *revision_info,
+                 apr_pool_t *scratch_pool)
+{
+  int i;
+  apr_off_t offset = rep_store_offset(store->count);
+
+  SVN_ERR_ASSERT(revision_info->revision == store->first_rep->nelts);
+  APR_ARRAY_PUSH(store->first_rep, apr_uint64_t) = store->count;
+
+  SVN_ERR(svn_io_file_seek(store->file, APR_SET, &offset, scratch_pool));
+  for (i = 0; i < revision_info->representations->nelts; ++i)
     {
-      svn_pool_clear(iterpool);
+      rep_stats_t *rep = APR_ARRAY_IDX(revision_info->representations, i,
+                                       rep_stats_t *);
+      SVN_ERR(svn_io_file_write_full(store->file, rep, sizeof(*rep), NULL,
+                                     scratch_pool));
+    }
 
-      if (svn_fs_fs__use_log_addressing(query->fs))
-        SVN_ERR(read_log_revision_file(query, revision, result_pool,
-                                       iterpool));
+  store->count += revision_info->representations->nelts;
+
+  return SVN_NO_ERROR;
+}
+
+/* Given all the representations found in SHARD, update their delta chain
+ * lengths.  The base reps are either part of SHARD or have already been
+ * merged into QUERY.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+resolve_representation_refs(query_t *query,
+                            shard_t *shard,
+                            apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *rep_refs = shard->rep_refs;
+  int i;
+
+  /* Because delta chains can only point to previous revs, after sorting
+   * REP_REFS, all base refs have already been updated. */
+  svn_sort__array(rep_refs, compare_representation_refs);
+
+  /* Build up the CHAIN_LENGTH values. */
+  for (i = 0; i < rep_refs->nelts; ++i)
+    {
+      int idx;
+      rep_ref_t *ref = APR_ARRAY_IDX(rep_refs, i, rep_ref_t *);
+      rep_stats_t *rep = find_representation(&idx, shard, NULL,
+                                             ref->revision, ref->item_index);
+
+      /* No dangling pointers and all base reps have been processed. */
+      SVN_ERR_ASSERT(rep);
+      SVN_ERR_ASSERT(!rep->chain_length);
+
+      /* Set the HEADER_SIZE as we found it during the scan. */
+      rep->header_size = ref->header_size;
+
+      /* The delta chain got 1 element longer. */
+      if (ref->base_revision == SVN_INVALID_REVNUM)
+        {
+          rep->chain_length = 1;
+        }
       else
-        SVN_ERR(read_phys_revision_file(query, revision, result_pool,
-                                        iterpool));
-    }
+        {
+          rep_stats_t *base;
 
-  svn_pool_destroy(iterpool);
+          if (ref->base_revision >= shard->start_rev)
+            base = find_representation(&idx, shard, NULL,
+                                       ref->base_revision,
+                                       ref->base_item_index);
+          else
+            SVN_ERR(rep_store_find(&base, query->store, ref->base_revision,
+                                   ref->base_item_index, scratch_pool));
+
+          SVN_ERR_ASSERT(base);
+          SVN_ERR_ASSERT(base->chain_length);
+
+          rep->chain_length = 1 + MIN(base->chain_length, (apr_byte_t)0xfe);
+        }
+    }
 
   return SVN_NO_ERROR;
 }
@@ -1257,64 +1527,244 @@ add_rep_stats(svn_fs_fs__representation_stats_t *stats,
   stats->chain_len += rep->chain_length;
 }
 
-/* Aggregate the info the in revision_info_t * array REVISIONS into the
- * respectve fields of STATS.
+/* Accumulate the stats of REP in the respective fields of STATS.
+ */
+static void
+aggregate_rep(svn_fs_fs__stats_t *stats,
+              rep_stats_t *rep)
+{
+  /* accumulate in the right bucket */
+  switch(rep->kind)
+    {
+      case file_rep:
+        add_rep_stats(&stats->file_rep_stats, rep);
+        break;
+      case dir_rep:
+        add_rep_stats(&stats->dir_rep_stats, rep);
+        break;
+      case file_property_rep:
+        add_rep_stats(&stats->file_prop_rep_stats, rep);
+        break;
+      case dir_property_rep:
+        add_rep_stats(&stats->dir_prop_rep_stats, rep);
+        break;
+      default:
+        break;
+    }
+
+  add_rep_stats(&stats->total_rep_stats, rep);
+}
+
+/* Aggregate the revision level info in REVISION into the respective
+ * fields of STATS.
  */
 static void
-aggregate_stats(const apr_array_header_t *revisions,
-                svn_fs_fs__stats_t *stats)
+aggregate_revision(svn_fs_fs__stats_t *stats,
+                   revision_info_t *revision)
+{
+  stats->revision_count++;
+
+  stats->change_count += revision->change_count;
+  stats->change_len += revision->changes_len;
+  stats->total_size += revision->end - revision->offset;
+
+  stats->dir_node_stats.count += revision->dir_noderev_count;
+  stats->dir_node_stats.size += revision->dir_noderev_size;
+  stats->file_node_stats.count += revision->file_noderev_count;
+  stats->file_node_stats.size += revision->file_noderev_size;
+  stats->total_node_stats.count += revision->dir_noderev_count
+                                + revision->file_noderev_count;
+  stats->total_node_stats.size += revision->dir_noderev_size
+                               + revision->file_noderev_size;
+}
+
+/* Aggregate the info on all representations in QUERY's rep store into
+ * the respective fields of QUERY's stats.  Use SCRATCH_POOL for temporary
+ * allocations.
+ */
+static svn_error_t *
+aggregate_reps(query_t *query,
+               apr_pool_t *scratch_pool)
+{
+  rep_store_t *store = query->store;
+  apr_off_t offset = 0;
+  apr_uint64_t i;
+
+  SVN_ERR(svn_io_file_seek(store->file, APR_SET, &offset, scratch_pool));
+
+  for (i = 0; i < store->count; ++i)
+    {
+      rep_stats_t rep;
+      SVN_ERR(svn_io_file_read_full2(store->file, &rep, sizeof(rep),
+                                     NULL, NULL, scratch_pool));
+      aggregate_rep(query->stats, &rep);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Merge the contents of SHARD into QUERY.  All older shards must already
+ * have been merged.  Afterwards, SHARD can be discarded.  Use SCRATCH_POOL
+ * for temporary allocations.
+ */
+static svn_error_t *
+merge_shard(query_t *query,
+            shard_t *shard,
+            apr_pool_t *scratch_pool)
 {
-  int i, k;
+  int i;
 
-  /* aggregate info from all revisions */
-  stats->revision_count = revisions->nelts;
-  for (i = 0; i < revisions->nelts; ++i)
+  /* All base reps are known now. */
+  SVN_ERR(resolve_representation_refs(query, shard, scratch_pool));
+
+  /* Apply the rep usage in scan order and record the largest changes. */
+  for (i = 0; i < shard->rep_uses->nelts; ++i)
     {
-      revision_info_t *revision = APR_ARRAY_IDX(revisions, i,
-                                                revision_info_t *);
-
-      /* data gathered on a revision level */
-      stats->change_count += revision->change_count;
-      stats->change_len += revision->changes_len;
-      stats->total_size += revision->end - revision->offset;
-
-      stats->dir_node_stats.count += revision->dir_noderev_count;
-      stats->dir_node_stats.size += revision->dir_noderev_size;
-      stats->file_node_stats.count += revision->file_noderev_count;
-      stats->file_node_stats.size += revision->file_noderev_size;
-      stats->total_node_stats.count += revision->dir_noderev_count
-                                    + revision->file_noderev_count;
-      stats->total_node_stats.size += revision->dir_noderev_size
-                                   + revision->file_noderev_size;
-
-      /* process representations */
-      for (k = 0; k < revision->representations->nelts; ++k)
+      rep_use_t *use = APR_ARRAY_IDX(shard->rep_uses, i, rep_use_t *);
+
+      if (use->in_older_shard)
         {
-          rep_stats_t *rep = APR_ARRAY_IDX(revision->representations, k,
-                                           rep_stats_t *);
+          rep_stats_t *rep;
+          SVN_ERR(rep_store_find(&rep, query->store, use->revision,
+                                 use->item_index, scratch_pool));
+          SVN_ERR_ASSERT(rep);
 
-          /* accumulate in the right bucket */
-          switch(rep->kind)
+          /* Not the first to use this rep -> not a change. */
+          if (++rep->ref_count > 1)
             {
-              case file_rep:
-                add_rep_stats(&stats->file_rep_stats, rep);
-                break;
-              case dir_rep:
-                add_rep_stats(&stats->dir_rep_stats, rep);
-                break;
-              case file_property_rep:
-                add_rep_stats(&stats->file_prop_rep_stats, rep);
-                break;
-              case dir_property_rep:
-                add_rep_stats(&stats->dir_prop_rep_stats, rep);
-                break;
-              default:
-                break;
+              SVN_ERR(rep_store_write_current(query->store, scratch_pool));
+              continue;
             }
 
-          add_rep_stats(&stats->total_rep_stats, rep);
+          rep->kind = use->kind;
+          SVN_ERR(rep_store_write_current(query->store, scratch_pool));
         }
+
+      add_change(query->stats, use->size, use->expanded_size, use->revision,
+                 use->path, use->kind, use->plain_added);
     }
+
+  /* Hand the shard's representations over to the rep store. */
+  for (i = 0; i < shard->revisions->nelts; ++i)
+    {
+      revision_info_t *info = APR_ARRAY_IDX(shard->revisions, i,
+                                            revision_info_t *);
+
+      aggregate_revision(query->stats, info);
+      SVN_ERR(rep_store_append(query->store, info, scratch_pool));
+    }
+
+  /* one more shard processed */
+  if (query->progress_func)
+    query->progress_func(shard->start_rev, query->progress_baton,
+                         scratch_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* For the shard starting at START_REV in QUERY, set *END_REV to its last
+ * revision and *PACKED to whether it is a pack file.  Non-packed revisions
+ * get grouped as if they were packed.  In non-sharded repositories, use
+ * groups of 1000 revisions.
+ */
+static void
+get_shard_range(svn_revnum_t *end_rev,
+                svn_boolean_t *packed,
+                query_t *query,
+                svn_revnum_t start_rev)
+{
+  svn_revnum_t shard_size = query->shard_size ? query->shard_size : 1000;
+
+  *packed = start_rev < query->min_unpacked_rev;
+  *end_rev = MIN(query->head, (start_rev / shard_size + 1) * shard_size - 1);
+}
+
+/* Implement svn__job_start_func_t for read_revisions().  BATON is a
+ * stats_jobs_baton_t.
+ */
+static svn_error_t *
+stats_job_start(void **job_p,
+                void *baton,
+                apr_pool_t *job_pool,
+                apr_pool_t *scratch_pool)
+{
+  stats_jobs_baton_t *jobs = baton;
+  query_t *query = jobs->query;
+  svn_fs_t *fs = query->fs;
+  svn_revnum_t end_rev;
+  svn_boolean_t packed;
+
+  *job_p = NULL;
+  if (jobs->next_rev > query->head)
+    return SVN_NO_ERROR;
+
+  /* Worker threads need a private instance of the repository. */
+  if (jobs->jobs > 1)
+    SVN_ERR(svn_fs_fs__open_clone(&fs, query->fs, job_pool, scratch_pool));
+
+  get_shard_range(&end_rev, &packed, query, jobs->next_rev);
+  *job_p = create_shard(fs, jobs->next_rev, end_rev, packed, job_pool);
+  jobs->next_rev = end_rev + 1;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn__job_work_func_t for read_revisions(), reading the
+ * shard_t JOB_BATON.
+ */
+static svn_error_t *
+stats_job_work(void *job_baton,
+               svn_cancel_func_t cancel_func,
+               void *cancel_baton,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
+{
+  shard_t *shard = job_baton;
+
+  shard->cancel_func = cancel_func;
+  shard->cancel_baton = cancel_baton;
+
+  return svn_error_trace(read_shard(shard, result_pool, scratch_pool));
+}
+
+/* Implement svn__job_finish_func_t for read_revisions(), merging the
+ * shard_t JOB_BATON into the query of the stats_jobs_baton_t BATON.
+ */
+static svn_error_t *
+stats_job_finish(void *job_baton,
+                 svn_error_t *err,
+                 void *baton,
+                 apr_pool_t *scratch_pool)
+{
+  stats_jobs_baton_t *jobs = baton;
+
+  SVN_ERR(err);
+
+  return svn_error_trace(merge_shard(jobs->query, job_baton,
+                                     scratch_pool));
+}
+
+/* Read the repository and collect the stats info in QUERY, using up to
+ * JOBS worker threads that read one shard each.  The calling thread
+ * merges the shards into QUERY strictly in revision order.
+ *
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+read_revisions(query_t *query,
+               int jobs,
+               apr_pool_t *scratch_pool)
+{
+  stats_jobs_baton_t baton;
+
+  baton.query = query;
+  baton.jobs = jobs;
+  baton.next_rev = 0;
+
+  return svn_error_trace(svn__jobs_run(jobs, stats_job_start,
+                                       stats_job_work, stats_job_finish,
+                                       &baton, query->cancel_func,
+                                       query->cancel_baton, scratch_pool));
 }
 
 /* Return a new svn_fs_fs__stats_t instance, allocated in RESULT_POOL.
@@ -1360,8 +1810,8 @@ create_query(query_t **query,
    * of both the nelts field of the array and our revision numbers). This
    * means this code will fail on platforms where int is less than 32-bits
    * and the repository has more revisions than int can hold. */
-  (*query)->revisions = apr_array_make(result_pool, (int) (*query)->head + 1,
-                                       sizeof(revision_info_t *));
+  SVN_ERR(rep_store_create(&(*query)->store, (int) (*query)->head + 1,
+                           result_pool, scratch_pool));
   (*query)->null_base = apr_pcalloc(result_pool,
                                     sizeof(*(*query)->null_base));
 
@@ -1379,6 +1829,7 @@ create_query(query_t **query,
 svn_error_t *
 svn_fs_fs__get_stats(svn_fs_fs__stats_t **stats,
                      svn_fs_t *fs,
+                     int jobs,
                      svn_fs_progress_notify_func_t progress_func,
                      void *progress_baton,
                      svn_cancel_func_t cancel_func,
@@ -1392,8 +1843,10 @@ svn_fs_fs__get_stats(svn_fs_fs__stats_t **stats,
   SVN_ERR(create_query(&query, fs, *stats, progress_func, progress_baton,
                        cancel_func, cancel_baton, scratch_pool,
                        scratch_pool));
-  SVN_ERR(read_revisions(query, scratch_pool, scratch_pool));
-  aggregate_stats(query->revisions, *stats);
+
+  SVN_ERR(read_revisions(query, jobs, scratch_pool));
+
+  SVN_ERR(aggregate_reps(query, scratch_pool));
 
   return SVN_NO_ERROR;
 }
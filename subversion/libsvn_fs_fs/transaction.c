@@ -42,9 +42,12 @@
 #include "cached_data.h"
 #include "lock.h"
 #include "rep-cache.h"
+#include "mergeinfo_index.h"
+#include "node_history.h"
 
 #include "private/svn_fs_util.h"
 #include "private/svn_fspath.h"
+#include "private/svn_io_private.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_string_private.h"
@@ -659,6 +662,66 @@ unparse_dir_entries(apr_array_header_t *entries,
   return SVN_NO_ERROR;
 }
 
+/* Like unparse_dir_entries but append a directory index as described in
+   low_level.h after the terminator.  Perform temporary allocations in
+   POOL. */
+static svn_error_t *
+unparse_indexed_dir_entries(apr_array_header_t *entries,
+                            svn_stream_t *stream,
+                            apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_stringbuf_t *buffer = svn_stringbuf_create_ensure(0x10000, pool);
+  svn_stream_t *buffer_stream = svn_stream_from_stringbuf(buffer, pool);
+  apr_array_header_t *offsets
+    = apr_array_make(pool, entries->nelts / SVN_FS_FS__DIR_INDEX_STRIDE + 1,
+                     sizeof(apr_uint64_t));
+  apr_uint64_t written = 0;
+  apr_size_t len;
+  int i;
+
+  for (i = 0; i < entries->nelts; ++i)
+    {
+      svn_fs_dirent_t *dirent;
+
+      svn_pool_clear(iterpool);
+      if (i % SVN_FS_FS__DIR_INDEX_STRIDE == 0)
+        APR_ARRAY_PUSH(offsets, apr_uint64_t) = written + buffer->len;
+
+      dirent = APR_ARRAY_IDX(entries, i, svn_fs_dirent_t *);
+      SVN_ERR(unparse_dir_entry(dirent, buffer_stream, iterpool));
+
+      /* Don't collect huge directories in memory. */
+      if (buffer->len >= 0x10000)
+        {
+          len = buffer->len;
+          SVN_ERR(svn_stream_write(stream, buffer->data, &len));
+          written += len;
+          svn_stringbuf_setempty(buffer);
+        }
+    }
+
+  svn_stringbuf_appendcstr(buffer, SVN_HASH_TERMINATOR "\n");
+  for (i = 0; i < offsets->nelts; ++i)
+    svn_stringbuf_appendcstr(buffer,
+                             apr_psprintf(iterpool,
+                                          "%016" APR_UINT64_T_HEX_FMT "\n",
+                                          APR_ARRAY_IDX(offsets, i,
+                                                        apr_uint64_t)));
+
+  svn_stringbuf_appendcstr(buffer,
+                           apr_psprintf(iterpool, "%s%08x %08x\n",
+                                        SVN_FS_FS__DIR_INDEX_FOOTER_PREFIX,
+                                        (unsigned int)offsets->nelts,
+                                        SVN_FS_FS__DIR_INDEX_STRIDE));
+
+  len = buffer->len;
+  SVN_ERR(svn_stream_write(stream, buffer->data, &len));
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
 /* Return a deep copy of SOURCE and allocate it in RESULT_POOL.
  */
 static svn_fs_path_change2_t *
@@ -1546,6 +1609,7 @@ svn_fs_fs__set_entry(svn_fs_t *fs,
   apr_file_t *file;
   svn_stream_t *out;
   svn_filesize_t filesize;
+  svn_filesize_t old_filesize = SVN_INVALID_FILESIZE;
   fs_fs_data_t *ffd = fs->fsap_data;
   apr_pool_t *subpool = svn_pool_create(pool);
 
@@ -1586,11 +1650,15 @@ svn_fs_fs__set_entry(svn_fs_t *fs,
           /* Obtain final file size to update txn_dir_cache. */
           SVN_ERR(svn_io_file_size_get(&filesize, file, subpool));
 
-          /* Store in the cache. */
+          /* Store in the cache.  If the directory is too large for it,
+           * keep it in memory instead. */
           dir_data.entries = entries;
           dir_data.txn_filesize = filesize;
           SVN_ERR(svn_cache__set(ffd->txn_dir_cache, key, &dir_data,
                                  subpool));
+          svn_fs_fs__set_txn_dir(fs, parent_noderev->id, entries, filesize,
+                                 subpool);
+          old_filesize = filesize;
         }
 
       svn_pool_clear(subpool);
@@ -1613,6 +1681,10 @@ svn_fs_fs__set_entry(svn_fs_t *fs,
           svn_boolean_t found;
           svn_filesize_t cached_filesize;
 
+          /* The in-memory directory copies need to know the size before
+           * the change as well. */
+          SVN_ERR(svn_io_file_size_get(&old_filesize, file, subpool));
+
           /* Get the file size that corresponds to the cached contents
            * (if any). */
           SVN_ERR(svn_cache__get_partial((void **)&cached_filesize, &found,
@@ -1622,14 +1694,8 @@ svn_fs_fs__set_entry(svn_fs_t *fs,
 
           /* File size info still matches?
            * If not, we need to drop the cache entry. */
-          if (found)
-            {
-              SVN_ERR(svn_io_file_size_get(&filesize, file, subpool));
-
-              if (cached_filesize != filesize)
-                SVN_ERR(svn_cache__set(ffd->txn_dir_cache, key, NULL,
-                                       subpool));
-            }
+          if (found && cached_filesize != old_filesize)
+            SVN_ERR(svn_cache__set(ffd->txn_dir_cache, key, NULL, subpool));
         }
     }
 
@@ -1683,6 +1749,10 @@ svn_fs_fs__set_entry(svn_fs_t *fs,
       SVN_ERR(svn_cache__set_partial(ffd->txn_dir_cache, key,
                                      svn_fs_fs__replace_dir_entry, &baton,
                                      subpool));
+
+      /* same for directories that are too large for the cache */
+      svn_fs_fs__update_txn_dir(fs, parent_noderev->id, name, id, kind,
+                                old_filesize, filesize, subpool);
     }
 
   svn_pool_destroy(subpool);
@@ -2769,6 +2839,19 @@ write_directory_to_stream(svn_stream_t *stream,
   return SVN_NO_ERROR;
 }
 
+/* Implement collection_writer_t writing the svn_fs_dirent_t* array given
+   as BATON followed by a directory index. */
+static svn_error_t *
+write_indexed_directory_to_stream(svn_stream_t *stream,
+                                  void *baton,
+                                  apr_pool_t *pool)
+{
+  apr_array_header_t *dir = baton;
+  SVN_ERR(unparse_indexed_dir_entries(dir, stream, pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Write out the COLLECTION as a text representation to file FILE using
    WRITER.  In the process, record position, the total size of the dump and
    MD5 as well as SHA1 in REP.   Add the representation of type ITEM_TYPE to
@@ -3124,6 +3207,10 @@ get_final_id(svn_fs_fs__id_part_t *part,
    of the representations of each property rep that is new in this
    revision.
 
+   If HISTORY_ENTRIES is not NULL, append to it a svn_fs_fs__node_history_t
+   (allocated in the array's pool) for each node revision that is new in
+   this revision.
+
    AT_ROOT is true if the node revision being written is the root
    node-revision.  It is only controls additional sanity checking
    logic.
@@ -3142,6 +3229,7 @@ write_final_rev(const svn_fs_id_t **new_id_p,
                 apr_array_header_t *reps_to_cache,
                 apr_hash_t *reps_hash,
                 apr_pool_t *reps_pool,
+                apr_array_header_t *history_entries,
                 svn_boolean_t at_root,
                 apr_pool_t *pool)
 {
@@ -3182,7 +3270,8 @@ write_final_rev(const svn_fs_id_t **new_id_p,
           SVN_ERR(write_final_rev(&new_id, file, rev, fs, dirent->id,
                                   start_node_id, start_copy_id, initial_offset,
                                   directory_ids, reps_to_cache, reps_hash,
-                                  reps_pool, FALSE, subpool));
+                                  reps_pool, history_entries, FALSE,
+                                  subpool));
           if (new_id && (svn_fs_fs__id_rev(new_id) == rev))
             dirent->id = svn_fs_fs__id_copy(new_id, pool);
         }
@@ -3194,7 +3283,14 @@ write_final_rev(const svn_fs_id_t **new_id_p,
 
           /* Write out the contents of this directory as a text rep. */
           noderev->data_rep->revision = rev;
-          if (ffd->deltify_directories)
+          if (   ffd->dir_index_threshold > 0
+              && entries->nelts >= ffd->dir_index_threshold)
+            /* Lookups can only use the index in PLAIN reps. */
+            SVN_ERR(write_container_rep(noderev->data_rep, file, entries,
+                                        write_indexed_directory_to_stream,
+                                        fs, NULL, FALSE,
+                                        SVN_FS_FS__ITEM_TYPE_DIR_REP, pool));
+          else if (ffd->deltify_directories)
             SVN_ERR(write_container_delta_rep(noderev->data_rep, file,
                                               entries,
                                               write_directory_to_stream,
@@ -3304,6 +3400,21 @@ write_final_rev(const svn_fs_id_t **new_id_p,
 
   noderev->id = new_id;
 
+  if (history_entries)
+    {
+      apr_pool_t *history_pool = history_entries->pool;
+      svn_fs_fs__node_history_t *entry
+        = apr_pcalloc(history_pool, sizeof(*entry));
+
+      entry->id = svn_fs_fs__id_copy(new_id, history_pool);
+      entry->predecessor_id
+        = noderev->predecessor_id
+        ? svn_fs_fs__id_copy(noderev->predecessor_id, history_pool)
+        : NULL;
+      entry->created_path = apr_pstrdup(history_pool, noderev->created_path);
+      APR_ARRAY_PUSH(history_entries, svn_fs_fs__node_history_t *) = entry;
+    }
+
   if (ffd->rep_sharing_allowed)
     {
       /* Save the data representation's hash in the rep cache. */
@@ -3592,14 +3703,13 @@ verify_locks(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
-/* Writes final revision properties to file PATH applying permissions
-   from file PERMS_REFERENCE. This involves setting svn:date and
+/* Writes final revision properties to file PATH and schedules the
+   necessary fsyncs in BATCH.  This involves setting svn:date and
    removing any temporary properties associated with the commit flags. */
 static svn_error_t *
 write_final_revprop(const char *path,
-                    const char *perms_reference,
                     svn_fs_txn_t *txn,
-                    svn_boolean_t flush_to_disk,
+                    svn_io__batch_fsync_t *batch,
                     apr_pool_t *pool)
 {
   apr_hash_t *txnprops;
@@ -3629,22 +3739,17 @@ write_final_revprop(const char *path,
       svn_hash_sets(txnprops, SVN_PROP_REVISION_DATE, &date);
     }
 
-  /* Create new revprops file. Tell OS to truncate existing file,
-     since  file may already exists from failed transaction. */
-  SVN_ERR(svn_io_file_open(&revprop_file, path,
-                           APR_WRITE | APR_CREATE | APR_TRUNCATE
-                           | APR_BUFFERED, APR_OS_DEFAULT, pool));
+  /* Create new revprops file. Truncate any existing file, since file
+     may already exists from failed transaction.  BATCH owns the handle
+     and will close it. */
+  SVN_ERR(svn_io__batch_fsync_open_file(&revprop_file, batch, path,
+                                        pool));
+  SVN_ERR(svn_io_file_trunc(revprop_file, 0, pool));
 
   stream = svn_stream_from_aprfile2(revprop_file, TRUE, pool);
   SVN_ERR(svn_hash_write2(txnprops, stream, SVN_HASH_TERMINATOR, pool));
   SVN_ERR(svn_stream_close(stream));
 
-  if (flush_to_disk)
-    SVN_ERR(svn_io_file_flush_to_disk(revprop_file, pool));
-  SVN_ERR(svn_io_file_close(revprop_file, pool));
-
-  SVN_ERR(svn_io_copy_perms(perms_reference, path, pool));
-
   return SVN_NO_ERROR;
 }
 
@@ -3732,8 +3837,52 @@ struct commit_baton {
   apr_array_header_t *reps_to_cache;
   apr_hash_t *reps_hash;
   apr_pool_t *reps_pool;
+  apr_array_header_t *history_entries;
+  apr_hash_t *changed_paths;
 };
 
+/* Do as much of the commit work for CB as possible without holding the
+   FS write lock, so that concurrent commits only serialize on the parts
+   that depend on the new revision number.  Fill in CB->CHANGED_PATHS and,
+   if the repository is configured to flush to disk, sync the proto-rev
+   file contents written so far.  The final sync in commit_body() then
+   only has to cover the data appended while holding the lock.
+
+   Use POOL for allocations. */
+static svn_error_t *
+prepare_commit(struct commit_baton *cb,
+               apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = cb->fs->fsap_data;
+  const svn_fs_fs__id_part_t *txn_id = svn_fs_fs__txn_get_id(cb->txn);
+
+  /* The changes list is private to the txn and does not depend on the
+     state of the repository. */
+  SVN_ERR(svn_fs_fs__txn_changes_fetch(&cb->changed_paths, cb->fs, txn_id,
+                                       pool));
+
+  if (ffd->flush_to_disk)
+    {
+      apr_file_t *proto_file;
+      void *proto_file_lockcookie;
+      svn_error_t *err;
+
+      SVN_ERR(get_writable_proto_rev(&proto_file, &proto_file_lockcookie,
+                                     cb->fs, txn_id, pool));
+
+      err = svn_io_file_flush_to_disk(proto_file, pool);
+      err = svn_error_compose_create(err,
+                                     svn_io_file_close(proto_file, pool));
+      err = svn_error_compose_create(err,
+                                     unlock_proto_rev(cb->fs, txn_id,
+                                                      proto_file_lockcookie,
+                                                      pool));
+      SVN_ERR(err);
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* The work-horse for svn_fs_fs__commit, called with the FS write lock.
    This implements the svn_fs_fs__with_write_lock() 'body' callback
    type.  BATON is a 'struct commit_baton *'. */
@@ -3755,6 +3904,7 @@ commit_body(void *baton, apr_pool_t *pool)
   apr_hash_t *changed_paths;
   apr_array_header_t *directory_ids = apr_array_make(pool, 4,
                                                      sizeof(pair_cache_key_t));
+  svn_io__batch_fsync_t *batch;
 
   /* Re-Read the current repository format.  All our repo upgrade and
      config evaluation strategies are such that existing information in
@@ -3786,9 +3936,8 @@ commit_body(void *baton, apr_pool_t *pool)
                             _("Transaction out of date"));
 
   /* We need the changes list for verification as well as for writing it
-     to the final rev file. */
-  SVN_ERR(svn_fs_fs__txn_changes_fetch(&changed_paths, cb->fs, txn_id,
-                                       pool));
+     to the final rev file.  It has been read by prepare_commit(). */
+  changed_paths = cb->changed_paths;
 
   /* Locks may have been added (or stolen) between the calling of
      previous svn_fs.h functions and svn_fs_commit_txn(), so we need
@@ -3799,6 +3948,9 @@ commit_body(void *baton, apr_pool_t *pool)
   /* We are going to be one better than this puny old revision. */
   new_rev = old_rev + 1;
 
+  /* Collect all files and folders that need to be synced. */
+  SVN_ERR(svn_io__batch_fsync_create(&batch, ffd->flush_to_disk, pool));
+
   /* Get a write handle on the proto revision file. */
   SVN_ERR(get_writable_proto_rev(&proto_file, &proto_file_lockcookie,
                                  cb->fs, txn_id, pool));
@@ -3809,7 +3961,7 @@ commit_body(void *baton, apr_pool_t *pool)
   SVN_ERR(write_final_rev(&new_root_id, proto_file, new_rev, cb->fs, root_id,
                           start_node_id, start_copy_id, initial_offset,
                           directory_ids, cb->reps_to_cache, cb->reps_hash,
-                          cb->reps_pool, TRUE, pool));
+                          cb->reps_pool, cb->history_entries, TRUE, pool));
 
   /* Write the changed-path information. */
   SVN_ERR(write_final_changed_path_info(&changed_path_offset, proto_file,
@@ -3837,8 +3989,7 @@ commit_body(void *baton, apr_pool_t *pool)
                                      NULL, pool));
     }
 
-  if (ffd->flush_to_disk)
-    SVN_ERR(svn_io_file_flush_to_disk(proto_file, pool));
+  /* The data will be synced together with the other new files below. */
   SVN_ERR(svn_io_file_close(proto_file, pool));
 
   /* We don't unlock the prototype revision file immediately to avoid a
@@ -3863,6 +4014,7 @@ commit_body(void *baton, apr_pool_t *pool)
                                                     PATH_REVS_DIR,
                                                     pool),
                                     new_dir, pool));
+          SVN_ERR(svn_io__batch_fsync_new_path(batch, new_dir, pool));
         }
 
       /* Create the revprops shard. */
@@ -3879,6 +4031,7 @@ commit_body(void *baton, apr_pool_t *pool)
                                                     PATH_REVPROPS_DIR,
                                                     pool),
                                     new_dir, pool));
+          SVN_ERR(svn_io__batch_fsync_new_path(batch, new_dir, pool));
         }
     }
 
@@ -3891,8 +4044,8 @@ commit_body(void *baton, apr_pool_t *pool)
   rev_filename = svn_fs_fs__path_rev(cb->fs, new_rev, pool);
   proto_filename = svn_fs_fs__path_txn_proto_rev(cb->fs, txn_id, pool);
   SVN_ERR(svn_fs_fs__move_into_place(proto_filename, rev_filename,
-                                     old_rev_filename, ffd->flush_to_disk,
-                                     pool));
+                                     old_rev_filename, FALSE, pool));
+  SVN_ERR(svn_io__batch_fsync_add_file(batch, rev_filename, pool));
 
   /* Now that we've moved the prototype revision file out of the way,
      we can unlock it (since further attempts to write to the file
@@ -3903,8 +4056,12 @@ commit_body(void *baton, apr_pool_t *pool)
   /* Write final revprops file. */
   SVN_ERR_ASSERT(! svn_fs_fs__is_packed_revprop(cb->fs, new_rev));
   revprop_filename = svn_fs_fs__path_revprops(cb->fs, new_rev, pool);
-  SVN_ERR(write_final_revprop(revprop_filename, old_rev_filename,
-                              cb->txn, ffd->flush_to_disk, pool));
+  SVN_ERR(write_final_revprop(revprop_filename, cb->txn, batch, pool));
+
+  /* Flush the rev file, the revprops file and any new directories
+     concurrently.  All of them must be on disk before we bump 'current'. */
+  SVN_ERR(svn_io__batch_fsync_run(batch, pool));
+  SVN_ERR(svn_io_copy_perms(old_rev_filename, revprop_filename, pool));
 
   /* Run paranoia checks. */
   if (ffd->verify_before_commit)
@@ -3935,25 +4092,6 @@ commit_body(void *baton, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
-/* Add the representations in REPS_TO_CACHE (an array of representation_t *)
- * to the rep-cache database of FS. */
-static svn_error_t *
-write_reps_to_cache(svn_fs_t *fs,
-                    const apr_array_header_t *reps_to_cache,
-                    apr_pool_t *scratch_pool)
-{
-  int i;
-
-  for (i = 0; i < reps_to_cache->nelts; i++)
-    {
-      representation_t *rep = APR_ARRAY_IDX(reps_to_cache, i, representation_t *);
-
-      SVN_ERR(svn_fs_fs__set_rep_reference(fs, rep, scratch_pool));
-    }
-
-  return SVN_NO_ERROR;
-}
-
 svn_error_t *
 svn_fs_fs__commit(svn_revnum_t *new_rev_p,
                   svn_fs_t *fs,
@@ -3980,6 +4118,15 @@ svn_fs_fs__commit(svn_revnum_t *new_rev_p,
       cb.reps_pool = NULL;
     }
 
+  if (ffd->node_history_enabled)
+    cb.history_entries = apr_array_make(pool, 5,
+                                        sizeof(svn_fs_fs__node_history_t *));
+  else
+    cb.history_entries = NULL;
+
+  /* Get the expensive but revision-independent work out of the way
+     before we block other commits. */
+  SVN_ERR(prepare_commit(&cb, pool));
   SVN_ERR(svn_fs_fs__with_write_lock(fs, commit_body, &cb, pool));
 
   /* At this point, *NEW_REV_P has been set, so errors below won't affect
@@ -3991,17 +4138,11 @@ svn_fs_fs__commit(svn_revnum_t *new_rev_p,
 
       SVN_ERR(svn_fs_fs__open_rep_cache(fs, pool));
 
-      /* Write new entries to the rep-sharing database.
-       *
-       * We use an sqlite transaction to speed things up;
-       * see <http://www.sqlite.org/faq.html#q19>.
-       */
-      /* ### A commit that touches thousands of files will starve other
-             (reader/writer) commits for the duration of the below call.
-             Maybe write in batches? */
-      SVN_ERR(svn_sqlite__begin_transaction(ffd->rep_cache_db));
-      err = write_reps_to_cache(fs, cb.reps_to_cache, pool);
-      err = svn_sqlite__finish_transaction(ffd->rep_cache_db, err);
+      /* Write new entries to the rep-sharing database in a single SQLite
+         transaction.  The repository write lock has already been
+         released, so other commits only wait for it if they need to
+         write to rep-cache.db themselves. */
+      err = svn_fs_fs__set_rep_references(fs, cb.reps_to_cache, pool);
 
       if (svn_error_find_cause(err, SVN_ERR_SQLITE_ROLLBACK_FAILED))
         {
@@ -4016,6 +4157,33 @@ svn_fs_fs__commit(svn_revnum_t *new_rev_p,
         return svn_error_trace(err);
     }
 
+  /* Record the new node revisions in the node history index.  Readers
+     fall back to the node revisions for anything missing from the index.
+     So, don't report the committed revision as a failure. */
+  if (cb.history_entries)
+    {
+      svn_error_t *err = svn_fs_fs__add_node_history(fs, cb.history_entries,
+                                                     pool);
+      if (err)
+        {
+          (fs->warning)(fs->warning_baton, err);
+          svn_error_clear(err);
+        }
+    }
+
+  /* Bring the mergeinfo index up to date with the new revision.  The index
+     is optional and the next commit will catch up.  So, don't report the
+     committed revision as a failure. */
+  {
+    svn_error_t *err = svn_fs_fs__update_mergeinfo_index(fs, *new_rev_p,
+                                                         pool);
+    if (err)
+      {
+        (fs->warning)(fs->warning_baton, err);
+        svn_error_clear(err);
+      }
+  }
+
   return SVN_NO_ERROR;
 }
 
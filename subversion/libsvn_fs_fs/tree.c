@@ -55,6 +55,8 @@
 #include "cached_data.h"
 #include "dag.h"
 #include "lock.h"
+#include "mergeinfo_index.h"
+#include "node_history.h"
 #include "tree.h"
 #include "fs_fs.h"
 #include "id.h"
@@ -3885,28 +3887,43 @@ history_prev(svn_fs_history_t **prev_history,
     {
       /* We know the last reported node (CURRENT_ID) and the NEXT_COPY
          revision is somewhat further in the past. */
-      node_revision_t *noderev;
+      const svn_fs_id_t *predecessor_id;
+      const char *created_path;
+      svn_boolean_t found;
       assert(reported);
 
+      /* The node history index, if present, provides what we need for
+         many node changes at once.  Otherwise, read the node itself. */
+      SVN_ERR(svn_fs_fs__get_node_history(&predecessor_id, &created_path,
+                                          &found, fs, fhd->current_id,
+                                          scratch_pool, scratch_pool));
+      if (! found)
+        {
+          node_revision_t *noderev;
+          SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs,
+                                               fhd->current_id,
+                                               scratch_pool, scratch_pool));
+          predecessor_id = noderev->predecessor_id;
+          created_path = noderev->created_path;
+        }
+
       /* Get the previous node change.  If there is none, then we already
          reported the initial addition and this history traversal is done. */
-      SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, fhd->current_id,
-                                           scratch_pool, scratch_pool));
-      if (! noderev->predecessor_id)
+      if (! predecessor_id)
         return SVN_NO_ERROR;
 
       /* If the previous node change is younger than the next copy, it is
          part of the linear history section. */
-      commit_rev = svn_fs_fs__id_rev(noderev->predecessor_id);
+      commit_rev = svn_fs_fs__id_rev(predecessor_id);
       if (commit_rev > fhd->next_copy)
         {
           /* Within the linear history, simply report all node changes and
              continue with the respective predecessor. */
-          *prev_history = assemble_history(fs, noderev->created_path,
+          *prev_history = assemble_history(fs, created_path,
                                            commit_rev, TRUE, NULL,
                                            SVN_INVALID_REVNUM,
                                            fhd->next_copy,
-                                           noderev->predecessor_id,
+                                           predecessor_id,
                                            result_pool);
 
           return SVN_NO_ERROR;
@@ -4289,6 +4306,7 @@ get_mergeinfo_for_path_internal(svn_mergeinfo_t *mergeinfo,
   parent_path_t *parent_path, *nearest_ancestor;
   apr_hash_t *proplist;
   svn_string_t *mergeinfo_string;
+  svn_boolean_t indexed;
 
   path = svn_fs__canonicalize_abspath(path, scratch_pool);
 
@@ -4326,34 +4344,52 @@ get_mergeinfo_for_path_internal(svn_mergeinfo_t *mergeinfo,
         }
     }
 
-  SVN_ERR(svn_fs_fs__dag_get_proplist(&proplist, nearest_ancestor->node,
-                                      scratch_pool));
-  mergeinfo_string = svn_hash_gets(proplist, SVN_PROP_MERGEINFO);
-  if (!mergeinfo_string)
-    return svn_error_createf
-      (SVN_ERR_FS_CORRUPT, NULL,
-       _("Node-revision '%s@%ld' claims to have mergeinfo but doesn't"),
-       parent_path_path(nearest_ancestor, scratch_pool), rev_root->rev);
-
-  /* Parse the mergeinfo; store the result in *MERGEINFO. */
-  {
-    /* Issue #3896: If a node has syntactically invalid mergeinfo, then
-       treat it as if no mergeinfo is present rather than raising a parse
-       error. */
-    svn_error_t *err = svn_mergeinfo_parse(mergeinfo,
-                                           mergeinfo_string->data,
-                                           result_pool);
-    if (err)
+  /* The mergeinfo index already has the parsed mergeinfo.  It has no
+     entry for nodes with invalid mergeinfo. */
+  SVN_ERR(svn_fs_fs__mergeinfo_index_covers(&indexed, rev_root->fs,
+                                            rev_root->rev, scratch_pool));
+  if (indexed)
+    {
+      SVN_ERR(svn_fs_fs__get_indexed_mergeinfo(mergeinfo, rev_root->fs,
+                                               rev_root->rev,
+                                               parent_path_path(
+                                                 nearest_ancestor,
+                                                 scratch_pool),
+                                               result_pool, scratch_pool));
+      if (*mergeinfo == NULL)
+        return SVN_NO_ERROR;
+    }
+  else
+    {
+      SVN_ERR(svn_fs_fs__dag_get_proplist(&proplist, nearest_ancestor->node,
+                                          scratch_pool));
+      mergeinfo_string = svn_hash_gets(proplist, SVN_PROP_MERGEINFO);
+      if (!mergeinfo_string)
+        return svn_error_createf
+          (SVN_ERR_FS_CORRUPT, NULL,
+           _("Node-revision '%s@%ld' claims to have mergeinfo but doesn't"),
+           parent_path_path(nearest_ancestor, scratch_pool), rev_root->rev);
+
+      /* Parse the mergeinfo; store the result in *MERGEINFO. */
       {
-        if (err->apr_err == SVN_ERR_MERGEINFO_PARSE_ERROR)
+        /* Issue #3896: If a node has syntactically invalid mergeinfo, then
+           treat it as if no mergeinfo is present rather than raising a
+           parse error. */
+        svn_error_t *err = svn_mergeinfo_parse(mergeinfo,
+                                               mergeinfo_string->data,
+                                               result_pool);
+        if (err)
           {
-            svn_error_clear(err);
-            err = NULL;
-            *mergeinfo = NULL;
+            if (err->apr_err == SVN_ERR_MERGEINFO_PARSE_ERROR)
+              {
+                svn_error_clear(err);
+                err = NULL;
+                *mergeinfo = NULL;
+              }
+            return svn_error_trace(err);
           }
-        return svn_error_trace(err);
       }
-  }
+    }
 
   /* If our nearest ancestor is the very path we inquired about, we
      can return the mergeinfo results directly.  Otherwise, we're
@@ -4439,7 +4475,17 @@ add_descendant_mergeinfo(svn_fs_root_t *root,
                          apr_pool_t *scratch_pool)
 {
   dag_node_t *this_dag;
-  svn_boolean_t go_down;
+  svn_boolean_t go_down, indexed;
+
+  /* The mergeinfo index lists all descendants with mergeinfo directly. */
+  SVN_ERR(svn_fs_fs__mergeinfo_index_covers(&indexed, root->fs, root->rev,
+                                            scratch_pool));
+  if (indexed)
+    return svn_error_trace(svn_fs_fs__walk_indexed_mergeinfo(
+                             root->fs, root->rev,
+                             svn_fs__canonicalize_abspath(path,
+                                                          scratch_pool),
+                             receiver, baton, scratch_pool));
 
   SVN_ERR(get_dag(&this_dag, root, path, scratch_pool));
   SVN_ERR(svn_fs_fs__dag_has_descendants_with_mergeinfo(&go_down,
@@ -179,6 +179,21 @@ recovery_started(void *baton,
     svn_error_clear(rb->start_callback(rb->start_callback_baton));
 }
 
+svn_error_t *
+svn_repos_recover4(const char *path,
+                   svn_boolean_t nonblocking,
+                   svn_repos_notify_func_t notify_func,
+                   void *notify_baton,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *pool)
+{
+  return svn_error_trace(svn_repos_recover5(path, nonblocking, NULL,
+                                            notify_func, notify_baton,
+                                            cancel_func, cancel_baton,
+                                            pool));
+}
+
 svn_error_t *
 svn_repos_recover3(const char *path,
                    svn_boolean_t nonblocking,
@@ -192,7 +207,7 @@ svn_repos_recover3(const char *path,
   rb.start_callback = start_callback;
   rb.start_callback_baton = start_callback_baton;
 
-  return svn_repos_recover4(path, nonblocking, recovery_started, &rb,
+  return svn_repos_recover5(path, nonblocking, NULL, recovery_started, &rb,
                             cancel_func, cancel_baton, pool);
 }
 
@@ -855,6 +870,35 @@ svn_repos_dump_fs2(svn_repos_t *repos,
                                             pool));
 }
 
+svn_error_t *
+svn_repos_verify_fs3(svn_repos_t *repos,
+                     svn_revnum_t start_rev,
+                     svn_revnum_t end_rev,
+                     svn_boolean_t check_normalization,
+                     svn_boolean_t metadata_only,
+                     svn_repos_notify_func_t notify_func,
+                     void *notify_baton,
+                     svn_repos_verify_callback_t verify_callback,
+                     void *verify_baton,
+                     svn_cancel_func_t cancel_func,
+                     void *cancel_baton,
+                     apr_pool_t *pool)
+{
+  return svn_error_trace(svn_repos_verify_fs4(repos,
+                                              start_rev,
+                                              end_rev,
+                                              check_normalization,
+                                              metadata_only,
+                                              1,
+                                              notify_func,
+                                              notify_baton,
+                                              verify_callback,
+                                              verify_baton,
+                                              cancel_func,
+                                              cancel_baton,
+                                              pool));
+}
+
 svn_error_t *
 svn_repos_verify_fs2(svn_repos_t *repos,
                      svn_revnum_t start_rev,
@@ -865,11 +909,12 @@ svn_repos_verify_fs2(svn_repos_t *repos,
                      void *cancel_baton,
                      apr_pool_t *pool)
 {
-  return svn_error_trace(svn_repos_verify_fs3(repos,
+  return svn_error_trace(svn_repos_verify_fs4(repos,
                                               start_rev,
                                               end_rev,
                                               FALSE,
                                               FALSE,
+                                              1,
                                               notify_func,
                                               notify_baton,
                                               NULL, NULL,
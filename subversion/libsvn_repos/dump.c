@@ -42,6 +42,7 @@
 #include "private/svn_mergeinfo_private.h"
 #include "private/svn_fs_private.h"
 #include "private/svn_sorts_private.h"
+#include "private/svn_subr_private.h"
 #include "private/svn_utf_private.h"
 #include "private/svn_cache.h"
 #include "private/svn_fspath.h"
@@ -2459,12 +2460,364 @@ report_error(svn_revnum_t revision,
     }
 }
 
+#if APR_HAS_THREADS
+
+/* Number of revisions per chunk of parallel verification work, unless
+   the backend's shard size suggests a better value. */
+#define VERIFY_CHUNK_SIZE 1000
+
+/* Parameters shared by all parallel verification jobs. */
+typedef struct verify_jobs_baton_t
+{
+  /* Repository filesystem to open in each worker. */
+  const char *fs_path;
+
+  /* Filesystem config to copy into each job. */
+  apr_hash_t *fs_config;
+
+  /* The first revision to verify overall (not just within the chunk). */
+  svn_revnum_t start_rev;
+
+  /* Options as passed to svn_repos_verify_fs4(). */
+  svn_boolean_t check_normalization;
+  svn_boolean_t metadata_only;
+
+  /* Whether to collect notifications at all. */
+  svn_boolean_t notify;
+
+  /* The caller's callbacks, as passed to svn_repos_verify_fs4(). */
+  svn_repos_notify_func_t notify_func;
+  void *notify_baton;
+  svn_repos_verify_callback_t verify_callback;
+  void *verify_baton;
+
+  /* The next revision to hand out and the last one to verify. */
+  svn_revnum_t next_rev;
+  svn_revnum_t end_rev;
+
+  /* Number of revisions per job. */
+  svn_revnum_t chunk_size;
+} verify_jobs_baton_t;
+
+/* A notification or failure recorded by a worker thread, to be forwarded
+   to the caller by the main thread. */
+typedef struct verify_event_t
+{
+  /* If not NULL, notification to send. */
+  svn_repos_notify_t *notify;
+
+  /* If not NULL, the failure to report for REVISION. */
+  svn_error_t *err;
+  svn_revnum_t revision;
+} verify_event_t;
+
+/* One chunk of parallel verification work. */
+typedef struct verify_job_t
+{
+  /* Shared parameters.  Read-only while the job is running. */
+  const verify_jobs_baton_t *shared;
+
+  /* Revision range to verify. */
+  svn_revnum_t start_rev;
+  svn_revnum_t end_rev;
+
+  /* Private copy of the filesystem config. */
+  apr_hash_t *fs_config;
+
+  /* Notifications and failures in the order they occurred.
+     Array of verify_event_t. */
+  apr_array_header_t *events;
+
+  /* Pool that contains everything above. */
+  apr_pool_t *pool;
+} verify_job_t;
+
+/* Append a copy of NOTIFY to the events of the verify_job_t BATON.
+   Implements svn_repos_notify_func_t. */
+static void
+verify_job_notify(void *baton,
+                  const svn_repos_notify_t *notify,
+                  apr_pool_t *scratch_pool)
+{
+  verify_job_t *job = baton;
+  verify_event_t *event = apr_array_push(job->events);
+  svn_repos_notify_t *copy = apr_pmemdup(job->pool, notify, sizeof(*copy));
+
+  copy->warning_str = apr_pstrdup(job->pool, notify->warning_str);
+  copy->path = apr_pstrdup(job->pool, notify->path);
+
+  event->notify = copy;
+  event->err = SVN_NO_ERROR;
+  event->revision = notify->revision;
+}
+
+/* Append a structure verification notification for REVISION to the
+   events of the verify_job_t BATON.
+   Implements svn_fs_progress_notify_func_t. */
+static void
+verify_job_fs_notify(svn_revnum_t revision,
+                     void *baton,
+                     apr_pool_t *pool)
+{
+  verify_job_t *job = baton;
+  verify_event_t *event = apr_array_push(job->events);
+
+  event->notify
+    = svn_repos_notify_create(svn_repos_notify_verify_rev_structure,
+                              job->pool);
+  event->notify->revision = revision;
+  event->err = SVN_NO_ERROR;
+  event->revision = revision;
+}
+
+/* Append the failure ERR for REVISION to the events of JOB. */
+static void
+verify_job_error(verify_job_t *job,
+                 svn_revnum_t revision,
+                 svn_error_t *err)
+{
+  verify_event_t *event = apr_array_push(job->events);
+
+  event->notify = NULL;
+  event->err = err;
+  event->revision = revision;
+}
+
+/* Clear all failures still recorded in the verify_job_t DATA.
+   Implements apr_pool_cleanup_t for jobs whose results get discarded. */
+static apr_status_t
+verify_job_cleanup(void *data)
+{
+  verify_job_t *job = data;
+  int i;
+
+  for (i = 0; i < job->events->nelts; ++i)
+    {
+      verify_event_t *event = &APR_ARRAY_IDX(job->events, i, verify_event_t);
+      svn_error_clear(event->err);
+      event->err = SVN_NO_ERROR;
+    }
+
+  return APR_SUCCESS;
+}
+
+/* Implement svn__job_start_func_t for verify_fs_parallel(), handing out
+   the next chunk of revisions.  BATON is a verify_jobs_baton_t. */
+static svn_error_t *
+verify_job_start(void **job_p,
+                 void *baton,
+                 apr_pool_t *job_pool,
+                 apr_pool_t *scratch_pool)
+{
+  verify_jobs_baton_t *shared = baton;
+  verify_job_t *job;
+  svn_revnum_t last_rev;
+
+  *job_p = NULL;
+  if (shared->next_rev > shared->end_rev)
+    return SVN_NO_ERROR;
+
+  last_rev = (shared->next_rev / shared->chunk_size + 1) * shared->chunk_size
+           - 1;
+  if (last_rev > shared->end_rev)
+    last_rev = shared->end_rev;
+
+  job = apr_pcalloc(job_pool, sizeof(*job));
+  job->shared = shared;
+  job->start_rev = shared->next_rev;
+  job->end_rev = last_rev;
+  job->fs_config = shared->fs_config
+                 ? apr_hash_copy(job_pool, shared->fs_config)
+                 : NULL;
+  job->events = apr_array_make(job_pool, 16, sizeof(verify_event_t));
+  job->pool = job_pool;
+  apr_pool_cleanup_register(job_pool, job, verify_job_cleanup,
+                            apr_pool_cleanup_null);
+
+  shared->next_rev = last_rev + 1;
+  *job_p = job;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn__job_work_func_t for verify_fs_parallel(): verify the FS
+   metadata and then each revision in the range of the verify_job_t
+   JOB_BATON, recording all outcomes in its event list.  Return
+   cancellation and other fatal errors directly. */
+static svn_error_t *
+verify_job_work(void *job_baton,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  verify_job_t *job = job_baton;
+  const verify_jobs_baton_t *shared = job->shared;
+  svn_fs_t *fs;
+  svn_revnum_t rev;
+  apr_pool_t *iterpool;
+  svn_error_t *err;
+
+  err = svn_fs_verify(shared->fs_path, job->fs_config,
+                      job->start_rev, job->end_rev,
+                      shared->notify ? verify_job_fs_notify : NULL, job,
+                      cancel_func, cancel_baton, scratch_pool);
+  if (err && err->apr_err == SVN_ERR_CANCELLED)
+    return svn_error_trace(err);
+  else if (err)
+    verify_job_error(job, SVN_INVALID_REVNUM, err);
+
+  if (shared->metadata_only)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_open2(&fs, shared->fs_path, job->fs_config,
+                       scratch_pool, scratch_pool));
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (rev = job->start_rev; rev <= job->end_rev; rev++)
+    {
+      svn_pool_clear(iterpool);
+
+      err = verify_one_revision(fs, rev,
+                                shared->notify ? verify_job_notify : NULL,
+                                job, shared->start_rev,
+                                shared->check_normalization,
+                                cancel_func, cancel_baton, iterpool);
+
+      if (err && err->apr_err == SVN_ERR_CANCELLED)
+        return svn_error_trace(err);
+      else if (err)
+        verify_job_error(job, rev, err);
+      else if (shared->notify)
+        {
+          verify_event_t *event = apr_array_push(job->events);
+
+          event->notify
+            = svn_repos_notify_create(svn_repos_notify_verify_rev_end,
+                                      result_pool);
+          event->notify->revision = rev;
+          event->err = SVN_NO_ERROR;
+          event->revision = rev;
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn__job_finish_func_t for verify_fs_parallel(): forward the
+   notifications and failures recorded by the verify_job_t JOB_BATON to
+   the caller's callbacks given in the verify_jobs_baton_t BATON.  ERR is
+   the job's fatal error. */
+static svn_error_t *
+verify_job_finish(void *job_baton,
+                  svn_error_t *err,
+                  void *baton,
+                  apr_pool_t *scratch_pool)
+{
+  verify_job_t *job = job_baton;
+  verify_jobs_baton_t *shared = baton;
+  int i;
+
+  for (i = 0; i < job->events->nelts; ++i)
+    {
+      verify_event_t *event = &APR_ARRAY_IDX(job->events, i, verify_event_t);
+
+      if (event->err)
+        {
+          svn_error_t *verify_err = event->err;
+
+          /* Stop on the first error that the caller won't accept.
+             The remaining events will be cleared with the job. */
+          event->err = SVN_NO_ERROR;
+          verify_err = report_error(event->revision, verify_err,
+                                    shared->verify_callback,
+                                    shared->verify_baton, scratch_pool);
+          if (verify_err)
+            {
+              svn_error_clear(err);
+              return svn_error_trace(verify_err);
+            }
+        }
+      else if (shared->notify_func)
+        {
+          shared->notify_func(shared->notify_baton, event->notify,
+                              scratch_pool);
+        }
+    }
+
+  return svn_error_trace(err);
+}
+
+/* Implement the body of svn_repos_verify_fs4() for JOBS > 1 and FS,
+   i.e. the FS-specific metadata check plus the per-revision checks of
+   START_REV to END_REV.  INFO is the svn_fs_info() of FS.  The remaining
+   parameters are the same as for svn_repos_verify_fs4().  Use
+   SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+verify_fs_parallel(svn_fs_t *fs,
+                   const svn_fs_info_placeholder_t *info,
+                   svn_revnum_t start_rev,
+                   svn_revnum_t end_rev,
+                   svn_boolean_t check_normalization,
+                   svn_boolean_t metadata_only,
+                   int jobs,
+                   svn_repos_notify_func_t notify_func,
+                   void *notify_baton,
+                   svn_repos_verify_callback_t verify_callback,
+                   void *verify_baton,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *scratch_pool)
+{
+  verify_jobs_baton_t *shared = apr_pcalloc(scratch_pool, sizeof(*shared));
+
+  shared->chunk_size = VERIFY_CHUNK_SIZE;
+
+  /* Chunks should align with shards, such that each worker reads from
+     as few (pack) files as possible. */
+  if (strcmp(info->fs_type, SVN_FS_TYPE_FSFS) == 0)
+    {
+      const svn_fs_fsfs_info_t *fsfs_info = (const void *)info;
+      if (fsfs_info->shard_size > 0)
+        shared->chunk_size = fsfs_info->shard_size;
+    }
+  else if (strcmp(info->fs_type, SVN_FS_TYPE_FSX) == 0)
+    {
+      const svn_fs_fsx_info_t *fsx_info = (const void *)info;
+      if (fsx_info->shard_size > 0)
+        shared->chunk_size = fsx_info->shard_size;
+    }
+
+  shared->fs_path = svn_fs_path(fs, scratch_pool);
+  shared->fs_config = svn_fs_config(fs, scratch_pool);
+  shared->start_rev = start_rev;
+  shared->check_normalization = check_normalization;
+  shared->metadata_only = metadata_only;
+  shared->notify = (notify_func != NULL);
+  shared->notify_func = notify_func;
+  shared->notify_baton = notify_baton;
+  shared->verify_callback = verify_callback;
+  shared->verify_baton = verify_baton;
+  shared->next_rev = start_rev;
+  shared->end_rev = end_rev;
+
+  return svn_error_trace(svn__jobs_run(jobs, verify_job_start,
+                                       verify_job_work, verify_job_finish,
+                                       shared, cancel_func, cancel_baton,
+                                       scratch_pool));
+}
+
+#endif
+
 svn_error_t *
-svn_repos_verify_fs3(svn_repos_t *repos,
+svn_repos_verify_fs4(svn_repos_t *repos,
                      svn_revnum_t start_rev,
                      svn_revnum_t end_rev,
                      svn_boolean_t check_normalization,
                      svn_boolean_t metadata_only,
+                     int jobs,
                      svn_repos_notify_func_t notify_func,
                      void *notify_baton,
                      svn_repos_verify_callback_t verify_callback,
@@ -2481,6 +2834,10 @@ svn_repos_verify_fs3(svn_repos_t *repos,
   svn_fs_progress_notify_func_t verify_notify = NULL;
   struct verify_fs_notify_func_baton_t *verify_notify_baton = NULL;
   svn_error_t *err;
+#if APR_HAS_THREADS
+  const svn_fs_info_placeholder_t *info = NULL;
+  svn_boolean_t parallel = FALSE;
+#endif
 
   /* Make sure we catch up on the latest revprop changes.  This is the only
    * time we will refresh the revprop data in this query. */
@@ -2521,49 +2878,72 @@ svn_repos_verify_fs3(svn_repos_t *repos,
         = svn_repos_notify_create(svn_repos_notify_verify_rev_structure, pool);
     }
 
-  /* Verify global metadata and backend-specific data first. */
-  err = svn_fs_verify(svn_fs_path(fs, pool), svn_fs_config(fs, pool),
-                      start_rev, end_rev,
-                      verify_notify, verify_notify_baton,
-                      cancel_func, cancel_baton, pool);
-
-  if (err && err->apr_err == SVN_ERR_CANCELLED)
+#if APR_HAS_THREADS
+  /* Spread the work across multiple threads?  We only do that for
+     backends that are known to cope well with many concurrent
+     connections to the same repository from within one process. */
+  if (jobs > 1 && start_rev < end_rev)
     {
-      return svn_error_trace(err);
+      SVN_ERR(svn_fs_info(&info, fs, pool, pool));
+      parallel = (strcmp(info->fs_type, SVN_FS_TYPE_FSFS) == 0
+                  || strcmp(info->fs_type, SVN_FS_TYPE_FSX) == 0);
     }
-  else if (err)
+
+  if (parallel)
     {
-      SVN_ERR(report_error(SVN_INVALID_REVNUM, err, verify_callback,
-                           verify_baton, iterpool));
+      SVN_ERR(verify_fs_parallel(fs, info, start_rev, end_rev,
+                                 check_normalization, metadata_only, jobs,
+                                 notify_func, notify_baton,
+                                 verify_callback, verify_baton,
+                                 cancel_func, cancel_baton, iterpool));
     }
+  else
+#endif
+    {
+      /* Verify global metadata and backend-specific data first. */
+      err = svn_fs_verify(svn_fs_path(fs, pool), svn_fs_config(fs, pool),
+                          start_rev, end_rev,
+                          verify_notify, verify_notify_baton,
+                          cancel_func, cancel_baton, pool);
 
-  if (!metadata_only)
-    for (rev = start_rev; rev <= end_rev; rev++)
-      {
-        svn_pool_clear(iterpool);
-
-        /* Wrapper function to catch the possible errors. */
-        err = verify_one_revision(fs, rev, notify_func, notify_baton,
-                                  start_rev, check_normalization,
-                                  cancel_func, cancel_baton,
-                                  iterpool);
+      if (err && err->apr_err == SVN_ERR_CANCELLED)
+        {
+          return svn_error_trace(err);
+        }
+      else if (err)
+        {
+          SVN_ERR(report_error(SVN_INVALID_REVNUM, err, verify_callback,
+                               verify_baton, iterpool));
+        }
 
-        if (err && err->apr_err == SVN_ERR_CANCELLED)
-          {
-            return svn_error_trace(err);
-          }
-        else if (err)
-          {
-            SVN_ERR(report_error(rev, err, verify_callback, verify_baton,
-                                 iterpool));
-          }
-        else if (notify_func)
+      if (!metadata_only)
+        for (rev = start_rev; rev <= end_rev; rev++)
           {
-            /* Tell the caller that we're done with this revision. */
-            notify->revision = rev;
-            notify_func(notify_baton, notify, iterpool);
+            svn_pool_clear(iterpool);
+
+            /* Wrapper function to catch the possible errors. */
+            err = verify_one_revision(fs, rev, notify_func, notify_baton,
+                                      start_rev, check_normalization,
+                                      cancel_func, cancel_baton,
+                                      iterpool);
+
+            if (err && err->apr_err == SVN_ERR_CANCELLED)
+              {
+                return svn_error_trace(err);
+              }
+            else if (err)
+              {
+                SVN_ERR(report_error(rev, err, verify_callback, verify_baton,
+                                     iterpool));
+              }
+            else if (notify_func)
+              {
+                /* Tell the caller that we're done with this revision. */
+                notify->revision = rev;
+                notify_func(notify_baton, notify, iterpool);
+              }
           }
-      }
+    }
 
   /* We're done. */
   if (notify_func)
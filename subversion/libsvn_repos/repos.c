@@ -1658,7 +1658,7 @@ svn_repos_fs_type(svn_repos_t *repos,
 /* For historical reasons, for the Berkeley DB backend, this code uses
  * repository locking, which is motivated by the need to support the
  * Berkeley DB error DB_RUN_RECOVERY.  (FSFS takes care of locking
- * itself, inside its implementation of svn_fs_recover.)  Here's how
+ * itself, inside its implementation of svn_fs_recover2.)  Here's how
  * it works:
  *
  * Every accessor of a repository's database takes out a shared lock
@@ -1666,7 +1666,7 @@ svn_repos_fs_type(svn_repos_t *repos,
  * there can be an unlimited number of shared locks simultaneously.
  *
  * Sometimes, a db access returns the error DB_RUN_RECOVERY.  When
- * this happens, we need to run svn_fs_recover() on the db
+ * this happens, we need to run svn_fs_recover2() on the db
  * with no other accessors present.  So we take out an exclusive lock
  * on the repository.  From the moment we request the exclusive lock,
  * no more shared locks are granted, and when the last shared lock
@@ -1678,8 +1678,9 @@ svn_repos_fs_type(svn_repos_t *repos,
  */
 
 svn_error_t *
-svn_repos_recover4(const char *path,
+svn_repos_recover5(const char *path,
                    svn_boolean_t nonblocking,
+                   apr_hash_t *fs_config,
                    svn_repos_notify_func_t notify_func,
                    void *notify_baton,
                    svn_cancel_func_t cancel_func,
@@ -1696,7 +1697,7 @@ svn_repos_recover4(const char *path,
      lock_repos.) */
   SVN_ERR(get_repos(&repos, path, TRUE, nonblocking,
                     FALSE,    /* don't try to open the db yet. */
-                    NULL,
+                    fs_config,
                     subpool, subpool));
 
   if (notify_func)
@@ -1712,7 +1713,8 @@ svn_repos_recover4(const char *path,
     }
 
   /* Recover the database to a consistent state. */
-  SVN_ERR(svn_fs_recover(repos->db_path, cancel_func, cancel_baton, subpool));
+  SVN_ERR(svn_fs_recover2(repos->db_path, fs_config, cancel_func,
+                          cancel_baton, subpool));
 
   /* Close shop and free the subpool, to release the exclusive lock. */
   svn_pool_destroy(subpool);
@@ -317,6 +317,28 @@ canonicalize(const char **canonical_path,
         return SVN_NO_ERROR;
     }
 
+  /* Most paths that we get are canonical already.  For those, a quick
+     check followed by a plain copy is much cheaper than the full walk.
+     Leave the special cases of Windows dirents to the code below. */
+  if (type != type_uri)
+    {
+      const char *relpart = path;
+
+#ifdef SVN_USE_DOS_PATHS
+      if (type == type_dirent)
+        relpart = NULL;
+#else
+      if (type == type_dirent && *relpart == '/')
+        relpart++;
+#endif /* SVN_USE_DOS_PATHS */
+
+      if (relpart && relpath_is_canonical(relpart))
+        {
+          *canonical_path = apr_pstrdup(pool, path);
+          return SVN_NO_ERROR;
+        }
+    }
+
   dst = canon = apr_pcalloc(pool, strlen(path) + 1);
 
   /* If this is supposed to be an URI, it should start with
@@ -1855,9 +1877,8 @@ svn_dirent_is_canonical(const char *dirent, apr_pool_t *scratch_pool)
 static svn_boolean_t
 relpath_is_canonical(const char *relpath)
 {
-  const char *dot_pos, *ptr = relpath;
-  apr_size_t i, len;
-  unsigned pattern = 0;
+  const char *dot_pos, *slash_pos, *ptr = relpath;
+  apr_size_t len;
 
   /* RELPATH is canonical if it has:
    *  - no '.' segments
@@ -1891,13 +1912,13 @@ relpath_is_canonical(const char *relpath)
     if (dot_pos > ptr && dot_pos[-1] == '/' && dot_pos[1] == '/')
       return FALSE;
 
-  /* Now validate the rest of the path. */
-  for (i = 0; i < len - 1; ++i)
-    {
-      pattern = ((pattern & 0xff) << 8) + (unsigned char)ptr[i];
-      if (pattern == 0x101 * (unsigned char)('/'))
-        return FALSE;
-    }
+  /* Now validate the rest of the path, i.e. look for "//".  Let memchr()
+   * skip over the segment names; it is much faster than a naive loop. */
+  for (slash_pos = memchr(ptr, '/', len);
+       slash_pos;
+       slash_pos = memchr(slash_pos + 1, '/', len - (slash_pos + 1 - ptr)))
+    if (slash_pos[1] == '/')
+      return FALSE;
 
   return TRUE;
 }
@@ -666,3 +666,216 @@ svn_hash__make(apr_pool_t *pool)
 {
   return apr_hash_make_custom(pool, hashfunc_compatible);
 }
+
+
+
+/*** Open-addressing hash tables ***/
+
+/* An entry in svn_hash__table_t. */
+typedef struct table_entry_t
+{
+  /* The key and its length.  KEY is NULL, if this entry has been
+   * removed.  We must not access the key memory in that case. */
+  const char *key;
+  apr_size_t klen;
+
+  /* The value.  NULL, if this entry has been removed. */
+  void *val;
+
+  /* Hash value of KEY. */
+  unsigned int hash;
+} table_entry_t;
+
+/* Index value marking an unused slot in svn_hash__table_t.  Other values
+ * are offsets into the ENTRIES array, plus 1. */
+#define EMPTY_SLOT 0
+
+struct svn_hash__table_t
+{
+  /* Entries in insertion order, including removed ones. */
+  table_entry_t *entries;
+
+  /* Number of elements in ENTRIES that have been used so far. */
+  apr_size_t entries_used;
+
+  /* Number of elements allocated for ENTRIES. */
+  apr_size_t entries_alloc;
+
+  /* Number of entries with non-NULL values. */
+  apr_size_t count;
+
+  /* Linear-probing index into ENTRIES.  Its size is a power of 2 and
+   * at least twice ENTRIES_ALLOC, i.e. at most half of it is in use. */
+  apr_uint32_t *slots;
+
+  /* Number of elements in SLOTS minus 1. */
+  apr_size_t slot_mask;
+
+  /* Pool to allocate ENTRIES and SLOTS from. */
+  apr_pool_t *pool;
+};
+
+/* Return a pointer into TABLE->SLOTS for the entry with the given KEY of
+ * length KLEN and hash value HASH.  If there is no such entry, return a
+ * pointer to the empty slot where it should be added. */
+static apr_uint32_t *
+find_slot(svn_hash__table_t *table,
+          const char *key,
+          apr_size_t klen,
+          unsigned int hash)
+{
+  apr_size_t i = hash & table->slot_mask;
+
+  while (table->slots[i] != EMPTY_SLOT)
+    {
+      const table_entry_t *entry = &table->entries[table->slots[i] - 1];
+      if (   entry->key
+          && entry->hash == hash
+          && entry->klen == klen
+          && memcmp(entry->key, key, klen) == 0)
+        break;
+
+      i = (i + 1) & table->slot_mask;
+    }
+
+  return &table->slots[i];
+}
+
+/* Re-allocate TABLE such that it can hold at least MIN_SIZE entries.
+ * Drop all removed entries. */
+static void
+grow_table(svn_hash__table_t *table,
+           apr_size_t min_size)
+{
+  table_entry_t *old_entries = table->entries;
+  apr_size_t old_used = table->entries_used;
+  apr_size_t slot_count = 16;
+  apr_size_t i;
+
+  while (slot_count < 2 * min_size)
+    slot_count *= 2;
+
+  table->entries_alloc = slot_count / 2;
+  table->entries = apr_palloc(table->pool,
+                              table->entries_alloc * sizeof(*table->entries));
+  table->slots = apr_pcalloc(table->pool,
+                             slot_count * sizeof(*table->slots));
+  table->slot_mask = slot_count - 1;
+  table->entries_used = 0;
+
+  /* Re-insert the remaining entries, keeping their order. */
+  for (i = 0; i < old_used; ++i)
+    if (old_entries[i].val)
+      {
+        table_entry_t *entry = &old_entries[i];
+        *find_slot(table, entry->key, entry->klen, entry->hash)
+          = (apr_uint32_t)(table->entries_used + 1);
+        table->entries[table->entries_used++] = *entry;
+      }
+}
+
+svn_hash__table_t *
+svn_hash__table_make(apr_size_t initial_size,
+                     apr_pool_t *result_pool)
+{
+  svn_hash__table_t *table = apr_pcalloc(result_pool, sizeof(*table));
+  table->pool = result_pool;
+  grow_table(table, initial_size);
+
+  return table;
+}
+
+apr_pool_t *
+svn_hash__table_pool_get(const svn_hash__table_t *table)
+{
+  return table->pool;
+}
+
+apr_size_t
+svn_hash__table_count(const svn_hash__table_t *table)
+{
+  return table->count;
+}
+
+void *
+svn_hash__table_get(svn_hash__table_t *table,
+                    const char *key,
+                    apr_size_t klen)
+{
+  apr_ssize_t len = (apr_ssize_t)klen;
+  unsigned int hash = hashfunc_compatible(key, &len);
+  apr_uint32_t slot = *find_slot(table, key, klen, hash);
+
+  return slot == EMPTY_SLOT ? NULL : table->entries[slot - 1].val;
+}
+
+void
+svn_hash__table_set(svn_hash__table_t *table,
+                    const char *key,
+                    apr_size_t klen,
+                    void *val)
+{
+  apr_ssize_t len = (apr_ssize_t)klen;
+  unsigned int hash = hashfunc_compatible(key, &len);
+  apr_uint32_t *slot = find_slot(table, key, klen, hash);
+  table_entry_t *entry;
+
+  /* Existing entry?  Update or remove it.  A removed entry keeps its
+     slot such that probing for other keys continues past it. */
+  if (*slot != EMPTY_SLOT)
+    {
+      entry = &table->entries[*slot - 1];
+      entry->val = val;
+      if (!val)
+        {
+          entry->key = NULL;
+          table->count--;
+        }
+
+      return;
+    }
+
+  /* Removing a non-existent entry is a no-op. */
+  if (!val)
+    return;
+
+  /* Make room for the new entry.  This invalidates SLOT. */
+  if (table->entries_used == table->entries_alloc)
+    {
+      grow_table(table, 2 * table->count + 1);
+      slot = find_slot(table, key, klen, hash);
+    }
+
+  entry = &table->entries[table->entries_used++];
+  entry->key = key;
+  entry->klen = klen;
+  entry->val = val;
+  entry->hash = hash;
+
+  *slot = (apr_uint32_t)table->entries_used;
+  table->count++;
+}
+
+void *
+svn_hash__table_next(const char **key,
+                     apr_size_t *klen,
+                     const svn_hash__table_t *table,
+                     apr_size_t *iter)
+{
+  for (; *iter < table->entries_used; ++*iter)
+    {
+      const table_entry_t *entry = &table->entries[*iter];
+      if (entry->val)
+        {
+          if (key)
+            *key = entry->key;
+          if (klen)
+            *klen = entry->klen;
+
+          ++*iter;
+          return entry->val;
+        }
+    }
+
+  return NULL;
+}
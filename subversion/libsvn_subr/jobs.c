@@ -0,0 +1,325 @@
+/* jobs.c --- worker threads with in-order results
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_thread_proc.h>
+#include <apr_time.h>
+
+#include "svn_pools.h"
+#include "svn_error.h"
+
+#include "private/svn_atomic.h"
+#include "private/svn_subr_private.h"
+
+#include "svn_private_config.h"
+
+/* Execute all jobs created by START_FUNC one after the other in the
+ * calling thread.  The parameters are the same as for svn__jobs_run().
+ */
+static svn_error_t *
+run_jobs_sequentially(svn__job_start_func_t start_func,
+                      svn__job_work_func_t work_func,
+                      svn__job_finish_func_t finish_func,
+                      void *baton,
+                      svn_cancel_func_t cancel_func,
+                      void *cancel_baton,
+                      apr_pool_t *scratch_pool)
+{
+  apr_pool_t *job_pool = svn_pool_create(scratch_pool);
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_error_t *err = SVN_NO_ERROR;
+
+  while (!err)
+    {
+      void *job;
+
+      svn_pool_clear(job_pool);
+      svn_pool_clear(iterpool);
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_ERR(start_func(&job, baton, job_pool, iterpool));
+      if (job == NULL)
+        break;
+
+      err = work_func(job, cancel_func, cancel_baton, job_pool, iterpool);
+      svn_pool_clear(iterpool);
+      err = finish_func(job, err, baton, iterpool);
+    }
+
+  svn_pool_destroy(iterpool);
+  svn_pool_destroy(job_pool);
+
+  return svn_error_trace(err);
+}
+
+#if APR_HAS_THREADS
+
+/* While waiting for a worker, call the caller's cancellation function
+ * at this interval (in microseconds). */
+#define CANCEL_POLL_INTERVAL 50000
+
+/* State shared by all workers of one svn__jobs_run() call. */
+typedef struct jobs_t
+{
+  /* Function executing the jobs. */
+  svn__job_work_func_t work_func;
+
+  /* Set by the calling thread to make all workers give up ASAP. */
+  volatile svn_atomic_t abort;
+} jobs_t;
+
+/* A job being executed by a worker thread. */
+typedef struct job_t
+{
+  /* Shared state. */
+  jobs_t *jobs;
+
+  /* The job object created by the start callback. */
+  void *job;
+
+  /* Outcome of the work callback. */
+  svn_error_t *result;
+
+  /* Set by the worker when RESULT is available. */
+  volatile svn_atomic_t done;
+
+  /* The worker thread. */
+  apr_thread_t *thread;
+
+  /* Root pool that contains everything above.  Only the worker touches
+     it while the thread is running. */
+  apr_pool_t *pool;
+} job_t;
+
+/* Implement svn_cancel_func_t for the workers.  BATON is a jobs_t. */
+static svn_error_t *
+check_abort(void *baton)
+{
+  jobs_t *jobs = baton;
+
+  if (svn_atomic_read(&jobs->abort))
+    return svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+
+  return SVN_NO_ERROR;
+}
+
+/* Thread entry point.  DATA is the job_t to execute. */
+static void * APR_THREAD_FUNC
+job_thread(apr_thread_t *tid,
+           void *data)
+{
+  job_t *job = data;
+  apr_pool_t *scratch_pool = svn_pool_create(job->pool);
+
+  job->result = job->jobs->work_func(job->job, check_abort, job->jobs,
+                                     job->pool, scratch_pool);
+  svn_pool_destroy(scratch_pool);
+  svn_atomic_set(&job->done, TRUE);
+
+  apr_thread_exit(tid, APR_SUCCESS);
+  return NULL;
+}
+
+/* Create the next job with START_FUNC and BATON and start a worker thread
+ * for it, using JOBS for the shared state.  Return the new job in *JOB_P
+ * or NULL if there is no more work.  Use SCRATCH_POOL for temporary
+ * allocations.
+ */
+static svn_error_t *
+start_job(job_t **job_p,
+          jobs_t *jobs,
+          svn__job_start_func_t start_func,
+          void *baton,
+          apr_pool_t *scratch_pool)
+{
+  apr_status_t status;
+  svn_error_t *err;
+
+  /* Each job lives in a root pool of its own, so it can be used by the
+     worker thread without synchronization. */
+  apr_pool_t *pool = svn_pool_create(NULL);
+  job_t *job = apr_pcalloc(pool, sizeof(*job));
+
+  job->jobs = jobs;
+  job->done = FALSE;
+  job->pool = pool;
+
+  err = start_func(&job->job, baton, pool, scratch_pool);
+  if (err || job->job == NULL)
+    {
+      svn_pool_destroy(pool);
+      *job_p = NULL;
+      return svn_error_trace(err);
+    }
+
+  status = apr_thread_create(&job->thread, NULL, job_thread, job, pool);
+  if (status)
+    {
+      svn_pool_destroy(pool);
+      return svn_error_wrap_apr(status, _("Can't create worker thread"));
+    }
+
+  *job_p = job;
+
+  return SVN_NO_ERROR;
+}
+
+/* Wait for the worker of JOB to finish.  Until then, call the optional
+ * CANCEL_FUNC with CANCEL_BATON periodically.  If that returns an error,
+ * tell all workers to stop and return the error after JOB's worker has
+ * finished.
+ */
+static svn_error_t *
+join_job(job_t *job,
+         svn_cancel_func_t cancel_func,
+         void *cancel_baton)
+{
+  apr_status_t thread_status;
+  apr_status_t status;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  if (cancel_func)
+    {
+      err = cancel_func(cancel_baton);
+      while (!err && !svn_atomic_read(&job->done))
+        {
+          apr_sleep(CANCEL_POLL_INTERVAL);
+          err = cancel_func(cancel_baton);
+        }
+
+      if (err)
+        svn_atomic_set(&job->jobs->abort, TRUE);
+    }
+
+  status = apr_thread_join(&thread_status, job->thread);
+  if (status)
+    err = svn_error_compose_create(err,
+                                   svn_error_wrap_apr(status,
+                                                      _("Can't join worker "
+                                                        "thread")));
+
+  return svn_error_trace(err);
+}
+
+/* Implement svn__jobs_run() for MAX_JOBS > 1 worker threads. */
+static svn_error_t *
+run_jobs_parallel(int max_jobs,
+                  svn__job_start_func_t start_func,
+                  svn__job_work_func_t work_func,
+                  svn__job_finish_func_t finish_func,
+                  void *baton,
+                  svn_cancel_func_t cancel_func,
+                  void *cancel_baton,
+                  apr_pool_t *scratch_pool)
+{
+  jobs_t *jobs = apr_pcalloc(scratch_pool, sizeof(*jobs));
+  job_t **running = apr_pcalloc(scratch_pool, max_jobs * sizeof(*running));
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_error_t *err = SVN_NO_ERROR;
+  svn_boolean_t exhausted = FALSE;
+  int first = 0;
+  int count = 0;
+
+  jobs->work_func = work_func;
+  jobs->abort = FALSE;
+
+  /* RUNNING is a ring buffer of up to MAX_JOBS running jobs in creation
+     order, starting at index FIRST. */
+  while (!err)
+    {
+      job_t *job;
+
+      svn_pool_clear(iterpool);
+
+      /* Keep all workers busy. */
+      while (!exhausted && count < max_jobs && !err)
+        {
+          err = start_job(&job, jobs, start_func, baton, iterpool);
+          if (!err && job)
+            running[(first + count++) % max_jobs] = job;
+          else if (!err)
+            exhausted = TRUE;
+        }
+
+      if (err || count == 0)
+        break;
+
+      /* Take the oldest job out of the ring buffer.  Later ones may
+         already have finished but have to wait for it. */
+      job = running[first];
+      first = (first + 1) % max_jobs;
+      --count;
+
+      err = join_job(job, cancel_func, cancel_baton);
+      if (err)
+        svn_error_clear(job->result);
+      else
+        err = finish_func(job->job, job->result, baton, iterpool);
+
+      svn_pool_destroy(job->pool);
+    }
+
+  /* On error, make the remaining jobs stop ASAP and dispose of them. */
+  if (err)
+    {
+      svn_atomic_set(&jobs->abort, TRUE);
+      for (; count > 0; --count, first = (first + 1) % max_jobs)
+        {
+          job_t *job = running[first];
+
+          svn_error_clear(join_job(job, NULL, NULL));
+          svn_error_clear(job->result);
+          svn_pool_destroy(job->pool);
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(err);
+}
+
+#endif
+
+svn_error_t *
+svn__jobs_run(int max_jobs,
+              svn__job_start_func_t start_func,
+              svn__job_work_func_t work_func,
+              svn__job_finish_func_t finish_func,
+              void *baton,
+              svn_cancel_func_t cancel_func,
+              void *cancel_baton,
+              apr_pool_t *scratch_pool)
+{
+#if APR_HAS_THREADS
+  if (max_jobs > 1)
+    return svn_error_trace(run_jobs_parallel(max_jobs, start_func,
+                                             work_func, finish_func, baton,
+                                             cancel_func, cancel_baton,
+                                             scratch_pool));
+#endif
+
+  return svn_error_trace(run_jobs_sequentially(start_func, work_func,
+                                               finish_func, baton,
+                                               cancel_func, cancel_baton,
+                                               scratch_pool));
+}
@@ -1082,6 +1082,273 @@ rangelist_merge(svn_rangelist_t *rl_out,
   return SVN_NO_ERROR;
 }
 
+/*** Compact rangelists ***/
+
+/* Return TRUE if RANGELIST consists of non-empty forward ranges in
+ * ascending order that do not overlap, i.e. if it can be converted into
+ * a svn_rangelist__compact_t.  If INHERITABLE_ONLY is set, also require
+ * all ranges to be inheritable. */
+static svn_boolean_t
+rangelist_is_compactable(const svn_rangelist_t *rangelist,
+                         svn_boolean_t inheritable_only)
+{
+  const svn_merge_range_t *const *ranges
+    = (const svn_merge_range_t *const *)rangelist->elts;
+  svn_revnum_t last_end = 0;
+  int i;
+
+  for (i = 0; i < rangelist->nelts; ++i)
+    {
+      if (   ranges[i]->start < last_end
+          || ranges[i]->start >= ranges[i]->end
+          || (inheritable_only && !ranges[i]->inheritable))
+        return FALSE;
+
+      last_end = ranges[i]->end;
+    }
+
+  return TRUE;
+}
+
+/* Return TRUE if the public rangelist operations may process RANGELIST
+ * in compact form.  That requires RANGELIST to be canonical, because the
+ * compact form combines adjacent ranges with the same inheritability.
+ * For canonical inputs, both implementations return the unique canonical
+ * rangelist of the same revisions.  If INHERITABLE_ONLY is set, also
+ * require all ranges to be inheritable. */
+static svn_boolean_t
+rangelist_takes_compact_path(const svn_rangelist_t *rangelist,
+                             svn_boolean_t inheritable_only)
+{
+  return svn_rangelist__is_canonical(rangelist)
+      && rangelist_is_compactable(rangelist, inheritable_only);
+}
+
+/* Return an empty compact rangelist with room for CAPACITY ranges,
+ * allocated in RESULT_POOL. */
+static svn_rangelist__compact_t *
+compact_create(int capacity,
+               apr_pool_t *result_pool)
+{
+  svn_rangelist__compact_t *result = apr_palloc(result_pool,
+                                                sizeof(*result));
+
+  /* Never hand out NULL arrays. */
+  capacity = MAX(capacity, 1);
+
+  result->nelts = 0;
+  result->start = apr_palloc(result_pool, capacity * sizeof(*result->start));
+  result->end = apr_palloc(result_pool, capacity * sizeof(*result->end));
+  result->inheritable = apr_palloc(result_pool,
+                                   capacity * sizeof(*result->inheritable));
+
+  return result;
+}
+
+/* Append the range START to END with INHERITABLE to RANGELIST.  Combine it
+ * with the last range in RANGELIST if they are adjacent and have the same
+ * inheritability.  START must not be before the end of the last range and
+ * RANGELIST must have room for another range. */
+static void
+compact_append(svn_rangelist__compact_t *rangelist,
+               svn_revnum_t start,
+               svn_revnum_t end,
+               svn_boolean_t inheritable)
+{
+  int last = rangelist->nelts - 1;
+
+  inheritable = inheritable ? TRUE : FALSE;
+  if (   last >= 0
+      && rangelist->end[last] == start
+      && rangelist->inheritable[last] == inheritable)
+    {
+      rangelist->end[last] = end;
+    }
+  else
+    {
+      rangelist->start[last + 1] = start;
+      rangelist->end[last + 1] = end;
+      rangelist->inheritable[last + 1] = inheritable;
+      rangelist->nelts++;
+    }
+}
+
+svn_rangelist__compact_t *
+svn_rangelist__compact(const svn_rangelist_t *rangelist,
+                       apr_pool_t *result_pool)
+{
+  svn_rangelist__compact_t *result;
+  int i;
+
+  if (!rangelist_is_compactable(rangelist, FALSE))
+    return NULL;
+
+  result = compact_create(rangelist->nelts, result_pool);
+  for (i = 0; i < rangelist->nelts; ++i)
+    {
+      const svn_merge_range_t *range
+        = APR_ARRAY_IDX(rangelist, i, const svn_merge_range_t *);
+      compact_append(result, range->start, range->end, range->inheritable);
+    }
+
+  return result;
+}
+
+svn_rangelist_t *
+svn_rangelist__from_compact(const svn_rangelist__compact_t *compact,
+                            apr_pool_t *result_pool)
+{
+  svn_rangelist_t *result = apr_array_make(result_pool, compact->nelts,
+                                           sizeof(svn_merge_range_t *));
+  svn_merge_range_t *ranges
+    = apr_palloc(result_pool, MAX(compact->nelts, 1) * sizeof(*ranges));
+  int i;
+
+  for (i = 0; i < compact->nelts; ++i)
+    {
+      ranges[i].start = compact->start[i];
+      ranges[i].end = compact->end[i];
+      ranges[i].inheritable = compact->inheritable[i];
+      APR_ARRAY_PUSH(result, svn_merge_range_t *) = &ranges[i];
+    }
+
+  return result;
+}
+
+svn_rangelist__compact_t *
+svn_rangelist__compact_merge(const svn_rangelist__compact_t *rangelist1,
+                             const svn_rangelist__compact_t *rangelist2,
+                             apr_pool_t *result_pool)
+{
+  /* Every range that we append ends at a start or end revision of some
+     input range and we never append the same revision twice. */
+  svn_rangelist__compact_t *result
+    = compact_create(2 * (rangelist1->nelts + rangelist2->nelts),
+                     result_pool);
+  svn_revnum_t pos = 0;
+  int i1 = 0, i2 = 0;
+
+  while (i1 < rangelist1->nelts || i2 < rangelist2->nelts)
+    {
+      svn_boolean_t have1, have2, inheritable;
+      svn_revnum_t start1, start2, start, end;
+
+      /* Skip ranges that lie completely before POS. */
+      if (i1 < rangelist1->nelts && rangelist1->end[i1] <= pos)
+        {
+          ++i1;
+          continue;
+        }
+      if (i2 < rangelist2->nelts && rangelist2->end[i2] <= pos)
+        {
+          ++i2;
+          continue;
+        }
+
+      /* The remainders of the current ranges start at START1 and
+         START2, respectively. */
+      have1 = i1 < rangelist1->nelts;
+      have2 = i2 < rangelist2->nelts;
+      start1 = have1 ? MAX(rangelist1->start[i1], pos) : 0;
+      start2 = have2 ? MAX(rangelist2->start[i2], pos) : 0;
+
+      /* Take the next revisions that have the same inheritability. */
+      if (have1 && have2 && start1 == start2)
+        {
+          start = start1;
+          end = MIN(rangelist1->end[i1], rangelist2->end[i2]);
+          inheritable = rangelist1->inheritable[i1]
+                     || rangelist2->inheritable[i2];
+        }
+      else if (have1 && (!have2 || start1 < start2))
+        {
+          start = start1;
+          end = have2 ? MIN(rangelist1->end[i1], start2)
+                      : rangelist1->end[i1];
+          inheritable = rangelist1->inheritable[i1];
+        }
+      else
+        {
+          start = start2;
+          end = have1 ? MIN(rangelist2->end[i2], start1)
+                      : rangelist2->end[i2];
+          inheritable = rangelist2->inheritable[i2];
+        }
+
+      compact_append(result, start, end, inheritable);
+      pos = end;
+    }
+
+  return result;
+}
+
+svn_rangelist__compact_t *
+svn_rangelist__compact_intersect(const svn_rangelist__compact_t *rangelist1,
+                                 const svn_rangelist__compact_t *rangelist2,
+                                 apr_pool_t *result_pool)
+{
+  /* Each iteration below appends at most one range. */
+  svn_rangelist__compact_t *result
+    = compact_create(rangelist1->nelts + rangelist2->nelts, result_pool);
+  int i1 = 0, i2 = 0;
+
+  while (i1 < rangelist1->nelts && i2 < rangelist2->nelts)
+    {
+      svn_revnum_t start = MAX(rangelist1->start[i1], rangelist2->start[i2]);
+      svn_revnum_t end = MIN(rangelist1->end[i1], rangelist2->end[i2]);
+
+      if (start < end)
+        compact_append(result, start, end,
+                       rangelist1->inheritable[i1]
+                       || rangelist2->inheritable[i2]);
+
+      /* The range that ends first can't overlap with any other range. */
+      if (rangelist1->end[i1] <= rangelist2->end[i2])
+        ++i1;
+      else
+        ++i2;
+    }
+
+  return result;
+}
+
+svn_rangelist__compact_t *
+svn_rangelist__compact_remove(const svn_rangelist__compact_t *eraser,
+                              const svn_rangelist__compact_t *whiteboard,
+                              apr_pool_t *result_pool)
+{
+  /* Every WHITEBOARD range gets cut into one piece more than there are
+     ERASER ranges overlapping it.  There are less than
+     WHITEBOARD->NELTS + ERASER->NELTS such overlaps in total. */
+  svn_rangelist__compact_t *result
+    = compact_create(2 * whiteboard->nelts + eraser->nelts, result_pool);
+  int i, k, first = 0;
+
+  for (i = 0; i < whiteboard->nelts; ++i)
+    {
+      svn_revnum_t pos = whiteboard->start[i];
+      svn_revnum_t end = whiteboard->end[i];
+
+      /* Skip erasers that end before this range. */
+      while (first < eraser->nelts && eraser->end[first] <= pos)
+        ++first;
+
+      /* Keep the parts between the overlapping erasers. */
+      for (k = first; k < eraser->nelts && eraser->start[k] < end; ++k)
+        {
+          if (eraser->start[k] > pos)
+            compact_append(result, pos, eraser->start[k],
+                           whiteboard->inheritable[i]);
+          pos = eraser->end[k];
+        }
+
+      if (pos < end)
+        compact_append(result, pos, end, whiteboard->inheritable[i]);
+    }
+
+  return result;
+}
+
 svn_error_t *
 svn_rangelist_merge2(svn_rangelist_t *rangelist,
                      const svn_rangelist_t *chg,
@@ -1096,6 +1363,23 @@ svn_rangelist_merge2(svn_rangelist_t *rangelist,
   SVN_ERR_ASSERT(rangelist_is_sorted(chg));
 #endif
 
+  /* Merging in compact form avoids allocating every range separately. */
+  if (   rangelist_takes_compact_path(rangelist, FALSE)
+      && rangelist_takes_compact_path(chg, FALSE))
+    {
+      svn_rangelist__compact_t *merged
+        = svn_rangelist__compact_merge(
+            svn_rangelist__compact(rangelist, scratch_pool),
+            svn_rangelist__compact(chg, scratch_pool),
+            scratch_pool);
+
+      apr_array_clear(rangelist);
+      apr_array_cat(rangelist,
+                    svn_rangelist__from_compact(merged, result_pool));
+
+      return SVN_NO_ERROR;
+    }
+
   /* Move the original rangelist aside. A shallow copy suffices,
    * as rangelist_merge() won't modify its inputs. */
   rangelist_orig = apr_array_copy(scratch_pool, rangelist);
@@ -1453,6 +1737,20 @@ svn_rangelist_intersect(svn_rangelist_t **output,
                         svn_boolean_t consider_inheritance,
                         apr_pool_t *pool)
 {
+  /* Without non-inheritable ranges, inheritance makes no difference and
+     the compact intersection gives the same result. */
+  if (   rangelist_takes_compact_path(rangelist1, TRUE)
+      && rangelist_takes_compact_path(rangelist2, TRUE))
+    {
+      *output = svn_rangelist__from_compact(
+                  svn_rangelist__compact_intersect(
+                    svn_rangelist__compact(rangelist1, pool),
+                    svn_rangelist__compact(rangelist2, pool),
+                    pool),
+                  pool);
+      return SVN_NO_ERROR;
+    }
+
   return rangelist_intersect_or_remove(output, rangelist1, rangelist2, FALSE,
                                        consider_inheritance, pool);
 }
@@ -1464,6 +1762,19 @@ svn_rangelist_remove(svn_rangelist_t **output,
                      svn_boolean_t consider_inheritance,
                      apr_pool_t *pool)
 {
+  /* Same as in svn_rangelist_intersect(). */
+  if (   rangelist_takes_compact_path(eraser, TRUE)
+      && rangelist_takes_compact_path(whiteboard, TRUE))
+    {
+      *output = svn_rangelist__from_compact(
+                  svn_rangelist__compact_remove(
+                    svn_rangelist__compact(eraser, pool),
+                    svn_rangelist__compact(whiteboard, pool),
+                    pool),
+                  pool);
+      return SVN_NO_ERROR;
+    }
+
   return rangelist_intersect_or_remove(output, eraser, whiteboard, TRUE,
                                        consider_inheritance, pool);
 }
@@ -2594,16 +2905,60 @@ svn_rangelist__merge_many(svn_rangelist_t *merged_rangelist,
     {
       apr_pool_t *iterpool = svn_pool_create(scratch_pool);
       apr_hash_index_t *hi;
+      svn_boolean_t compactable
+        = rangelist_takes_compact_path(merged_rangelist, FALSE);
 
       for (hi = apr_hash_first(scratch_pool, merge_history);
-           hi;
+           hi && compactable;
            hi = apr_hash_next(hi))
+        compactable = rangelist_takes_compact_path(apr_hash_this_val(hi),
+                                                   FALSE);
+
+      if (compactable)
         {
-          svn_rangelist_t *subtree_rangelist = apr_hash_this_val(hi);
+          /* Accumulate the result in compact form and convert it only
+             once at the end.  Intermediate results live in alternating
+             pools. */
+          apr_pool_t *merged_pool = svn_pool_create(scratch_pool);
+          svn_rangelist__compact_t *merged
+            = svn_rangelist__compact(merged_rangelist, merged_pool);
+
+          for (hi = apr_hash_first(scratch_pool, merge_history);
+               hi;
+               hi = apr_hash_next(hi))
+            {
+              svn_rangelist_t *subtree_rangelist = apr_hash_this_val(hi);
+              apr_pool_t *swap;
+
+              svn_pool_clear(iterpool);
+              merged = svn_rangelist__compact_merge(
+                         merged,
+                         svn_rangelist__compact(subtree_rangelist, iterpool),
+                         iterpool);
+
+              swap = merged_pool;
+              merged_pool = iterpool;
+              iterpool = swap;
+            }
 
-          svn_pool_clear(iterpool);
-          SVN_ERR(svn_rangelist_merge2(merged_rangelist, subtree_rangelist,
-                                       result_pool, iterpool));
+          apr_array_clear(merged_rangelist);
+          apr_array_cat(merged_rangelist,
+                        svn_rangelist__from_compact(merged, result_pool));
+          svn_pool_destroy(merged_pool);
+        }
+      else
+        {
+          for (hi = apr_hash_first(scratch_pool, merge_history);
+               hi;
+               hi = apr_hash_next(hi))
+            {
+              svn_rangelist_t *subtree_rangelist = apr_hash_this_val(hi);
+
+              svn_pool_clear(iterpool);
+              SVN_ERR(svn_rangelist_merge2(merged_rangelist,
+                                           subtree_rangelist,
+                                           result_pool, iterpool));
+            }
         }
       svn_pool_destroy(iterpool);
     }
@@ -74,6 +74,11 @@ struct svn_spillbuf_t {
   /* How much content remains in SPILL.  */
   svn_filesize_t spill_size;
 
+  /* The offset of SPILL's file pointer as left by our last read or write,
+     or -1 if unknown.  Seeking a buffered APR file flushes its buffer, so
+     we only seek when this differs from the position we need.  */
+  apr_off_t spill_pos;
+
   /* When false, do not delete the spill file when it is closed. */
   svn_boolean_t delete_on_close;
 
@@ -129,6 +134,7 @@ init_spillbuf_extended(svn_spillbuf_t *buf,
   buf->delete_on_close = delete_on_close;
   buf->spill_all_contents = spill_all_contents;
   buf->dirpath = dirpath;
+  buf->spill_pos = -1;
 }
 
 /* Common constructor for initializing spillbufs.
@@ -195,7 +201,9 @@ svn_spillbuf__get_file(const svn_spillbuf_t *buf)
 }
 
 /* Get a memblock from the spill-buffer. It will be the block that we
-   passed out for reading, come from the free list, or allocated.  */
+   passed out for reading, come from the free list, or allocated.  Newly
+   allocated blocks carry their data in the same pool allocation, right
+   behind the header.  */
 static struct memblock_t *
 get_buffer(svn_spillbuf_t *buf)
 {
@@ -209,8 +217,8 @@ get_buffer(svn_spillbuf_t *buf)
 
   if (buf->avail == NULL)
     {
-      mem = apr_palloc(buf->pool, sizeof(*mem));
-      mem->data = apr_palloc(buf->pool, buf->blocksize);
+      mem = apr_palloc(buf->pool, sizeof(*mem) + buf->blocksize);
+      mem->data = (char *)(mem + 1);
       return mem;
     }
 
@@ -271,6 +279,9 @@ svn_spillbuf__write(svn_spillbuf_t *buf,
              data from the file. */
           buf->spill_start = buf->memory_size;
         }
+
+      /* The file pointer sits right behind whatever we just wrote.  */
+      buf->spill_pos = buf->spill_start;
     }
 
   /* Once a spill file has been constructed, then we need to put all
@@ -278,17 +289,26 @@ svn_spillbuf__write(svn_spillbuf_t *buf,
      in memory.  */
   if (buf->spill != NULL)
     {
-      apr_off_t output_unused = 0;  /* ### stupid API  */
+      apr_off_t spill_end = buf->spill_start + buf->spill_size;
 
-      /* Seek to the end of the spill file. We don't know if a read has
-         occurred since our last write, and moved the file position.  */
-      SVN_ERR(svn_io_file_seek(buf->spill,
-                               APR_END, &output_unused,
-                               scratch_pool));
+      /* Seek to the end of the spill file, unless a read has moved the
+         file position since our last write.  Consecutive writes thus
+         stay within APR's write buffer.  */
+      if (buf->spill_pos != spill_end)
+        {
+          apr_off_t output_unused = 0;  /* ### stupid API  */
 
+          SVN_ERR(svn_io_file_seek(buf->spill,
+                                   APR_END, &output_unused,
+                                   scratch_pool));
+        }
+
+      /* Should the write fail, we don't know where the pointer ends up. */
+      buf->spill_pos = -1;
       SVN_ERR(svn_io_file_write_full(buf->spill, data, len,
                                      NULL, scratch_pool));
       buf->spill_size += len;
+      buf->spill_pos = spill_end + len;
 
       return SVN_NO_ERROR;
     }
@@ -395,12 +415,14 @@ read_data(struct memblock_t **mem,
                          scratch_pool);
   if (err)
     {
+      buf->spill_pos = -1;
       return_buffer(buf, *mem);
       return svn_error_trace(err);
     }
 
   /* Mark the data that we consumed from the spill file.  */
   buf->spill_start += (*mem)->size;
+  buf->spill_pos = buf->spill_start;
 
   /* Did we consume all the data from the spill file?  */
   if ((buf->spill_size -= (*mem)->size) == 0)
@@ -409,6 +431,7 @@ read_data(struct memblock_t **mem,
       SVN_ERR(svn_io_file_close(buf->spill, scratch_pool));
       buf->spill = NULL;
       buf->spill_start = 0;
+      buf->spill_pos = -1;
     }
 
   /* *mem has been initialized. Done.  */
@@ -417,21 +440,28 @@ read_data(struct memblock_t **mem,
 
 
 /* If the next read would consume data from the file, then seek to the
-   correct position.  */
+   correct position.  Skip the seek if the file pointer is already there,
+   e.g. because the previous operation was a read as well.  */
 static svn_error_t *
 maybe_seek(svn_boolean_t *seeked,
-           const svn_spillbuf_t *buf,
+           svn_spillbuf_t *buf,
            apr_pool_t *scratch_pool)
 {
   if (buf->head == NULL && buf->spill != NULL)
     {
-      apr_off_t output_unused;
+      if (buf->spill_pos != buf->spill_start)
+        {
+          apr_off_t output_unused;
+
+          /* Seek to where we left off reading.  */
+          output_unused = buf->spill_start;  /* ### stupid API  */
+          buf->spill_pos = -1;
+          SVN_ERR(svn_io_file_seek(buf->spill,
+                                   APR_SET, &output_unused,
+                                   scratch_pool));
+          buf->spill_pos = buf->spill_start;
+        }
 
-      /* Seek to where we left off reading.  */
-      output_unused = buf->spill_start;  /* ### stupid API  */
-      SVN_ERR(svn_io_file_seek(buf->spill,
-                               APR_SET, &output_unused,
-                               scratch_pool));
       if (seeked != NULL)
         *seeked = TRUE;
     }
@@ -981,6 +981,60 @@ eol_unchanged(struct translation_baton *b,
 }
 
 
+/* Word-sized pattern of '$' bytes, used by find_interesting(). */
+#if APR_SIZEOF_VOIDP == 8
+#  define DOLLAR_MASK 0x2424242424242424
+#else
+#  define DOLLAR_MASK 0x24242424
+#endif
+
+/* Return a pointer to the first character in [P, END) that INTERESTING
+ * flags as starting a translation action, or END if there is none.
+ * The only characters that may be flagged are '$' and - if EOLS_ARE_
+ * INTERESTING is set - CR and LF.
+ *
+ * Where possible, this scans the input one machine word at a time,
+ * similar to svn_eol__find_eol_start().
+ */
+static const char *
+find_interesting(const char *interesting,
+                 svn_boolean_t eols_are_interesting,
+                 const char *p,
+                 const char *end)
+{
+#if SVN_UNALIGNED_ACCESS_IS_OK
+  for (; end - p > (apr_ssize_t)sizeof(apr_uintptr_t)
+       ; p += sizeof(apr_uintptr_t))
+    {
+      apr_uintptr_t chunk = *(const apr_uintptr_t *)p;
+
+      /* A byte in D_TEST is < 0x80, iff it was '$' in *P. */
+      apr_uintptr_t d_test = chunk ^ DOLLAR_MASK;
+      d_test |= (d_test & SVN__LOWER_7BITS_SET) + SVN__LOWER_7BITS_SET;
+
+      if (eols_are_interesting)
+        {
+          /* Same for \r and \n, see svn_eol__find_eol_start(). */
+          apr_uintptr_t r_test = chunk ^ SVN__R_MASK;
+          apr_uintptr_t n_test = chunk ^ SVN__N_MASK;
+
+          r_test |= (r_test & SVN__LOWER_7BITS_SET) + SVN__LOWER_7BITS_SET;
+          n_test |= (n_test & SVN__LOWER_7BITS_SET) + SVN__LOWER_7BITS_SET;
+          d_test &= r_test & n_test;
+        }
+
+      if ((d_test & SVN__BIT_7_SET) != SVN__BIT_7_SET)
+        break;
+    }
+#endif
+
+  /* Find the exact position within the last word, or in the odd bytes. */
+  while (p < end && !interesting[(unsigned char)*p])
+    ++p;
+
+  return p;
+}
+
 /* Translate eols and keywords of a 'chunk' of characters BUF of size BUFLEN
  * according to the settings and state stored in baton B.
  *
@@ -1004,6 +1058,12 @@ translate_chunk(svn_stream_t *dst,
   const char *p;
   apr_size_t len;
 
+  /* Without EOL and keyword translation, there is nothing to do but to
+     pass the data through.  No state can have been buffered either. */
+  if (!b->eol_str && !b->keywords)
+    return buf ? svn_error_trace(translate_write(dst, buf, buflen))
+               : SVN_NO_ERROR;
+
   if (buf)
     {
       /* precalculate some oft-used values */
@@ -1125,24 +1185,10 @@ translate_chunk(svn_stream_t *dst,
 
               if (b->keywords)
                 {
-                  /* Check 4 bytes at once to allow for efficient pipelining
-                    and to reduce loop condition overhead. */
-                  while ((end - p) >= (len + 4))
-                    {
-                      if (interesting[(unsigned char)p[len]]
-                          || interesting[(unsigned char)p[len+1]]
-                          || interesting[(unsigned char)p[len+2]]
-                          || interesting[(unsigned char)p[len+3]])
-                        break;
-
-                      len += 4;
-                    }
-
-                  /* Found an interesting char or EOF in the next 4 bytes.
-                     Find its exact position. */
-                  while ((p + len) < end
-                         && !interesting[(unsigned char)p[len]])
-                    ++len;
+                  /* Skip to the next '$' or EOL (or to EOF). */
+                  const char *start = p + len;
+                  len += find_interesting(interesting, b->eol_str != NULL,
+                                          start, end) - start;
                 }
               else
                 {
@@ -79,6 +79,9 @@ typedef struct xlate_handle_node_t {
   /* FALSE if the handle is not valid, since its pool is being
      destroyed. */
   svn_boolean_t valid;
+  /* TRUE if HANDLE maps all 7-bit ASCII characters onto themselves,
+     i.e. pure ASCII strings can simply be copied. */
+  svn_boolean_t ascii_transparent;
   /* The name of a char encoding or APR_LOCALE_CHARSET. */
   const char *frompage, *topage;
   struct xlate_handle_node_t *next;
@@ -199,6 +202,41 @@ atomic_swap(void * volatile * mem, void *new_value)
 #endif
 }
 
+static svn_error_t *
+convert_to_stringbuf(xlate_handle_node_t *node,
+                     const char *src_data,
+                     apr_size_t src_length,
+                     svn_stringbuf_t **dest,
+                     apr_pool_t *pool);
+
+/* Return TRUE if NODE->handle converts every 7-bit ASCII character to
+   itself.  That holds for nearly all encodings in practical use but,
+   e.g., not for EBCDIC or some variants of Shift-JIS.  Use SCRATCH_POOL
+   for temporary allocations. */
+static svn_boolean_t
+is_ascii_transparent(xlate_handle_node_t *node,
+                     apr_pool_t *scratch_pool)
+{
+  char ascii[127];
+  svn_stringbuf_t *result;
+  svn_error_t *err;
+  apr_size_t i;
+
+  for (i = 0; i < sizeof(ascii); ++i)
+    ascii[i] = (char)(i + 1);
+
+  err = convert_to_stringbuf(node, ascii, sizeof(ascii), &result,
+                             scratch_pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      return FALSE;
+    }
+
+  return result->len == sizeof(ascii)
+      && memcmp(result->data, ascii, sizeof(ascii)) == 0;
+}
+
 /* Set *RET to a newly created handle node for converting from FROMPAGE
    to TOPAGE, If apr_xlate_open() returns APR_EINVAL or APR_ENOTIMPL, set
    (*RET)->handle to NULL.  If fail for any other reason, return the error.
@@ -264,6 +302,7 @@ xlate_alloc_handle(xlate_handle_node_t **ret,
   *ret = apr_palloc(pool, sizeof(xlate_handle_node_t));
   (*ret)->handle = handle;
   (*ret)->valid = TRUE;
+  (*ret)->ascii_transparent = FALSE;
   (*ret)->frompage = ((frompage != SVN_APR_LOCALE_CHARSET)
                       ? apr_pstrdup(pool, frompage) : frompage);
   (*ret)->topage = ((topage != SVN_APR_LOCALE_CHARSET)
@@ -276,8 +315,16 @@ xlate_alloc_handle(xlate_handle_node_t **ret,
      To prevent this, we register a cleanup handler that will reset the valid
      flag of our node, so we don't use an invalid handle. */
   if (handle)
-    apr_pool_cleanup_register(pool, *ret, xlate_handle_node_cleanup,
-                              apr_pool_cleanup_null);
+    {
+      apr_pool_t *scratch_pool = svn_pool_create(pool);
+
+      apr_pool_cleanup_register(pool, *ret, xlate_handle_node_cleanup,
+                                apr_pool_cleanup_null);
+
+      /* Find out once whether we may bypass the handle for ASCII data. */
+      (*ret)->ascii_transparent = is_ascii_transparent(*ret, scratch_pool);
+      svn_pool_destroy(scratch_pool);
+    }
 
   return SVN_NO_ERROR;
 }
@@ -489,15 +536,25 @@ convert_to_stringbuf(xlate_handle_node_t *node,
 {
 #ifdef WIN32
   apr_status_t apr_err;
-
-  apr_err = svn_subr__win32_xlate_to_stringbuf(node->handle, src_data,
-                                               src_length, dest, pool);
 #else
   apr_size_t buflen = src_length * 2;
   apr_status_t apr_err;
   apr_size_t srclen = src_length;
   apr_size_t destlen = buflen;
+#endif
 
+  /* Most paths and log messages are plain ASCII.  Don't bother the
+     converter with them if it would not change them anyway. */
+  if (node->ascii_transparent && svn_utf__is_ascii(src_data, src_length))
+    {
+      *dest = svn_stringbuf_ncreate(src_data, src_length, pool);
+      return SVN_NO_ERROR;
+    }
+
+#ifdef WIN32
+  apr_err = svn_subr__win32_xlate_to_stringbuf(node->handle, src_data,
+                                               src_length, dest, pool);
+#else
   /* Initialize *DEST to an empty stringbuf.
      A 1:2 ratio of input bytes to output bytes (as assigned above)
      should be enough for most translations, and if it turns out not
@@ -320,10 +320,23 @@ svn_utf__is_valid(const char *data, apr_size_t len)
       unsigned char octet = *data++;
       int category = octet_category[octet];
       state = machine[state][category];
+
+      /* Mostly-ASCII data is common.  Skip ASCII runs following a
+       * multi-byte char quickly and bail out on the first error. */
+      if (state == FSM_START)
+        data = first_non_fsm_start_char(data, end - data);
+      else if (state == FSM_ERROR)
+        return FALSE;
     }
   return state == FSM_START;
 }
 
+svn_boolean_t
+svn_utf__is_ascii(const char *data, apr_size_t len)
+{
+  return first_non_fsm_start_char(data, len) == data + len;
+}
+
 const char *
 svn_utf__last_valid2(const char *data, apr_size_t len)
 {
@@ -48,6 +48,7 @@
 #include "props.h"
 
 #include "private/svn_sorts_private.h"
+#include "private/svn_subr_private.h"
 #include "private/svn_wc_private.h"
 #include "private/svn_fspath.h"
 #include "private/svn_editor.h"
@@ -199,9 +200,9 @@ struct dir_baton
   svn_boolean_t text_changed;
 
   /* Working copy status structures for children of this directory.
-     This hash maps const char * abspaths  to svn_wc_status3_t *
+     This table maps const char * abspaths  to svn_wc_status3_t *
      status items. */
-  apr_hash_t *statii;
+  svn_hash__table_t *statii;
 
   /* The pool in which this baton itself is allocated. */
   apr_pool_t *pool;
@@ -1470,17 +1471,17 @@ get_child_status(const struct walk_status_baton *wb,
 
 /*** Helpers ***/
 
-/* A faux status callback function for stashing STATUS item in an hash
-   (which is the BATON), keyed on PATH.  This implements the
-   svn_wc_status_func4_t interface. */
+/* A faux status callback function for stashing STATUS item in a
+   svn_hash__table_t (which is the BATON), keyed on PATH.  This implements
+   the svn_wc_status_func4_t interface. */
 static svn_error_t *
 hash_stash(void *baton,
            const char *path,
            const svn_wc_status3_t *status,
            apr_pool_t *scratch_pool)
 {
-  apr_hash_t *stat_hash = baton;
-  apr_pool_t *hash_pool = apr_hash_pool_get(stat_hash);
+  svn_hash__table_t *stat_hash = baton;
+  apr_pool_t *hash_pool = svn_hash__table_pool_get(stat_hash);
   void *new_status = svn_wc_dup_status3(status, hash_pool);
   const svn_wc__internal_status_t *old_status = (const void*)status;
 
@@ -1489,8 +1490,8 @@ hash_stash(void *baton,
   is->has_descendants = old_status->has_descendants;
   is->op_root = old_status->op_root;
 
-  assert(! svn_hash_gets(stat_hash, path));
-  svn_hash_sets(stat_hash, apr_pstrdup(hash_pool, path), new_status);
+  assert(! svn_hash__table_gets(stat_hash, path));
+  svn_hash__table_sets(stat_hash, apr_pstrdup(hash_pool, path), new_status);
 
   return SVN_NO_ERROR;
 }
@@ -1541,16 +1542,16 @@ tweak_statushash(void *baton,
 {
   svn_wc_status3_t *statstruct;
   apr_pool_t *pool;
-  apr_hash_t *statushash;
+  svn_hash__table_t *statushash;
 
   if (is_dir_baton)
     statushash = ((struct dir_baton *) baton)->statii;
   else
     statushash = ((struct file_baton *) baton)->dir_baton->statii;
-  pool = apr_hash_pool_get(statushash);
+  pool = svn_hash__table_pool_get(statushash);
 
   /* Is PATH already a hash-key? */
-  statstruct = svn_hash_gets(statushash, local_abspath);
+  statstruct = svn_hash__table_gets(statushash, local_abspath);
 
   /* If not, make it so. */
   if (! statstruct)
@@ -1575,7 +1576,8 @@ tweak_statushash(void *baton,
                               check_working_copy, pool, scratch_pool));
       statstruct = &i_stat->s;
       statstruct->repos_lock = repos_lock;
-      svn_hash_sets(statushash, apr_pstrdup(pool, local_abspath), statstruct);
+      svn_hash__table_sets(statushash, apr_pstrdup(pool, local_abspath),
+                           statstruct);
     }
 
   /* Merge a repos "delete" + "add" into a single "replace". */
@@ -1677,8 +1679,8 @@ find_dir_repos_relpath(const struct dir_baton *db, apr_pool_t *pool)
     {
       const char *repos_relpath;
       struct dir_baton *pb = db->parent_baton;
-      const svn_wc_status3_t *status = svn_hash_gets(pb->statii,
-                                                     db->local_abspath);
+      const svn_wc_status3_t *status = svn_hash__table_gets(pb->statii,
+                                                            db->local_abspath);
       /* Note that status->repos_relpath could be NULL in the case of a missing
        * directory, which means we need to recurse up another level to get
        * a useful relpath. */
@@ -1728,7 +1730,7 @@ make_dir_baton(void **dir_baton,
   d->name = path ? svn_dirent_basename(path, dir_pool) : NULL;
   d->edit_baton = edit_baton;
   d->parent_baton = parent_baton;
-  d->statii = apr_hash_make(dir_pool);
+  d->statii = svn_hash__table_make(16, dir_pool);
   d->ood_changed_rev = SVN_INVALID_REVNUM;
   d->ood_changed_date = 0;
   d->repos_relpath = find_dir_repos_relpath(d, dir_pool);
@@ -1758,7 +1760,7 @@ make_dir_baton(void **dir_baton,
   /* Get the status for this path's children.  Of course, we only want
      to do this if the path is versioned as a directory. */
   if (pb)
-    status_in_parent = svn_hash_gets(pb->statii, d->local_abspath);
+    status_in_parent = svn_hash__table_gets(pb->statii, d->local_abspath);
   else
     status_in_parent = eb->anchor_status;
 
@@ -1789,7 +1791,7 @@ make_dir_baton(void **dir_baton,
                              dir_pool));
 
       /* If we found a depth here, it should govern. */
-      this_dir_status = svn_hash_gets(d->statii, d->local_abspath);
+      this_dir_status = svn_hash__table_gets(d->statii, d->local_abspath);
       if (this_dir_status && this_dir_status->versioned
           && (d->depth == svn_depth_unknown
               || d->depth > status_in_parent->s.depth))
@@ -1930,13 +1932,15 @@ handle_statii(struct edit_baton *eb,
               const char *dir_repos_root_url,
               const char *dir_repos_relpath,
               const char *dir_repos_uuid,
-              apr_hash_t *statii,
+              svn_hash__table_t *statii,
               svn_boolean_t dir_was_deleted,
               svn_depth_t depth,
               apr_pool_t *pool)
 {
   const apr_array_header_t *ignores = eb->ignores;
-  apr_hash_index_t *hi;
+  apr_size_t iter = 0;
+  const char *local_abspath;
+  svn_wc__internal_status_t *status;
   apr_pool_t *iterpool = svn_pool_create(pool);
   svn_wc_status_func4_t status_func = eb->status_func;
   void *status_baton = eb->status_baton;
@@ -1951,11 +1955,8 @@ handle_statii(struct edit_baton *eb,
     }
 
   /* Loop over all the statii still in our hash, handling each one. */
-  for (hi = apr_hash_first(pool, statii); hi; hi = apr_hash_next(hi))
+  while ((status = svn_hash__table_next(&local_abspath, NULL, statii, &iter)))
     {
-      const char *local_abspath = apr_hash_this_key(hi);
-      svn_wc__internal_status_t *status = apr_hash_this_val(hi);
-
       /* Clear the subpool. */
       svn_pool_clear(iterpool);
 
@@ -2203,7 +2204,7 @@ close_directory(void *dir_baton,
       svn_wc__internal_status_t *dir_status;
 
       /* See if the directory was deleted or replaced. */
-      dir_status = svn_hash_gets(pb->statii, db->local_abspath);
+      dir_status = svn_hash__table_gets(pb->statii, db->local_abspath);
       if (dir_status &&
           ((dir_status->s.repos_node_status == svn_wc_status_deleted)
            || (dir_status->s.repos_node_status == svn_wc_status_replaced)))
@@ -2219,7 +2220,7 @@ close_directory(void *dir_baton,
                                            eb->get_all))
         SVN_ERR((eb->status_func)(eb->status_baton, db->local_abspath,
                                   &dir_status->s, scratch_pool));
-      svn_hash_sets(pb->statii, db->local_abspath, NULL);
+      svn_hash__table_sets(pb->statii, db->local_abspath, NULL);
     }
   else if (! pb)
     {
@@ -2229,7 +2230,7 @@ close_directory(void *dir_baton,
         {
           const svn_wc__internal_status_t *tgt_status;
 
-          tgt_status = svn_hash_gets(db->statii, eb->target_abspath);
+          tgt_status = svn_hash__table_gets(db->statii, eb->target_abspath);
           if (tgt_status)
             {
               if (tgt_status->has_descendants)
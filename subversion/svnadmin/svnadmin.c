@@ -159,7 +159,8 @@ enum svnadmin__cmdline_options_t
     svnadmin__normalize_props,
     svnadmin__exclude,
     svnadmin__include,
-    svnadmin__glob
+    svnadmin__glob,
+    svnadmin__jobs
   };
 
 /* Option codes and descriptions.
@@ -292,6 +293,11 @@ static const apr_getopt_option_t options_table[] =
     {"include", svnadmin__include, 1,
      N_("filter out nodes without given prefix(es) from dump")},
 
+    {"jobs", svnadmin__jobs, 1,
+     N_("use ARG worker threads to process independent\n"
+        "                             revision ranges concurrently. Default: 1.\n"
+        "                             [used for FSFS and FSX repositories only]")},
+
     {"pattern", svnadmin__glob, 0,
      N_("treat the path prefixes as file glob patterns.\n"
         "                             Glob special characters are '*' '?' '[]' and '\\'.\n"
@@ -315,7 +321,7 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
     "If no revision arguments are given, process all revisions. If only\n"
     "LOWER revision argument is given, process only that single revision.\n"
    )},
-   {'r', 'q', 'M'} },
+   {'r', 'q', 'M', svnadmin__jobs} },
 
   {"crashtest", subcommand_crashtest, {0}, {N_(
     "usage: svnadmin crashtest REPOS_PATH\n"
@@ -529,8 +535,11 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
     "been getting errors indicating that recovery ought to be run.\n"
     "Berkeley DB recovery requires exclusive access and will\n"
     "exit if the repository is in use by another process.\n"
+    "\n"
+    "FSFS repositories created by Subversion 1.4 or earlier need to\n"
+    "scan all revisions; use --jobs to scan several ranges concurrently.\n"
    )},
-   {svnadmin__wait} },
+   {svnadmin__wait, svnadmin__jobs} },
 
   {"rev-size", subcommand_rev_size, {0}, {N_(
     "usage: svnadmin rev-size REPOS_PATH -r REVISION\n"
@@ -630,7 +639,8 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
     "Verify the data stored in the repository.\n"
    )},
    {'t', 'r', 'q', svnadmin__keep_going, 'M',
-    svnadmin__check_normalization, svnadmin__metadata_only} },
+    svnadmin__check_normalization, svnadmin__metadata_only,
+    svnadmin__jobs} },
 
   { NULL, NULL, {0}, {NULL}, {0} }
 };
@@ -673,6 +683,7 @@ struct svnadmin_opt_state
   apr_array_header_t *exclude;                      /* --exclude */
   apr_array_header_t *include;                      /* --include */
   svn_boolean_t glob;                               /* --pattern */
+  int jobs;                                         /* --jobs */
 
   const char *config_dir;    /* Overriding Configuration Directory */
 };
@@ -1015,7 +1026,7 @@ struct repos_verify_callback_baton
 };
 
 /* Implementation of svn_repos_verify_callback_t to handle errors coming
-   from svn_repos_verify_fs3(). */
+   from svn_repos_verify_fs4(). */
 static svn_error_t *
 repos_verify_callback(void *baton,
                       svn_revnum_t revision,
@@ -1881,18 +1892,22 @@ subcommand_recover(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   svn_error_t *err;
   struct svnadmin_opt_state *opt_state = baton;
   svn_stream_t *feedback_stream = NULL;
+  apr_hash_t *fs_config = apr_hash_make(pool);
 
   /* Expect no more arguments. */
   SVN_ERR(parse_args(NULL, os, 0, 0, pool));
 
   SVN_ERR(svn_stream_for_stdout(&feedback_stream, pool));
 
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_RECOVERY_JOBS,
+                apr_itoa(pool, opt_state->jobs));
+
   /* Restore default signal handlers until after we have acquired the
    * exclusive lock so that the user interrupt before we actually
    * touch the repository. */
   svn_cmdline__disable_cancellation_handler();
 
-  err = svn_repos_recover4(opt_state->repository_path, TRUE,
+  err = svn_repos_recover5(opt_state->repository_path, TRUE, fs_config,
                            repos_notify_handler, feedback_stream,
                            check_cancel, NULL, pool);
   if (err)
@@ -1910,7 +1925,8 @@ subcommand_recover(apr_getopt_t *os, void *baton, apr_pool_t *pool)
                                  _("Waiting on repository lock; perhaps"
                                    " another process has it open?\n")));
       SVN_ERR(svn_cmdline_fflush(stdout));
-      SVN_ERR(svn_repos_recover4(opt_state->repository_path, FALSE,
+      SVN_ERR(svn_repos_recover5(opt_state->repository_path, FALSE,
+                                 fs_config,
                                  repos_notify_handler, feedback_stream,
                                  check_cancel, NULL, pool));
     }
@@ -2272,9 +2288,10 @@ subcommand_verify(apr_getopt_t *os, void *baton, apr_pool_t *pool)
     apr_array_make(pool, 0, sizeof(struct verification_error *));
   verify_baton.result_pool = pool;
 
-  SVN_ERR(svn_repos_verify_fs3(repos, lower, upper,
+  SVN_ERR(svn_repos_verify_fs4(repos, lower, upper,
                                opt_state->check_normalization,
                                opt_state->metadata_only,
+                               opt_state->jobs,
                                !opt_state->quiet
                                  ? repos_notify_handler : NULL,
                                feedback_stream,
@@ -2956,6 +2973,7 @@ build_rep_cache(svn_fs_t *fs,
 
   input.start_rev = start_rev;
   input.end_rev = end_rev;
+  input.jobs = opt_state->jobs;
 
   if (opt_state->quiet)
     {
@@ -3076,6 +3094,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   opt_state.start_revision.kind = svn_opt_revision_unspecified;
   opt_state.end_revision.kind = svn_opt_revision_unspecified;
   opt_state.memory_cache_size = svn_cache_config_get()->cache_size;
+  opt_state.jobs = 1;
 
   /* Parse options. */
   SVN_ERR(svn_cmdline__getopt_init(&os, argc, argv, pool));
@@ -3290,6 +3309,13 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       case svnadmin__glob:
         opt_state.glob = TRUE;
         break;
+      case svnadmin__jobs:
+        SVN_ERR(svn_cstring_atoi(&opt_state.jobs, opt_arg));
+        if (opt_state.jobs < 1)
+          return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                   _("Invalid number of jobs '%s'"),
+                                   opt_arg);
+        break;
       default:
         {
           SVN_ERR(subcommand_help(NULL, NULL, pool));
@@ -3417,7 +3443,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
     svn_cache_config_t settings = *svn_cache_config_get();
 
     settings.cache_size = opt_state.memory_cache_size;
-    settings.single_threaded = TRUE;
+    settings.single_threaded = (opt_state.jobs <= 1);
 
     svn_cache_config_set(&settings);
   }
@@ -0,0 +1,77 @@
+/* build-mergeinfo-index-cmd.c -- implements the mergeinfo index sub-command.
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svn_cmdline.h"
+#include "svn_pools.h"
+
+#include "private/svn_fs_fs_private.h"
+
+#include "svn_private_config.h"
+
+#include "svnfsfs.h"
+
+/* Our progress function overwrites the current line with the last
+ * REVISION that the index covers and makes it appear immediately.
+ * BATON is an svn_boolean_t that will be set once anything was printed.
+ */
+static void
+print_progress(svn_revnum_t revision,
+               void *baton,
+               apr_pool_t *pool)
+{
+  svn_boolean_t *printed = baton;
+
+  svn_error_clear(svn_cmdline_printf(pool,
+                                     _("\rIndexed mergeinfo up to "
+                                       "revision %ld."),
+                                     revision));
+  svn_error_clear(svn_cmdline_fflush(stdout));
+  *printed = TRUE;
+}
+
+/* This implements `svn_opt_subcommand_t'. */
+svn_error_t *
+subcommand__build_mergeinfo_index(apr_getopt_t *os, void *baton,
+                                  apr_pool_t *pool)
+{
+  svnfsfs__opt_state *opt_state = baton;
+  svn_fs_t *fs;
+  svn_fs_fs__ioctl_build_mergeinfo_index_input_t input = {0};
+  svn_boolean_t printed = FALSE;
+
+  SVN_ERR(open_fs(&fs, opt_state->repository_path, pool));
+
+  if (!opt_state->quiet)
+    {
+      input.progress_func = print_progress;
+      input.progress_baton = &printed;
+    }
+
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_BUILD_MERGEINFO_INDEX, &input,
+                       NULL, check_cancel, NULL, pool, pool));
+
+  /* Terminate the progress line. */
+  if (printed)
+    SVN_ERR(svn_cmdline_fputs("\n", stdout, pool));
+
+  return SVN_NO_ERROR;
+}
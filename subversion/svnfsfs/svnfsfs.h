@@ -45,11 +45,13 @@ typedef struct svnfsfs__opt_state
   svn_boolean_t version;                            /* --version */
   svn_boolean_t quiet;                              /* --quiet */
   apr_uint64_t memory_cache_size;                   /* --memory-cache-size M */
+  int jobs;                                         /* --jobs */
 } svnfsfs__opt_state;
 
 /* Declare all the command procedures */
 svn_opt_subcommand_t
   subcommand__help,
+  subcommand__build_mergeinfo_index,
   subcommand__dump_index,
   subcommand__load_index,
   subcommand__stats;
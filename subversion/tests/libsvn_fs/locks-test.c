@@ -26,9 +26,11 @@
 
 #include "../svn_test.h"
 
+#include "svn_dirent_uri.h"
 #include "svn_error.h"
 #include "svn_fs.h"
 #include "svn_hash.h"
+#include "svn_pools.h"
 
 #include "../svn_test_fs.h"
 
@@ -1214,6 +1216,191 @@ parent_and_child_lock(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-lock_database"
+#define LOCK_COUNT 1500
+
+/* Implements svn_fs_get_locks_callback_t counting the locks in the
+ * int pointed to by BATON. */
+static svn_error_t *
+count_locks(void *baton,
+            svn_lock_t *lock,
+            apr_pool_t *pool)
+{
+  ++*(int *)baton;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_fs_lock_callback_t failing on all errors. */
+static svn_error_t *
+fail_on_lock_error(void *baton,
+                   const char *path,
+                   const svn_lock_t *lock,
+                   svn_error_t *fs_err,
+                   apr_pool_t *pool)
+{
+  return svn_error_dup(fs_err);
+}
+
+/* Open the filesystem REPO_NAME as "user" and return it in *FS_P.
+ * Use POOL for allocations. */
+static svn_error_t *
+open_lock_database_fs(svn_fs_t **fs_p,
+                      apr_pool_t *pool)
+{
+  svn_fs_access_t *access;
+
+  SVN_ERR(svn_fs_open2(fs_p, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_create_access(&access, "user", pool));
+  SVN_ERR(svn_fs_set_access(*fs_p, access));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+lock_database(const svn_test_opts_t *opts,
+              apr_pool_t *pool)
+{
+  svn_fs_t *fs, *stale_fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  svn_lock_t *lock;
+  svn_node_kind_t kind;
+  svn_stringbuf_t *config;
+  svn_stringbuf_t *enabled_config;
+  const char *config_path = svn_dirent_join(REPO_NAME, "fsfs.conf", pool);
+  const char *lock_db_path = svn_dirent_join(REPO_NAME, "locks.db", pool);
+  apr_hash_t *targets = apr_hash_make(pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int count;
+  int i;
+
+  /* The lock database is an FSFS feature and requires SQLite. */
+  if (strcmp(opts->fs_type, SVN_FS_TYPE_FSFS) != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  if (opts->server_minor_version && (opts->server_minor_version < 6))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.6 SVN doesn't use SQLite");
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+
+  /* Besides the many files in /a, add a few files that sort right next
+   * to the /a sub-tree. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_dir(root, "a", pool));
+  SVN_ERR(svn_fs_make_dir(root, "a/b", pool));
+  SVN_ERR(svn_fs_make_file(root, "a/b/g", pool));
+  SVN_ERR(svn_fs_make_file(root, "a-x", pool));
+  SVN_ERR(svn_fs_make_file(root, "ab", pool));
+  for (i = 0; i < LOCK_COUNT; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_make_file(root, apr_psprintf(iterpool, "a/f%04d", i),
+                               iterpool));
+    }
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(rev));
+
+  /* This one goes into the digest files. */
+  SVN_ERR(open_lock_database_fs(&fs, pool));
+  SVN_ERR(svn_fs_lock(&lock, fs, "/a/f0000", NULL, "", FALSE, 0,
+                      SVN_INVALID_REVNUM, FALSE, pool));
+  SVN_ERR(svn_io_check_path(lock_db_path, &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+
+  /* This instance only knows about the digest files. */
+  SVN_ERR(open_lock_database_fs(&stale_fs, pool));
+
+  /* Taking the next locks moves all locks into the database. */
+  SVN_ERR(svn_stringbuf_from_file2(&config, config_path, pool));
+  enabled_config = svn_stringbuf_dup(config, pool);
+  svn_stringbuf_appendcstr(enabled_config,
+                           "\n[locks]\nenable-lock-db = true\n");
+  SVN_ERR(svn_io_write_atomic2(config_path, enabled_config->data,
+                               enabled_config->len, NULL, FALSE, pool));
+  SVN_ERR(open_lock_database_fs(&fs, pool));
+
+  svn_hash_sets(targets, "/a/b/g",
+                svn_fs_lock_target_create(NULL, SVN_INVALID_REVNUM, pool));
+  svn_hash_sets(targets, "/a-x",
+                svn_fs_lock_target_create(NULL, SVN_INVALID_REVNUM, pool));
+  svn_hash_sets(targets, "/ab",
+                svn_fs_lock_target_create(NULL, SVN_INVALID_REVNUM, pool));
+  for (i = 1; i < LOCK_COUNT; ++i)
+    svn_hash_sets(targets, apr_psprintf(pool, "/a/f%04d", i),
+                  svn_fs_lock_target_create(NULL, SVN_INVALID_REVNUM, pool));
+  SVN_ERR(svn_fs_lock_many(fs, targets, "", FALSE, 0, FALSE,
+                           fail_on_lock_error, NULL, pool, pool));
+
+  SVN_ERR(svn_io_check_path(lock_db_path, &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+  SVN_ERR(svn_io_check_path(svn_dirent_join(REPO_NAME, "locks", pool),
+                            &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+
+  /* The migrated lock is still there. */
+  SVN_ERR(svn_fs_get_lock(&lock, fs, "/a/f0000", pool));
+  SVN_TEST_ASSERT(lock != NULL);
+  SVN_ERR(svn_fs_get_lock(&lock, fs, "/a/b", pool));
+  SVN_TEST_ASSERT(lock == NULL);
+
+  /* Sub-tree queries must neither miss locks nor return neighbours. */
+  count = 0;
+  SVN_ERR(svn_fs_get_locks2(fs, "/", svn_depth_infinity, count_locks,
+                            &count, pool));
+  SVN_TEST_INT_ASSERT(count, LOCK_COUNT + 3);
+
+  count = 0;
+  SVN_ERR(svn_fs_get_locks2(fs, "/a", svn_depth_infinity, count_locks,
+                            &count, pool));
+  SVN_TEST_INT_ASSERT(count, LOCK_COUNT + 1);
+
+  count = 0;
+  SVN_ERR(svn_fs_get_locks2(fs, "/a", svn_depth_files, count_locks,
+                            &count, pool));
+  SVN_TEST_INT_ASSERT(count, LOCK_COUNT);
+
+  count = 0;
+  SVN_ERR(svn_fs_get_locks2(fs, "/ab", svn_depth_infinity, count_locks,
+                            &count, pool));
+  SVN_TEST_INT_ASSERT(count, 1);
+
+  /* Commits check the locks in the database, even through an instance
+     that was opened before the database existed. */
+  SVN_ERR(svn_fs_begin_txn(&txn, stale_fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_delete(root, "a/b", pool));
+  SVN_TEST_ASSERT_ERROR(svn_fs_commit_txn(NULL, &rev, txn, pool),
+                        SVN_ERR_FS_BAD_LOCK_TOKEN);
+  SVN_ERR(svn_fs_abort_txn(txn, pool));
+
+  /* Unlocking removes the lock from the database. */
+  SVN_ERR(svn_fs_unlock(fs, "/a/b/g", NULL, TRUE, pool));
+  SVN_ERR(svn_fs_get_lock(&lock, fs, "/a/b/g", pool));
+  SVN_TEST_ASSERT(lock == NULL);
+
+  /* The database is being used even if the option is not set. */
+  SVN_ERR(svn_io_write_atomic2(config_path, config->data, config->len,
+                               NULL, FALSE, pool));
+  SVN_ERR(open_lock_database_fs(&fs, pool));
+
+  count = 0;
+  SVN_ERR(svn_fs_get_locks2(fs, "/a", svn_depth_infinity, count_locks,
+                            &count, pool));
+  SVN_TEST_INT_ASSERT(count, LOCK_COUNT);
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef LOCK_COUNT
+
 /* ------------------------------------------------------------------------ */
 
 /* The test table.  */
@@ -1253,6 +1440,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "lock/unlock when 'write-lock' couldn't be obtained"),
     SVN_TEST_OPTS_PASS(parent_and_child_lock,
                        "lock parent and it's child"),
+    SVN_TEST_OPTS_PASS(lock_database,
+                       "store locks in a SQLite database"),
     SVN_TEST_NULL
   };
 
@@ -27,9 +27,12 @@
 #include "../svn_test.h"
 #include "../../libsvn_fs/fs-loader.h"
 #include "../../libsvn_fs_fs/fs.h"
+#include "../../libsvn_fs_fs/cached_data.h"
 #include "../../libsvn_fs_fs/fs_fs.h"
+#include "../../libsvn_fs_fs/id.h"
 #include "../../libsvn_fs_fs/low_level.h"
 #include "../../libsvn_fs_fs/pack.h"
+#include "../../libsvn_fs_fs/rev_file.h"
 #include "../../libsvn_fs_fs/util.h"
 
 #include "svn_hash.h"
@@ -37,6 +40,7 @@
 #include "svn_props.h"
 #include "svn_fs.h"
 #include "private/svn_string_private.h"
+#include "private/svn_subr_private.h"
 
 #include "../svn_test_fs.h"
 
@@ -1812,6 +1816,691 @@ pack_with_limited_memory(const svn_test_opts_t *opts,
 #undef MAX_REV
 #undef SHARD_SIZE
 
+/* ------------------------------------------------------------------------ */
+/* Verify that packing multiple shards in parallel still switches them over
+   to their packed form strictly in order. */
+#define REPO_NAME "test-repo-pack-in-parallel"
+#define SHARD_SIZE 3
+#define MAX_REV 31
+static svn_error_t *
+pack_in_parallel(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  struct pack_notify_baton pnb;
+  apr_file_t *file;
+  svn_revnum_t min_unpacked_rev;
+  svn_fs_t *fs;
+  const char *config =
+    "[" CONFIG_SECTION_CONCURRENCY "]\n"
+    CONFIG_OPTION_PACK_THREADS " = 4\n";
+
+  SVN_ERR(create_non_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                       pool));
+
+  /* Enable parallel packing. */
+  SVN_ERR(svn_io_file_open(&file, svn_dirent_join(REPO_NAME, PATH_CONFIG,
+                                                  pool),
+                           APR_WRITE | APR_APPEND | APR_CREATE, APR_OS_DEFAULT,
+                           pool));
+  SVN_ERR(svn_io_file_write_full(file, config, strlen(config), NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+
+  /* PACK_NOTIFY checks that the shards get completed in order. */
+  pnb.expected_shard = 0;
+  pnb.expected_action = svn_fs_pack_notify_start;
+  SVN_ERR(svn_fs_pack(REPO_NAME, pack_notify, &pnb, NULL, NULL, pool));
+  SVN_TEST_ASSERT(pnb.expected_shard == (MAX_REV + 1) / SHARD_SIZE);
+
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_fs__read_min_unpacked_rev(&min_unpacked_rev, fs, pool));
+  SVN_TEST_INT_ASSERT(min_unpacked_rev,
+                      (MAX_REV + 1) / SHARD_SIZE * SHARD_SIZE);
+
+  /* To be sure: Verify that we didn't break the repo. */
+  SVN_ERR(svn_fs_verify(REPO_NAME, NULL, 0, MAX_REV, NULL, NULL, NULL, NULL,
+                        pool));
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef MAX_REV
+#undef SHARD_SIZE
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-hotcopy_in_parallel"
+#define COPY_NAME "test-repo-hotcopy_in_parallel-copy"
+#define SHARD_SIZE 4
+#define MAX_REV 21
+#define MORE_REVS 6
+
+/* Baton for hotcopy_notify(). */
+struct hotcopy_notify_baton
+{
+  svn_revnum_t next_rev;
+  svn_boolean_t out_of_order;
+};
+
+/* Implements svn_fs_hotcopy_notify_t.  Check that the revisions get
+ * reported in ascending order. */
+static void
+hotcopy_notify(void *baton,
+               svn_revnum_t start_revision,
+               svn_revnum_t end_revision,
+               apr_pool_t *scratch_pool)
+{
+  struct hotcopy_notify_baton *hnb = baton;
+
+  if (start_revision < hnb->next_rev || end_revision < start_revision)
+    hnb->out_of_order = TRUE;
+
+  hnb->next_rev = end_revision + 1;
+}
+
+static svn_error_t *
+hotcopy_in_parallel(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  struct hotcopy_notify_baton hnb;
+  apr_file_t *file;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  int i;
+  const char *config =
+    "[" CONFIG_SECTION_CONCURRENCY "]\n"
+    CONFIG_OPTION_HOTCOPY_THREADS " = 3\n";
+
+  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                   pool));
+
+  /* Enable parallel hotcopy. */
+  SVN_ERR(svn_io_file_open(&file, svn_dirent_join(REPO_NAME, PATH_CONFIG,
+                                                  pool),
+                           APR_WRITE | APR_APPEND | APR_CREATE, APR_OS_DEFAULT,
+                           pool));
+  SVN_ERR(svn_io_file_write_full(file, config, strlen(config), NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+
+  /* Full copy.  All revisions get reported, in order. */
+  hnb.next_rev = 0;
+  hnb.out_of_order = FALSE;
+  SVN_ERR(svn_fs_hotcopy3(REPO_NAME, COPY_NAME, TRUE, FALSE,
+                          hotcopy_notify, &hnb, NULL, NULL, pool));
+  SVN_TEST_ASSERT(!hnb.out_of_order);
+  SVN_TEST_INT_ASSERT(hnb.next_rev, MAX_REV + 1);
+
+  SVN_ERR(svn_fs_open2(&fs, COPY_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_youngest_rev(&rev, fs, pool));
+  SVN_TEST_INT_ASSERT(rev, MAX_REV);
+
+  /* Add more revisions, completing a shard, and update the copy. */
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  for (i = 0; i < MORE_REVS; ++i)
+    {
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, MAX_REV + i, pool));
+      SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+      SVN_ERR(svn_fs_make_file(root, apr_psprintf(pool, "new-%d", i), pool));
+      SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+    }
+  SVN_ERR(svn_fs_pack(REPO_NAME, NULL, NULL, NULL, NULL, pool));
+
+  hnb.next_rev = 0;
+  hnb.out_of_order = FALSE;
+  SVN_ERR(svn_fs_hotcopy3(REPO_NAME, COPY_NAME, FALSE, TRUE,
+                          hotcopy_notify, &hnb, NULL, NULL, pool));
+  SVN_TEST_ASSERT(!hnb.out_of_order);
+  SVN_TEST_INT_ASSERT(hnb.next_rev, MAX_REV + MORE_REVS + 1);
+
+  SVN_ERR(svn_fs_open2(&fs, COPY_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_youngest_rev(&rev, fs, pool));
+  SVN_TEST_INT_ASSERT(rev, MAX_REV + MORE_REVS);
+
+  /* To be sure: Verify that we didn't break the copy. */
+  SVN_ERR(svn_fs_verify(COPY_NAME, NULL, 0, MAX_REV + MORE_REVS,
+                        NULL, NULL, NULL, NULL, pool));
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef COPY_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+#undef MORE_REVS
+
+/* ------------------------------------------------------------------------ */
+#define REPO_NAME "test-repo-block_read_ahead"
+#define SHARD_SIZE 8
+#define MAX_REV 23
+static svn_error_t *
+block_read_ahead(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  apr_file_t *file;
+  apr_hash_t *fs_config = apr_hash_make(pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_revnum_t i;
+  const char *config =
+    "[" CONFIG_SECTION_IO "]\n"
+    CONFIG_OPTION_BLOCK_SIZE " = 1\n"
+    CONFIG_OPTION_BLOCK_READ_AHEAD " = 4\n";
+
+  /* Block-read requires logical addressing. */
+  if (opts->server_minor_version && (opts->server_minor_version < 9))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.9 SVN doesn't support block-read");
+
+  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                   pool));
+
+  /* Use tiny blocks such that sequential reads span many of them. */
+  SVN_ERR(svn_io_file_open(&file, svn_dirent_join(REPO_NAME, PATH_CONFIG,
+                                                  pool),
+                           APR_WRITE | APR_APPEND | APR_CREATE, APR_OS_DEFAULT,
+                           pool));
+  SVN_ERR(svn_io_file_write_full(file, config, strlen(config), NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+
+  /* Read with block-read enabled and from empty caches. */
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                svn_uuid_generate(pool));
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_BLOCK_READ, "1");
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+  ffd = fs->fsap_data;
+  SVN_TEST_ASSERT(ffd->blocks_read_ahead == 0);
+
+  /* Walk all revisions in order, i.e. sequentially through the packs.
+   * Data served from read-ahead must be the same as when read directly. */
+  for (i = 1; i <= MAX_REV; i++)
+    {
+      svn_fs_root_t *rev_root;
+      svn_stream_t *rstream;
+      svn_stringbuf_t *rstring;
+      apr_hash_t *entries;
+      const char *expected;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_fs_revision_root(&rev_root, fs, i, iterpool));
+      SVN_ERR(svn_fs_file_contents(&rstream, rev_root, "iota", iterpool));
+      SVN_ERR(svn_test__stream_to_string(&rstring, rstream, iterpool));
+
+      expected = i == 1 ? "This is the file 'iota'.\n"
+                        : get_rev_contents(i, iterpool);
+      SVN_TEST_STRING_ASSERT(rstring->data, expected);
+
+      /* Touch a few more noderevs further down the tree. */
+      SVN_ERR(svn_fs_dir_entries(&entries, rev_root, "A/D/G", iterpool));
+      SVN_TEST_INT_ASSERT(apr_hash_count(entries), 3);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  /* The sequential access pattern must have been detected. */
+  SVN_TEST_ASSERT(ffd->blocks_read_ahead > 0);
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef MAX_REV
+#undef SHARD_SIZE
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-mmap_pack_files"
+#define SHARD_SIZE 4
+#define MAX_REV 9
+static svn_error_t *
+mmap_pack_files(const svn_test_opts_t *opts,
+                apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  apr_file_t *file;
+  svn_fs_fs__revision_file_t *rev_file;
+  svn_boolean_t mapped;
+  const char *data;
+  char buffer[64];
+  apr_off_t offset = 0;
+  apr_hash_t *fs_config = apr_hash_make(pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_revnum_t i;
+  const char *config =
+    "[" CONFIG_SECTION_IO "]\n"
+    CONFIG_OPTION_MMAP_PACK_FILES " = true\n";
+
+  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                   pool));
+
+  SVN_ERR(svn_io_file_open(&file, svn_dirent_join(REPO_NAME, PATH_CONFIG,
+                                                  pool),
+                           APR_WRITE | APR_APPEND | APR_CREATE, APR_OS_DEFAULT,
+                           pool));
+  SVN_ERR(svn_io_file_write_full(file, config, strlen(config), NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+
+  /* Read from empty caches such that everything comes from the pack and
+   * rev files.  Mapped and non-mapped reads must give the same results. */
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                svn_uuid_generate(pool));
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_BLOCK_READ, "1");
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+
+  for (i = 1; i <= MAX_REV; i++)
+    {
+      svn_fs_root_t *rev_root;
+      svn_stream_t *rstream;
+      svn_stringbuf_t *rstring;
+      const char *expected;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_fs_revision_root(&rev_root, fs, i, iterpool));
+      SVN_ERR(svn_fs_file_contents(&rstream, rev_root, "iota", iterpool));
+      SVN_ERR(svn_test__stream_to_string(&rstring, rstream, iterpool));
+
+      expected = i == 1 ? "This is the file 'iota'.\n"
+                        : get_rev_contents(i, iterpool);
+      SVN_TEST_STRING_ASSERT(rstring->data, expected);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  /* Pack files opened through FS must be mapped, otherwise the reads
+   * above silently fell back to plain file access.  Non-packed revision
+   * files never get mapped. */
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, 0, pool, pool));
+  mapped = svn_fs_fs__rev_file_mapped_data(&data, rev_file, 0,
+                                           sizeof(buffer));
+#if APR_HAS_MMAP
+  SVN_TEST_ASSERT(mapped);
+  SVN_ERR(svn_io_file_seek(rev_file->file, APR_SET, &offset, pool));
+  SVN_ERR(svn_io_file_read_full2(rev_file->file, buffer, sizeof(buffer),
+                                 NULL, NULL, pool));
+  SVN_TEST_ASSERT(memcmp(data, buffer, sizeof(buffer)) == 0);
+#else
+  SVN_TEST_ASSERT(!mapped);
+#endif
+  SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, MAX_REV, pool,
+                                           pool));
+  SVN_TEST_ASSERT(!rev_file->is_packed);
+  SVN_TEST_ASSERT(!svn_fs_fs__rev_file_mapped_data(&data, rev_file, 0, 1));
+  SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+
+  /* Verification reads all indexes and items through the mapping. */
+  SVN_ERR(svn_fs_verify(REPO_NAME, fs_config, 0, MAX_REV, NULL, NULL,
+                        NULL, NULL, pool));
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef MAX_REV
+#undef SHARD_SIZE
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-file_handle_cache"
+#define SHARD_SIZE 4
+#define MAX_REV 9
+static svn_error_t *
+file_handle_cache(const svn_test_opts_t *opts,
+                  apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  apr_file_t *file;
+  apr_pool_t *subpool;
+  svn_fs_fs__revision_file_t *file1, *file2, *file3;
+  const char *config =
+    "[" CONFIG_SECTION_IO "]\n"
+    CONFIG_OPTION_FILE_HANDLE_CACHE_SIZE " = 2\n";
+
+  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                   pool));
+
+  SVN_ERR(svn_io_file_open(&file, svn_dirent_join(REPO_NAME, PATH_CONFIG,
+                                                  pool),
+                           APR_WRITE | APR_APPEND | APR_CREATE, APR_OS_DEFAULT,
+                           pool));
+  SVN_ERR(svn_io_file_write_full(file, config, strlen(config), NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+
+  /* A closed file will be handed out again for the same pack file. */
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&file1, fs, 1, pool, pool));
+  SVN_ERR(svn_fs_fs__close_revision_file(file1));
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&file2, fs, 2, pool, pool));
+  SVN_TEST_ASSERT(file1 == file2);
+  SVN_TEST_ASSERT(file2->file != NULL);
+  SVN_TEST_ASSERT(file2->is_packed);
+
+  /* Files that are in use must not be shared. */
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&file3, fs, 3, pool, pool));
+  SVN_TEST_ASSERT(file3 != file2);
+  SVN_ERR(svn_fs_fs__close_revision_file(file2));
+  SVN_ERR(svn_fs_fs__close_revision_file(file3));
+
+  /* Files get returned to the cache when the user's pool is cleared. */
+  subpool = svn_pool_create(pool);
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&file1, fs, 5, subpool,
+                                           subpool));
+  svn_pool_destroy(subpool);
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&file2, fs, 6, pool, pool));
+  SVN_TEST_ASSERT(file1 == file2);
+  SVN_ERR(svn_fs_fs__close_revision_file(file2));
+
+  /* Non-packed revisions are cached per revision. */
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&file1, fs, 8, pool, pool));
+  SVN_TEST_ASSERT(!file1->is_packed);
+  SVN_ERR(svn_fs_fs__close_revision_file(file1));
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&file2, fs, 9, pool, pool));
+  SVN_TEST_ASSERT(file1 != file2);
+  SVN_ERR(svn_fs_fs__close_revision_file(file2));
+
+  /* Reading through the cached handles must still work. */
+  SVN_ERR(svn_fs_verify(REPO_NAME, NULL, 0, MAX_REV, NULL, NULL, NULL, NULL,
+                        pool));
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef MAX_REV
+#undef SHARD_SIZE
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-packed_revprop_cache"
+#define COPY_NAME "test-repo-packed_revprop_cache-copy"
+#define SHARD_SIZE 4
+#define MAX_REV 8
+
+/* Set *PATH to the revprop pack file that contains REV in FS, as listed
+ * in the respective manifest.  Use POOL for allocations. */
+static svn_error_t *
+get_revprop_pack_path(const char **path,
+                      svn_fs_t *fs,
+                      svn_revnum_t rev,
+                      apr_pool_t *pool)
+{
+  svn_stringbuf_t *content;
+  apr_array_header_t *filenames;
+  const char *folder = svn_fs_fs__path_revprops_pack_shard(fs, rev, pool);
+  int idx = rev < SHARD_SIZE ? (int)rev - 1 : (int)(rev % SHARD_SIZE);
+
+  SVN_ERR(svn_stringbuf_from_file2(&content,
+                                   svn_dirent_join(folder, PATH_MANIFEST,
+                                                   pool),
+                                   pool));
+  filenames = svn_cstring_split(content->data, "\n", TRUE, pool);
+  *path = svn_dirent_join(folder,
+                          APR_ARRAY_IDX(filenames, idx, const char *),
+                          pool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+packed_revprop_cache(const svn_test_opts_t *opts,
+                     apr_pool_t *pool)
+{
+  svn_fs_t *fs1, *fs2, *fs3;
+  svn_string_t *value;
+  const char *old_path, *new_path;
+  const svn_string_t *old_value = NULL;
+  svn_boolean_t has_instance_id;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if ((strcmp(opts->fs_type, "fsfs") != 0)
+      || (opts->server_minor_version && (opts->server_minor_version < 8)))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.8 SVN doesn't support packed revprops");
+
+  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                   pool));
+
+  /* Keep an identical copy that gets a new instance ID. */
+  SVN_ERR(svn_io_remove_dir2(COPY_NAME, TRUE, NULL, NULL, pool));
+  SVN_ERR(svn_fs_hotcopy3(REPO_NAME, COPY_NAME, FALSE, FALSE,
+                          NULL, NULL, NULL, NULL, pool));
+
+  /* Two independent instances, standing in for two processes. */
+  SVN_ERR(svn_fs_open2(&fs1, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_open2(&fs2, REPO_NAME, NULL, pool, pool));
+  has_instance_id = ((fs_fs_data_t *)fs1->fsap_data)->format
+                  >= SVN_FS_FS__MIN_INSTANCE_ID_FORMAT;
+
+  /* Read r5 through FS1.  This caches the whole pack. */
+  SVN_ERR(svn_fs_revision_prop2(&value, fs1, 5, SVN_PROP_REVISION_LOG,
+                                FALSE, pool, pool));
+  SVN_TEST_ASSERT(value == NULL);
+
+  /* Changing r6 in FS2 writes a new pack file, even though the new
+   * content easily fits into the old one. */
+  SVN_ERR(get_revprop_pack_path(&old_path, fs2, 6, pool));
+  SVN_ERR(svn_fs_change_rev_prop2(fs2, 6, SVN_PROP_REVISION_LOG,
+                                  &old_value,
+                                  svn_string_create("changed", pool),
+                                  pool));
+  SVN_ERR(get_revprop_pack_path(&new_path, fs2, 6, pool));
+  SVN_TEST_ASSERT(strcmp(old_path, new_path) != 0);
+
+  /* FS1 sees the change after a sync barrier. */
+  SVN_ERR(svn_fs_revision_prop2(&value, fs1, 6, SVN_PROP_REVISION_LOG,
+                                TRUE, pool, pool));
+  SVN_TEST_STRING_ASSERT(value->data, "changed");
+
+  /* Read r2 through FS1, then remove its pack file.  Because that pack
+   * did not change, the cached revprops of all its revisions remain
+   * valid across sync barriers. */
+  SVN_ERR(svn_fs_revision_prop2(&value, fs1, 2, SVN_PROP_REVISION_LOG,
+                                FALSE, pool, pool));
+  SVN_ERR(get_revprop_pack_path(&old_path, fs1, 2, pool));
+  SVN_ERR(svn_io_remove_file2(old_path, FALSE, pool));
+
+  SVN_ERR(svn_fs_refresh_revision_props(fs1, pool));
+  SVN_ERR(svn_fs_revision_prop2(&value, fs1, 1, SVN_PROP_REVISION_LOG,
+                                TRUE, pool, pool));
+  SVN_TEST_STRING_ASSERT(value->data, R1_LOG_MSG);
+
+  /* Put the copy in place of the original after giving r6 a different
+   * value but the same pack file name as in the original.  Without the
+   * instance ID, we would get the original's cached value. */
+  if (has_instance_id)
+    {
+      SVN_ERR(svn_fs_open2(&fs3, COPY_NAME, NULL, pool, pool));
+      old_value = NULL;
+      SVN_ERR(svn_fs_change_rev_prop2(fs3, 6, SVN_PROP_REVISION_LOG,
+                                      &old_value,
+                                      svn_string_create("copied", pool),
+                                      pool));
+      SVN_ERR(get_revprop_pack_path(&old_path, fs3, 6, pool));
+      SVN_TEST_STRING_ASSERT(svn_dirent_basename(old_path, pool),
+                             svn_dirent_basename(new_path, pool));
+
+      SVN_ERR(svn_io_remove_dir2(REPO_NAME, FALSE, NULL, NULL, pool));
+      SVN_ERR(svn_io_file_rename2(COPY_NAME, REPO_NAME, FALSE, pool));
+
+      SVN_ERR(svn_fs_open2(&fs3, REPO_NAME, NULL, pool, pool));
+      SVN_ERR(svn_fs_revision_prop2(&value, fs3, 6, SVN_PROP_REVISION_LOG,
+                                    FALSE, pool, pool));
+      SVN_TEST_STRING_ASSERT(value->data, "copied");
+    }
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef COPY_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-changes_index"
+#define SHARD_SIZE 4
+#define FILE_COUNT 250
+
+/* Read all changes of REV in FS block by block and return them in
+ * *CHANGES.  Set *USED_REV_FILE if that required opening the rev or pack
+ * file.  Use POOL for allocations.
+ */
+static svn_error_t *
+read_all_changes(apr_array_header_t **changes,
+                 svn_boolean_t *used_rev_file,
+                 svn_fs_t *fs,
+                 svn_revnum_t rev,
+                 apr_pool_t *pool)
+{
+  svn_fs_fs__changes_context_t *context;
+  apr_array_header_t *result = apr_array_make(pool, 0, sizeof(change_t *));
+
+  *used_rev_file = FALSE;
+  SVN_ERR(svn_fs_fs__create_changes_context(&context, fs, rev, pool));
+  while (!context->eol)
+    {
+      apr_array_header_t *block;
+
+      SVN_ERR(svn_fs_fs__get_changes(&block, context, pool, pool));
+      SVN_TEST_ASSERT(block->nelts <= SVN_FS_FS__CHANGES_BLOCK_SIZE);
+      apr_array_cat(result, block);
+
+      if (context->revision_file)
+        *used_rev_file = TRUE;
+    }
+
+  *changes = result;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+changes_index(const svn_test_opts_t *opts,
+              apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root, *rev_root;
+  svn_revnum_t rev;
+  apr_file_t *file;
+  apr_hash_t *fs_config;
+  svn_node_kind_t kind;
+  svn_boolean_t used_rev_file;
+  apr_array_header_t *expected[SHARD_SIZE];
+  apr_array_header_t *actual;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i, k;
+  const char *config =
+    "[" CONFIG_SECTION_IO "]\n"
+    CONFIG_OPTION_CHANGES_INDEX " = true\n";
+
+  /* Revision 1 is the Greek tree. */
+  SVN_ERR(create_non_packed_filesystem(REPO_NAME, opts, 1, SHARD_SIZE,
+                                       pool));
+
+  SVN_ERR(svn_io_file_open(&file, svn_dirent_join(REPO_NAME, PATH_CONFIG,
+                                                  pool),
+                           APR_WRITE | APR_APPEND | APR_CREATE, APR_OS_DEFAULT,
+                           pool));
+  SVN_ERR(svn_io_file_write_full(file, config, strlen(config), NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+
+  /* Revision 2: a changes list that spans multiple blocks. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 1, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  for (i = 0; i < FILE_COUNT; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_make_file(root, apr_psprintf(iterpool, "A/f%03d", i),
+                               iterpool));
+    }
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* Revision 3: a copy, a deletion and property changes. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 2, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, 2, pool));
+  SVN_ERR(svn_fs_copy(rev_root, "A/D", root, "A/D2", pool));
+  SVN_ERR(svn_fs_delete(root, "A/B", pool));
+  SVN_ERR(svn_fs_change_node_prop(root, "iota", "prop",
+                                  svn_string_create("value", pool), pool));
+  SVN_ERR(svn_fs_change_node_prop(root, "A/C", SVN_PROP_MERGEINFO,
+                                  svn_string_create("/A/D:2", pool), pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* Revision 4 completes the first shard. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 3, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(root, "iota", "new-iota", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* Remember the changes as read from the rev files and pack. */
+  for (i = 0; i < SHARD_SIZE; ++i)
+    SVN_ERR(read_all_changes(&expected[i], &used_rev_file, fs, i, pool));
+
+  SVN_ERR(svn_fs_pack(REPO_NAME, NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_io_check_path(svn_dirent_join_many(pool, REPO_NAME,
+                                                 PATH_REVS_DIR, "0.pack",
+                                                 PATH_CHANGES_INDEX,
+                                                 SVN_VA_NULL),
+                            &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+
+  /* Re-open the repository without changes cache, such that all reads
+   * have to go to disk. */
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                svn_uuid_generate(pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+  ffd = fs->fsap_data;
+  ffd->changes_cache = NULL;
+
+  /* The index must return the same changes without touching the pack. */
+  for (i = 0; i < SHARD_SIZE; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(read_all_changes(&actual, &used_rev_file, fs, i, iterpool));
+      SVN_TEST_ASSERT(!used_rev_file);
+      SVN_TEST_INT_ASSERT(actual->nelts, expected[i]->nelts);
+
+      for (k = 0; k < actual->nelts; ++k)
+        {
+          const change_t *lhs = APR_ARRAY_IDX(actual, k, change_t *);
+          const change_t *rhs = APR_ARRAY_IDX(expected[i], k, change_t *);
+
+          SVN_TEST_STRING_ASSERT(lhs->path.data, rhs->path.data);
+          SVN_TEST_ASSERT(svn_fs_fs__id_eq(lhs->info.node_rev_id,
+                                           rhs->info.node_rev_id));
+          SVN_TEST_ASSERT(lhs->info.change_kind == rhs->info.change_kind);
+          SVN_TEST_ASSERT(lhs->info.node_kind == rhs->info.node_kind);
+          SVN_TEST_ASSERT(lhs->info.text_mod == rhs->info.text_mod);
+          SVN_TEST_ASSERT(lhs->info.prop_mod == rhs->info.prop_mod);
+          SVN_TEST_ASSERT(lhs->info.mergeinfo_mod
+                          == rhs->info.mergeinfo_mod);
+          SVN_TEST_ASSERT(lhs->info.copyfrom_known
+                          == rhs->info.copyfrom_known);
+          SVN_TEST_ASSERT(lhs->info.copyfrom_rev == rhs->info.copyfrom_rev);
+          SVN_TEST_STRING_ASSERT(lhs->info.copyfrom_path,
+                                 rhs->info.copyfrom_path);
+        }
+    }
+
+  /* Non-packed revisions are still read from their rev files. */
+  SVN_ERR(read_all_changes(&actual, &used_rev_file, fs, 4, pool));
+  SVN_TEST_INT_ASSERT(actual->nelts, 1);
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef FILE_COUNT
+
 /* ------------------------------------------------------------------------ */
 
 #define REPO_NAME "test-repo-large_delta_against_plain"
@@ -1889,7 +2578,207 @@ large_delta_against_plain(const svn_test_opts_t *opts,
 #undef REPO_NAME
 
 
-
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-block_packed_index"
+#define SHARD_SIZE 4
+#define MAX_REV 13
+
+/* Return poorly compressible file contents of about 16kB for revision REV.
+ * Allocate the result in POOL. */
+static const char *
+get_large_contents(svn_revnum_t rev,
+                   apr_pool_t *pool)
+{
+  svn_stringbuf_t *contents = svn_stringbuf_create_ensure(16384, pool);
+  apr_uint32_t seed = (apr_uint32_t)rev;
+  int i;
+
+  for (i = 0; i < 16384; ++i)
+    {
+      seed = seed * 1103515245 + 12345;
+      svn_stringbuf_appendbyte(contents, (char)('a' + (seed >> 16) % 26));
+    }
+
+  return contents->data;
+}
+
+/* Commit revision REV to FS.  Depending on REV, add many small files, a
+ * large file or modify "iota" such that the indexes get many pages of
+ * either kind, some of them being empty.  Use POOL for allocations. */
+static svn_error_t *
+commit_index_test_rev(svn_fs_t *fs,
+                      svn_revnum_t rev,
+                      apr_pool_t *pool)
+{
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t new_rev;
+  int i;
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev - 1, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+
+  if (rev == 1)
+    {
+      SVN_ERR(svn_test__create_greek_tree(root, pool));
+    }
+  else if (rev % 4 == 2)
+    {
+      const char *dir = apr_psprintf(pool, "dir%ld", rev);
+      SVN_ERR(svn_fs_make_dir(root, dir, pool));
+
+      for (i = 0; i < 300; ++i)
+        {
+          const char *path = apr_psprintf(pool, "%s/file%d", dir, i);
+          SVN_ERR(svn_fs_make_file(root, path, pool));
+          SVN_ERR(svn_test__set_file_contents(root, path, path, pool));
+        }
+    }
+  else if (rev % 4 == 3)
+    {
+      SVN_ERR(svn_test__set_file_contents(root, "A/mu",
+                                          get_large_contents(rev, pool),
+                                          pool));
+    }
+  else
+    {
+      SVN_ERR(svn_test__set_file_contents(root, "iota",
+                                          get_rev_contents(rev, pool),
+                                          pool));
+    }
+
+  SVN_ERR(svn_fs_commit_txn(NULL, &new_rev, txn, pool));
+  SVN_TEST_ASSERT(new_rev == rev);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+block_packed_index(const svn_test_opts_t *opts,
+                   apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  apr_file_t *file;
+  apr_hash_t *fs_config = apr_hash_make(pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_version_t *supports_version;
+  int format;
+  int block_read;
+  svn_revnum_t rev;
+  const char *config =
+    "[" CONFIG_SECTION_IO "]\n"
+    CONFIG_OPTION_L2P_PAGE_SIZE " = 256\n"
+    CONFIG_OPTION_P2L_PAGE_SIZE " = 1\n";
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  if (opts->server_minor_version && (opts->server_minor_version < 15))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.15 SVN doesn't support block-packed "
+                            "index pages");
+
+  /* Start with a repository that writes 7b/8b encoded index pages. */
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_SHARD_SIZE,
+                apr_itoa(pool, SHARD_SIZE));
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_COMPATIBLE_VERSION, "1.10");
+  SVN_ERR(svn_test__create_fs2(&fs, REPO_NAME, opts, fs_config, pool));
+
+  /* Small pages give us many of them. */
+  SVN_ERR(svn_io_file_open(&file, svn_dirent_join(REPO_NAME, PATH_CONFIG,
+                                                  pool),
+                           APR_WRITE | APR_APPEND | APR_CREATE, APR_OS_DEFAULT,
+                           pool));
+  SVN_ERR(svn_io_file_write_full(file, config, strlen(config), NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_info_format(&format, &supports_version, fs, pool, pool));
+  SVN_TEST_ASSERT(format < SVN_FS_FS__MIN_BLOCK_PACKED_INDEX_FORMAT);
+
+  for (rev = 1; rev < 2 * SHARD_SIZE; ++rev)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(commit_index_test_rev(fs, rev, iterpool));
+    }
+
+  SVN_ERR(svn_fs_pack(REPO_NAME, NULL, NULL, NULL, NULL, pool));
+
+  /* After the upgrade, new rev and pack files use block-packed pages
+   * while the existing ones must remain readable. */
+  SVN_ERR(svn_fs_upgrade2(REPO_NAME, NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_info_format(&format, &supports_version, fs, pool, pool));
+  SVN_TEST_ASSERT(format >= SVN_FS_FS__MIN_BLOCK_PACKED_INDEX_FORMAT);
+
+  for (; rev <= MAX_REV; ++rev)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(commit_index_test_rev(fs, rev, iterpool));
+    }
+
+  /* Pack another shard, leaving the last two revisions non-packed. */
+  SVN_ERR(svn_fs_pack(REPO_NAME, NULL, NULL, NULL, NULL, pool));
+
+  /* Read everything from empty caches, with and without block-read. */
+  for (block_read = 0; block_read < 2; ++block_read)
+    {
+      fs_config = apr_hash_make(pool);
+      svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                    svn_uuid_generate(pool));
+      svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_BLOCK_READ,
+                    block_read ? "1" : "0");
+      SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+
+      for (rev = 2; rev <= MAX_REV; ++rev)
+        {
+          svn_fs_root_t *rev_root;
+          svn_stream_t *rstream;
+          svn_stringbuf_t *rstring;
+          const char *path;
+          const char *expected;
+
+          svn_pool_clear(iterpool);
+
+          if (rev % 4 == 2)
+            {
+              path = apr_psprintf(iterpool, "dir%ld/file299", rev);
+              expected = path;
+            }
+          else if (rev % 4 == 3)
+            {
+              path = "A/mu";
+              expected = get_large_contents(rev, iterpool);
+            }
+          else
+            {
+              path = "iota";
+              expected = get_rev_contents(rev, iterpool);
+            }
+
+          SVN_ERR(svn_fs_revision_root(&rev_root, fs, rev, iterpool));
+          SVN_ERR(svn_fs_file_contents(&rstream, rev_root, path, iterpool));
+          SVN_ERR(svn_test__stream_to_string(&rstring, rstream, iterpool));
+          SVN_TEST_STRING_ASSERT(rstring->data, expected);
+        }
+
+      /* Verification cross-checks both indexes for every revision. */
+      SVN_ERR(svn_fs_verify(REPO_NAME, fs_config, 0, MAX_REV, NULL, NULL,
+                            NULL, NULL, pool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef MAX_REV
+#undef SHARD_SIZE
+
+
 /* The test table.  */
 
 static int max_threads = 4;
@@ -1943,6 +2832,22 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "pack with limited memory for metadata"),
     SVN_TEST_OPTS_PASS(large_delta_against_plain,
                        "large deltas against PLAIN, issue #4658"),
+    SVN_TEST_OPTS_PASS(pack_in_parallel,
+                       "pack multiple shards in parallel"),
+    SVN_TEST_OPTS_PASS(hotcopy_in_parallel,
+                       "hotcopy shards in parallel"),
+    SVN_TEST_OPTS_PASS(block_read_ahead,
+                       "read ahead during sequential block-read"),
+    SVN_TEST_OPTS_PASS(mmap_pack_files,
+                       "read from memory-mapped pack files"),
+    SVN_TEST_OPTS_PASS(file_handle_cache,
+                       "re-use cached rev and pack file handles"),
+    SVN_TEST_OPTS_PASS(packed_revprop_cache,
+                       "invalidate cached packed revprops per pack"),
+    SVN_TEST_OPTS_PASS(changes_index,
+                       "read changed paths from the changes index"),
+    SVN_TEST_OPTS_PASS(block_packed_index,
+                       "read block-packed and 7b/8b index pages"),
     SVN_TEST_NULL
   };
 
@@ -28,14 +28,22 @@
 #include "svn_hash.h"
 #include "svn_pools.h"
 #include "svn_props.h"
+#include "svn_sorts.h"
 #include "svn_fs.h"
+#include "svn_dirent_uri.h"
 
+#include "private/svn_sorts_private.h"
 #include "private/svn_string_private.h"
 #include "private/svn_fs_fs_private.h"
 #include "private/svn_subr_private.h"
 
+#include "../../libsvn_fs_fs/id.h"
 #include "../../libsvn_fs_fs/index.h"
+#include "../../libsvn_fs_fs/mergeinfo_index.h"
+#include "../../libsvn_fs_fs/node_history.h"
+#include "../../libsvn_fs_fs/recovery.h"
 #include "../../libsvn_fs_fs/rep-cache.h"
+#include "../../libsvn_fs_fs/util.h"
 #include "../../libsvn_fs/fs-loader.h"
 
 #include "../svn_test_fs.h"
@@ -424,8 +432,8 @@ load_index(const svn_test_opts_t *opts, apr_pool_t *pool)
   SVN_ERR(svn_fs_ioctl(svn_repos_fs(repos), SVN_FS_FS__IOCTL_LOAD_INDEX,
                        &load_input, NULL, NULL, NULL, pool, pool));
 
-  SVN_TEST_ASSERT_ERROR(svn_repos_verify_fs3(repos, rev, rev, FALSE, FALSE,
-                                             NULL, NULL, NULL, NULL, NULL,
+  SVN_TEST_ASSERT_ERROR(svn_repos_verify_fs4(repos, rev, rev, FALSE, FALSE,
+                                             1, NULL, NULL, NULL, NULL, NULL,
                                              NULL, pool),
                         SVN_ERR_FS_INDEX_CORRUPTION);
 
@@ -434,7 +442,7 @@ load_index(const svn_test_opts_t *opts, apr_pool_t *pool)
   load_input.entries = entries;
   SVN_ERR(svn_fs_ioctl(svn_repos_fs(repos), SVN_FS_FS__IOCTL_LOAD_INDEX,
                        &load_input, NULL, NULL, NULL, pool, pool));
-  SVN_ERR(svn_repos_verify_fs3(repos, rev, rev, FALSE, FALSE, NULL, NULL,
+  SVN_ERR(svn_repos_verify_fs4(repos, rev, rev, FALSE, FALSE, 1, NULL, NULL,
                                NULL, NULL, NULL, NULL, pool));
 
   return SVN_NO_ERROR;
@@ -499,8 +507,1285 @@ build_rep_cache(const svn_test_opts_t *opts, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-verify-parallel-test"
+
+/* Implements svn_repos_notify_func_t.  Append the revisions of all
+ * svn_repos_notify_verify_rev_end notifications to the array BATON. */
+static void
+collect_verified_revs(void *baton,
+                      const svn_repos_notify_t *notify,
+                      apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *revs = baton;
+
+  if (notify->action == svn_repos_notify_verify_rev_end)
+    APR_ARRAY_PUSH(revs, svn_revnum_t) = notify->revision;
+}
+
+/* Implements svn_repos_verify_callback_t.  Append REVISION to the array
+ * BATON and continue verification. */
+static svn_error_t *
+collect_failed_revs(void *baton,
+                    svn_revnum_t revision,
+                    svn_error_t *verify_err,
+                    apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *revs = baton;
+  APR_ARRAY_PUSH(revs, svn_revnum_t) = revision;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+verify_parallel(const svn_test_opts_t *opts, apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t rev;
+  apr_hash_t *fs_config = apr_hash_make(pool);
+  apr_array_header_t *revs = apr_array_make(pool, 16, sizeof(svn_revnum_t));
+  svn_node_kind_t kind;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  if (opts->server_minor_version && (opts->server_minor_version < 9))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.9 SVN doesn't have FSFS indexes");
+
+  /* Use tiny shards such that verification gets split into many jobs. */
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FS_TYPE, opts->fs_type);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_SHARD_SIZE, "2");
+
+  SVN_ERR(svn_io_remove_dir2(REPO_NAME, TRUE, NULL, NULL, pool));
+  SVN_ERR(svn_repos_create(&repos, REPO_NAME, NULL, NULL, NULL, fs_config,
+                           pool));
+  svn_test_add_dir_cleanup(REPO_NAME);
+  fs = svn_repos_fs(repos);
+
+  /* r1 adds the Greek tree, r2 .. r10 modify iota. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(rev));
+
+  for (i = 2; i <= 10; ++i)
+    {
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, iterpool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, iterpool));
+      SVN_ERR(svn_test__set_file_contents(txn_root, "iota",
+                                          apr_psprintf(iterpool,
+                                                       "iota in r%d\n", i),
+                                          iterpool));
+      SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, iterpool));
+      SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(rev));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  /* Verify with fewer workers than shards.  The results must still be
+   * reported in revision order. */
+  SVN_ERR(svn_repos_verify_fs4(repos, 1, rev, FALSE, FALSE, 3,
+                               collect_verified_revs, revs,
+                               NULL, NULL, NULL, NULL, pool));
+  SVN_TEST_INT_ASSERT(revs->nelts, 10);
+  for (i = 0; i < revs->nelts; ++i)
+    SVN_TEST_INT_ASSERT(APR_ARRAY_IDX(revs, i, svn_revnum_t), i + 1);
+
+#if APR_HAS_THREADS
+  {
+    apr_array_header_t *entries = apr_array_make(pool, 16, sizeof(void *));
+    apr_array_header_t *alt_entries = apr_array_make(pool, 1, sizeof(void *));
+    svn_fs_fs__p2l_entry_t entry;
+    svn_fs_fs__ioctl_dump_index_input_t dump_input = {0};
+    svn_fs_fs__ioctl_load_index_input_t load_input = {0};
+
+    /* Without threads, verification is sequential and reports the index
+     * failures up-front.  So, the following applies to parallel runs only.
+     *
+     * Corrupt r5 by replacing its P2L index with one that declares the
+     * whole revision contents as "unused". */
+    dump_input.revision = 5;
+    dump_input.callback_func = receive_index;
+    dump_input.callback_baton = entries;
+    SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_DUMP_INDEX,
+                         &dump_input, NULL, NULL, NULL, pool, pool));
+
+    entry = *APR_ARRAY_IDX(entries, entries->nelts - 1,
+                           svn_fs_fs__p2l_entry_t *);
+    entry.size += entry.offset;
+    entry.offset = 0;
+    entry.type = SVN_FS_FS__ITEM_TYPE_UNUSED;
+    entry.item.number = SVN_FS_FS__ITEM_INDEX_UNUSED;
+    entry.item.revision = SVN_INVALID_REVNUM;
+    APR_ARRAY_PUSH(alt_entries, svn_fs_fs__p2l_entry_t *) = &entry;
+
+    load_input.revision = 5;
+    load_input.entries = alt_entries;
+    SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_LOAD_INDEX,
+                         &load_input, NULL, NULL, NULL, pool, pool));
+
+    /* Without a verify callback, the failure in the r4 .. r5 shard must
+     * stop verification.  Only the shards before it got reported. */
+    apr_array_clear(revs);
+    SVN_TEST_ASSERT_ERROR(svn_repos_verify_fs4(repos, 1, rev, FALSE, FALSE, 3,
+                                               collect_verified_revs, revs,
+                                               NULL, NULL, NULL, NULL, pool),
+                          SVN_ERR_FS_INDEX_CORRUPTION);
+    SVN_TEST_INT_ASSERT(revs->nelts, 3);
+    for (i = 0; i < revs->nelts; ++i)
+      SVN_TEST_INT_ASSERT(APR_ARRAY_IDX(revs, i, svn_revnum_t), i + 1);
+
+    /* With a callback that accepts all failures, verification continues
+     * and the shard's structure failure gets reported in sequence.  Should
+     * the r5 contents check fail as well, it takes the place of the r5
+     * notification. */
+    apr_array_clear(revs);
+    SVN_ERR(svn_repos_verify_fs4(repos, 1, rev, FALSE, FALSE, 3,
+                                 collect_verified_revs, revs,
+                                 collect_failed_revs, revs,
+                                 NULL, NULL, pool));
+    SVN_TEST_INT_ASSERT(revs->nelts, 11);
+    SVN_TEST_INT_ASSERT(APR_ARRAY_IDX(revs, 0, svn_revnum_t), 1);
+    SVN_TEST_INT_ASSERT(APR_ARRAY_IDX(revs, 1, svn_revnum_t), 2);
+    SVN_TEST_INT_ASSERT(APR_ARRAY_IDX(revs, 2, svn_revnum_t), 3);
+    SVN_TEST_INT_ASSERT(APR_ARRAY_IDX(revs, 3, svn_revnum_t),
+                        SVN_INVALID_REVNUM);
+    for (i = 4; i < revs->nelts; ++i)
+      SVN_TEST_INT_ASSERT(APR_ARRAY_IDX(revs, i, svn_revnum_t), i);
+
+    /* Restore the original index. */
+    load_input.entries = entries;
+    SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_LOAD_INDEX,
+                         &load_input, NULL, NULL, NULL, pool, pool));
+  }
+#endif
+
+  /* Same for a mix of packed and non-packed shards: r0 .. r9 get packed
+   * while r10 remains in the incomplete last shard. */
+  SVN_ERR(svn_repos_fs_pack2(repos, NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_io_check_path(svn_fs_fs__path_rev_packed(fs, 9, PATH_PACKED,
+                                                       pool),
+                            &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+  SVN_ERR(svn_io_check_path(svn_fs_fs__path_rev(fs, 10, pool), &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+
+  apr_array_clear(revs);
+  SVN_ERR(svn_repos_verify_fs4(repos, 0, rev, FALSE, FALSE, 4,
+                               collect_verified_revs, revs,
+                               NULL, NULL, NULL, NULL, pool));
+  SVN_TEST_INT_ASSERT(revs->nelts, 11);
+  for (i = 0; i < revs->nelts; ++i)
+    SVN_TEST_INT_ASSERT(APR_ARRAY_IDX(revs, i, svn_revnum_t), i);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-build-rep-cache-parallel-test"
+
+/* Implements svn_fs_progress_notify_func_t.  Append REVISION to the
+ * array BATON. */
+static void
+collect_progress_revs(svn_revnum_t revision,
+                      void *baton,
+                      apr_pool_t *pool)
+{
+  apr_array_header_t *revs = baton;
+  APR_ARRAY_PUSH(revs, svn_revnum_t) = revision;
+}
+
+/* Implements svn_fs_fs__walk_rep_reference().walker.  Count the reps
+ * per revision in the svn_revnum_t array BATON. */
+static svn_error_t *
+count_reps_per_rev(representation_t *rep,
+                   void *baton,
+                   svn_fs_t *fs,
+                   apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *counts = baton;
+
+  SVN_TEST_ASSERT(rep->revision >= 0 && rep->revision < counts->nelts);
+  ++APR_ARRAY_IDX(counts, rep->revision, svn_revnum_t);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+build_rep_cache_parallel(const svn_test_opts_t *opts, apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t rev;
+  apr_hash_t *fs_config = apr_hash_make(pool);
+  apr_array_header_t *revs = apr_array_make(pool, 16, sizeof(svn_revnum_t));
+  apr_array_header_t *counts = apr_array_make(pool, 16, sizeof(svn_revnum_t));
+  svn_fs_fs__ioctl_build_rep_cache_input_t input = {0};
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  if (opts->server_minor_version && (opts->server_minor_version < 6))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.6 SVN doesn't support FSFS rep-sharing");
+
+  /* Use tiny shards such that the scan gets split into many jobs. */
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_SHARD_SIZE, "2");
+  SVN_ERR(svn_test__create_fs2(&fs, REPO_NAME, opts, fs_config, pool));
+  ffd = fs->fsap_data;
+  ffd->rep_sharing_allowed = FALSE;
+
+  /* r1 adds the Greek tree, r2 .. r9 modify iota. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(rev));
+
+  for (i = 2; i <= 9; ++i)
+    {
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, iterpool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, iterpool));
+      SVN_ERR(svn_test__set_file_contents(txn_root, "iota",
+                                          apr_psprintf(iterpool,
+                                                       "iota in r%d\n", i),
+                                          iterpool));
+      SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, iterpool));
+      SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(rev));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  /* Build the rep-cache with fewer workers than shards.  Progress must
+   * still be reported in revision order. */
+  ffd->rep_sharing_allowed = TRUE;
+
+  input.start_rev = SVN_INVALID_REVNUM;
+  input.end_rev = SVN_INVALID_REVNUM;
+  input.progress_func = collect_progress_revs;
+  input.progress_baton = revs;
+  input.jobs = 3;
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_BUILD_REP_CACHE,
+                       &input, NULL, NULL, NULL, pool, pool));
+
+  SVN_TEST_INT_ASSERT(revs->nelts, 9);
+  for (i = 0; i < revs->nelts; ++i)
+    SVN_TEST_INT_ASSERT(APR_ARRAY_IDX(revs, i, svn_revnum_t), i + 1);
+
+  /* Every revision added at least one rep. */
+  for (i = 0; i <= rev; ++i)
+    APR_ARRAY_PUSH(counts, svn_revnum_t) = 0;
+  SVN_ERR(svn_fs_fs__walk_rep_reference(fs, 0, rev, count_reps_per_rev,
+                                        counts, NULL, NULL, pool));
+  for (i = 1; i <= rev; ++i)
+    SVN_TEST_ASSERT(APR_ARRAY_IDX(counts, i, svn_revnum_t) > 0);
+
+  SVN_ERR(svn_fs_verify(REPO_NAME, NULL, 0, SVN_INVALID_REVNUM,
+                        NULL, NULL, NULL, NULL, pool));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
 
 
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-get-repo-stats-parallel-test"
+
+/* Verify that the statistics LHS and RHS are identical. */
+static svn_error_t *
+compare_repo_stats(const svn_fs_fs__stats_t *lhs,
+                   const svn_fs_fs__stats_t *rhs)
+{
+  apr_size_t i;
+
+#define SAME_MEMBER(member) \
+  SVN_TEST_ASSERT(memcmp(&lhs->member, &rhs->member, \
+                         sizeof(lhs->member)) == 0)
+
+  SAME_MEMBER(total_size);
+  SAME_MEMBER(revision_count);
+  SAME_MEMBER(change_count);
+  SAME_MEMBER(change_len);
+  SAME_MEMBER(total_rep_stats);
+  SAME_MEMBER(file_rep_stats);
+  SAME_MEMBER(dir_rep_stats);
+  SAME_MEMBER(file_prop_rep_stats);
+  SAME_MEMBER(dir_prop_rep_stats);
+  SAME_MEMBER(total_node_stats);
+  SAME_MEMBER(file_node_stats);
+  SAME_MEMBER(dir_node_stats);
+  SAME_MEMBER(rep_size_histogram);
+  SAME_MEMBER(node_size_histogram);
+  SAME_MEMBER(added_rep_size_histogram);
+  SAME_MEMBER(added_node_size_histogram);
+  SAME_MEMBER(unused_rep_histogram);
+  SAME_MEMBER(file_histogram);
+  SAME_MEMBER(file_rep_histogram);
+  SAME_MEMBER(file_prop_histogram);
+  SAME_MEMBER(file_prop_rep_histogram);
+  SAME_MEMBER(dir_histogram);
+  SAME_MEMBER(dir_rep_histogram);
+  SAME_MEMBER(dir_prop_histogram);
+  SAME_MEMBER(dir_prop_rep_histogram);
+
+#undef SAME_MEMBER
+
+  SVN_TEST_ASSERT(lhs->largest_changes->count
+                  == rhs->largest_changes->count);
+  for (i = 0; i < lhs->largest_changes->count; ++i)
+    {
+      svn_fs_fs__large_change_info_t *lhs_change
+        = lhs->largest_changes->changes[i];
+      svn_fs_fs__large_change_info_t *rhs_change
+        = rhs->largest_changes->changes[i];
+
+      SVN_TEST_ASSERT(lhs_change->size == rhs_change->size);
+      SVN_TEST_ASSERT(lhs_change->revision == rhs_change->revision);
+      SVN_TEST_STRING_ASSERT(lhs_change->path->data,
+                             rhs_change->path->data);
+    }
+
+  SVN_TEST_ASSERT(apr_hash_count(lhs->by_extension)
+                  == apr_hash_count(rhs->by_extension));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+get_repo_stats_parallel(const svn_test_opts_t *opts,
+                        apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t rev;
+  apr_hash_t *fs_config = apr_hash_make(pool);
+  apr_array_header_t *revs = apr_array_make(pool, 16, sizeof(svn_revnum_t));
+  svn_fs_fs__ioctl_get_stats_input_t input = {0};
+  svn_fs_fs__ioctl_get_stats_output_t *serial;
+  svn_fs_fs__ioctl_get_stats_output_t *parallel;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  if (opts->server_minor_version && (opts->server_minor_version < 6))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.6 SVN doesn't support FSFS packing");
+
+  /* Use tiny shards such that the scan gets split into many jobs. */
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_SHARD_SIZE, "2");
+  SVN_ERR(svn_test__create_fs2(&fs, REPO_NAME, opts, fs_config, pool));
+
+  /* r1 adds the Greek tree, r2 .. r8 modify iota and r9 reverts it such
+   * that it shares the representation added in r1. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(rev));
+
+  for (i = 2; i <= 9; ++i)
+    {
+      const char *contents;
+      svn_pool_clear(iterpool);
+
+      contents = i < 9 ? apr_psprintf(iterpool, "iota in r%d\n", i)
+                       : "This is the file 'iota'.\n";
+
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, iterpool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, iterpool));
+      SVN_ERR(svn_test__set_file_contents(txn_root, "iota", contents,
+                                          iterpool));
+      SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, iterpool));
+      SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(rev));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  /* Pack all complete shards, leaving r8 and r9 non-packed. */
+  SVN_ERR(svn_fs_pack(REPO_NAME, NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+
+  /* Single-threaded reference. */
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_GET_STATS, &input,
+                       (void **)&serial, NULL, NULL, pool, pool));
+
+  /* Fewer workers than shards.  Progress must be reported per shard and
+   * in revision order. */
+  input.progress_func = collect_progress_revs;
+  input.progress_baton = revs;
+  input.jobs = 3;
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_GET_STATS, &input,
+                       (void **)&parallel, NULL, NULL, pool, pool));
+
+  SVN_TEST_INT_ASSERT(revs->nelts, 5);
+  for (i = 0; i < revs->nelts; ++i)
+    SVN_TEST_INT_ASSERT(APR_ARRAY_IDX(revs, i, svn_revnum_t), 2 * i);
+
+  SVN_ERR(compare_repo_stats(serial->stats, parallel->stats));
+
+  /* The r9 node in the non-packed shard refers to the rep of r1. */
+  SVN_TEST_ASSERT(parallel->stats->revision_count == 10);
+  SVN_TEST_ASSERT(parallel->stats->file_rep_stats.shared.count == 1);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+#define REPO_NAME "test-repo-recovery_checkpoint"
+#define MAX_REV 10
+#define CHUNK_SIZE 3
+
+/* Write a recovery checkpoint for revision REV of FS claiming MAX_NODE_ID
+ * and MAX_COPY_ID.  Add SIZE_DELTA to the actual size of REV's rev file. */
+static svn_error_t *
+write_recovery_checkpoint(svn_fs_t *fs,
+                          svn_revnum_t rev,
+                          apr_off_t size_delta,
+                          int max_node_id,
+                          int max_copy_id,
+                          apr_pool_t *pool)
+{
+  apr_finfo_t finfo;
+  const char *content;
+
+  SVN_ERR(svn_io_stat(&finfo, svn_fs_fs__path_rev_absolute(fs, rev, pool),
+                      APR_FINFO_SIZE, pool));
+  content = apr_psprintf(pool, "%ld %" APR_OFF_T_FMT " %d %d\n", rev,
+                         finfo.size + size_delta, max_node_id, max_copy_id);
+  SVN_ERR(svn_io_write_atomic2(svn_dirent_join(fs->path,
+                                               PATH_RECOVERY_CHECKPOINT,
+                                               pool),
+                               content, strlen(content), NULL, FALSE, pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the revision recorded in the recovery checkpoint of REPO_NAME
+ * in *REV.  Use POOL for allocations. */
+static svn_error_t *
+read_checkpoint_rev(svn_revnum_t *rev,
+                    apr_pool_t *pool)
+{
+  svn_stringbuf_t *checkpoint;
+
+  SVN_ERR(svn_stringbuf_from_file2(&checkpoint,
+                                   svn_dirent_join(REPO_NAME,
+                                                   PATH_RECOVERY_CHECKPOINT,
+                                                   pool),
+                                   pool));
+  *rev = SVN_STR_TO_REV(checkpoint->data);
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton type for count_and_cancel(). */
+typedef struct cancel_counter_t
+{
+  /* Number of calls so far. */
+  int calls;
+
+  /* Fail all calls after this many.  -1 for "never". */
+  int limit;
+} cancel_counter_t;
+
+/* Implement svn_cancel_func_t, counting the calls in the
+ * cancel_counter_t BATON. */
+static svn_error_t *
+count_and_cancel(void *baton)
+{
+  cancel_counter_t *counter = baton;
+
+  if (counter->limit >= 0 && counter->calls >= counter->limit)
+    return svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+
+  ++counter->calls;
+  return SVN_NO_ERROR;
+}
+
+/* Clobber the ID counters in the 'current' file of REPO_NAME, open it
+ * for recovery with THREADS scanner threads and CHUNK_SIZE revisions per
+ * chunk and run FSFS recovery on it with COUNTER as cancellation baton.
+ * Use POOL for allocations. */
+static svn_error_t *
+recover_in_chunks(cancel_counter_t *counter,
+                  int threads,
+                  apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  apr_hash_t *fs_config = apr_hash_make(pool);
+
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_RECOVERY_JOBS,
+                apr_itoa(pool, threads));
+  SVN_ERR(svn_io_write_atomic2(svn_dirent_join(REPO_NAME, PATH_CURRENT,
+                                               pool),
+                               "1 1 1\n", 6, NULL, FALSE, pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+
+  ffd = fs->fsap_data;
+  SVN_TEST_INT_ASSERT(ffd->recovery_threads, threads);
+  ffd->recovery_chunk_size = CHUNK_SIZE;
+
+  counter->calls = 0;
+  return svn_error_trace(svn_fs_fs__recover(fs, count_and_cancel, counter,
+                                            pool));
+}
+
+static svn_error_t *
+recovery_checkpoint(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  svn_test_opts_t temp_opts;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t rev;
+  int i;
+  svn_stringbuf_t *current, *recovered;
+  const char *current_path;
+  const char *checkpoint_path;
+  char node_id[SVN_INT64_BUFFER_SIZE];
+  char copy_id[SVN_INT64_BUFFER_SIZE];
+  cancel_counter_t counter;
+  svn_error_t *err;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  /* Only repositories with global ID counters need to scan for IDs. */
+  temp_opts = *opts;
+  temp_opts.server_minor_version = 4;
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, &temp_opts, pool));
+
+  /* r1: Greek tree.  Further revisions add nodes and copies. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  for (i = 1; i < MAX_REV; ++i)
+    {
+      SVN_ERR(svn_fs_revision_root(&rev_root, fs, i, pool));
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, i, pool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+      SVN_ERR(svn_fs_copy(rev_root, "A", txn_root,
+                          apr_psprintf(pool, "A%d", i), pool));
+      SVN_ERR(svn_fs_make_file(txn_root, apr_psprintf(pool, "new-%d", i),
+                               pool));
+      SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+    }
+  SVN_TEST_INT_ASSERT(rev, MAX_REV);
+
+  current_path = svn_fs_fs__path_current(fs, pool);
+  checkpoint_path = svn_dirent_join(REPO_NAME, PATH_RECOVERY_CHECKPOINT,
+                                    pool);
+  SVN_ERR(svn_stringbuf_from_file2(&current, current_path, pool));
+
+  /* Lose the ID counters and recover them in a single chunk.  That
+     leaves a checkpoint. */
+  SVN_ERR(svn_io_write_atomic2(current_path, "1 1 1\n", 6, NULL, FALSE,
+                               pool));
+  SVN_ERR(svn_fs_recover2(REPO_NAME, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_stringbuf_from_file2(&recovered, current_path, pool));
+  SVN_TEST_STRING_ASSERT(recovered->data, current->data);
+  SVN_ERR(read_checkpoint_rev(&rev, pool));
+  SVN_TEST_INT_ASSERT(rev, MAX_REV);
+
+  /* Scanning many small chunks concurrently gives the same result. */
+  SVN_ERR(svn_io_remove_file2(checkpoint_path, FALSE, pool));
+  counter.limit = -1;
+  SVN_ERR(recover_in_chunks(&counter, 4, pool));
+  SVN_ERR(svn_stringbuf_from_file2(&recovered, current_path, pool));
+  SVN_TEST_STRING_ASSERT(recovered->data, current->data);
+  SVN_ERR(read_checkpoint_rev(&rev, pool));
+  SVN_TEST_INT_ASSERT(rev, MAX_REV);
+
+  /* A serial scan checks for cancellation before each chunk, before each
+     revision and once more at the end.  Interrupt it at the first
+     revision of the third chunk.  The checkpoint covers the first two. */
+  SVN_ERR(svn_io_remove_file2(checkpoint_path, FALSE, pool));
+  counter.limit = 2 * (CHUNK_SIZE + 1) + 1;
+  err = recover_in_chunks(&counter, 1, pool);
+  SVN_TEST_ASSERT_ERROR(err, SVN_ERR_CANCELLED);
+  SVN_ERR(read_checkpoint_rev(&rev, pool));
+  SVN_TEST_INT_ASSERT(rev, 2 * CHUNK_SIZE - 1);
+
+  /* The next run only scans the remaining 5 revisions in 2 chunks. */
+  counter.limit = -1;
+  SVN_ERR(recover_in_chunks(&counter, 1, pool));
+  SVN_TEST_INT_ASSERT(counter.calls, 5 + 2 + 1);
+  SVN_ERR(svn_stringbuf_from_file2(&recovered, current_path, pool));
+  SVN_TEST_STRING_ASSERT(recovered->data, current->data);
+
+  /* Recovery continues from a valid checkpoint and trusts its IDs. */
+  SVN_ERR(write_recovery_checkpoint(fs, MAX_REV - 1, 0, 1000, 2000, pool));
+  SVN_ERR(svn_fs_recover2(REPO_NAME, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_stringbuf_from_file2(&recovered, current_path, pool));
+  svn__ui64tobase36(node_id, 1001);
+  svn__ui64tobase36(copy_id, 2001);
+  SVN_TEST_STRING_ASSERT(recovered->data,
+                         apr_psprintf(pool, "%d %s %s\n", MAX_REV,
+                                      node_id, copy_id));
+
+  /* A checkpoint that does not match the rev file gets ignored. */
+  SVN_ERR(write_recovery_checkpoint(fs, MAX_REV - 1, 1, 1000, 2000, pool));
+  SVN_ERR(svn_fs_recover2(REPO_NAME, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_stringbuf_from_file2(&recovered, current_path, pool));
+  SVN_TEST_STRING_ASSERT(recovered->data, current->data);
+
+  /* Same for a checkpoint beyond the youngest revision. */
+  SVN_ERR(write_recovery_checkpoint(fs, MAX_REV, 0, 1000, 2000, pool));
+  SVN_ERR(svn_io_write_atomic2(current_path, "9 1 1\n", 6, NULL, FALSE,
+                               pool));
+  SVN_ERR(svn_io_remove_file2(svn_fs_fs__path_rev_absolute(fs, MAX_REV,
+                                                           pool),
+                              FALSE, pool));
+  SVN_ERR(svn_io_remove_file2(svn_fs_fs__path_revprops(fs, MAX_REV, pool),
+                              FALSE, pool));
+  SVN_ERR(svn_fs_recover2(REPO_NAME, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_youngest_rev(&rev, fs, pool));
+  SVN_TEST_INT_ASSERT(rev, MAX_REV - 1);
+
+  SVN_ERR(svn_stringbuf_from_file2(&recovered, current_path, pool));
+  SVN_TEST_ASSERT(strcmp(recovered->data, "9 1 1\n") != 0);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef MAX_REV
+#undef CHUNK_SIZE
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-indexed_directory"
+#define DIR_SIZE 100
+static svn_error_t *
+indexed_directory(const svn_test_opts_t *opts,
+                  apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  svn_node_kind_t kind;
+  apr_hash_t *entries;
+  apr_hash_t *fs_config;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  /* Index all directories with at least 10 entries. */
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  ffd = fs->fsap_data;
+  ffd->dir_index_threshold = 10;
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_dir(root, "big", pool));
+  SVN_ERR(svn_fs_make_dir(root, "small", pool));
+  SVN_ERR(svn_fs_make_file(root, "small/file", pool));
+  for (i = 0; i < DIR_SIZE; ++i)
+    {
+      svn_pool_clear(iterpool);
+      if (i % 3)
+        SVN_ERR(svn_fs_make_file(root,
+                                 apr_psprintf(iterpool, "big/f%03d", i * 2),
+                                 iterpool));
+      else
+        SVN_ERR(svn_fs_make_dir(root,
+                                apr_psprintf(iterpool, "big/f%03d", i * 2),
+                                iterpool));
+    }
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(rev));
+
+  /* Re-open the repository without directory cache, such that lookups
+   * must go through the on-disk index. */
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                svn_uuid_generate(pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+  ffd = fs->fsap_data;
+  ffd->dir_cache = NULL;
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  for (i = 0; i < 2 * DIR_SIZE; ++i)
+    {
+      svn_node_kind_t expected = i % 2 ? svn_node_none
+                               : (i / 2) % 3 ? svn_node_file
+                                             : svn_node_dir;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_check_path(&kind, root,
+                                apr_psprintf(iterpool, "big/f%03d", i),
+                                iterpool));
+      SVN_TEST_ASSERT(kind == expected);
+    }
+
+  /* Names sorting before, after and in between existing entries. */
+  SVN_ERR(svn_fs_check_path(&kind, root, "big/a", pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+  SVN_ERR(svn_fs_check_path(&kind, root, "big/f", pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+  SVN_ERR(svn_fs_check_path(&kind, root, "big/f0001", pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+  SVN_ERR(svn_fs_check_path(&kind, root, "big/z", pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+
+  /* Non-indexed directories still work. */
+  SVN_ERR(svn_fs_check_path(&kind, root, "small/file", pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+
+  /* Reading the whole directory ignores the index. */
+  SVN_ERR(svn_fs_dir_entries(&entries, root, "big", pool));
+  SVN_TEST_INT_ASSERT(apr_hash_count(entries), DIR_SIZE);
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef DIR_SIZE
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-large_txn_directory"
+#define DIR_SIZE 2000
+
+static svn_error_t *
+large_txn_directory(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  svn_node_kind_t kind;
+  apr_hash_t *entries;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  ffd = fs->fsap_data;
+
+  /* Add many entries to a single directory, looking up each one right
+   * after adding it. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_dir(root, "big", pool));
+  for (i = 0; i < DIR_SIZE; ++i)
+    {
+      const char *path;
+
+      svn_pool_clear(iterpool);
+      path = apr_psprintf(iterpool, "big/f%04d", i);
+      SVN_ERR(svn_fs_make_file(root, path, iterpool));
+      SVN_ERR(svn_fs_check_path(&kind, root, path, iterpool));
+      SVN_TEST_ASSERT(kind == svn_node_file);
+    }
+
+  /* Directories that the txn dir cache can't hold are kept in memory. */
+  if (   ffd->txn_dir_cache
+      && !svn_cache__is_cachable(ffd->txn_dir_cache, 150 * DIR_SIZE))
+    SVN_TEST_INT_ASSERT(svn_hash__table_count(ffd->txn_dirs), 1);
+
+  /* Remove every 5th entry and turn every 7th into a directory. */
+  for (i = 0; i < DIR_SIZE; ++i)
+    {
+      const char *path;
+
+      svn_pool_clear(iterpool);
+      path = apr_psprintf(iterpool, "big/f%04d", i);
+      if (i % 5 == 0)
+        {
+          SVN_ERR(svn_fs_delete(root, path, iterpool));
+        }
+      else if (i % 7 == 0)
+        {
+          SVN_ERR(svn_fs_delete(root, path, iterpool));
+          SVN_ERR(svn_fs_make_dir(root, path, iterpool));
+        }
+    }
+
+  SVN_ERR(svn_fs_dir_entries(&entries, root, "big", pool));
+  SVN_TEST_INT_ASSERT(apr_hash_count(entries), DIR_SIZE - DIR_SIZE / 5);
+
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(rev));
+
+  /* Verify the committed directory. */
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  SVN_ERR(svn_fs_dir_entries(&entries, root, "big", pool));
+  SVN_TEST_INT_ASSERT(apr_hash_count(entries), DIR_SIZE - DIR_SIZE / 5);
+
+  for (i = 0; i < DIR_SIZE; ++i)
+    {
+      svn_node_kind_t expected = i % 5 == 0 ? svn_node_none
+                               : i % 7 == 0 ? svn_node_dir
+                                            : svn_node_file;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_check_path(&kind, root,
+                                apr_psprintf(iterpool, "big/f%04d", i),
+                                iterpool));
+      SVN_TEST_ASSERT(kind == expected);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef DIR_SIZE
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-node_history_index"
+#define MAX_REV 30
+#define COPY_REV 21
+
+/* Return the history of PATH@REVISION in FS as "path@rev" strings in
+ * *HISTORY, crossing copies.  Allocate it in POOL. */
+static svn_error_t *
+get_history(apr_array_header_t **history,
+            svn_fs_t *fs,
+            const char *path,
+            svn_revnum_t revision,
+            apr_pool_t *pool)
+{
+  svn_fs_root_t *root;
+  svn_fs_history_t *node_history;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  *history = apr_array_make(pool, MAX_REV, sizeof(const char *));
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, revision, pool));
+  SVN_ERR(svn_fs_node_history2(&node_history, root, path, pool, iterpool));
+  while (TRUE)
+    {
+      const char *history_path;
+      svn_revnum_t history_rev;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_history_prev2(&node_history, node_history, TRUE, pool,
+                                   iterpool));
+      if (!node_history)
+        break;
+
+      SVN_ERR(svn_fs_history_location(&history_path, &history_rev,
+                                      node_history, iterpool));
+      APR_ARRAY_PUSH(*history, const char *)
+        = apr_psprintf(pool, "%s@%ld", history_path, history_rev);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+node_history_index(const svn_test_opts_t *opts,
+                   apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root, *rev_root;
+  svn_revnum_t rev;
+  svn_node_kind_t kind;
+  const svn_fs_id_t *id, *pred_id;
+  const char *created_path;
+  const char *db_path = svn_dirent_join(REPO_NAME, PATH_NODE_HISTORY_DB,
+                                        pool);
+  const char *moved_path = apr_pstrcat(pool, db_path, ".moved", SVN_VA_NULL);
+  apr_array_header_t *expected, *actual;
+  apr_hash_t *fs_config;
+  svn_boolean_t found;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  ffd = fs->fsap_data;
+  if (ffd->format < SVN_FS_FS__MIN_REP_SHARING_FORMAT)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.6 SVN doesn't use SQLite");
+
+  /* r1 gets committed before the index is enabled. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_file(root, "f", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_ERR(svn_io_check_path(db_path, &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+
+  /* Linear history of "f" up to COPY_REV, then continued in "g". */
+  ffd->node_history_enabled = TRUE;
+  for (i = 2; i <= MAX_REV; ++i)
+    {
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, iterpool));
+      SVN_ERR(svn_fs_txn_root(&root, txn, iterpool));
+      if (i == COPY_REV)
+        {
+          SVN_ERR(svn_fs_revision_root(&rev_root, fs, rev, iterpool));
+          SVN_ERR(svn_fs_copy(rev_root, "f", root, "g", iterpool));
+        }
+      else
+        {
+          SVN_ERR(svn_test__set_file_contents(root, i > COPY_REV ? "g" : "f",
+                                              apr_psprintf(iterpool, "%d", i),
+                                              iterpool));
+        }
+      SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, iterpool));
+    }
+  SVN_TEST_INT_ASSERT(rev, MAX_REV);
+
+  SVN_ERR(svn_io_check_path(db_path, &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+
+  /* Look at the index directly. */
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, MAX_REV, pool));
+  SVN_ERR(svn_fs_node_id(&id, rev_root, "g", pool));
+  SVN_ERR(svn_fs_fs__get_node_history(&pred_id, &created_path, &found, fs,
+                                      id, pool, pool));
+  SVN_TEST_ASSERT(found);
+  SVN_TEST_STRING_ASSERT(created_path, "/g");
+  SVN_TEST_ASSERT(pred_id && svn_fs_fs__id_rev(pred_id) == MAX_REV - 1);
+
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, 1, pool));
+  SVN_ERR(svn_fs_node_id(&id, rev_root, "f", pool));
+  SVN_ERR(svn_fs_fs__get_node_history(&pred_id, &created_path, &found, fs,
+                                      id, pool, pool));
+  SVN_TEST_ASSERT(!found);
+
+  /* Reference: the history as found without index. */
+  SVN_ERR(svn_io_file_rename2(db_path, moved_path, FALSE, pool));
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                svn_uuid_generate(pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+  SVN_ERR(get_history(&expected, fs, "g", MAX_REV, pool));
+  SVN_TEST_INT_ASSERT(expected->nelts, MAX_REV);
+  SVN_TEST_STRING_ASSERT(APR_ARRAY_IDX(expected, MAX_REV - 1, const char *),
+                         "/f@1");
+
+  /* Same history, now using the index. */
+  SVN_ERR(svn_io_file_rename2(moved_path, db_path, FALSE, pool));
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                svn_uuid_generate(pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+  SVN_ERR(get_history(&actual, fs, "g", MAX_REV, pool));
+
+  SVN_TEST_INT_ASSERT(actual->nelts, expected->nelts);
+  for (i = 0; i < actual->nelts; ++i)
+    SVN_TEST_STRING_ASSERT(APR_ARRAY_IDX(actual, i, const char *),
+                           APR_ARRAY_IDX(expected, i, const char *));
+
+  /* Recovery removes entries of revisions that are gone.  We can't
+   * remove revisions, so pretend that they are still to come. */
+  SVN_ERR(svn_fs_fs__prune_node_history(fs, COPY_REV - 1, pool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, MAX_REV, pool));
+  SVN_ERR(svn_fs_node_id(&id, rev_root, "g", pool));
+  SVN_ERR(svn_fs_fs__get_node_history(&pred_id, &created_path, &found, fs,
+                                      id, pool, pool));
+  SVN_TEST_ASSERT(!found);
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef MAX_REV
+#undef COPY_REV
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-mergeinfo_index"
+
+/* Implements svn_fs_mergeinfo_receiver_t adding PATH and MERGEINFO as
+ * strings to the apr_hash_t BATON. */
+static svn_error_t *
+collect_mergeinfo(const char *path,
+                  svn_mergeinfo_t mergeinfo,
+                  void *baton,
+                  apr_pool_t *scratch_pool)
+{
+  apr_hash_t *catalog = baton;
+  apr_pool_t *result_pool = apr_hash_pool_get(catalog);
+  svn_string_t *mergeinfo_string;
+
+  SVN_ERR(svn_mergeinfo_to_string(&mergeinfo_string, mergeinfo,
+                                  result_pool));
+  svn_hash_sets(catalog, apr_pstrdup(result_pool, path),
+                mergeinfo_string->data);
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the mergeinfo of PATH@REVISION in FS as reported by
+ * svn_fs_get_mergeinfo3() for INHERIT and INCLUDE_DESCENDANTS in *RESULT,
+ * one "path=mergeinfo" line per path.  Return an empty string if PATH
+ * does not exist in REVISION.  Allocate it in POOL. */
+static svn_error_t *
+get_mergeinfo_lines(const char **result,
+                    svn_fs_t *fs,
+                    svn_revnum_t revision,
+                    const char *path,
+                    svn_mergeinfo_inheritance_t inherit,
+                    svn_boolean_t include_descendants,
+                    apr_pool_t *pool)
+{
+  svn_fs_root_t *root;
+  apr_hash_t *catalog = apr_hash_make(pool);
+  apr_array_header_t *paths = apr_array_make(pool, 1, sizeof(const char *));
+  apr_array_header_t *sorted;
+  svn_stringbuf_t *lines = svn_stringbuf_create_empty(pool);
+  svn_node_kind_t kind;
+  int i;
+
+  *result = "";
+  SVN_ERR(svn_fs_revision_root(&root, fs, revision, pool));
+  SVN_ERR(svn_fs_check_path(&kind, root, path, pool));
+  if (kind == svn_node_none)
+    return SVN_NO_ERROR;
+
+  APR_ARRAY_PUSH(paths, const char *) = path;
+  SVN_ERR(svn_fs_get_mergeinfo3(root, paths, inherit, include_descendants,
+                                TRUE, collect_mergeinfo, catalog, pool));
+
+  sorted = svn_sort__hash(catalog, svn_sort_compare_items_as_paths, pool);
+  for (i = 0; i < sorted->nelts; ++i)
+    {
+      svn_sort__item_t *item = &APR_ARRAY_IDX(sorted, i, svn_sort__item_t);
+      svn_stringbuf_appendcstr(lines, item->key);
+      svn_stringbuf_appendbyte(lines, '=');
+      svn_stringbuf_appendcstr(lines, item->value);
+      svn_stringbuf_appendbyte(lines, '\n');
+    }
+
+  *result = lines->data;
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the mergeinfo queries that we compare with and without index
+ * for all revisions up to YOUNGEST in FS as a single string in *RESULT.
+ * Allocate it in POOL. */
+static svn_error_t *
+get_all_mergeinfo(const char **result,
+                  svn_fs_t *fs,
+                  svn_revnum_t youngest,
+                  apr_pool_t *pool)
+{
+  svn_stringbuf_t *all = svn_stringbuf_create_empty(pool);
+  svn_revnum_t revision;
+
+  for (revision = 1; revision <= youngest; ++revision)
+    {
+      const char *lines;
+
+      SVN_ERR(get_mergeinfo_lines(&lines, fs, revision, "/",
+                                  svn_mergeinfo_explicit, TRUE, pool));
+      svn_stringbuf_appendcstr(all, apr_psprintf(pool, "r%ld\n", revision));
+      svn_stringbuf_appendcstr(all, lines);
+
+      SVN_ERR(get_mergeinfo_lines(&lines, fs, revision, "/trunk/sub/f",
+                                  svn_mergeinfo_inherited, FALSE, pool));
+      svn_stringbuf_appendcstr(all, lines);
+
+      SVN_ERR(get_mergeinfo_lines(&lines, fs, revision, "/branches/b1/sub",
+                                  svn_mergeinfo_inherited, FALSE, pool));
+      svn_stringbuf_appendcstr(all, lines);
+    }
+
+  *result = all->data;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+mergeinfo_index(const svn_test_opts_t *opts,
+                apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root, *rev_root;
+  svn_revnum_t rev;
+  svn_node_kind_t kind;
+  svn_mergeinfo_t mergeinfo;
+  svn_boolean_t covered;
+  const char *db_path = svn_dirent_join(REPO_NAME, PATH_MERGEINFO_DB, pool);
+  const char *moved_path = apr_pstrcat(pool, db_path, ".moved", SVN_VA_NULL);
+  const char *expected, *actual;
+  apr_hash_t *fs_config;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  ffd = fs->fsap_data;
+  if (ffd->format < SVN_FS_FS__MIN_REP_SHARING_FORMAT)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.6 SVN doesn't use SQLite");
+
+  /* r1 gets committed before the index is enabled. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_dir(root, "trunk", pool));
+  SVN_ERR(svn_fs_make_dir(root, "trunk/sub", pool));
+  SVN_ERR(svn_fs_make_file(root, "trunk/sub/f", pool));
+  SVN_ERR(svn_fs_make_dir(root, "branches", pool));
+  SVN_ERR(svn_fs_change_node_prop(root, "trunk", SVN_PROP_MERGEINFO,
+                                  svn_string_create("/vendor:1", pool),
+                                  pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_ERR(svn_io_check_path(db_path, &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+
+  /* r2: Commits don't create the index, even when it is enabled. */
+  ffd->mergeinfo_index_enabled = TRUE;
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_change_node_prop(root, "trunk/sub", SVN_PROP_MERGEINFO,
+                                  svn_string_create("/other:1*,3-5", pool),
+                                  pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_ERR(svn_io_check_path(db_path, &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+
+  /* Build the catalog for r2 explicitly. */
+  SVN_ERR(svn_fs_fs__build_mergeinfo_index(fs, NULL, NULL, NULL, NULL,
+                                           pool));
+  SVN_ERR(svn_io_check_path(db_path, &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+
+  /* r3: Branches inherit the mergeinfo of the copy source. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, rev, pool));
+  SVN_ERR(svn_fs_copy(rev_root, "trunk", root, "branches/b1", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* r4: Modify and delete mergeinfo. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_change_node_prop(root, "branches/b1", SVN_PROP_MERGEINFO,
+                                  svn_string_create("/trunk:2-3\n"
+                                                    "/vendor:1", pool),
+                                  pool));
+  SVN_ERR(svn_fs_change_node_prop(root, "branches/b1/sub/f",
+                                  SVN_PROP_MERGEINFO,
+                                  svn_string_create("/other:4", pool),
+                                  pool));
+  SVN_ERR(svn_fs_delete(root, "trunk/sub", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* r5: Invalid mergeinfo counts as none. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_change_node_prop(root, "trunk", SVN_PROP_MERGEINFO,
+                                  svn_string_create("invalid", pool),
+                                  pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_TEST_INT_ASSERT(rev, 5);
+
+  /* Look at the index directly. */
+  SVN_ERR(svn_fs_fs__mergeinfo_index_covers(&covered, fs, 1, pool));
+  SVN_TEST_ASSERT(!covered);
+  SVN_ERR(svn_fs_fs__mergeinfo_index_covers(&covered, fs, 2, pool));
+  SVN_TEST_ASSERT(covered);
+  SVN_ERR(svn_fs_fs__mergeinfo_index_covers(&covered, fs, 5, pool));
+  SVN_TEST_ASSERT(covered);
+
+  SVN_ERR(svn_fs_fs__get_indexed_mergeinfo(&mergeinfo, fs, 3,
+                                           "/branches/b1/sub", pool, pool));
+  SVN_TEST_ASSERT(mergeinfo);
+  SVN_ERR(svn_fs_fs__get_indexed_mergeinfo(&mergeinfo, fs, 4,
+                                           "/trunk/sub", pool, pool));
+  SVN_TEST_ASSERT(mergeinfo == NULL);
+  SVN_ERR(svn_fs_fs__get_indexed_mergeinfo(&mergeinfo, fs, 5, "/trunk",
+                                           pool, pool));
+  SVN_TEST_ASSERT(mergeinfo == NULL);
+
+  /* Reference: the mergeinfo as found without index. */
+  SVN_ERR(svn_io_file_rename2(db_path, moved_path, FALSE, pool));
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                svn_uuid_generate(pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+  SVN_ERR(get_all_mergeinfo(&expected, fs, rev, pool));
+
+  /* Same mergeinfo, now using the index. */
+  SVN_ERR(svn_io_file_rename2(moved_path, db_path, FALSE, pool));
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                svn_uuid_generate(pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+  SVN_ERR(get_all_mergeinfo(&actual, fs, rev, pool));
+
+  SVN_TEST_STRING_ASSERT(actual, expected);
+
+  /* Recovery removes all information about revisions that are gone. */
+  SVN_ERR(svn_fs_fs__prune_mergeinfo_index(fs, 3, pool));
+  SVN_ERR(svn_fs_fs__mergeinfo_index_covers(&covered, fs, 4, pool));
+  SVN_TEST_ASSERT(!covered);
+  SVN_ERR(svn_fs_fs__get_indexed_mergeinfo(&mergeinfo, fs, 3,
+                                           "/trunk/sub", pool, pool));
+  SVN_TEST_ASSERT(mergeinfo);
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+
+
 /* The test table.  */
 
 static int max_threads = 0;
@@ -516,6 +1801,22 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "load the P2L index"),
     SVN_TEST_OPTS_PASS(build_rep_cache,
                        "build the representation cache"),
+    SVN_TEST_OPTS_PASS(verify_parallel,
+                       "verify with multiple worker threads"),
+    SVN_TEST_OPTS_PASS(build_rep_cache_parallel,
+                       "build the representation cache in parallel"),
+    SVN_TEST_OPTS_PASS(get_repo_stats_parallel,
+                       "get statistics with multiple worker threads"),
+    SVN_TEST_OPTS_PASS(recovery_checkpoint,
+                       "recover in parallel and from a checkpoint"),
+    SVN_TEST_OPTS_PASS(indexed_directory,
+                       "look up entries in indexed directories"),
+    SVN_TEST_OPTS_PASS(large_txn_directory,
+                       "add many entries to a directory in one txn"),
+    SVN_TEST_OPTS_PASS(node_history_index,
+                       "follow node history through the history index"),
+    SVN_TEST_OPTS_PASS(mergeinfo_index,
+                       "look up mergeinfo in the mergeinfo index"),
     SVN_TEST_NULL
   };
 
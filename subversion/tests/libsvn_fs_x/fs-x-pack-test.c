@@ -25,13 +25,13 @@
 #include <apr_pools.h>
 
 #include "../svn_test.h"
-#include "../../libsvn_fs_x/batch_fsync.h"
 #include "../../libsvn_fs_x/fs.h"
 #include "../../libsvn_fs_x/reps.h"
 
 #include "svn_pools.h"
 #include "svn_props.h"
 #include "svn_fs.h"
+#include "private/svn_io_private.h"
 #include "private/svn_string_private.h"
 
 #include "../svn_test_fs.h"
@@ -851,7 +851,7 @@ test_batch_fsync(const svn_test_opts_t *opts,
                  apr_pool_t *pool)
 {
   const char *abspath;
-  svn_fs_x__batch_fsync_t *batch;
+  svn_io__batch_fsync_t *batch;
   int i;
 
   /* Disable this test for non FSX backends because it has no relevance to
@@ -870,13 +870,13 @@ test_batch_fsync(const svn_test_opts_t *opts,
 
   /* Initialize infrastructure with a pool that lives as long as this
    * application. */
-  SVN_ERR(svn_fs_x__batch_fsync_init(pool));
+  SVN_ERR(svn_io__batch_fsync_init(pool));
 
   /* We use and re-use the same batch object throughout this test. */
-  SVN_ERR(svn_fs_x__batch_fsync_create(&batch, TRUE, pool));
+  SVN_ERR(svn_io__batch_fsync_create(&batch, TRUE, pool));
 
   /* The working directory is new. */
-  SVN_ERR(svn_fs_x__batch_fsync_new_path(batch, abspath, pool));
+  SVN_ERR(svn_io__batch_fsync_new_path(batch, abspath, pool));
 
   /* 1st run: Has to fire up worker threads etc. */
   for (i = 0; i < 10; ++i)
@@ -887,12 +887,12 @@ test_batch_fsync(const svn_test_opts_t *opts,
                                          pool);
       apr_size_t len = strlen(path);
 
-      SVN_ERR(svn_fs_x__batch_fsync_open_file(&file, batch, path, pool));
+      SVN_ERR(svn_io__batch_fsync_open_file(&file, batch, path, pool));
 
       SVN_ERR(svn_io_file_write(file, path, &len, pool));
     }
 
-  SVN_ERR(svn_fs_x__batch_fsync_run(batch, pool));
+  SVN_ERR(svn_io__batch_fsync_run(batch, pool));
 
   /* 2nd run: Running a batch must leave the container in an empty,
    * re-usable state. Hence, try to re-use it. */
@@ -904,12 +904,12 @@ test_batch_fsync(const svn_test_opts_t *opts,
                                          pool);
       apr_size_t len = strlen(path);
 
-      SVN_ERR(svn_fs_x__batch_fsync_open_file(&file, batch, path, pool));
+      SVN_ERR(svn_io__batch_fsync_open_file(&file, batch, path, pool));
 
       SVN_ERR(svn_io_file_write(file, path, &len, pool));
     }
 
-  SVN_ERR(svn_fs_x__batch_fsync_run(batch, pool));
+  SVN_ERR(svn_io__batch_fsync_run(batch, pool));
 
   /* 3rd run: Schedule but don't execute. POOL cleanup shall not fail. */
   for (i = 0; i < 10; ++i)
@@ -920,7 +920,7 @@ test_batch_fsync(const svn_test_opts_t *opts,
                                          pool);
       apr_size_t len = strlen(path);
 
-      SVN_ERR(svn_fs_x__batch_fsync_open_file(&file, batch, path, pool));
+      SVN_ERR(svn_io__batch_fsync_open_file(&file, batch, path, pool));
 
       SVN_ERR(svn_io_file_write(file, path, &len, pool));
     }
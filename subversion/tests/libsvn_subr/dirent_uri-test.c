@@ -1173,6 +1173,9 @@ test_relpath_is_canonical(apr_pool_t *pool)
     { "dirA",                  TRUE },
     { "foo/dirA",              TRUE },
     { "foo/./bar",             FALSE },
+    { "foo/bar/baz/qux",       TRUE },
+    { "foo/bar/baz//qux",      FALSE },
+    { "foo/bar/baz/qux//x",    FALSE },
     { "http://hst",            FALSE },
     { "http://hst/foo/../bar", FALSE },
     { "http://HST/",           FALSE },
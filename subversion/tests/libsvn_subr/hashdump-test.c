@@ -35,6 +35,9 @@
 #include "svn_string.h"
 #include "svn_error.h"
 #include "svn_hash.h"
+#include "svn_pools.h"
+
+#include "private/svn_subr_private.h"
 
 
 /* Our own global variables */
@@ -230,6 +233,77 @@ read_hash_buffered_test(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+hash_table_test(apr_pool_t *pool)
+{
+  enum { COUNT = 10000 };
+  svn_hash__table_t *table = svn_hash__table_make(0, pool);
+  const char **keys = apr_palloc(pool, COUNT * sizeof(*keys));
+  const char *key;
+  apr_size_t klen;
+  apr_size_t iter;
+  int *val;
+  int i;
+
+  for (i = 0; i < COUNT; ++i)
+    {
+      int *value = apr_palloc(pool, sizeof(*value));
+      *value = i;
+      keys[i] = apr_psprintf(pool, "key%d", i);
+      svn_hash__table_sets(table, keys[i], value);
+    }
+
+  SVN_TEST_ASSERT(svn_hash__table_count(table) == COUNT);
+
+  /* Remove every other entry. */
+  for (i = 0; i < COUNT; i += 2)
+    svn_hash__table_sets(table, keys[i], NULL);
+
+  SVN_TEST_ASSERT(svn_hash__table_count(table) == COUNT / 2);
+  for (i = 0; i < COUNT; ++i)
+    {
+      val = svn_hash__table_gets(table, keys[i]);
+      if (i % 2)
+        SVN_TEST_ASSERT(val && *val == i);
+      else
+        SVN_TEST_ASSERT(val == NULL);
+    }
+
+  /* Removing non-existent entries is a no-op. */
+  svn_hash__table_sets(table, "no such key", NULL);
+  svn_hash__table_sets(table, keys[0], NULL);
+  SVN_TEST_ASSERT(svn_hash__table_count(table) == COUNT / 2);
+
+  /* Re-add a removed key, it goes to the end. */
+  val = apr_palloc(pool, sizeof(*val));
+  *val = 0;
+  svn_hash__table_sets(table, keys[0], val);
+
+  /* Iteration must follow insertion order. */
+  iter = 0;
+  for (i = 1; i < COUNT; i += 2)
+    {
+      val = svn_hash__table_next(&key, &klen, table, &iter);
+      SVN_TEST_ASSERT(val && *val == i);
+      SVN_TEST_ASSERT(klen == strlen(keys[i]));
+      SVN_TEST_STRING_ASSERT(key, keys[i]);
+    }
+
+  val = svn_hash__table_next(&key, NULL, table, &iter);
+  SVN_TEST_ASSERT(val && *val == 0);
+  SVN_TEST_STRING_ASSERT(key, keys[0]);
+  SVN_TEST_ASSERT(svn_hash__table_next(NULL, NULL, table, &iter) == NULL);
+
+  /* Replace a value. */
+  val = apr_palloc(pool, sizeof(*val));
+  *val = -1;
+  svn_hash__table_sets(table, keys[1], val);
+  SVN_TEST_ASSERT(*(int *)svn_hash__table_gets(table, keys[1]) == -1);
+  SVN_TEST_ASSERT(svn_hash__table_count(table) == COUNT / 2 + 1);
+
+  return SVN_NO_ERROR;
+}
+
 
 /*
    ====================================================================
@@ -252,6 +326,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "write hash out, read back in, compare"),
     SVN_TEST_PASS2(read_hash_buffered_test,
                    "read hash from buffered file"),
+    SVN_TEST_PASS2(hash_table_test,
+                   "open-addressing hash table"),
     SVN_TEST_NULL
   };
 
@@ -2481,6 +2481,95 @@ test_mergeinfo_merge_random_non_validated_inputs(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Apply OPERATION ("merge", "intersect" or "remove") to the rangelists
+ * given as RANGELIST1_STR and RANGELIST2_STR in compact form and verify
+ * that the result is EXPECTED_STR. */
+static svn_error_t *
+verify_compact_operation(const char *operation,
+                         const char *rangelist1_str,
+                         const char *rangelist2_str,
+                         const char *expected_str,
+                         apr_pool_t *pool)
+{
+  svn_rangelist_t *rangelist1, *rangelist2;
+  svn_rangelist__compact_t *compact1, *compact2, *result;
+  svn_string_t *result_string;
+
+  SVN_ERR(svn_rangelist__parse(&rangelist1, rangelist1_str, pool));
+  SVN_ERR(svn_rangelist__parse(&rangelist2, rangelist2_str, pool));
+  compact1 = svn_rangelist__compact(rangelist1, pool);
+  compact2 = svn_rangelist__compact(rangelist2, pool);
+  SVN_TEST_ASSERT(compact1 && compact2);
+
+  if (strcmp(operation, "merge") == 0)
+    result = svn_rangelist__compact_merge(compact1, compact2, pool);
+  else if (strcmp(operation, "intersect") == 0)
+    result = svn_rangelist__compact_intersect(compact1, compact2, pool);
+  else
+    result = svn_rangelist__compact_remove(compact1, compact2, pool);
+
+  SVN_ERR(svn_rangelist_to_string(&result_string,
+                                  svn_rangelist__from_compact(result, pool),
+                                  pool));
+  if (strcmp(result_string->data, expected_str) != 0)
+    return fail(pool, "compact %s of '%s' and '%s': expected '%s', got '%s'",
+                operation, rangelist1_str, rangelist2_str, expected_str,
+                result_string->data);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_rangelist_compact(apr_pool_t *pool)
+{
+  svn_rangelist_t *rangelist, *changes;
+  svn_string_t *result_string;
+
+  /* Only sorted rangelists without overlaps can be compacted. */
+  SVN_ERR(svn_rangelist__parse(&rangelist, "5-7,3", pool));
+  SVN_TEST_ASSERT(svn_rangelist__compact(rangelist, pool) == NULL);
+  SVN_ERR(svn_rangelist__parse(&rangelist, "3-7,5-9*", pool));
+  SVN_TEST_ASSERT(svn_rangelist__compact(rangelist, pool) == NULL);
+
+  /* Adjacent ranges get combined unless their inheritability differs. */
+  SVN_ERR(svn_rangelist__parse(&rangelist, "1-3,4,5-6*,8", pool));
+  SVN_ERR(svn_rangelist_to_string(
+            &result_string,
+            svn_rangelist__from_compact(svn_rangelist__compact(rangelist,
+                                                               pool),
+                                        pool),
+            pool));
+  SVN_TEST_STRING_ASSERT(result_string->data, "1-4,5-6*,8");
+
+  SVN_ERR(verify_compact_operation("merge", "8-10", "5-10*,11-24",
+                                   "5-7*,8-24", pool));
+  SVN_ERR(verify_compact_operation("merge", "1-10*", "3,5-6",
+                                   "1-2*,3,4*,5-6,7-10*", pool));
+  SVN_ERR(verify_compact_operation("merge", "1,5", "", "1,5", pool));
+  SVN_ERR(verify_compact_operation("intersect", "90-420*", "1-100",
+                                   "90-100", pool));
+  SVN_ERR(verify_compact_operation("intersect", "90-420*", "1-100*",
+                                   "90-100*", pool));
+  SVN_ERR(verify_compact_operation("intersect", "1-5,8-12", "3-9",
+                                   "3-5,8-9", pool));
+  SVN_ERR(verify_compact_operation("remove", "3-4*", "1-10",
+                                   "1-2,5-10", pool));
+  SVN_ERR(verify_compact_operation("remove", "2,4-6,9-20", "1-7*,8-12",
+                                   "1*,3*,7*,8", pool));
+  SVN_ERR(verify_compact_operation("remove", "1-20", "5-7", "", pool));
+
+  /* Canonical rangelists may still contain adjacent ranges that differ
+     in inheritability.  Merging them in compact form keeps them apart. */
+  SVN_ERR(svn_rangelist__parse(&rangelist, "1-5*,6-8", pool));
+  SVN_ERR(svn_rangelist__parse(&changes, "3-4", pool));
+  SVN_TEST_ASSERT(svn_rangelist__is_canonical(rangelist));
+  SVN_ERR(svn_rangelist_merge2(rangelist, changes, pool, pool));
+  SVN_ERR(svn_rangelist_to_string(&result_string, rangelist, pool));
+  SVN_TEST_STRING_ASSERT(result_string->data, "1-2*,3-4,5*,6-8");
+
+  return SVN_NO_ERROR;
+}
+
 /* The test table.  */
 
 static int max_threads = 4;
@@ -2540,6 +2629,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test rangelist merge random non-validated inputs"),
     SVN_TEST_PASS2(test_mergeinfo_merge_random_non_validated_inputs,
                    "test mergeinfo merge random non-validated inputs"),
+    SVN_TEST_PASS2(test_rangelist_compact,
+                   "test compact rangelist operations"),
     SVN_TEST_NULL
   };
 
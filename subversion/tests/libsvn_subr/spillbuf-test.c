@@ -558,6 +558,67 @@ test_spillbuf_file_attrs_spill_all(apr_pool_t *pool)
   return test_spillbuf__file_attrs(pool, TRUE, buf);
 }
 
+static svn_error_t *
+test_spillbuf__small_writes(apr_pool_t *pool, svn_spillbuf_t *buf)
+{
+  int written = 0;
+  int read = 0;
+  int i;
+
+  /* Lots of tiny writes, most of which end up in the spill file.  */
+  for (i = 0; i < 100; ++i, ++written)
+    {
+      char c = (char)('a' + written % 26);
+      SVN_ERR(svn_spillbuf__write(buf, &c, 1, pool));
+    }
+
+  /* Drain the buffer, appending a byte after every read.  */
+  while (read < written)
+    {
+      const char *readptr;
+      apr_size_t readlen;
+      apr_size_t k;
+
+      SVN_ERR(svn_spillbuf__read(&readptr, &readlen, buf, pool));
+      SVN_TEST_ASSERT(readptr != NULL && readlen > 0);
+      for (k = 0; k < readlen; ++k, ++read)
+        SVN_TEST_ASSERT(readptr[k] == (char)('a' + read % 26));
+
+      if (written < 150)
+        {
+          char c = (char)('a' + written % 26);
+          SVN_ERR(svn_spillbuf__write(buf, &c, 1, pool));
+          ++written;
+        }
+    }
+
+  SVN_TEST_ASSERT(read == 150);
+  SVN_TEST_ASSERT(svn_spillbuf__get_size(buf) == 0);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_spillbuf_small_writes(apr_pool_t *pool)
+{
+  svn_spillbuf_t *buf = svn_spillbuf__create(4 /* blocksize */,
+                                             10 /* maxsize */,
+                                             pool);
+  return test_spillbuf__small_writes(pool, buf);
+}
+
+static svn_error_t *
+test_spillbuf_small_writes_spill_all(apr_pool_t *pool)
+{
+  svn_spillbuf_t *buf = svn_spillbuf__create_extended(
+                          4 /* blocksize */,
+                          10 /* maxsize */,
+                          TRUE /* delte on close */,
+                          TRUE /* spill all data */,
+                          NULL, pool);
+  return test_spillbuf__small_writes(pool, buf);
+}
+
 /* The test table.  */
 
 static int max_threads = 1;
@@ -589,6 +650,10 @@ static struct svn_test_descriptor_t test_funcs[] =
     SVN_TEST_PASS2(test_spillbuf_file_attrs, "check spill file properties"),
     SVN_TEST_PASS2(test_spillbuf_file_attrs_spill_all,
                    "check spill file properties (spill-all-data)"),
+    SVN_TEST_PASS2(test_spillbuf_small_writes,
+                   "interleave many small reads and writes"),
+    SVN_TEST_PASS2(test_spillbuf_small_writes_spill_all,
+                   "interleave small reads and writes (spill-all-data)"),
     SVN_TEST_NULL
   };
 
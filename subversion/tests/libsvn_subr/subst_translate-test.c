@@ -31,6 +31,7 @@
 #include "svn_string.h"
 #include "svn_subst.h"
 #include "svn_hash.h"
+#include "svn_pools.h"
 
 #define ARRAY_LEN(ary) ((sizeof (ary)) / (sizeof ((ary)[0])))
 
@@ -500,6 +501,56 @@ test_svn_subst_long_keywords(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_svn_subst_keyword_offsets(apr_pool_t *pool)
+{
+  apr_hash_t *keywords = apr_hash_make(pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  svn_hash_sets(keywords, "Rev", svn_string_create("42", pool));
+
+  /* Place keywords and EOLs at all offsets within a machine word,
+     so the scanner finds them at any position within a chunk. */
+  for (i = 0; i < 24; i++)
+    {
+      const char *prefix;
+      const char *src;
+      const char *expected;
+      const char *result;
+
+      svn_pool_clear(iterpool);
+
+      prefix = apr_psprintf(iterpool, "%.*s", i, "xxxxxxxxxxxxxxxxxxxxxxxx");
+      src = apr_pstrcat(iterpool, prefix, "$Rev$yyyyyyyyy\r\n",
+                        prefix, "$Rev$\r\n", prefix, "\r", SVN_VA_NULL);
+      expected = apr_pstrcat(iterpool, prefix, "$Rev: 42 $yyyyyyyyy\n",
+                             prefix, "$Rev: 42 $\n", prefix, "\n",
+                             SVN_VA_NULL);
+
+      SVN_ERR(svn_subst_translate_cstring2(src, &result, "\n", TRUE,
+                                           keywords, TRUE, iterpool));
+      SVN_TEST_STRING_ASSERT(result, expected);
+
+      /* Keywords only */
+      SVN_ERR(svn_subst_translate_cstring2(src, &result, NULL, FALSE,
+                                           keywords, TRUE, iterpool));
+      SVN_TEST_STRING_ASSERT(result,
+                             apr_pstrcat(iterpool,
+                                         prefix, "$Rev: 42 $yyyyyyyyy\r\n",
+                                         prefix, "$Rev: 42 $\r\n",
+                                         prefix, "\r", SVN_VA_NULL));
+
+      /* No translation at all */
+      SVN_ERR(svn_subst_translate_cstring2(src, &result, NULL, FALSE,
+                                           NULL, FALSE, iterpool));
+      SVN_TEST_STRING_ASSERT(result, src);
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
 static int max_threads = 1;
 
 static struct svn_test_descriptor_t test_funcs[] =
@@ -519,6 +570,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test truncated keywords (issue 4349)"),
     SVN_TEST_PASS2(test_svn_subst_long_keywords,
                    "test long keywords (issue 4350)"),
+    SVN_TEST_PASS2(test_svn_subst_keyword_offsets,
+                   "test keywords and EOLs at varying offsets"),
     SVN_TEST_NULL
   };
 
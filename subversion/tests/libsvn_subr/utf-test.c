@@ -215,6 +215,47 @@ utf_validate2(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Compare svn_utf__is_valid and svn_utf__is_ascii against
+   svn_utf__last_valid using mostly-ASCII random data, exercising the
+   word-wise skipping of ASCII runs. */
+static svn_error_t *
+utf_validate3(apr_pool_t *pool)
+{
+  int i;
+
+  seed_val();
+
+  for (i = 0; i < 100000; ++i)
+    {
+      unsigned int j;
+      char str[64];
+      svn_boolean_t ascii = TRUE;
+
+      /* A random string with the occasional non-ASCII byte. */
+      for (j = 0; j < sizeof(str); ++j)
+        {
+          if (range_rand(0, 15) == 0)
+            str[j] = (char)range_rand(0x80, 0xff);
+          else
+            str[j] = (char)range_rand(0, 0x7f);
+
+          if ((unsigned char)str[j] >= 0x80)
+            ascii = FALSE;
+        }
+
+      if (svn_utf__is_valid(str, sizeof(str))
+          != (svn_utf__last_valid(str, sizeof(str)) == str + sizeof(str)))
+        return svn_error_createf
+          (SVN_ERR_TEST_FAILED, NULL, "is_valid test %d failed", i);
+
+      if (svn_utf__is_ascii(str, sizeof(str)) != ascii)
+        return svn_error_createf
+          (SVN_ERR_TEST_FAILED, NULL, "is_ascii test %d failed", i);
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Test conversion from different codepages to utf8. */
 static svn_error_t *
 test_utf_cstring_to_utf8_ex2(apr_pool_t *pool)
@@ -228,7 +269,8 @@ test_utf_cstring_to_utf8_ex2(apr_pool_t *pool)
       const char *from_page;
   } tests[] = {
       {"ascii text\n", "ascii text\n", "unexistent-page"},
-      {"Edelwei\xdf", "Edelwei\xc3\x9f", "ISO-8859-1"}
+      {"Edelwei\xdf", "Edelwei\xc3\x9f", "ISO-8859-1"},
+      {"ascii text\n", "ascii text\n", "ISO-8859-1"}
   };
 
   for (i = 0; i < sizeof(tests) / sizeof(tests[0]); i++)
@@ -1028,6 +1070,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test svn_utf__normalize"),
     SVN_TEST_PASS2(test_utf_xfrm,
                    "test svn_utf__xfrm"),
+    SVN_TEST_PASS2(utf_validate3,
+                   "test is_valid/is_ascii on mostly ASCII data"),
     SVN_TEST_NULL
   };
 